@@ -13,10 +13,13 @@ namespace MathAnim
 {
 	struct Font;
 	struct SvgObject;
+	struct SvgMorph;
 	struct AnimationManagerData;
 	
 	// Constants
-	constexpr uint32 SERIALIZER_VERSION = 1;
+	// Version 2 stores SvgObject geometry in binary instead of as SVG path text,
+	// everything else is laid out the same as version 1
+	constexpr uint32 SERIALIZER_VERSION = 2;
 	constexpr uint32 MAGIC_NUMBER = 0xDEADBEEF;
 
 	inline bool isNull(AnimObjId animObj) { return animObj == NULL_ANIM_OBJECT; }
@@ -283,6 +286,8 @@ namespace MathAnim
 		//      animation
 		void applyAnimation(AnimationManagerData* am, float t = 1.0f) const;
 		void applyAnimationToObj(AnimationManagerData* am, AnimObjId animObj, float t = 1.0f) const;
+		// Same as applyAnimationToObj for a single glyph of obj's glyph run
+		void applyAnimationToGlyph(const AnimObject* obj, GlyphInstance& glyph, float t) const;
 		void calculateKeyframes(AnimationManagerData* am);
 		void calculateKeyframesForObj(AnimationManagerData* am, AnimObjId animObj);
 
@@ -387,6 +392,9 @@ namespace MathAnim
 
 		SvgObject* _svgObjectStart;
 		SvgObject* svgObject;
+		// Cached correspondence for the replacement transform this object is in, so
+		// it doesn't get worked out again on every frame
+		SvgMorph* _replacementMorph;
 		float svgScale;
 		AnimObjectStatus status;
 		bool isTransparent;
@@ -435,6 +443,11 @@ namespace MathAnim
 		void copyStrokeColorToChildren(AnimationManagerData* am) const;
 		void copyFillColorToChildren(AnimationManagerData* am) const;
 
+		// Returns the glyphs of text objects that haven't been split into characters,
+		// nullptr for everything else
+		GlyphRun* getGlyphRun();
+		const GlyphRun* getGlyphRun() const;
+
 		AnimObjectBreadthFirstIter beginBreadthFirst(AnimationManagerData* am) const;
 		inline AnimObjId end() const { return NULL_ANIM_OBJECT; }
 		
@@ -36,6 +36,11 @@ namespace MathAnim
 		void render(AnimationManagerData* am, int deltaFrame);
 
 		int lastAnimatedFrame(const AnimationManagerData* am);
+		// Returns true if any animation could produce a different result at `frame` than
+		// it did at `previousFrame`. If this is false and the edit counter hasn't changed
+		// then both frames render exactly the same.
+		bool hasAnimationsActiveBetween(const AnimationManagerData* am, int previousFrame, int frame);
+		uint64 getEditCounter(const AnimationManagerData* am);
 		const AnimObject* getActiveOrthoCamera(const AnimationManagerData* am);
 		void setActiveOrthoCamera(AnimationManagerData* am, AnimObjId id);
 
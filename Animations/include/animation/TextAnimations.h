@@ -9,15 +9,85 @@ namespace MathAnim
 	struct Font;
 	struct AnimObject;
 	struct SvgGroup;
+	struct SvgObject;
+	struct SvgMorph;
 	struct AnimationManagerData;
+	struct TokenizedCode;
+
+	struct GlyphInstance
+	{
+		// Index of the glyph's outline in GlyphRun::outlines
+		uint32 glyphId;
+		uint32 codepoint;
+		// Center of the glyph relative to the text object
+		Vec2 offset;
+		// Tints the text object's fill and stroke colors
+		glm::u8vec4 color;
+
+		// Animation state, reset along with the text object's. The alphas scale the
+		// text object's fill and stroke alpha.
+		float percentCreated;
+		uint8 fillAlpha;
+		uint8 strokeAlpha;
+	};
+
+	// Blends a glyph into the glyph at the same index of the run replacing it
+	struct GlyphMorph
+	{
+		SvgMorph* morph;
+		// Blended outline, reused every frame
+		SvgObject* outline;
+		// False when both glyphs share an outline, which then gets drawn as is
+		bool isBlended;
+	};
+
+	// Every glyph of a text object laid out in one array. The text object animates and
+	// draws them itself instead of going through an AnimObject per character, so all
+	// the glyphs on an SVG cache page end up in a single batch. Per character children
+	// only get created when the user asks for them with splitIntoCharacters.
+	struct GlyphRun
+	{
+		// Every distinct glyph in the run once. The outlines are owned by the font.
+		SvgObject** outlines;
+		int32 numOutlines;
+		int32 maxOutlines;
+
+		GlyphInstance* glyphs;
+		int32 numGlyphs;
+		int32 maxGlyphs;
+		// Bounds of the glyphs relative to the text object
+		BBox bbox;
+
+		// Set by a replacement transform every frame it runs. The glyphs the runs have in
+		// common blend into each other and the rest fade in or out.
+		AnimObjId replacementId;
+		float percentReplaced;
+		GlyphMorph* morphs;
+		int32 numMorphs;
+		int32 maxMorphs;
+
+		void addGlyph(SvgObject* svg, uint32 codepoint, const Vec2& offset, const glm::u8vec4& color);
+		void resetState();
+		void morphTo(const GlyphRun& replacement, AnimObjId replacementObjId, float t);
+		void prefetch(AnimationManagerData* am, const AnimObject* parent) const;
+		void render(AnimationManagerData* am, const AnimObject* parent) const;
+		// Replaces the run with a generated child object per glyph, which leaves the run empty
+		void splitIntoCharacters(AnimationManagerData* am, AnimObjId parentId);
+		void free();
+
+		static GlyphRun createDefault();
+	};
 
 	struct TextObject
 	{
 		char* text;
 		int32 textLength;
 		Font* font;
+		GlyphRun glyphRun;
+		// Key of the last layout in TextLayouts, so edits can reuse it
+		uint64 layoutKey;
 
-		void init(AnimationManagerData* am, AnimObjId parentId);
+		void layoutGlyphs();
 		void reInit(AnimationManagerData* am, AnimObject* obj);
 		void serialize(RawMemory& memory) const;
 		void free();
@@ -60,8 +130,14 @@ namespace MathAnim
 		int32 textLength;
 		HighlighterLanguage language;
 		HighlighterTheme theme;
+		GlyphRun glyphRun;
+		// Key of the last layout in TextLayouts, so edits can reuse it
+		uint64 layoutKey;
+		// Tokens from the last time the code was highlighted, so edits only tokenize
+		// the lines they touch. Created the first time the code is laid out.
+		TokenizedCode* tokens;
 
-		void init(AnimationManagerData* am, AnimObjId parentId);
+		void layoutGlyphs();
 		void reInit(AnimationManagerData* am, AnimObject* obj);
 		void serialize(RawMemory& memory) const;
 		void free();
@@ -35,6 +35,12 @@
 #include <unordered_set>
 #include <regex>
 
+#ifndef _WIN32
+#include <climits>
+// Path buffers are sized with MSVC's max path constant
+#define _MAX_PATH PATH_MAX
+#endif
+
 // GLFW/glad
 #include <glad/glad.h>
 #include <GLFW/glfw3.h>
@@ -7,6 +7,7 @@ namespace MathAnim
 	class GlobalThreadPool;
 	struct OrthoCamera;
 	class SvgCache;
+	struct HeadlessRenderOptions;
 
 	enum class AnimState : uint8
 	{
@@ -17,10 +18,14 @@ namespace MathAnim
 
 	namespace Application
 	{
-		void init(const char* projectFile);
+		void init(const char* projectFile, bool headless = false);
 
 		void run();
 
+		// Renders the requested scene/frame range straight to the output file with no
+		// editor UI. Application must be initialized with headless = true.
+		bool renderHeadless(const HeadlessRenderOptions& options);
+
 		void free();
 
 		float getDeltaTime();
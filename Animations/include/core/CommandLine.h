@@ -0,0 +1,76 @@
+#ifndef MATH_ANIM_COMMAND_LINE_H
+#define MATH_ANIM_COMMAND_LINE_H
+#include "core.h"
+#include "video/RawFrameWriter.h"
+
+namespace MathAnim
+{
+	enum class CommandLineMode : uint8
+	{
+		Editor,
+		HeadlessRender,
+		BenchmarkSvgParser,
+		Invalid,
+	};
+
+	struct HeadlessRenderOptions
+	{
+		// Path to the project.bin file of the project to render
+		std::string projectFile;
+		// Empty means "use the scene that was open when the project was last saved"
+		std::string sceneName;
+		std::string outputFilename;
+		// Inclusive frame range. frameEnd < 0 means "until the last animated frame"
+		int frameStart;
+		int frameEnd;
+
+		// Sharded export. When numWorkers > 1 the frame range is split into shards
+		// that are rendered by separate worker processes and then concatenated.
+		// framesPerShard <= 0 picks a shard size automatically. Shards double as the
+		// checkpoint segments of a single process export.
+		int numWorkers;
+		int framesPerShard;
+		// Used to launch the worker processes
+		std::string executablePath;
+
+		// Render frames that were detected as static holds anyway and make sure they
+		// match the previous frame
+		bool verifyHeldFrames;
+
+		// Checkpointing. Exports are written as segments with a manifest so that resume
+		// can continue an interrupted export. Workers write their shard directly instead.
+		bool useCheckpoints;
+		bool resume;
+
+		// When set, uncompressed frames are streamed to outputFilename (or stdout if it's "-")
+		// for an external encoder instead of being encoded in process
+		RawFrameFormat rawFormat;
+	};
+
+	struct SvgBenchmarkOptions
+	{
+		// Directory of .svg files to parse
+		std::string corpusDir;
+		// Number of times each file gets parsed
+		int iterations;
+	};
+
+	namespace CommandLine
+	{
+		// Parses the command line arguments. If this returns CommandLineMode::HeadlessRender
+		// then `options` will be filled with the requested render settings, and if it returns
+		// CommandLineMode::BenchmarkSvgParser then `benchmarkOptions` will be.
+		//
+		// Usage:
+		//   MathAnimations --render <projectDir> [--scene <name>] [--frames <start>:<end>]
+		//                  [--workers <count>] [--shard-frames <count>] [--verify-holds]
+		//                  [--resume] [--no-checkpoints] [--raw <rgb24|yuv420p|y4m>]
+		//                  --out <file.mp4|pipe|->
+		//   MathAnimations --bench-svg <corpusDir> [--iterations <count>]
+		CommandLineMode parse(int argc, char** argv, HeadlessRenderOptions* options, SvgBenchmarkOptions* benchmarkOptions);
+
+		void printUsage(const char* programName);
+	}
+}
+
+#endif
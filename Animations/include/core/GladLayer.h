@@ -5,7 +5,10 @@ namespace MathAnim
 {
 	namespace GladLayer
 	{
-		void init();
+		// When headless is true no window system is required on Linux. GLFW's null
+		// platform is used with a surfaceless EGL (or OSMesa) context, which also works
+		// on GPU-less machines through Mesa's llvmpipe. Windows uses a hidden window.
+		void init(bool headless = false);
 
 		void deinit();
 	}
@@ -15,6 +15,9 @@ namespace MathAnim
 	{
 		None,
 		OpenMaximized = 0x1,
+		// Never shown on screen, used for headless rendering where we only
+		// need the GL context
+		Hidden = 0x2,
 	};
     
 	struct Window
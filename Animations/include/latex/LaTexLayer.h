@@ -23,6 +23,9 @@ namespace MathAnim
 
 		void update();
 
+		// True while any LaTeX is still queued or being turned into an SVG
+		bool hasPendingWork();
+
 		void free();
 	}
 }
@@ -10,6 +10,8 @@ namespace MathAnim
 	struct GrammarMatch;
 	struct ParserInfo;
 	struct PatternRepository;
+	struct TokenizedCode;
+	struct Grammar;
 
 	struct Capture
 	{
@@ -30,8 +32,8 @@ namespace MathAnim
 		std::optional<ScopeRule> scope;
 		regex_t* regMatch;
 		std::optional<CaptureList> captures;
-
-		bool match(const std::string& str, size_t start, size_t end, const PatternRepository& repo, OnigRegion* region, std::vector<GrammarMatch>* outMatches) const;
+		// The regex uses \G, so where it matches depends on where the search starts
+		bool anchoredToSearchStart;
 
 		void free();
 	};
@@ -42,12 +44,12 @@ namespace MathAnim
 		std::optional<ScopeRule> scope;
 		regex_t* begin;
 		regex_t* end;
+		// The begin regex uses \G, so where it matches depends on where the search starts
+		bool anchoredToSearchStart;
 		std::optional<CaptureList> beginCaptures;
 		std::optional<CaptureList> endCaptures;
 		std::optional<std::vector<SyntaxPattern>> patterns;
 
-		bool match(const std::string& str, size_t start, size_t end, const PatternRepository& repo, OnigRegion* region, std::vector<GrammarMatch>* outMatches) const;
-
 		void free();
 	};
 
@@ -75,8 +77,6 @@ namespace MathAnim
 		std::optional<PatternArray> patternArray;
 		std::optional<std::string> patternInclude;
 
-		bool match(const std::string& str, size_t start, size_t end, const PatternRepository& repo, OnigRegion* region, std::vector<GrammarMatch>* outMatches) const;
-
 		void free();
 	};
 
@@ -85,14 +85,77 @@ namespace MathAnim
 		std::unordered_map<std::string, SyntaxPattern> patterns;
 	};
 
+	struct CompiledCapture
+	{
+		size_t index;
+		const ScopeRule* scope;
+	};
+
+	// A pattern in the grammar's compiled pattern table. The regexes and scopes belong to
+	// the imported patterns, the table only points at them. Includes are resolved while
+	// compiling, so the table only holds simple, complex and array patterns.
+	struct CompiledPattern
+	{
+		PatternType type;
+		// Null if the pattern has no name
+		const ScopeRule* scope;
+		// Simple patterns match with begin
+		regex_t* begin;
+		regex_t* end;
+		bool anchoredToSearchStart;
+		// Range in Grammar::compiledCaptures. These are the begin captures of complex patterns.
+		uint32 firstCapture;
+		uint32 numCaptures;
+		uint32 firstEndCapture;
+		uint32 numEndCaptures;
+		// Range in Grammar::compiledChildren of the patterns in an array, or the patterns
+		// matched between the begin and end of a complex pattern
+		uint32 firstChild;
+		uint32 numChildren;
+	};
+
 	struct GrammarMatch
 	{
 		size_t start;
 		size_t end;
-		ScopeRule scope;
+		// Points into the grammar that made the match
+		const ScopeRule* scope;
 		std::vector<GrammarMatch> subMatches;
 	};
 
+	struct ScannerCandidate
+	{
+		std::vector<GrammarMatch> matches;
+		// The candidate's searches found what they found at or after this offset, so
+		// searching again from anywhere up to here finds the same matches
+		size_t validUntil;
+		bool searched;
+	};
+
+	// Finds which of the top level patterns matches first in a line. Each pattern's result
+	// is kept while the scan moves along the line, and only the patterns whose matches the
+	// scan has moved past are searched again.
+	struct PatternScanner
+	{
+		std::vector<ScannerCandidate> candidates;
+		size_t lineEnd;
+
+		void beginLine(const Grammar* grammar, size_t lineEnd);
+		// Start has to move forward between calls on the same line
+		bool scan(const Grammar* grammar, const std::string& code, size_t start, std::vector<GrammarMatch>* outMatches);
+	};
+
+	struct GrammarLineState
+	{
+		// Byte offset of the first character in the line
+		size_t start;
+		// Where matching picks back up in this line. A begin/end match that started on an
+		// earlier line can run into this line or past it.
+		size_t resume;
+		// Index of the first match in TokenizedCode::matches found on this line or later
+		size_t firstMatch;
+	};
+
 	// This loosely follows the rules set out by TextMate grammars.
 	// More info here: https://macromates.com/manual/en/language_grammars
 	struct Grammar
@@ -104,11 +167,31 @@ namespace MathAnim
 		PatternRepository repository;
 		OnigRegion* region;
 
-		bool getNextMatch(const std::string& code, std::vector<GrammarMatch>* outMatches) const;
+		// The patterns above flattened into tables for matching. The root pattern is an
+		// array of the top level patterns.
+		std::vector<CompiledPattern> compiledPatterns;
+		std::vector<uint32> compiledChildren;
+		std::vector<CompiledCapture> compiledCaptures;
+		uint32 rootPattern;
+
+		mutable PatternScanner scanner;
+
+		// Tokenizes the code one line at a time. If tokens already holds the tokens of an
+		// earlier version of the code, tokenizing starts just before the first edited line and stops
+		// once a line after the edit starts in the same state it did before.
+		void tokenize(const std::string& code, TokenizedCode* tokens) const;
 
 		static Grammar* importGrammar(const char* filepath);
 		static void free(Grammar* grammar);
 	};
+
+	struct TokenizedCode
+	{
+		const Grammar* grammar;
+		std::string code;
+		std::vector<GrammarMatch> matches;
+		std::vector<GrammarLineState> lines;
+	};
 }
 
 #endif 
\ No newline at end of file
@@ -6,6 +6,7 @@ namespace MathAnim
 {
 	struct SyntaxTheme;
 	struct Grammar;
+	struct TokenizedCode;
 
 	enum class HighlighterLanguage : uint8
 	{
@@ -83,6 +84,9 @@ namespace MathAnim
 		SyntaxHighlighter(const std::filesystem::path& grammar);
 
 		CodeHighlights parse(const std::string& code, const SyntaxTheme& theme, bool printDebugInfo = false) const;
+		// Keeps the tokens around between calls, so when the code is edited only the lines
+		// around the edit get tokenized again
+		CodeHighlights parse(const std::string& code, const SyntaxTheme& theme, TokenizedCode* tokens, bool printDebugInfo = false) const;
 
 		void free();
 
@@ -23,6 +23,15 @@ namespace MathAnim
 		std::vector<ThemeSetting> settings;
 	};
 
+	struct ScopeTrieNode
+	{
+		// Index in tokenColors of the first rule with a selector that ends at this node, or -1
+		int32 firstRule;
+		// Same thing for selectors that end at this node or anywhere below it
+		int32 firstRuleBelow;
+		std::unordered_map<std::string, uint32> children;
+	};
+
 	struct SyntaxTheme
 	{
 		TokenRule defaultRule;
@@ -30,6 +39,12 @@ namespace MathAnim
 		Vec4 defaultBackground;
 		std::vector<TokenRule> tokenColors;
 
+		// The selectors of tokenColors in a trie keyed by their dot separated scopes. The
+		// root is the first node.
+		std::vector<ScopeTrieNode> scopeTrie;
+		// What match returned for every scope it was asked about, keyed by the scope's name
+		mutable std::unordered_map<std::string, const TokenRule*> matchCache;
+
 		const TokenRule* match(const ScopeRule& scope) const;
 
 		static SyntaxTheme* importTheme(const char* filepath);
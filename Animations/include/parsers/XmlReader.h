@@ -0,0 +1,100 @@
+#ifndef MATH_ANIM_XML_READER_H
+#define MATH_ANIM_XML_READER_H
+#include "core.h"
+
+namespace MathAnim
+{
+	// A piece of the document the reader was given, nothing gets copied out of it.
+	// Entity references like &amp; are left as they are, see XmlReader::unescape.
+	struct XmlSlice
+	{
+		const char* text;
+		size_t length;
+
+		bool equals(const char* str) const;
+		std::string toString() const;
+		// Returns false if the slice isn't a number, surrounding whitespace is allowed
+		bool toFloat(float* out) const;
+	};
+
+	struct XmlAttribute
+	{
+		XmlSlice name;
+		XmlSlice value;
+	};
+
+	enum class XmlEventType : uint8
+	{
+		StartElement,
+		EndElement,
+		// Character data between tags, entity references aren't expanded
+		Text,
+		// Contents of a <![CDATA[ ]]> section
+		CData,
+		EndOfDocument,
+		Error
+	};
+
+	// Single pass pull parser. Every call to next() reads up to the next tag or run of
+	// text and hands out slices of the document, so reading doesn't build anything up
+	// in memory. The document has to outlive the slices.
+	//
+	// Comments, processing instructions and the DOCTYPE are skipped. Self closing
+	// elements are reported as a StartElement immediately followed by an EndElement.
+	class XmlReader
+	{
+	public:
+		XmlReader(const char* document, size_t documentLength);
+
+		XmlEventType next();
+
+		// Name of the element that just started or ended
+		inline const XmlSlice& name() const { return elementName; }
+		// Attributes of the element that just started
+		inline const std::vector<XmlAttribute>& attributes() const { return elementAttributes; }
+		const XmlSlice* findAttribute(const char* attributeName) const;
+		// Contents of the Text or CData event that was just read
+		inline const XmlSlice& text() const { return textSlice; }
+		// Depth of the element that just started or ended, the root element is at depth 1
+		inline int depth() const { return elementDepth; }
+
+		// Reads past the rest of the element that just started, up to and including
+		// its end tag
+		bool skipElement();
+
+		// Message and line of the error once next() returns Error
+		inline const std::string& getError() const { return error; }
+		int getErrorLine() const;
+
+		// Expands the entity and character references in slice
+		static std::string unescape(const XmlSlice& slice);
+
+	private:
+		XmlEventType readTag();
+		XmlEventType readStartTag();
+		XmlEventType readEndTag();
+		bool skipPast(const char* terminator);
+		bool skipDeclaration();
+		XmlSlice readName();
+		void skipWhitespace();
+		XmlEventType fail(const char* message);
+
+	private:
+		const char* document;
+		size_t documentLength;
+		size_t cursor;
+		size_t errorCursor;
+
+		XmlSlice elementName;
+		std::vector<XmlAttribute> elementAttributes;
+		XmlSlice textSlice;
+		int elementDepth;
+		// Names of the elements that haven't been closed yet
+		std::vector<XmlSlice> openElements;
+		bool pendingEndElement;
+
+		std::string error;
+	};
+}
+
+#endif
@@ -4,16 +4,31 @@
 
 namespace MathAnim
 {
+	struct MemoryMappedFile
+	{
+		const uint8* data;
+		size_t dataSize;
+		void* fileHandle;
+		void* mappingHandle;
+	};
+
 	namespace Platform
 	{
 		const std::vector<std::string>& getAvailableFonts();
 
+		// Monospaced font that ships with the OS, used for code blocks
+		const char* getDefaultMonoFontPath();
+
 		bool isProgramInstalled(const char* displayName);
 
 		bool getProgramInstallDir(const char* programDisplayName, char* buffer, size_t bufferLength);
 
 		bool executeProgram(const char* programFilepath, const char* cmdLineArgs = nullptr, const char* workingDirectory = nullptr, const char* executionOutputFilename = nullptr);
 
+		// Unlike executeProgram this has no timeout, the child shares this process's
+		// stdout/stderr and its exit code is written to exitCode
+		bool executeProgramAndWait(const char* programFilepath, const char* cmdLineArgs, int* exitCode);
+
 		bool openFileWithDefaultProgram(const char* filepath);
 
 		bool openFileWithVsCode(const char* filepath, int lineNumber = -1);
@@ -33,6 +48,18 @@ namespace MathAnim
 		std::string md5FromString(const char* str, size_t length, int md5Length = 16);
 
 		std::string md5FromString(const std::string& str, int md5Length = 16);
+
+		// Maps the whole file into memory read only. Returns nullptr if the file can't be
+		// opened or is empty.
+		MemoryMappedFile* memoryMapFile(const char* filename);
+
+		void unmapFile(MemoryMappedFile* file);
+
+		// Takes an exclusive lock on the file, creating it if needed. The lock goes away
+		// with the process, so a crash never leaves it stuck.
+		void* tryLockFile(const char* filename);
+
+		void unlockFile(void* lock);
 	}
 }
 
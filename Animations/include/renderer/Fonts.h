@@ -2,10 +2,30 @@
 #define MATH_ANIM_FONTS_H
 #include "core.h"
 #include "renderer/Texture.h"
+#include "utils/RectPacker.h"
 
 namespace MathAnim
 {
 	struct SvgObject;
+	struct SdfAtlasJob;
+	struct FontLoadJob;
+	struct MemoryMappedFile;
+
+	enum class FontAtlasMode : uint8
+	{
+		// Every size gets its own texture with glyphs rasterized by freetype
+		Bitmap = 0,
+		// Every size draws from the font's shared signed distance field atlas
+		DistanceField,
+	};
+
+	enum class FontLoadState : uint8
+	{
+		Loading = 0,
+		Loaded,
+		// The font couldn't be read, it acts like a font without any glyphs
+		Failed,
+	};
 
 	struct CharRange
 	{
@@ -13,6 +33,7 @@ namespace MathAnim
 		uint32 lastCharCode;
 
 		static CharRange Ascii;
+		static CharRange None;
 	};
 
 	struct GlyphOutline
@@ -26,20 +47,70 @@ namespace MathAnim
 		float glyphHeight;
 
 		void free();
+		// Glyphs without a size, like spaces, have nothing to draw
+		inline bool hasGeometry() const { return svg != nullptr && glyphWidth > 0.0f && glyphHeight > 0.0f; }
+	};
+
+	struct SdfGlyph
+	{
+		Vec2 uvMin;
+		Vec2 uvMax;
+		// Corners of the glyph's quad in em units, relative to the top left of the
+		// glyph. The quad is bigger than the glyph so the edges can fade out.
+		Vec2 planeMin;
+		Vec2 planeMax;
+	};
+
+	// Signed distance fields of a font's glyphs generated from their outlines. Since
+	// a distance field stays sharp when it's scaled, one atlas serves every size.
+	struct SdfFontAtlas
+	{
+		Texture texture;
+		std::unordered_map<uint32, SdfGlyph> glyphs;
+		// Glyphs only ever get added, new ones are placed around the old ones and the
+		// atlas grows when they don't fit
+		SkylinePacker packer;
+		// Copy of the texture, the whole atlas gets written to the disk cache
+		uint8* pixels;
+		int width;
+		int height;
+		// Set while the new glyphs are being generated on the worker threads
+		SdfAtlasJob* pendingJob;
+		// Font::numVisibleOutlines when the atlas was last updated. Outlines are created
+		// lazily, so the atlas gets the new glyphs added when this falls behind.
+		int numSourceGlyphs;
+		bool isReady;
 	};
 
 	struct Font
 	{
 		FT_Face fontFace;
+		// The face reads the font file straight out of this mapping. Every SizedFont of
+		// this font goes through unsizedFont, so they all share the face and the mapping.
+		MemoryMappedFile* fileData;
 		std::unordered_map<uint32, GlyphOutline> glyphMap;
+		// Outlines in glyphMap that have geometry
+		int numVisibleOutlines;
 		std::string fontFilepath;
 		float unitsPerEM;
 		float lineHeight;
-
-		const GlyphOutline& getGlyphInfo(uint32 glyphIndex) const;
-		float getKerning(uint32 leftCodepoint, uint32 rightCodepoint) const;
-		glm::vec2 getSizeOfString(const std::string& string) const;
-		glm::vec2 getSizeOfString(const std::string& string, int fontSizePixels) const;
+		SdfFontAtlas sdfAtlas;
+		// Kerning between pairs of codepoints, the left codepoint is in the high bits
+		std::unordered_map<uint64, float> kerningPairs;
+		bool hasKerning;
+		FontLoadState loadState;
+		// Set while the font is being loaded on the worker threads
+		FontLoadJob* pendingLoad;
+
+		// Creates the outline the first time a codepoint is requested. Codepoints the
+		// font doesn't have get an outline without an svg. Waits for the font if it's
+		// still loading, like getKerning does.
+		const GlyphOutline& getGlyphInfo(uint32 codepoint);
+		// In em units
+		float getKerning(uint32 leftCodepoint, uint32 rightCodepoint);
+		// Strings are UTF-8 encoded. The width is the width of the longest line.
+		glm::vec2 getSizeOfString(const std::string& string);
+		glm::vec2 getSizeOfString(const std::string& string, int fontSizePixels);
 	};
 
 	struct GlyphTexture
@@ -47,6 +118,14 @@ namespace MathAnim
 		uint32 lruCacheId;
 		Vec2 uvMin;
 		Vec2 uvMax;
+		// Index in SizedFont::pages, -1 for glyphs without a bitmap like spaces
+		int page;
+	};
+
+	struct GlyphAtlasPage
+	{
+		Texture texture;
+		SkylinePacker packer;
 	};
 
 	struct SizedFont
@@ -54,10 +133,14 @@ namespace MathAnim
 		Font* unsizedFont;
 		std::unordered_map<uint32, GlyphTexture> glyphTextureCoords;
 		int fontSizePixels;
-		Texture texture;
-
-		const GlyphTexture& getGlyphTexture(uint32 codepoint) const;
-		inline const GlyphOutline& getGlyphInfo(uint32 glyphIndex) const { g_logger_assert(unsizedFont != nullptr, "How did this happen."); return unsizedFont->getGlyphInfo(glyphIndex); }
+		FontAtlasMode atlasMode;
+		// Only used in bitmap mode, distance field fonts draw from unsizedFont->sdfAtlas.
+		// A new page is added whenever the glyphs don't fit in the existing ones.
+		std::vector<GlyphAtlasPage> pages;
+
+		// Rasterizes the glyph the first time it's requested
+		const GlyphTexture& getGlyphTexture(uint32 codepoint);
+		inline const GlyphOutline& getGlyphInfo(uint32 codepoint) const { g_logger_assert(unsizedFont != nullptr, "How did this happen."); return unsizedFont->getGlyphInfo(codepoint); }
 		inline float getKerning(uint32 leftCodepoint, uint32 rightCodepoint) const { g_logger_assert(unsizedFont != nullptr, "How did this happen."); return unsizedFont->getKerning(leftCodepoint, rightCodepoint); }
 		inline glm::vec2 getSizeOfString(const std::string& string) const { g_logger_assert(unsizedFont != nullptr, "How did this happen."); return unsizedFont->getSizeOfString(string, fontSizePixels); }
 	};
@@ -69,11 +152,15 @@ namespace MathAnim
 		// Returns a non-zero value if creating the outline fails
 		int createOutline(Font* font, uint32 character, GlyphOutline* outlineResult);
 
-		// Loads a sized font if it is not already loaded and creates
-		// a texture with the default charset.
+		// Loads a sized font if it is not already loaded. Glyphs are
+		// rasterized the first time they're drawn, defaultCharset only
+		// decides which outlines the unsized font creates up front.
 		// If the font is already loaded, it just increments
 		// a reference count and returns the font.
-		SizedFont* loadSizedFont(const char* filepath, int fontSizePixels, CharRange defaultCharset = CharRange::Ascii);
+		//
+		// Distance field fonts don't create a texture of their own, they
+		// start generating the font's shared atlas instead.
+		SizedFont* loadSizedFont(const char* filepath, int fontSizePixels, CharRange defaultCharset = CharRange::None, FontAtlasMode atlasMode = FontAtlasMode::Bitmap);
 
 		// Decreases a reference count to the font
 		// If the reference count goes below 0, the 
@@ -83,17 +170,31 @@ namespace MathAnim
 		// Decreases a reference count to the font
 		// If the reference count goes below 0, the 
 		// font is fully unloaded
-		void unloadSizedFont(const char* filepath, int fontSizePixels);
+		void unloadSizedFont(const char* filepath, int fontSizePixels, FontAtlasMode atlasMode = FontAtlasMode::Bitmap);
 
 		// Decreases a reference count to the font
 		// If the reference count goes below 0, the 
 		// font is fully unloaded
 		void unloadFont(const char* filepath);
 
-		// Loads a font if it is not already loaded.
+		// Loads a font if it is not already loaded. Outlines in
+		// defaultCharset are created up front, the rest are created
+		// the first time they're requested.
 		// If the font is already loaded, it just increments
 		// a reference count and returns the font.
-		Font* loadFont(const char* filepath, CharRange defaultCharset = CharRange::Ascii);
+		Font* loadFont(const char* filepath, CharRange defaultCharset = CharRange::None);
+
+		// Same as loadFont, except the font is loaded on the worker threads and
+		// this returns right away. The outlines in defaultCharset are extracted
+		// in parallel. Use isFontReady or waitUntilFontReady before reading the
+		// font's metrics. The font may fail to load after this returns, in which
+		// case its loadState is Failed and it doesn't have any glyphs.
+		Font* loadFontAsync(const char* filepath, CharRange defaultCharset = CharRange::None);
+
+		// Returns true once the font is done loading, whether it failed or not.
+		// Must be called from the main thread.
+		bool isFontReady(Font* font);
+		void waitUntilFontReady(Font* font);
 
 		// Decreases a reference count to the font
 		// If the reference count goes below 0, the 
@@ -110,6 +211,12 @@ namespace MathAnim
 		void unloadAllFonts();
 
 		Font* getDefaultMonoFont();
+
+		// Returns the font's distance field atlas. The first call loads it
+		// from the disk cache, or starts generating it on the worker threads
+		// if it isn't cached yet. Returns nullptr while it's being generated
+		// unless waitUntilReady is set. Must be called from the main thread.
+		const SdfFontAtlas* getSdfAtlas(Font* font, bool waitUntilReady = false);
 	}
 }
 
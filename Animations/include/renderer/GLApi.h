@@ -30,6 +30,7 @@ namespace MathAnim
 		void renderbufferStorage(GLenum target, GLenum internalformat, GLsizei width, GLsizei height);
 		void framebufferRenderbuffer(GLenum target, GLenum attachment, GLenum renderbuffertarget, GLuint renderbuffer);
 		GLenum checkFramebufferStatus(GLenum target);
+		void blitFramebuffer(GLint srcX0, GLint srcY0, GLint srcX1, GLint srcY1, GLint dstX0, GLint dstY0, GLint dstX1, GLint dstY1, GLbitfield mask, GLenum filter);
 
 		// Vaos
 		void bindVertexArray(GLuint array);
@@ -96,6 +97,7 @@ namespace MathAnim
 		void clear(GLbitfield mask);
 		void depthMask(GLboolean flag);
 		void viewport(GLint x, GLint y, GLsizei width, GLsizei height);
+		void scissor(GLint x, GLint y, GLsizei width, GLsizei height);
 		void lineWidth(GLfloat width);
 		void polygonMode(GLenum face, GLenum mode);
 
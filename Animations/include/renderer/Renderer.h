@@ -47,7 +47,7 @@ namespace MathAnim
 		void pushColor(const glm::vec4& color);
 		void pushColor(const Vec4& color);
 		void pushLineEnding(CapType lineEnding);
-		void pushFont(const SizedFont* sizedFont);
+		void pushFont(SizedFont* sizedFont);
 		Vec4 getColor();
 
 		void popStrokeWidth(int numToPop = 1);
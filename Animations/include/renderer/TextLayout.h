@@ -0,0 +1,66 @@
+#ifndef MATH_ANIM_TEXT_LAYOUT_H
+#define MATH_ANIM_TEXT_LAYOUT_H
+#include "core.h"
+
+namespace MathAnim
+{
+	struct Font;
+	struct GlyphOutline;
+
+	struct LayoutGlyph
+	{
+		uint32 codepoint;
+		// Byte offset of the codepoint in the UTF-8 text
+		uint32 textOffset;
+		// Pen position on the baseline, y grows downwards one line height per line
+		Vec2 position;
+		float advance;
+		// Null for line breaks
+		const GlyphOutline* outline;
+	};
+
+	struct TextLayoutLine
+	{
+		uint32 firstGlyph;
+		// Includes the line break that ends the line, if there is one
+		uint32 numGlyphs;
+		float width;
+	};
+
+	// Positioned glyphs for a string. Every codepoint in the text gets a glyph, including
+	// whitespace and line breaks, so glyphs can be mapped back to the text they came from.
+	struct TextLayout
+	{
+		uint64 key;
+		const Font* font;
+		float fontSize;
+		float lineHeight;
+		std::string text;
+		std::vector<LayoutGlyph> glyphs;
+		std::vector<TextLayoutLine> lines;
+		// Width of the longest line by the height of all the lines
+		Vec2 size;
+	};
+
+	// Lays out text with kerning and line breaks, and caches the results keyed by the font,
+	// size and text. When the text was laid out before an edit, pass the old layout's key
+	// and only the part of the text that changed gets laid out again.
+	namespace TextLayouts
+	{
+		// Tabs are as wide as this many spaces
+		constexpr int tabDepth = 2;
+
+		// Positions are in em units scaled by fontSize. The layout belongs to the cache and
+		// is only valid until the next call into TextLayouts.
+		const TextLayout* layout(Font* font, float fontSize, const char* text, size_t textLength, uint64 previousKey = 0);
+		const TextLayout* layout(Font* font, float fontSize, const std::string& text, uint64 previousKey = 0);
+
+		// Layouts point into the font's glyphs, so they have to go when the font does
+		void evictFont(const Font* font);
+		void clear();
+
+		int getNumCachedLayouts();
+	}
+}
+
+#endif
@@ -29,6 +29,9 @@ namespace MathAnim
 		RG32_UI,
 		R8_UI,
 		R8_F,
+		// Single 8 bit channel that samples as a normalized float, so unlike R8_UI it
+		// can be filtered
+		R8_UNORM,
 	};
 
 	enum class ColorChannel
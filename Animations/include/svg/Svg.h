@@ -54,35 +54,77 @@ namespace MathAnim
 			Bezier3 bezier3;
 		} as;
 
+		// Arc length is measured along a polyline through this many evenly spaced
+		// points of the curve
+		static constexpr int numArcLengthSamples = 4;
+
+		// Writes the length from p0 to the end of each sample, so outLengths needs
+		// room for numArcLengthSamples floats and the last one is the whole curve
+		void calculateArcLengths(float* outLengths) const;
 		float calculateApproximatePerimeter() const;
 		Curve split(float t0, float t1) const;
 	};
 
 	struct Path
 	{
-		Curve* curves;
+		// Range of the path's curves in SvgObject::curveTypes
+		int firstCurve;
 		int numCurves;
-		int maxCapacity;
+		// Index of the point the path starts at in SvgObject::points
+		int firstPoint;
 		bool isHole;
-
-		float calculateApproximatePerimeter() const;
 	};
 
 	struct SvgObject
 	{
+		// Every array below lives in this one allocation. Curves are a verb stream
+		// (curveTypes) plus a packed point stream: a path stores its start point, then
+		// each curve adds 1 point for a line, 2 for a quadratic and 3 for a cubic. A
+		// curve's p0 is always the point right before its own points.
+		//
+		// Arenas are refcounted so objects can share geometry through Svg::share.
+		// Anything that writes to a shared arena copies it first.
+		uint8* arena;
 		Path* paths;
+		Vec2* points;
+		// Index in points of the first point after p0, one per curve
+		int* curvePointOffsets;
+		// Curve::numArcLengthSamples per curve, each one is the outline's length from
+		// the start of the first path to the end of that sample. Only valid after
+		// calculateApproximatePerimeter.
+		float* arcLengths;
+		CurveType* curveTypes;
 		int numPaths;
+		int numCurves;
+		int numPoints;
+		int maxPaths;
+		int maxCurves;
+		int maxPoints;
 		float approximatePerimeter;
 		BBox bbox;
 		Vec2 _cursor;
 		Vec4 fillColor;
 		FillType fillType;
+		// Hash of the curves and fill rule, identical shapes get identical hashes no
+		// matter which object they belong to
+		uint64 geometryHash;
+
+		// Unpacks a curve from the streams, for code that still works with Curves
+		Curve getCurve(int pathi, int curvei) const;
+		const Vec2& getPathStart(int pathi) const;
 
 		void normalize();
 		void calculateApproximatePerimeter();
+		// Also refreshes geometryHash, every edit to the curves finishes with this call
 		void calculateBBox();
-		void render(const AnimObject* parent, const Texture& texture, const Vec2& textureOffset) const;
+		void calculateGeometryHash();
+		// Fills the SVG in white at rasterScale pixels per SVG unit and returns the RGBA
+		// pixels, top row first. Only reads the SVG, so it's safe to call from worker
+		// threads as long as nothing modifies it at the same time. Free the pixels with
+		// g_memory_free.
+		uint8* rasterize(float rasterScale, int* outWidth, int* outHeight) const;
 		void renderOutline(float t, const AnimObject* parent) const;
+		void renderOutline(float t, const glm::mat4& transform, const glm::u8vec4& strokeColor, float strokeWidth) const;
 		void free();
 
 		void serialize(RawMemory& memory) const;
@@ -105,10 +147,39 @@ namespace MathAnim
 		void free();
 	};
 
+	// Curve correspondence between two shapes for replacement transforms. Both shapes
+	// get split into the same number of paths and curves, then stored as cubic control
+	// points with matching layouts, so blending them is a single lerp over two flat
+	// float arrays.
+	struct SvgMorph
+	{
+		uint64 srcGeometryHash;
+		uint64 dstGeometryHash;
+		FillType srcFillType;
+		FillType dstFillType;
+
+		int numPaths;
+		// Cubics in each path, not counting the line that closes it
+		int* pathNumCurves;
+		bool* srcIsHole;
+		bool* dstIsHole;
+
+		// Each path is its start point followed by p1, p2, p3 of every cubic, stored
+		// as x, y pairs
+		int numFloats;
+		float* srcPoints;
+		float* dstPoints;
+		// Scratch space the blended points are written to
+		float* points;
+
+		void free();
+	};
+
 	namespace Svg
 	{
 		SvgObject createDefault();
 		SvgGroup createDefaultGroup();
+		SvgMorph createDefaultMorph();
 
 		void init();
 
@@ -133,8 +204,32 @@ namespace MathAnim
 		// Manually add a curve
 		void addCurveManually(SvgObject* object, const Curve& curve);
 
+		// Copies the streams along with src's bbox, perimeter and hash, so src needs
+		// to be up to date. Only allocates when dest doesn't have room yet.
 		void copy(SvgObject* dest, const SvgObject* src);
+		// Like copy, except dest references src's geometry instead of copying it. The
+		// refcount isn't atomic, so only share on the main thread and give worker
+		// threads their own copy.
+		void share(SvgObject* dest, const SvgObject* src);
+		// Copies object's geometry if anything else shares it. Call this before writing
+		// to the streams directly.
+		void makeArenaUnique(SvgObject* object);
+		// Works out which curves of src turn into which curves of dst. This is the
+		// expensive part of interpolating, so do it once per pair of shapes. Returns
+		// false if either shape is empty.
+		bool prepareMorph(SvgMorph* morph, const SvgObject* src, const SvgObject* dst);
+		// True if morph was prepared for these exact shapes
+		bool morphMatches(const SvgMorph& morph, const SvgObject* src, const SvgObject* dst);
+		// Writes the shape t of the way through the morph into dest. dest keeps its
+		// memory between calls, so this doesn't allocate once dest is big enough.
+		void morph(SvgMorph& morph, float t, SvgObject* dest);
+		// One off version of prepareMorph + morph that returns a new object
 		SvgObject* interpolate(const SvgObject* src, const SvgObject* dst, float t);
+
+		// Finds where the outline is length units in, given cumulative arc lengths
+		// laid out like SvgObject::arcLengths. Lengths past the end give the end of
+		// the last curve.
+		void findCurveAtLength(const float* arcLengths, int numCurves, float length, int* outCurve, float* outT);
 	}
 }
 
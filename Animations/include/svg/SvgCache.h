@@ -3,6 +3,8 @@
 #include "core.h"
 #include "renderer/Framebuffer.h"
 #include "utils/LRUCache.hpp"
+#include "utils/RectPacker.h"
+#include "svg/SvgDiskCache.h"
 
 namespace MathAnim
 {
@@ -11,6 +13,7 @@ namespace MathAnim
 	struct Texture;
 	struct AnimationManagerData;
 	struct AnimObject;
+	struct SvgRasterJob;
 
 	struct SvgCacheEntry
 	{
@@ -24,63 +27,127 @@ namespace MathAnim
 		Vec2 texCoordsMin;
 		Vec2 texCoordsMax;
 		Vec2 svgSize;
-		Vec2 allottedSize;
-		Vec2 textureOffset;
+		// Rect reserved in the page including padding, the SVG sits in its top left corner
+		PackedRect allottedRect;
 		int colorAttachment;
 	};
 
+	struct SvgCachePageStats
+	{
+		float occupancy;
+		float fragmentation;
+		int numEntries;
+		uint64 numEvictions;
+		uint64 numDefragmentations;
+	};
+
 	class SvgCache
 	{
 	public:
 		SvgCache() :
 			cachedSvgs(),
+			pages(),
+			pageStats(),
+			pageNeedsDefrag(),
 			framebuffer(),
-			cacheCurrentPos(Vec2{ 0, 0 }),
-			cacheCurrentColorAttachment(0),
-			cacheLineHeight(0.0f)
+			defragFramebuffer(),
+			pendingRasters(),
+			lastShownRaster(),
+			diskCache()
 		{
 		}
 
 		void init();
 		void free();
 
+		// Rasters that miss in memory are looked up in this directory before they get
+		// rasterized, and new rasters are saved there for the next session
+		void openDiskCache(const std::string& directory);
+		SvgDiskCache& getDiskCache();
+
 		bool exists(AnimationManagerData* am, AnimObjId obj);
 
 		SvgCacheEntry get(AnimationManagerData* am, AnimObjId obj);
 		SvgCacheEntry getOrCreateIfNotExist(AnimationManagerData* am, SvgObject* svg, AnimObjId obj);
+		// For SVGs that get drawn on behalf of parent without being its svgObject, like
+		// the glyphs of a text object. They're rasterized at parent's resolution.
+		SvgCacheEntry getOrCreateIfNotExist(AnimationManagerData* am, const AnimObject* parent, SvgObject* svg);
 
-		void put(const AnimObject* parent, SvgObject* svg);
+		// Rasterizes synchronously
+		void put(const AnimObject* parent, SvgObject* svg, int rasterLevel);
 		void clearAll();
 
+		// Starts rasterizing the object's SVG on the thread pool if it isn't cached yet.
+		// Prefetching everything a frame needs before drawing any of it lets all the misses
+		// rasterize in parallel.
+		void prefetch(AnimationManagerData* am, const AnimObject* obj);
+		void prefetch(AnimationManagerData* am, const AnimObject* parent, const SvgObject* svg);
+		// Uploads rasters that finished on worker threads since the last update
+		void update();
+		bool hasPendingWork() const;
+
 		void render(AnimationManagerData* am, SvgObject* svg, AnimObjId obj);
 
+		// Repacks at most one badly fragmented page. Call this once per frame after the
+		// draw calls have been flushed, since it moves entries around in the texture.
+		void defragmentStep();
+
 		const Framebuffer& getFramebuffer();
+		int getNumPages() const;
+		SvgCachePageStats getPageStats(int page) const;
 
 	public:
 		static Vec2 cachePadding;
+		static bool backgroundDefragmentation;
 
 	private:
-		void incrementCacheCurrentY();
-		void incrementCacheCurrentX(float distance);
-		//const Vec2& getCacheCurrentPos();
-		void checkLineHeight(float newLineHeight);
-		void growCache();
+		bool allocate(int32 width, int32 height, PackedRect* outRect, int* outPage);
+		// Returns the page the evicted SVG was on, or -1 if the cache is empty
+		int evictOldest();
+		void clearRect(int page, const PackedRect& rect);
+		void defragmentPage(int page);
+		void updateTexCoords(_SvgCacheEntryInternal& entry) const;
+
+		void insertRaster(uint64 key, const uint8* pixels, int width, int height, const Vec2& svgSize);
+		bool loadFromDisk(uint64 key);
+		SvgRasterJob* queueRaster(const AnimObject* parent, const SvgObject* svg, int rasterLevel, uint64 key);
+		bool isRasterDone(SvgRasterJob* job) const;
+		void waitForRaster(SvgRasterJob* job) const;
+		void finishRaster(SvgRasterJob* job);
+		void abandonPendingRasters();
+		// Falls back to the raster lastShownId was drawn with last while the new one is
+		// pending. Pass NULL_ANIM_OBJECT for SVGs that aren't tracked per object.
+		std::optional<_SvgCacheEntryInternal> findOrRasterize(AnimationManagerData* am, const AnimObject* parent, SvgObject* svg, AnimObjId lastShownId, uint64* outKey);
+		std::optional<_SvgCacheEntryInternal> getPlaceholder(const AnimObject* parent, SvgObject* svg, int rasterLevel, AnimObjId lastShownId, uint64* outKey);
+
+		std::optional<_SvgCacheEntryInternal> findRaster(AnimationManagerData* am, const AnimObject* parent, const SvgObject* svg, uint64* outKey);
+		int getRasterLevel(AnimationManagerData* am, const AnimObject* parent, const SvgObject* svg) const;
+		static float getRasterScale(float svgScale, int rasterLevel);
 
 		std::optional<_SvgCacheEntryInternal> getInternal(uint64 hash);
 		bool existsInternal(uint64 hash);
 
 		void generateDefaultFramebuffer(uint32 width, uint32 height);
 
-		uint64 hash(AnimObjId obj, float svgScale, float replacementTransform);
+		uint64 hash(const SvgObject* svg, float svgScale, int rasterLevel);
 
 	private:
-		std::vector<LRUCache<uint64, _SvgCacheEntryInternal>> cachedSvgs;
+		// One LRU across all pages so the globally least recently used SVG gets evicted first
+		LRUCache<uint64, _SvgCacheEntryInternal> cachedSvgs;
+		std::vector<RectPacker> pages;
+		std::vector<SvgCachePageStats> pageStats;
+		std::vector<bool> pageNeedsDefrag;
 		Framebuffer framebuffer;
-	public:
-		Vec2 cacheCurrentPos;
-	private:
-		int cacheCurrentColorAttachment;
-		float cacheLineHeight;
+		// Scratch page used to copy entries out while a page is being repacked
+		Framebuffer defragFramebuffer;
+
+		// Rasters being rendered on worker threads, keyed like the cache entries. Objects
+		// with the same geometry share a job.
+		std::unordered_map<uint64, SvgRasterJob*> pendingRasters;
+		// The entry each object was drawn with last, shown while its new raster is pending
+		std::unordered_map<AnimObjId, uint64> lastShownRaster;
+
+		SvgDiskCache diskCache;
 	};
 }
 
@@ -0,0 +1,103 @@
+#ifndef MATH_ANIM_SVG_DISK_CACHE_H
+#define MATH_ANIM_SVG_DISK_CACHE_H
+#include "core.h"
+
+namespace MathAnim
+{
+	struct MemoryMappedFile;
+
+	struct SvgDiskCacheEntry
+	{
+		uint64 key;
+		uint32 page;
+		uint32 width;
+		uint32 height;
+		Vec2 svgSize;
+		// Byte offset of the RGBA pixels in the page file
+		uint64 offset;
+		// Session the entry was last read or written in
+		uint64 lastUsed;
+	};
+
+	struct SvgDiskCachePage
+	{
+		uint32 id;
+		uint64 size;
+		uint64 lastUsed;
+		// Sealed pages are mapped the first time something is read from them
+		MemoryMappedFile* mapping;
+	};
+
+	// Keeps rasterized SVGs around between sessions. Rasters are appended to page files
+	// under the project's cache directory and an index maps cache keys to where their
+	// pixels live. Pages from earlier sessions are read through memory mapped views.
+	// When the cache grows past sizeBudget, the least recently used pages get deleted.
+	//
+	// Only one process at a time can write to the cache. Any others that open the same
+	// directory get read only access. A sharded export closes the cache in the
+	// coordinator, so the first worker to start becomes the writer.
+	class SvgDiskCache
+	{
+	public:
+		SvgDiskCache() :
+			directory(),
+			entries(),
+			pages(),
+			scratchPixels(),
+			lock(nullptr),
+			writeFile(nullptr),
+			writePage(-1),
+			nextPageId(0),
+			session(0),
+			indexDirty(false)
+		{
+		}
+
+		void open(const std::string& directory);
+		// Writes the index and releases the page files
+		void close();
+		bool isOpen() const;
+		bool isReadOnly() const;
+
+		// Returns the RGBA pixels stored for key, or nullptr if there aren't any. The
+		// pointer is only valid until the next call that modifies the cache.
+		const uint8* find(uint64 key, int* outWidth, int* outHeight, Vec2* outSvgSize);
+		void store(uint64 key, const uint8* pixels, int width, int height, const Vec2& svgSize);
+
+		// Deletes the least recently used pages until the cache fits in budget bytes
+		void trim(uint64 budget);
+		void clear();
+
+		uint64 getSizeOnDisk() const;
+		int getNumEntries() const;
+
+	public:
+		static uint64 sizeBudget;
+
+	private:
+		bool loadIndex();
+		bool saveIndex();
+		void deleteOrphanedPages();
+
+		int findPage(uint32 id) const;
+		void sealWritePage();
+		void deletePage(int pageIndex);
+		std::string pageFilename(uint32 id) const;
+
+	private:
+		std::string directory;
+		std::unordered_map<uint64, SvgDiskCacheEntry> entries;
+		std::vector<SvgDiskCachePage> pages;
+		// Holds pixels read from the page that's still being written to
+		std::vector<uint8> scratchPixels;
+
+		void* lock;
+		FILE* writeFile;
+		int writePage;
+		uint32 nextPageId;
+		uint64 session;
+		bool indexDirty;
+	};
+}
+
+#endif
@@ -0,0 +1,18 @@
+#ifndef MATH_ANIM_SVG_PARSER_BENCHMARK_H
+#define MATH_ANIM_SVG_PARSER_BENCHMARK_H
+#include "core.h"
+
+namespace MathAnim
+{
+	struct SvgBenchmarkOptions;
+
+	namespace SvgParserBenchmark
+	{
+		// Runs SvgParser::parseSvgDoc on every .svg file in options.corpusDir
+		// options.iterations times and logs the min and median time and the throughput
+		// per file. Returns false if the corpus is empty or any file fails to parse.
+		bool run(const SvgBenchmarkOptions& options);
+	}
+}
+
+#endif
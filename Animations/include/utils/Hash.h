@@ -0,0 +1,18 @@
+#ifndef MATH_ANIM_HASH_H
+#define MATH_ANIM_HASH_H
+#include "core.h"
+
+namespace MathAnim
+{
+	namespace Hash
+	{
+		// Starting value for a 64-bit FNV-1a hash
+		constexpr uint64 fnvOffsetBasis = 14695981039346656037ULL;
+
+		// Mixes size bytes of data into hash with 64-bit FNV-1a. Pass the result of one
+		// call into the next to hash several buffers as if they were one.
+		uint64 fnv1a(const void* data, size_t size, uint64 hash = fnvOffsetBasis);
+	}
+}
+
+#endif
@@ -35,6 +35,12 @@ namespace MathAnim
 					return entry->data;
 				}
 
+				// Promoting the oldest entry makes the next one the oldest
+				if (entry == oldestEntry)
+				{
+					oldestEntry = entry->next;
+				}
+
 				// Update the surrounding nodes in the doubly linked list
 				if (entry->next)
 				{
@@ -137,6 +143,7 @@ namespace MathAnim
 
 		inline LRUCacheEntry<Key, Value>* getOldest() { return oldestEntry; }
 		inline LRUCacheEntry<Key, Value>* getNewest() { return newestEntry; }
+		inline size_t size() const { return indexLookup.size(); }
 
 		void clear()
 		{
@@ -154,8 +161,8 @@ namespace MathAnim
 
 	private:
 		std::unordered_map<Key, LRUCacheEntry<Key, Value>*> indexLookup;
-		LRUCacheEntry<Key, Value>* oldestEntry;
-		LRUCacheEntry<Key, Value>* newestEntry;
+		LRUCacheEntry<Key, Value>* oldestEntry = nullptr;
+		LRUCacheEntry<Key, Value>* newestEntry = nullptr;
 	};
 }
 
@@ -0,0 +1,77 @@
+#ifndef MATH_ANIM_RECT_PACKER_H
+#define MATH_ANIM_RECT_PACKER_H
+#include "core.h"
+
+namespace MathAnim
+{
+	struct PackedRect
+	{
+		int32 x;
+		int32 y;
+		int32 width;
+		int32 height;
+	};
+
+	// MaxRects bin packer for a single atlas page. The free space is tracked as a list
+	// of maximal free rectangles, which may overlap each other but never overlap an
+	// allocated rectangle. Rectangles can be released in any order, released space is
+	// merged back with its neighbours so it can be reused by larger allocations.
+	struct RectPacker
+	{
+		int32 width;
+		int32 height;
+		int64 usedArea;
+		int numAllocations;
+		std::vector<PackedRect> freeRects;
+
+		void init(int32 width, int32 height);
+		void free();
+		void clear();
+
+		// Uses the best short side fit heuristic. Returns false if there is no free
+		// rectangle big enough, in which case the packer is left untouched.
+		bool allocate(int32 rectWidth, int32 rectHeight, PackedRect* out);
+		void release(const PackedRect& rect);
+
+		int64 freeArea() const;
+		int64 largestFreeArea() const;
+		// Fraction of the page that is currently allocated in the range [0, 1]
+		float occupancy() const;
+		// How badly the free space is scattered in the range [0, 1]. 0 means all of the
+		// free space is one rectangle, values close to 1 mean it's split into slivers.
+		float fragmentation() const;
+	};
+
+	struct SkylineNode
+	{
+		int32 x;
+		int32 y;
+		int32 width;
+	};
+
+	// Skyline bin packer for atlases that only ever grow, like glyph atlases. The top
+	// edge of the allocated space is tracked as a list of horizontal segments, which
+	// is much cheaper than tracking every free rectangle. Space can't be released,
+	// clear the packer to start over.
+	struct SkylinePacker
+	{
+		int32 width;
+		int32 height;
+		int64 usedArea;
+		std::vector<SkylineNode> skyline;
+
+		void init(int32 width, int32 height);
+		void free();
+		void clear();
+
+		// Places the rect as low as possible, ties go to the spot that wastes the least
+		// width. Returns false if it doesn't fit anywhere.
+		bool allocate(int32 rectWidth, int32 rectHeight, PackedRect* out);
+		// Makes room on the right and bottom, everything allocated so far stays put
+		void grow(int32 newWidth, int32 newHeight);
+
+		float occupancy() const;
+	};
+}
+
+#endif
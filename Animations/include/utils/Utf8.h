@@ -0,0 +1,23 @@
+#ifndef MATH_ANIM_UTF8_H
+#define MATH_ANIM_UTF8_H
+#include "core.h"
+
+namespace MathAnim
+{
+	namespace Utf8
+	{
+		// Codepoint that malformed sequences decode to
+		constexpr uint32 replacementCharacter = 0xFFFD;
+
+		// Decodes the codepoint that starts at str and writes the length of its sequence
+		// to outNumBytes. Malformed sequences decode to replacementCharacter and only
+		// consume one byte, so decoding always makes progress.
+		uint32 decode(const uint8* str, size_t length, int* outNumBytes);
+
+		// Writes the UTF-8 sequence for codepoint to out, which needs room for 4 bytes.
+		// Returns the number of bytes written.
+		int encode(uint32 codepoint, uint8* out);
+	}
+}
+
+#endif
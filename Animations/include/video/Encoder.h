@@ -25,6 +25,8 @@ namespace MathAnim
 		int height;
 		int framerate;
 		int frameCounter;
+		// Frames that reused the previous frame through pushDuplicateFrame
+		int duplicateFrameCount;
 		bool logProgress;
 
 		// ffmpeg data
@@ -41,10 +43,21 @@ namespace MathAnim
 	{
 		bool startEncodingFile(VideoEncoder* output, const char* outputFilename, int outputWidth, int outputHeight, int outputFramerate, Mbps bitrate = 60, bool logProgress = false);
 		bool pushFrame(Pixel* pixels, int pixelsLength, VideoEncoder& encoder);
+		// Encodes the last pushed frame again without converting any pixels. Used for
+		// frames where nothing in the scene changed.
+		bool pushDuplicateFrame(VideoEncoder& encoder);
 
 		bool finalizeEncodingFile(VideoEncoder& encoder);
 		void freeEncoder(VideoEncoder& encoder);
 
+		// Joins files written by startEncodingFile (in order) into one file using FFmpeg's
+		// concat demuxer. Packets are copied as is, nothing gets re-encoded.
+		bool concatSegments(const std::vector<std::string>& segmentFilenames, const char* outputFilename);
+
+		// Counts the video frames in an existing file by reading through its packets.
+		// Returns -1 if the file can't be opened, e.g. if it was never finalized.
+		int countFrames(const char* filename);
+
 	}
 }
 
@@ -0,0 +1,54 @@
+#ifndef MATH_ANIM_EXPORT_CHECKPOINT_H
+#define MATH_ANIM_EXPORT_CHECKPOINT_H
+#include "core.h"
+
+namespace MathAnim
+{
+	struct ExportSegment
+	{
+		// Inclusive frame range covered by this segment
+		int frameStart;
+		int frameEnd;
+		std::string filename;
+		bool complete;
+	};
+
+	// An export is written as a series of closed-GOP segments next to the output file
+	// in <outputFilename>.segments/. The manifest in that directory records which
+	// segments have been fully written, so an interrupted export can pick up where
+	// it left off instead of starting over.
+	struct ExportManifest
+	{
+		std::string outputFilename;
+		std::string segmentDir;
+		std::string sceneName;
+		int frameStart;
+		int frameEnd;
+		std::vector<ExportSegment> segments;
+	};
+
+	namespace ExportCheckpoint
+	{
+		// Splits the inclusive range [frameStart, frameEnd] into segments of framesPerSegment
+		// frames and writes a fresh manifest. Any segments left over from a previous export
+		// to the same file are deleted.
+		bool create(ExportManifest* manifest, const std::string& outputFilename, const std::string& sceneName, int frameStart, int frameEnd, int framesPerSegment);
+
+		// Loads the manifest of a previous export to the same file. The scene and frame range
+		// have to match. Every segment marked as complete is probed and gets re-rendered if
+		// it's missing or doesn't contain the frames it should.
+		bool resume(ExportManifest* manifest, const std::string& outputFilename, const std::string& sceneName, int frameStart, int frameEnd);
+
+		// Marks the segment as complete and flushes the manifest to disk. Only call this
+		// once the segment file has been finalized.
+		bool markComplete(ExportManifest& manifest, size_t segmentIndex);
+
+		int numCompleteFrames(const ExportManifest& manifest);
+
+		// Stitches all segments into manifest.outputFilename without re-encoding and
+		// deletes the segment directory on success
+		bool finalize(const ExportManifest& manifest);
+	}
+}
+
+#endif
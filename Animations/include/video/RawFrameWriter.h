@@ -0,0 +1,71 @@
+#ifndef MATH_ANIM_RAW_FRAME_WRITER_H
+#define MATH_ANIM_RAW_FRAME_WRITER_H
+#include "core.h"
+
+struct SwsContext;
+
+namespace MathAnim
+{
+	struct Pixel;
+	struct RawFrameQueue;
+
+	enum class RawFrameFormat : uint8
+	{
+		None,
+		Rgb24,
+		Yuv420p,
+		// yuv420p with a YUV4MPEG2 stream header and per frame headers, so the consumer
+		// doesn't need to be told the resolution and framerate
+		Y4m,
+		Length
+	};
+
+	constexpr const char* rawFrameFormatNames[(uint8)RawFrameFormat::Length] = {
+		"None",
+		"rgb24",
+		"yuv420p",
+		"y4m"
+	};
+
+	// Streams uncompressed frames to stdout or a named pipe so an external encoder can
+	// consume them. Frames are handed to a writer thread through a small fixed pool of
+	// buffers. If the consumer falls behind, pushFrame blocks instead of queueing more
+	// frames, so memory use never grows past the pool.
+	struct RawFrameOutput
+	{
+		int width;
+		int height;
+		int framerate;
+		RawFrameFormat format;
+		int frameCounter;
+		// Frames that reused the previous frame through pushDuplicateFrame
+		int duplicateFrameCount;
+
+		int fd;
+		// Bytes of per frame header (FRAME\n for y4m) followed by the pixels
+		size_t frameHeaderSize;
+		size_t frameSize;
+		SwsContext* swsContext;
+		RawFrameQueue* queue;
+	};
+
+	namespace RawFrameWriter
+	{
+		// Takes over stdout for frame data and points everything that would normally be
+		// printed there at stderr instead. Call this before anything gets logged when
+		// streaming to stdout.
+		void reserveStdout();
+
+		// filename "-" streams to stdout, reserving it first if that hasn't happened yet
+		bool open(RawFrameOutput* output, const char* filename, RawFrameFormat format, int width, int height, int framerate);
+		bool pushFrame(Pixel* pixels, int pixelsLength, RawFrameOutput& output);
+		// Sends the last pushed frame again without copying or converting any pixels
+		bool pushDuplicateFrame(RawFrameOutput& output);
+		// Waits for every queued frame to be written and closes the output
+		bool close(RawFrameOutput& output);
+
+		RawFrameFormat parseFormat(const char* str);
+	}
+}
+
+#endif
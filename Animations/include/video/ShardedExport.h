@@ -0,0 +1,21 @@
+#ifndef MATH_ANIM_SHARDED_EXPORT_H
+#define MATH_ANIM_SHARDED_EXPORT_H
+#include "core.h"
+
+namespace MathAnim
+{
+	struct HeadlessRenderOptions;
+
+	namespace ShardedExport
+	{
+		// Splits the inclusive range [frameStart, frameEnd] into shards and renders them with
+		// options.numWorkers headless worker processes. Workers pull a new shard as soon as they
+		// finish one, so slow shards (heavy LaTeX, lots of objects) don't leave other workers idle.
+		// Every shard is its own closed-GOP checkpoint segment which get concatenated into
+		// options.outputFilename without re-encoding. With options.resume only the shards
+		// that aren't finished yet are rendered.
+		bool run(const HeadlessRenderOptions& options, const std::string& sceneName, int frameStart, int frameEnd);
+	}
+}
+
+#endif
@@ -18,7 +18,7 @@ namespace MathAnim
 	static AnimObjId animationUidCounter = 0;
 
 	// ----------------------------- Internal Functions -----------------------------
-	static AnimObject deserializeAnimObjectV1(AnimationManagerData* am, RawMemory& memory);
+	static AnimObject deserializeAnimObjectV1(AnimationManagerData* am, RawMemory& memory, uint32 serializerVersion);
 	static Animation deserializeAnimationExV1(RawMemory& memory);
 	static CameraObject deserializeCameraObjectV1(RawMemory& memory);
 
@@ -60,6 +60,10 @@ namespace MathAnim
 	{
 		AnimObject* obj = AnimationManager::getMutableObject(am, animObjId);
 
+		// Glyphs carry the fade of the animations that get staggered over them. Fading
+		// the text object too would apply it twice, since glyphs scale its alpha.
+		bool fadesGlyphs = false;
+
 		// Apply animation to all children as well
 		if (obj && Animation::appliesToChildren(this->type))
 		{
@@ -83,6 +87,24 @@ namespace MathAnim
 				float interpolatedT = CMath::mapRange(Vec2{ 0.0f, 1.0f - startT }, Vec2{ 0.0f, 1.0f }, (t - startT));
 				applyAnimationToObj(am, children[i], interpolatedT);
 			}
+
+			// Glyphs get staggered the same way children do
+			GlyphRun* glyphRun = obj->getGlyphRun();
+			if (glyphRun)
+			{
+				for (int32 i = 0; i < glyphRun->numGlyphs; i++)
+				{
+					float startT = 0.0f;
+					if (this->playbackType == PlaybackType::LaggedStart)
+					{
+						startT = (float)i / (float)glyphRun->numGlyphs * lagRatio;
+					}
+
+					float interpolatedT = CMath::mapRange(Vec2{ 0.0f, 1.0f - startT }, Vec2{ 0.0f, 1.0f }, (t - startT));
+					applyAnimationToGlyph(obj, glyphRun->glyphs[i], glm::clamp(interpolatedT, 0.0f, 1.0f));
+				}
+				fadesGlyphs = true;
+			}
 		}
 
 		switch (type)
@@ -92,6 +114,11 @@ namespace MathAnim
 			if (obj)
 			{
 				obj->percentCreated = t;
+				if (fadesGlyphs)
+				{
+					break;
+				}
+
 				// Start the fade in after 80% of the drawing is complete
 				constexpr float fadeInStart = 0.8f;
 				float amountToFadeIn = ((t - fadeInStart) / (1.0f - fadeInStart));
@@ -121,13 +148,16 @@ namespace MathAnim
 			if (obj)
 			{
 				obj->percentCreated = 1.0f - t;
-				obj->fillColor.a = (uint8)((1.0f - t) * 255.0f);
+				if (!fadesGlyphs)
+				{
+					obj->fillColor.a = (uint8)((1.0f - t) * 255.0f);
+				}
 			}
 		}
 		break;
 		case AnimTypeV1::FadeIn:
 		{
-			if (obj)
+			if (obj && !fadesGlyphs)
 			{
 				static bool logWarning = true;
 				if (logWarning)
@@ -142,7 +172,7 @@ namespace MathAnim
 		break;
 		case AnimTypeV1::FadeOut:
 		{
-			if (obj)
+			if (obj && !fadesGlyphs)
 			{
 				obj->fillColor.a = obj->fillColor.a - (uint8)((float)obj->fillColor.a * t);
 				obj->strokeColor.a = obj->strokeColor.a - (uint8)((float)obj->strokeColor.a * t);
@@ -239,6 +269,49 @@ namespace MathAnim
 		}
 	}
 
+	void Animation::applyAnimationToGlyph(const AnimObject* obj, GlyphInstance& glyph, float t) const
+	{
+		switch (type)
+		{
+		case AnimTypeV1::Create:
+		{
+			glyph.percentCreated = t;
+			// Start the fade in after 80% of the drawing is complete
+			constexpr float fadeInStart = 0.8f;
+			float amountToFadeIn = ((t - fadeInStart) / (1.0f - fadeInStart));
+			float percentToFadeIn = glm::max(glm::min(amountToFadeIn, 1.0f), 0.0f);
+			glyph.fillAlpha = (uint8)(percentToFadeIn * (float)glyph.fillAlpha);
+
+			if (obj->strokeWidth <= 0.0f)
+			{
+				glyph.strokeAlpha = (uint8)((1.0f - percentToFadeIn) * 255.0f);
+			}
+		}
+		break;
+		case AnimTypeV1::UnCreate:
+		{
+			glyph.percentCreated = 1.0f - t;
+			glyph.fillAlpha = (uint8)((1.0f - t) * 255.0f);
+		}
+		break;
+		case AnimTypeV1::FadeIn:
+		{
+			glyph.fillAlpha = (uint8)(255.0f * t);
+			glyph.strokeAlpha = (uint8)(255.0f * t);
+		}
+		break;
+		case AnimTypeV1::FadeOut:
+		{
+			glyph.fillAlpha = glyph.fillAlpha - (uint8)((float)glyph.fillAlpha * t);
+			glyph.strokeAlpha = glyph.strokeAlpha - (uint8)((float)glyph.strokeAlpha * t);
+		}
+		break;
+		default:
+			// Everything else animates the text object as a whole
+			break;
+		}
+	}
+
 	void Animation::calculateKeyframes(AnimationManagerData* am)
 	{
 		if (Animation::appliesToChildren(type))
@@ -979,13 +1052,22 @@ namespace MathAnim
 		}
 		// NOP: Cube just has a bunch of children anim objects that get rendered
 		break;
-		case AnimObjectTypeV1::Axis:
 		case AnimObjectTypeV1::TextObject:
+		case AnimObjectTypeV1::CodeBlock:
+		{
+			// Text that hasn't been split into characters draws its glyphs itself
+			const GlyphRun* glyphRun = getGlyphRun();
+			if (glyphRun)
+			{
+				glyphRun->render(am, this);
+			}
+		}
+		break;
+		case AnimObjectTypeV1::Axis:
 		case AnimObjectTypeV1::LaTexObject:
 		case AnimObjectTypeV1::SvgFileObject:
 		case AnimObjectTypeV1::Camera:
 		case AnimObjectTypeV1::ScriptObject:
-		case AnimObjectTypeV1::CodeBlock:
 			// NOP: These just have a bunch of children anim objects that get rendered
 			break;
 		case AnimObjectTypeV1::Length:
@@ -1162,10 +1244,29 @@ namespace MathAnim
 			if (this->svgObject && replacement->svgObject)
 			{
 				this->percentReplacementTransformed = t;
-				SvgObject* interpolated = Svg::interpolate(this->svgObject, replacement->svgObject, t);
-				this->svgObject->free();
-				g_memory_free(this->svgObject);
-				this->svgObject = interpolated;
+				if (!this->_replacementMorph)
+				{
+					this->_replacementMorph = (SvgMorph*)g_memory_allocate(sizeof(SvgMorph));
+					*this->_replacementMorph = Svg::createDefaultMorph();
+				}
+
+				// svgObject was just reset to its start shape, so it can be blended
+				// in place
+				bool morphReady = Svg::morphMatches(*this->_replacementMorph, this->svgObject, replacement->svgObject) ||
+					Svg::prepareMorph(this->_replacementMorph, this->svgObject, replacement->svgObject);
+				if (morphReady)
+				{
+					Svg::morph(*this->_replacementMorph, t, this->svgObject);
+				}
+			}
+
+			// Text draws its glyphs itself, so the runs get blended glyph by glyph when
+			// they're drawn
+			GlyphRun* glyphRun = getGlyphRun();
+			const GlyphRun* replacementGlyphRun = replacement->getGlyphRun();
+			if (glyphRun && replacementGlyphRun)
+			{
+				glyphRun->morphTo(*replacementGlyphRun, replacement->id, t);
 			}
 
 			// Interpolate other properties
@@ -1197,6 +1298,15 @@ namespace MathAnim
 		else
 		{
 			replacement->percentCreated = 1.0f;
+
+			GlyphRun* replacementGlyphRun = replacement->getGlyphRun();
+			if (replacementGlyphRun)
+			{
+				for (int32 i = 0; i < replacementGlyphRun->numGlyphs; i++)
+				{
+					replacementGlyphRun->glyphs[i].percentCreated = 1.0f;
+				}
+			}
 		}
 	}
 
@@ -1204,7 +1314,17 @@ namespace MathAnim
 	{
 		if (_svgObjectStart != nullptr && svgObject != nullptr)
 		{
-			Svg::copy(svgObject, _svgObjectStart);
+			// Objects that haven't been deformed just reference their start geometry.
+			// Once something like a replacement gives svgObject its own copy, the copy
+			// gets reused so resetting doesn't allocate every frame.
+			if (svgObject->arena == nullptr || svgObject->arena == _svgObjectStart->arena)
+			{
+				Svg::share(svgObject, _svgObjectStart);
+			}
+			else
+			{
+				Svg::copy(svgObject, _svgObjectStart);
+			}
 		}
 		globalPosition = _globalPositionStart;
 		position = _positionStart;
@@ -1217,6 +1337,12 @@ namespace MathAnim
 		status = AnimObjectStatus::Inactive;
 		circumscribeId = NULL_ANIM;
 
+		GlyphRun* glyphRun = getGlyphRun();
+		if (glyphRun)
+		{
+			glyphRun->resetState();
+		}
+
 		if (objectType == AnimObjectTypeV1::Camera && as.camera.isActiveCamera)
 		{
 			status = as.camera.isActiveCamera
@@ -1251,6 +1377,26 @@ namespace MathAnim
 		}
 	}
 
+	GlyphRun* AnimObject::getGlyphRun()
+	{
+		GlyphRun* res = nullptr;
+		if (objectType == AnimObjectTypeV1::TextObject)
+		{
+			res = &as.textObject.glyphRun;
+		}
+		else if (objectType == AnimObjectTypeV1::CodeBlock)
+		{
+			res = &as.codeBlock.glyphRun;
+		}
+
+		return res && res->numGlyphs > 0 ? res : nullptr;
+	}
+
+	const GlyphRun* AnimObject::getGlyphRun() const
+	{
+		return const_cast<AnimObject*>(this)->getGlyphRun();
+	}
+
 	void AnimObject::copySvgScaleToChildren(AnimationManagerData* am) const
 	{
 		for (auto iter = beginBreadthFirst(am); iter != end(); ++iter)
@@ -1320,6 +1466,13 @@ namespace MathAnim
 			this->_svgObjectStart = nullptr;
 		}
 
+		if (this->_replacementMorph)
+		{
+			this->_replacementMorph->free();
+			g_memory_free(this->_replacementMorph);
+			this->_replacementMorph = nullptr;
+		}
+
 		if (this->name)
 		{
 			g_memory_free(this->name);
@@ -1485,9 +1638,9 @@ namespace MathAnim
 
 	AnimObject AnimObject::deserialize(AnimationManagerData* am, RawMemory& memory, uint32 version)
 	{
-		if (version == 1)
+		if (version == 1 || version == 2)
 		{
-			return deserializeAnimObjectV1(am, memory);
+			return deserializeAnimObjectV1(am, memory, version);
 		}
 
 		g_logger_error("AnimObject serialized with unknown version '%d'. Potentially corrupted memory.", version);
@@ -1544,6 +1697,7 @@ namespace MathAnim
 
 		res.svgObject = nullptr;
 		res._svgObjectStart = nullptr;
+		res._replacementMorph = nullptr;
 
 		res.isTransparent = false;
 		res.drawDebugBoxes = false;
@@ -1578,7 +1732,7 @@ namespace MathAnim
 		case AnimObjectTypeV1::TextObject:
 			res.svgScale = 150.0f;
 			res.as.textObject = TextObject::createDefault();
-			res.as.textObject.init(am, res.id);
+			res.as.textObject.layoutGlyphs();
 			break;
 		case AnimObjectTypeV1::LaTexObject:
 			res.as.laTexObject = LaTexObject::createDefault();
@@ -1672,6 +1826,7 @@ namespace MathAnim
 
 		res.svgObject = nullptr;
 		res._svgObjectStart = nullptr;
+		res._replacementMorph = nullptr;
 
 		if (from.svgObject)
 		{
@@ -1731,7 +1886,7 @@ namespace MathAnim
 	}
 
 	// ----------------------------- Internal Functions -----------------------------
-	static AnimObject deserializeAnimObjectV1(AnimationManagerData*, RawMemory& memory)
+	static AnimObject deserializeAnimObjectV1(AnimationManagerData*, RawMemory& memory, uint32 serializerVersion)
 	{
 		// TODO: Replace this with some sort of library where you register 
 		// an object layout and it automatically serializes/deserializes stuff
@@ -1839,12 +1994,14 @@ namespace MathAnim
 		res.strokeWidth = res._strokeWidthStart;
 		res.svgObject = nullptr;
 		res._svgObjectStart = nullptr;
+		res._replacementMorph = nullptr;
 
 		// We're in V1 so this is version 1
 		constexpr uint32 version = 1;
 		switch (res.objectType)
 		{
 		case AnimObjectTypeV1::TextObject:
+			// Laid out by the animation manager once the whole project is read
 			res.as.textObject = TextObject::deserialize(memory, version);
 			break;
 		case AnimObjectTypeV1::LaTexObject:
@@ -1855,7 +2012,7 @@ namespace MathAnim
 			res.as.square.init(&res);
 			break;
 		case AnimObjectTypeV1::SvgObject:
-			res._svgObjectStart = SvgObject::deserialize(memory, version);
+			res._svgObjectStart = SvgObject::deserialize(memory, serializerVersion);
 			res.svgObject = (SvgObject*)g_memory_allocate(sizeof(SvgObject));
 			*res.svgObject = Svg::createDefault();
 			Svg::copy(res.svgObject, res._svgObjectStart);
@@ -1882,6 +2039,7 @@ namespace MathAnim
 			res.as.script = ScriptObject::deserialize(memory, version);
 			break;
 		case AnimObjectTypeV1::CodeBlock:
+			// Laid out by the animation manager once the whole project is read
 			res.as.codeBlock = CodeBlock::deserialize(memory, version);
 			break;
 		case AnimObjectTypeV1::Arrow:
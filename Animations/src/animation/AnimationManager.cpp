@@ -5,6 +5,7 @@
 #include "renderer/Framebuffer.h"
 #include "renderer/OrthoCamera.h"
 #include "svg/Svg.h"
+#include "svg/SvgCache.h"
 #include "core/Application.h"
 
 namespace MathAnim
@@ -34,12 +35,16 @@ namespace MathAnim
 		AnimObjId startingActiveCamera;
 		AnimObjId activeCamera;
 		int currentFrame;
+
+		// Bumped whenever the scene is edited in a way that can change what gets
+		// rendered outside of regular animation playback
+		uint64 editCounter;
 	};
 
 	namespace AnimationManager
 	{
 		// -------- Internal Functions --------
-		static void deserializeAnimationManagerExV1(AnimationManagerData* am, RawMemory& memory);
+		static void deserializeAnimationManagerExV1(AnimationManagerData* am, RawMemory& memory, uint32 serializerVersion);
 		static bool compareAnimation(const Animation& a1, const Animation& a2);
 		static void updateGlobalTransform(AnimObject& obj);
 		static void addQueuedAnimObject(AnimationManagerData* am, const AnimObject& obj);
@@ -49,6 +54,7 @@ namespace MathAnim
 		static bool removeSingleAnimObject(AnimationManagerData* am, AnimObjId animObj);
 		static void applyDelta(AnimationManagerData* am, int deltaFrame);
 		static void applyAnimationsFrom(AnimationManagerData* am, int startIndex, int frame, bool calculateKeyframes = false);
+		static bool usesSvgCache(AnimObjectTypeV1 objectType);
 
 		AnimationManagerData* create()
 		{
@@ -59,6 +65,7 @@ namespace MathAnim
 
 			res->startingActiveCamera = NULL_ANIM_OBJECT;
 			res->currentFrame = 0;
+			res->editCounter = 0;
 
 			// TODO: Initialize some cameras and add them to the scene if this is
 			// the first time the scene is being opened
@@ -105,6 +112,12 @@ namespace MathAnim
 
 		void endFrame(AnimationManagerData* am)
 		{
+			if (am->queuedRemoveObjects.size() > 0 || am->queuedRemoveAnimations.size() > 0 ||
+				am->queuedAddObjects.size() > 0 || am->queuedAddAnimations.size() > 0)
+			{
+				am->editCounter++;
+			}
+
 			// Remove all queued delete objects
 			for (auto animObjId : am->queuedRemoveObjects)
 			{
@@ -225,6 +238,7 @@ namespace MathAnim
 			{
 				anim->animObjectIds.insert(animObjId);
 				obj->referencedAnimations.insert(animationId);
+				am->editCounter++;
 			}
 		}
 
@@ -236,6 +250,7 @@ namespace MathAnim
 			{
 				anim->animObjectIds.erase(animObjId);
 				obj->referencedAnimations.erase(animationId);
+				am->editCounter++;
 			}
 		}
 
@@ -277,6 +292,7 @@ namespace MathAnim
 			if (animation)
 			{
 				animation->timelineTrack = track;
+				am->editCounter++;
 			}
 		}
 
@@ -334,6 +350,27 @@ namespace MathAnim
 				applyDelta(am, deltaFrame);
 			}
 
+			// Queue up every SVG raster this frame is missing before drawing anything, so
+			// the misses rasterize in parallel instead of one after the other
+			SvgCache* svgCache = Application::getSvgCache();
+			svgCache->update();
+			for (auto objectIter = am->objects.begin(); objectIter != am->objects.end(); objectIter++)
+			{
+				if (objectIter->status == AnimObjectStatus::Inactive)
+				{
+					continue;
+				}
+
+				if (usesSvgCache(objectIter->objectType))
+				{
+					svgCache->prefetch(am, &(*objectIter));
+				}
+				else if (const GlyphRun* glyphRun = objectIter->getGlyphRun())
+				{
+					glyphRun->prefetch(am, &(*objectIter));
+				}
+			}
+
 			// Render any active/animating objects
 			// Make sure to initialize the NanoVG cache and then flush it after all the 
 			// draw calls are complete
@@ -374,6 +411,40 @@ namespace MathAnim
 			return lastFrame + 60;
 		}
 
+		bool hasAnimationsActiveBetween(const AnimationManagerData* am, int previousFrame, int frame)
+		{
+			g_logger_assert(am != nullptr, "Null AnimationManagerData.");
+
+			if (previousFrame > frame)
+			{
+				std::swap(previousFrame, frame);
+			}
+
+			// Animations are clamped outside of [frameStart, frameStart + duration], so the
+			// output can only change if one of them overlaps (previousFrame, frame]
+			for (auto animIter = am->animations.begin(); animIter != am->animations.end(); animIter++)
+			{
+				if (animIter->frameStart > frame)
+				{
+					// Sorted by frameStart, nothing after this can be active yet
+					break;
+				}
+
+				if (animIter->frameStart + animIter->duration > previousFrame)
+				{
+					return true;
+				}
+			}
+
+			return false;
+		}
+
+		uint64 getEditCounter(const AnimationManagerData* am)
+		{
+			g_logger_assert(am != nullptr, "Null AnimationManagerData.");
+			return am->editCounter;
+		}
+
 		const AnimObject* getActiveOrthoCamera(const AnimationManagerData* am)
 		{
 			return getObject(am, am->activeCamera);
@@ -383,6 +454,7 @@ namespace MathAnim
 		{
 			am->startingActiveCamera = id;
 			am->activeCamera = id;
+			am->editCounter++;
 		}
 
 		const AnimObject* getPendingObject(const AnimationManagerData* am, AnimObjId animObj)
@@ -572,9 +644,9 @@ namespace MathAnim
 			g_logger_assert(magicNumber == MAGIC_NUMBER, "Project file had invalid magic number '0x%8x'. File must have been corrupted.", magicNumber);
 			g_logger_assert((serializerVersion != 0 && serializerVersion <= SERIALIZER_VERSION), "Project file saved with invalid version '%d'. Looks like corrupted data.", serializerVersion);
 
-			if (serializerVersion == 1)
+			if (serializerVersion == 1 || serializerVersion == 2)
 			{
-				deserializeAnimationManagerExV1(am, memory);
+				deserializeAnimationManagerExV1(am, memory, serializerVersion);
 				am->currentFrame = currentFrame;
 				// Calculate all key frame starting points and stuff
 				calculateAnimationKeyFrames(am);
@@ -722,6 +794,16 @@ namespace MathAnim
 					finalBoundingBox.max = Vec2{ -FLT_MAX, -FLT_MAX };
 				}
 
+				// The glyph run's bounds were worked out when it was laid out
+				const GlyphRun* glyphRun = nextObj->getGlyphRun();
+				if (glyphRun)
+				{
+					Vec2 scale = Vec2{ scaleFactor.x, scaleFactor.y };
+					Vec2 position = CMath::vector2From3(nextObj->globalPosition);
+					finalBoundingBox.min = CMath::min(finalBoundingBox.min, glyphRun->bbox.min * scale + position);
+					finalBoundingBox.max = CMath::max(finalBoundingBox.max, glyphRun->bbox.max * scale + position);
+				}
+
 				// Then append all direct children to the queue so they are
 				// recursively updated
 				for (auto childIter = am->objects.begin(); childIter != am->objects.end(); childIter++)
@@ -747,6 +829,8 @@ namespace MathAnim
 				return;
 			}
 
+			am->editCounter++;
+
 			// It's easiest to just apply all updates from the
 			// root of the scene, so we'll find the root of this
 			// object, reset all the children then update from there
@@ -801,9 +885,10 @@ namespace MathAnim
 		}
 
 		// -------- Internal Functions --------
-		static void deserializeAnimationManagerExV1(AnimationManagerData* am, RawMemory& memory)
+		static void deserializeAnimationManagerExV1(AnimationManagerData* am, RawMemory& memory, uint32 serializerVersion)
 		{
-			// We're in function V1 so this is a version 1 for sure
+			// We're in function V1 so this is a version 1 for sure. Version 2 files only
+			// differ in how anim objects store SVG geometry.
 			constexpr uint32 version = 1;
 
 			// startingActiveCamera -> AnimObjId
@@ -834,7 +919,7 @@ namespace MathAnim
 			// Read each anim object followed by 0xDEADBEEF
 			for (uint32 i = 0; i < numAnimObjects; i++)
 			{
-				AnimObject animObject = AnimObject::deserialize(am, memory, version);
+				AnimObject animObject = AnimObject::deserialize(am, memory, serializerVersion);
 				am->objects.push_back(animObject);
 				uint32 magicNumber;
 				memory.read<uint32>(&magicNumber);
@@ -842,6 +927,25 @@ namespace MathAnim
 
 				am->objectIdMap[animObject.id] = i;
 			}
+
+			// Text gets laid out after everything is read so the fonts can load in parallel.
+			// Text that was split into characters got saved along with its children.
+			for (AnimObject& obj : am->objects)
+			{
+				if (obj.generatedChildrenIds.size() > 0)
+				{
+					continue;
+				}
+
+				if (obj.objectType == AnimObjectTypeV1::TextObject)
+				{
+					obj.as.textObject.layoutGlyphs();
+				}
+				else if (obj.objectType == AnimObjectTypeV1::CodeBlock)
+				{
+					obj.as.codeBlock.layoutGlyphs();
+				}
+			}
 		}
 
 		static bool compareAnimation(const Animation& a1, const Animation& a2)
@@ -1103,5 +1207,20 @@ namespace MathAnim
 				}
 			}
 		}
+
+		static bool usesSvgCache(AnimObjectTypeV1 objectType)
+		{
+			// Keep this in sync with AnimObject::render
+			switch (objectType)
+			{
+			case AnimObjectTypeV1::Square:
+			case AnimObjectTypeV1::Circle:
+			case AnimObjectTypeV1::SvgObject:
+			case AnimObjectTypeV1::Arrow:
+				return true;
+			default:
+				return false;
+			}
+		}
 	}
-}
\ No newline at end of file
+}
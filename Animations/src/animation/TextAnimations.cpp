@@ -2,15 +2,20 @@
 #include "animation/Animation.h"
 #include "animation/AnimationManager.h"
 #include "svg/Svg.h"
+#include "svg/SvgCache.h"
 #include "renderer/Renderer.h"
 #include "renderer/Framebuffer.h"
 #include "renderer/Fonts.h"
+#include "renderer/TextLayout.h"
 #include "renderer/PerspectiveCamera.h"
 #include "renderer/OrthoCamera.h"
 #include "core/Application.h"
 #include "latex/LaTexLayer.h"
 #include "editor/SceneHierarchyPanel.h"
 #include "parsers/SyntaxTheme.h"
+#include "parsers/Grammar.h"
+#include "utils/CMath.h"
+#include "utils/Utf8.h"
 
 namespace MathAnim
 {
@@ -18,36 +23,31 @@ namespace MathAnim
 	static TextObject deserializeTextV1(RawMemory& memory);
 	static LaTexObject deserializeLaTexV1(RawMemory& memory);
 	static CodeBlock deserializeCodeBlockV1(RawMemory& memory);
+	static glm::u8vec4 tintColor(const glm::u8vec4& color, const glm::u8vec4& tint, uint8 alpha);
+	static void drawGlyphFill(const AnimObject* parent, const SvgCacheEntry& entry, const SvgObject* svg, const glm::mat4& transform, const glm::u8vec4& fillColor);
+	static void drawGlyph(AnimationManagerData* am, const AnimObject* parent, SvgObject* svg, const Vec2& offset, const glm::u8vec4& color, uint8 fillAlpha, uint8 strokeAlpha, float percentCreated);
+	static void renderReplacement(AnimationManagerData* am, const AnimObject* parent, const GlyphRun& run, const GlyphRun& replacement);
 
-	// Number of spaces for tabs. Make this configurable
-	constexpr int tabDepth = 2;
-
-	void TextObject::init(AnimationManagerData* am, AnimObjId parentId)
+	void TextObject::layoutGlyphs()
 	{
+		glyphRun.free();
 		if (font == nullptr)
 		{
 			return;
 		}
 
-		std::string textStr = std::string(text);
+		// Passing the last layout in lets small edits only lay out what changed
+		const TextLayout* layout = TextLayouts::layout(font, 1.0f, text, (size_t)textLength, layoutKey);
+		layoutKey = layout->key;
 
-		// Generate children that represent each character of the text object `obj`
-		Vec2 cursorPos = Vec2{ 0, 0 };
-		for (int i = 0; i < textStr.length(); i++)
+		for (const LayoutGlyph& glyph : layout->glyphs)
 		{
-			if (textStr[i] == '\n')
-			{
-				cursorPos = Vec2{ 0.0f, cursorPos.y - font->lineHeight };
-				continue;
-			}
-
-			uint8 codepoint = (uint8)textStr[i];
-			const GlyphOutline& glyphOutline = font->getGlyphInfo(codepoint);
-			if (!glyphOutline.svg)
+			if (!glyph.outline || !glyph.outline->svg)
 			{
 				continue;
 			}
 
+			const GlyphOutline& glyphOutline = *glyph.outline;
 			float halfGlyphHeight = glyphOutline.glyphHeight / 2.0f;
 			float halfGlyphWidth = glyphOutline.glyphWidth / 2.0f;
 			Vec2 offset = Vec2{
@@ -55,33 +55,14 @@ namespace MathAnim
 				halfGlyphHeight - glyphOutline.descentY
 			};
 
-			if (textStr[i] != ' ' && textStr[i] != '\t')
+			if (glyph.codepoint != ' ' && glyph.codepoint != '\t')
 			{
-				// Add this character as a child
-				AnimObject childObj = AnimObject::createDefaultFromParent(am, AnimObjectTypeV1::SvgObject, parentId, true);
-				childObj.parentId = parentId;
-				Vec2 finalOffset = offset + cursorPos;
-				childObj._positionStart = Vec3{ finalOffset.x, finalOffset.y, 0.0f };
-				childObj.isGenerated = true;
-				// Copy the glyph as the svg object here
-				childObj._svgObjectStart = (SvgObject*)g_memory_allocate(sizeof(SvgObject));
-				childObj.svgObject = (SvgObject*)g_memory_allocate(sizeof(SvgObject));
-				*(childObj._svgObjectStart) = Svg::createDefault();
-				*(childObj.svgObject) = Svg::createDefault();
-				Svg::copy(childObj._svgObjectStart, glyphOutline.svg);
-
-				childObj.name = (uint8*)g_memory_realloc(childObj.name, sizeof(uint8) * 2);
-				childObj.nameLength = 1;
-				childObj.name[0] = codepoint;
-				childObj.name[1] = '\0';
-
-				AnimationManager::addAnimObject(am, childObj);
-				// TODO: Ugly what do I do???
-				SceneHierarchyPanel::addNewAnimObject(childObj);
-			}
+				// Layouts go down the screen, text objects go up
+				Vec2 cursorPos = Vec2{ glyph.position.x, -glyph.position.y };
 
-			// TODO: I may have to add kerning info here
-			cursorPos += Vec2{ glyphOutline.advanceX, 0.0f };
+				// Text objects draw in their own colors, so their glyphs don't tint them
+				glyphRun.addGlyph(glyphOutline.svg, glyph.codepoint, offset + cursorPos, glm::u8vec4(255));
+			}
 		}
 	}
 
@@ -99,10 +80,15 @@ namespace MathAnim
 				AnimationManager::removeAnimObject(am, obj->generatedChildrenIds[i]);
 			}
 		}
+		bool wasSplit = obj->generatedChildrenIds.size() > 0;
 		obj->generatedChildrenIds.clear();
 
-		// Next init again which should regenerate the children
-		init(am, obj->id);
+		// Next lay the glyphs out again and split them back up if they were split before
+		layoutGlyphs();
+		if (wasSplit)
+		{
+			glyphRun.splitIntoCharacters(am, obj->id);
+		}
 	}
 
 	void TextObject::serialize(RawMemory& memory) const
@@ -134,6 +120,8 @@ namespace MathAnim
 
 	void TextObject::free()
 	{
+		glyphRun.free();
+
 		if (this->font)
 		{
 			Fonts::unloadFont(this->font);
@@ -171,6 +159,8 @@ namespace MathAnim
 		g_memory_copyMem(res.text, (void*)defaultText, sizeof(defaultText) / sizeof(char));
 		res.textLength = (sizeof(defaultText) / sizeof(char)) - 1;
 		res.text[res.textLength] = '\0';
+		res.glyphRun = GlyphRun::createDefault();
+		res.layoutKey = 0;
 		return res;
 	}
 
@@ -191,6 +181,13 @@ namespace MathAnim
 		g_memory_copyMem(res.text, (void*)from.text, from.textLength);
 		res.textLength = from.textLength;
 		res.text[res.textLength] = '\0';
+
+		res.glyphRun = GlyphRun::createDefault();
+		res.layoutKey = 0;
+		if (from.glyphRun.numGlyphs > 0)
+		{
+			res.layoutGlyphs();
+		}
 		return res;
 	}
 
@@ -327,8 +324,10 @@ namespace MathAnim
 		return res;
 	}
 
-	void CodeBlock::init(AnimationManagerData* am, AnimObjId parentId)
+	void CodeBlock::layoutGlyphs()
 	{
+		glyphRun.free();
+
 		Font* font = Fonts::getDefaultMonoFont();
 		if (font == nullptr)
 		{
@@ -347,14 +346,24 @@ namespace MathAnim
 			return;
 		}
 
+		if (!tokens)
+		{
+			tokens = (TokenizedCode*)g_memory_allocate(sizeof(TokenizedCode));
+			new(tokens)TokenizedCode();
+		}
+
 		// First parse the code block and get the code in segmented form with highlight information
-		CodeHighlights highlights = highlighter->parse(text, *syntaxTheme);
+		CodeHighlights highlights = highlighter->parse(text, *syntaxTheme, tokens);
+
+		const TextLayout* layout = TextLayouts::layout(font, 1.0f, text, (size_t)textLength, layoutKey);
+		layoutKey = layout->key;
 
-		// Generate children that represent each character of the text object `obj`
-		Vec2 cursorPos = Vec2{ 0, 0 };
 		size_t codeBlockCursor = 0;
-		for (size_t textIndex = 0; textIndex < (size_t)textLength; textIndex++)
+		for (const LayoutGlyph& glyph : layout->glyphs)
 		{
+			// Highlight segments are in bytes like the glyph offsets
+			size_t textIndex = (size_t)glyph.textOffset;
+
 			Vec4 textColor = syntaxTheme->defaultForeground;
 			if (codeBlockCursor < highlights.segments.size())
 			{
@@ -369,24 +378,12 @@ namespace MathAnim
 				textColor = highlights.segments[codeBlockCursor].color;
 			}
 
-			if (text[textIndex] == '\n')
+			if (!glyph.outline || !glyph.outline->svg)
 			{
-				cursorPos = Vec2{ 0.0f, cursorPos.y - font->lineHeight };
 				continue;
 			}
 
-			uint8 codepoint = (uint8)text[textIndex];
-			bool isTab = codepoint == '\t';
-			if (codepoint == '\t')
-			{
-				codepoint = ' ';
-			}
-
-			const GlyphOutline& glyphOutline = font->getGlyphInfo(codepoint);
-			if (!glyphOutline.svg)
-			{
-				continue;
-			}
+			const GlyphOutline& glyphOutline = *glyph.outline;
 
 			float halfGlyphHeight = glyphOutline.glyphHeight / 2.0f;
 			float halfGlyphWidth = glyphOutline.glyphWidth / 2.0f;
@@ -395,48 +392,18 @@ namespace MathAnim
 				halfGlyphHeight - glyphOutline.descentY
 			};
 
-			if (text[textIndex] != ' ' && text[textIndex] != '\t')
+			if (glyph.codepoint != ' ' && glyph.codepoint != '\t')
 			{
-				// Add this character as a child
-				AnimObject childObj = AnimObject::createDefaultFromParent(am, AnimObjectTypeV1::SvgObject, parentId, true);
-				childObj.parentId = parentId;
-				Vec2 finalOffset = offset + cursorPos;
-				childObj._positionStart = Vec3{ finalOffset.x, finalOffset.y, 0.0f };
-				childObj.isGenerated = true;
-				// Copy the glyph as the svg object here
-				childObj._svgObjectStart = (SvgObject*)g_memory_allocate(sizeof(SvgObject));
-				childObj.svgObject = (SvgObject*)g_memory_allocate(sizeof(SvgObject));
-				*(childObj._svgObjectStart) = Svg::createDefault();
-				*(childObj.svgObject) = Svg::createDefault();
-				Svg::copy(childObj._svgObjectStart, glyphOutline.svg);
-
-				childObj._fillColorStart = glm::u8vec4(
+				// Layouts go down the screen, code blocks go up
+				Vec2 cursorPos = Vec2{ glyph.position.x, -glyph.position.y };
+				glm::u8vec4 glyphColor = glm::u8vec4(
 					(uint8)(textColor.r * 255.0f),
 					(uint8)(textColor.g * 255.0f),
 					(uint8)(textColor.b * 255.0f),
 					(uint8)(textColor.a * 255.0f)
 				);
-				childObj.fillColor = childObj._fillColorStart;
-				childObj._strokeColorStart = childObj._fillColorStart;
-				childObj.strokeColor = childObj._fillColorStart;
-
-				childObj.name = (uint8*)g_memory_realloc(childObj.name, sizeof(uint8) * 2);
-				childObj.nameLength = 1;
-				childObj.name[0] = codepoint;
-				childObj.name[1] = '\0';
-
-				AnimationManager::addAnimObject(am, childObj);
-				// TODO: Ugly what do I do???
-				SceneHierarchyPanel::addNewAnimObject(childObj);
+				glyphRun.addGlyph(glyphOutline.svg, glyph.codepoint, offset + cursorPos, glyphColor);
 			}
-
-			// TODO: I may have to add kerning info here
-			float advance = glyphOutline.advanceX;
-			if (isTab)
-			{
-				advance *= tabDepth;
-			}
-			cursorPos += Vec2{ advance, 0.0f };
 		}
 	}
 
@@ -454,10 +421,15 @@ namespace MathAnim
 				AnimationManager::removeAnimObject(am, obj->generatedChildrenIds[i]);
 			}
 		}
+		bool wasSplit = obj->generatedChildrenIds.size() > 0;
 		obj->generatedChildrenIds.clear();
 
-		// Next init again which should regenerate the children
-		init(am, obj->id);
+		// Next lay the glyphs out again and split them back up if they were split before
+		layoutGlyphs();
+		if (wasSplit)
+		{
+			glyphRun.splitIntoCharacters(am, obj->id);
+		}
 	}
 
 	void CodeBlock::serialize(RawMemory& memory) const
@@ -475,6 +447,15 @@ namespace MathAnim
 
 	void CodeBlock::free()
 	{
+		glyphRun.free();
+
+		if (this->tokens)
+		{
+			this->tokens->~TokenizedCode();
+			g_memory_free(this->tokens);
+			this->tokens = nullptr;
+		}
+
 		if (this->text)
 		{
 			g_memory_free(this->text);
@@ -513,6 +494,253 @@ int main()
 		g_memory_copyMem(res.text, (void*)defaultText, sizeof(defaultText) / sizeof(char));
 		res.textLength = (sizeof(defaultText) / sizeof(char)) - 1;
 		res.text[res.textLength] = '\0';
+		res.glyphRun = GlyphRun::createDefault();
+		res.layoutKey = 0;
+		res.tokens = nullptr;
+		return res;
+	}
+
+	void GlyphRun::addGlyph(SvgObject* svg, uint32 codepoint, const Vec2& offset, const glm::u8vec4& color)
+	{
+		// Text only uses a handful of distinct glyphs, so a linear search is plenty
+		int32 glyphId = 0;
+		while (glyphId < numOutlines && outlines[glyphId] != svg)
+		{
+			glyphId++;
+		}
+
+		if (glyphId == numOutlines)
+		{
+			if (numOutlines >= maxOutlines)
+			{
+				maxOutlines = maxOutlines == 0 ? 32 : maxOutlines * 2;
+				outlines = (SvgObject**)g_memory_realloc(outlines, sizeof(SvgObject*) * maxOutlines);
+			}
+			outlines[numOutlines] = svg;
+			numOutlines++;
+		}
+
+		if (numGlyphs >= maxGlyphs)
+		{
+			maxGlyphs = maxGlyphs == 0 ? 64 : maxGlyphs * 2;
+			glyphs = (GlyphInstance*)g_memory_realloc(glyphs, sizeof(GlyphInstance) * maxGlyphs);
+		}
+
+		GlyphInstance& glyph = glyphs[numGlyphs];
+		glyph.glyphId = (uint32)glyphId;
+		glyph.codepoint = codepoint;
+		glyph.offset = offset;
+		glyph.color = color;
+		glyph.percentCreated = 0.0f;
+		glyph.fillAlpha = 255;
+		glyph.strokeAlpha = 255;
+		numGlyphs++;
+
+		Vec2 halfSize = (svg->bbox.max - svg->bbox.min) / 2.0f;
+		bbox.min = CMath::min(bbox.min, offset - halfSize);
+		bbox.max = CMath::max(bbox.max, offset + halfSize);
+	}
+
+	void GlyphRun::resetState()
+	{
+		for (int32 i = 0; i < numGlyphs; i++)
+		{
+			glyphs[i].percentCreated = 0.0f;
+			glyphs[i].fillAlpha = 255;
+			glyphs[i].strokeAlpha = 255;
+		}
+
+		replacementId = NULL_ANIM_OBJECT;
+		percentReplaced = 0.0f;
+	}
+
+	void GlyphRun::morphTo(const GlyphRun& replacement, AnimObjId replacementObjId, float t)
+	{
+		replacementId = replacementObjId;
+		percentReplaced = t;
+
+		numMorphs = glm::min(numGlyphs, replacement.numGlyphs);
+		if (numMorphs > maxMorphs)
+		{
+			morphs = (GlyphMorph*)g_memory_realloc(morphs, sizeof(GlyphMorph) * numMorphs);
+			for (int32 i = maxMorphs; i < numMorphs; i++)
+			{
+				morphs[i].morph = (SvgMorph*)g_memory_allocate(sizeof(SvgMorph));
+				*morphs[i].morph = Svg::createDefaultMorph();
+				morphs[i].outline = (SvgObject*)g_memory_allocate(sizeof(SvgObject));
+				*morphs[i].outline = Svg::createDefault();
+				morphs[i].isBlended = false;
+			}
+			maxMorphs = numMorphs;
+		}
+
+		for (int32 i = 0; i < numMorphs; i++)
+		{
+			const SvgObject* src = outlines[glyphs[i].glyphId];
+			const SvgObject* dst = replacement.outlines[replacement.glyphs[i].glyphId];
+			GlyphMorph& glyphMorph = morphs[i];
+			glyphMorph.isBlended = false;
+			if (src == dst)
+			{
+				continue;
+			}
+
+			// The morph only gets prepared again when the pair of glyphs changes
+			bool morphReady = Svg::morphMatches(*glyphMorph.morph, src, dst) ||
+				Svg::prepareMorph(glyphMorph.morph, src, dst);
+			if (morphReady)
+			{
+				Svg::morph(*glyphMorph.morph, t, glyphMorph.outline);
+				glyphMorph.isBlended = true;
+			}
+		}
+
+		// Objects count as created while they're being replaced, so do their glyphs
+		for (int32 i = 0; i < numGlyphs; i++)
+		{
+			glyphs[i].percentCreated = 1.0f;
+		}
+	}
+
+	void GlyphRun::prefetch(AnimationManagerData* am, const AnimObject* parent) const
+	{
+		SvgCache* svgCache = Application::getSvgCache();
+		for (int32 i = 0; i < numOutlines; i++)
+		{
+			svgCache->prefetch(am, parent, outlines[i]);
+		}
+	}
+
+	void GlyphRun::render(AnimationManagerData* am, const AnimObject* parent) const
+	{
+		const AnimObject* replacement = AnimationManager::getObject(am, replacementId);
+		const GlyphRun* replacementRun = replacement ? replacement->getGlyphRun() : nullptr;
+		if (replacementRun)
+		{
+			renderReplacement(am, parent, *this, *replacementRun);
+			return;
+		}
+
+		// Every distinct glyph only gets looked up in the cache once, no matter how many
+		// times it shows up in the text
+		SvgCache* svgCache = Application::getSvgCache();
+		std::vector<SvgCacheEntry> entries;
+		entries.reserve(numOutlines);
+		for (int32 i = 0; i < numOutlines; i++)
+		{
+			entries.push_back(svgCache->getOrCreateIfNotExist(am, parent, outlines[i]));
+		}
+
+		// All the fills go in first, so glyphs that share a cache page stay in one batch
+		for (int32 i = 0; i < numGlyphs; i++)
+		{
+			const GlyphInstance& glyph = glyphs[i];
+			glm::u8vec4 fillColor = tintColor(glyph.color, parent->fillColor, glyph.fillAlpha);
+			if (fillColor.a == 0)
+			{
+				continue;
+			}
+
+			glm::mat4 transform = glm::translate(parent->globalTransform, glm::vec3(glyph.offset.x, glyph.offset.y, 0.0f));
+			drawGlyphFill(parent, entries[glyph.glyphId], outlines[glyph.glyphId], transform, fillColor);
+		}
+
+		for (int32 i = 0; i < numGlyphs; i++)
+		{
+			const GlyphInstance& glyph = glyphs[i];
+			if (parent->strokeWidth > 0.0f || glyph.percentCreated < 1.0f)
+			{
+				glm::mat4 transform = glm::translate(parent->globalTransform, glm::vec3(glyph.offset.x, glyph.offset.y, 0.0f));
+				glm::u8vec4 strokeColor = tintColor(glyph.color, parent->strokeColor, glyph.strokeAlpha);
+				outlines[glyph.glyphId]->renderOutline(glyph.percentCreated, transform, strokeColor, parent->strokeWidth);
+			}
+		}
+	}
+
+	void GlyphRun::splitIntoCharacters(AnimationManagerData* am, AnimObjId parentId)
+	{
+		for (int32 i = 0; i < numGlyphs; i++)
+		{
+			const GlyphInstance& glyph = glyphs[i];
+
+			// Add this character as a child
+			AnimObject childObj = AnimObject::createDefaultFromParent(am, AnimObjectTypeV1::SvgObject, parentId, true);
+			childObj.parentId = parentId;
+			childObj._positionStart = Vec3{ glyph.offset.x, glyph.offset.y, 0.0f };
+			childObj.isGenerated = true;
+			// Every copy of a letter references the font's outline for that glyph, it
+			// only gets its own geometry once an animation deforms it
+			childObj._svgObjectStart = (SvgObject*)g_memory_allocate(sizeof(SvgObject));
+			childObj.svgObject = (SvgObject*)g_memory_allocate(sizeof(SvgObject));
+			*(childObj._svgObjectStart) = Svg::createDefault();
+			*(childObj.svgObject) = Svg::createDefault();
+			Svg::share(childObj._svgObjectStart, outlines[glyph.glyphId]);
+
+			childObj._fillColorStart = tintColor(glyph.color, childObj._fillColorStart, 255);
+			childObj.fillColor = childObj._fillColorStart;
+			childObj._strokeColorStart = tintColor(glyph.color, childObj._strokeColorStart, 255);
+			childObj.strokeColor = childObj._strokeColorStart;
+
+			// Name the child after its character
+			uint8 utf8[4];
+			int utf8Length = Utf8::encode(glyph.codepoint, utf8);
+			childObj.name = (uint8*)g_memory_realloc(childObj.name, sizeof(uint8) * (utf8Length + 1));
+			childObj.nameLength = utf8Length;
+			g_memory_copyMem(childObj.name, utf8, sizeof(uint8) * utf8Length);
+			childObj.name[utf8Length] = '\0';
+
+			AnimationManager::addAnimObject(am, childObj);
+			// TODO: Ugly what do I do???
+			SceneHierarchyPanel::addNewAnimObject(childObj);
+		}
+
+		free();
+	}
+
+	void GlyphRun::free()
+	{
+		if (outlines)
+		{
+			g_memory_free(outlines);
+		}
+
+		if (glyphs)
+		{
+			g_memory_free(glyphs);
+		}
+
+		for (int32 i = 0; i < maxMorphs; i++)
+		{
+			morphs[i].morph->free();
+			g_memory_free(morphs[i].morph);
+			morphs[i].outline->free();
+			g_memory_free(morphs[i].outline);
+		}
+
+		if (morphs)
+		{
+			g_memory_free(morphs);
+		}
+
+		*this = createDefault();
+	}
+
+	GlyphRun GlyphRun::createDefault()
+	{
+		GlyphRun res;
+		res.outlines = nullptr;
+		res.numOutlines = 0;
+		res.maxOutlines = 0;
+		res.glyphs = nullptr;
+		res.numGlyphs = 0;
+		res.maxGlyphs = 0;
+		res.bbox.min = Vec2{ FLT_MAX, FLT_MAX };
+		res.bbox.max = Vec2{ -FLT_MAX, -FLT_MAX };
+		res.replacementId = NULL_ANIM_OBJECT;
+		res.percentReplaced = 0.0f;
+		res.morphs = nullptr;
+		res.numMorphs = 0;
+		res.maxMorphs = 0;
 		return res;
 	}
 
@@ -538,9 +766,16 @@ int main()
 		memory.readDangerous((uint8*)fontFilepath, sizeof(uint8) * fontFilepathLength);
 		fontFilepath[fontFilepathLength] = '\0';
 
-		res.font = Fonts::loadFont((const char*)fontFilepath);
+		// Projects are laid out after every object is read, so their fonts can load in
+		// the background in the meantime
+		res.font = Fonts::loadFontAsync((const char*)fontFilepath, CharRange::Ascii);
 		g_memory_free(fontFilepath);
 
+		// The glyphs get laid out by the owning object, unless it was saved with its
+		// characters split into children
+		res.glyphRun = GlyphRun::createDefault();
+		res.layoutKey = 0;
+
 		return res;
 	}
 
@@ -582,6 +817,109 @@ int main()
 		memory.readDangerous((uint8*)res.text, sizeof(uint8) * res.textLength);
 		res.text[res.textLength] = '\0';
 
+		res.glyphRun = GlyphRun::createDefault();
+		res.layoutKey = 0;
+		res.tokens = nullptr;
+
 		return res;
 	}
+
+	static glm::u8vec4 tintColor(const glm::u8vec4& color, const glm::u8vec4& tint, uint8 alpha)
+	{
+		// alpha scales the tint's alpha, so fading the text object fades every glyph
+		return glm::u8vec4(
+			(uint8)((uint32)color.r * (uint32)tint.r / 255),
+			(uint8)((uint32)color.g * (uint32)tint.g / 255),
+			(uint8)((uint32)color.b * (uint32)tint.b / 255),
+			(uint8)((uint32)color.a * (uint32)tint.a * (uint32)alpha / (255 * 255))
+		);
+	}
+
+	static void drawGlyphFill(const AnimObject* parent, const SvgCacheEntry& entry, const SvgObject* svg, const glm::mat4& transform, const glm::u8vec4& fillColor)
+	{
+		Vec2 svgSize = svg->bbox.max - svg->bbox.min;
+		if (parent->is3D)
+		{
+			Renderer::drawTexturedQuad3D(
+				entry.textureRef,
+				svgSize,
+				entry.texCoordsMin,
+				entry.texCoordsMax,
+				transform,
+				parent->isTransparent
+			);
+		}
+		else
+		{
+			Renderer::drawTexturedQuad(
+				entry.textureRef,
+				svgSize,
+				entry.texCoordsMin,
+				entry.texCoordsMax,
+				Vec4{
+					(float)fillColor.r / 255.0f,
+					(float)fillColor.g / 255.0f,
+					(float)fillColor.b / 255.0f,
+					(float)fillColor.a / 255.0f
+				},
+				parent->id,
+				transform
+			);
+		}
+	}
+
+	static void drawGlyph(AnimationManagerData* am, const AnimObject* parent, SvgObject* svg, const Vec2& offset, const glm::u8vec4& color, uint8 fillAlpha, uint8 strokeAlpha, float percentCreated)
+	{
+		glm::mat4 transform = glm::translate(parent->globalTransform, glm::vec3(offset.x, offset.y, 0.0f));
+		glm::u8vec4 fillColor = tintColor(color, parent->fillColor, fillAlpha);
+		if (fillColor.a > 0)
+		{
+			SvgCacheEntry entry = Application::getSvgCache()->getOrCreateIfNotExist(am, parent, svg);
+			drawGlyphFill(parent, entry, svg, transform, fillColor);
+		}
+
+		if (parent->strokeWidth > 0.0f || percentCreated < 1.0f)
+		{
+			glm::u8vec4 strokeColor = tintColor(color, parent->strokeColor, strokeAlpha);
+			svg->renderOutline(percentCreated, transform, strokeColor, parent->strokeWidth);
+		}
+	}
+
+	static void renderReplacement(AnimationManagerData* am, const AnimObject* parent, const GlyphRun& run, const GlyphRun& replacement)
+	{
+		// The blended outlines are new shapes every frame, so this doesn't bother batching
+		// fills the way the regular path does. Replacements only last a few seconds.
+		float t = run.percentReplaced;
+		for (int32 i = 0; i < run.numGlyphs; i++)
+		{
+			const GlyphInstance& glyph = run.glyphs[i];
+			if (i < run.numMorphs && i < replacement.numGlyphs)
+			{
+				const GlyphInstance& other = replacement.glyphs[i];
+				SvgObject* svg = run.morphs[i].isBlended
+					? run.morphs[i].outline
+					: run.outlines[glyph.glyphId];
+				drawGlyph(am, parent, svg,
+					CMath::interpolate(t, glyph.offset, other.offset),
+					CMath::interpolate(t, glyph.color, other.color),
+					glyph.fillAlpha, glyph.strokeAlpha, glyph.percentCreated);
+			}
+			else
+			{
+				// Glyphs the replacement doesn't have fade out
+				drawGlyph(am, parent, run.outlines[glyph.glyphId], glyph.offset, glyph.color,
+					(uint8)((float)glyph.fillAlpha * (1.0f - t)),
+					(uint8)((float)glyph.strokeAlpha * (1.0f - t)),
+					glyph.percentCreated);
+			}
+		}
+
+		// And the ones only the replacement has fade in
+		for (int32 i = run.numGlyphs; i < replacement.numGlyphs; i++)
+		{
+			const GlyphInstance& other = replacement.glyphs[i];
+			drawGlyph(am, parent, replacement.outlines[other.glyphId], other.offset, other.color,
+				(uint8)(255.0f * t), (uint8)(255.0f * t), 1.0f);
+		}
+	}
 }
\ No newline at end of file
@@ -5,6 +5,7 @@
 #include "core/GladLayer.h"
 #include "core/ImGuiLayer.h"
 #include "core/Colors.h"
+#include "core/CommandLine.h"
 #include "renderer/Renderer.h"
 #include "renderer/OrthoCamera.h"
 #include "renderer/PerspectiveCamera.h"
@@ -32,7 +33,11 @@
 #include "latex/LaTexLayer.h"
 #include "multithreading/GlobalThreadPool.h"
 #include "video/Encoder.h"
+#include "video/ShardedExport.h"
+#include "video/ExportCheckpoint.h"
+#include "video/RawFrameWriter.h"
 #include "utils/TableOfContents.h"
+#include "utils/Hash.h"
 #include "scripting/LuauLayer.h"
 
 #include <imgui.h>
@@ -43,6 +48,7 @@ namespace MathAnim
 	namespace Application
 	{
 		static AnimState animState = AnimState::Pause;
+		static bool isHeadless = false;
 		static bool outputVideoFile = false;
 		static std::string outputVideoFilename = "";
 
@@ -64,6 +70,9 @@ namespace MathAnim
 		static float accumulatedTime = 0.0f;
 		static std::string currentProjectRoot;
 		static VideoEncoder encoder = {};
+		// Headless exports can stream raw frames to an external encoder instead
+		static RawFrameFormat rawFrameFormat = RawFrameFormat::None;
+		static RawFrameOutput rawOutput = {};
 		static SceneData sceneData = {};
 		static bool reloadCurrentScene = false;
 		static bool saveCurrentSceneOnReload = true;
@@ -71,6 +80,21 @@ namespace MathAnim
 		static SvgCache* svgCache = nullptr;
 		static float deltaTime = 0.0f;
 
+		// Static hold detection for exports. When nothing could have changed since the
+		// last frame we actually rendered, the encoder just gets that frame again.
+		static int lastExportedFrame = -1;
+		static uint64 lastExportedEditCounter = 0;
+		static bool lastExportHadPendingWork = false;
+		static bool editorWasActive = false;
+		// When set, held frames are rendered anyway and compared against the previous
+		// frame's hash to make sure the detection didn't skip a real change
+		static bool verifyHeldFrames = false;
+		static uint64 lastExportedFrameHash = 0;
+		static int heldFrameMismatches = 0;
+
+		// Length of each checkpoint segment for headless exports
+		static constexpr int checkpointSegmentSeconds = 10;
+
 		static const char* winTitle = "Math Animations";
 
 		// ------- Internal Functions -------
@@ -80,9 +104,19 @@ namespace MathAnim
 		static void reloadCurrentSceneInternal();
 		static void initializeSceneSystems();
 		static void freeSceneSystems();
+		static void resetStaticHoldDetection();
+		static bool isStaticHold(int frame);
+		static void markFrameExported(int frame, bool wasHold, uint64 editCounterBeforeRender, bool hadPendingWork);
+		static bool encodeExportFrame(bool isHold);
+		static bool renderHeadlessRange(const std::string& outputFilename, int frameStart, int frameEnd, int* framesEncoded);
+		static bool finishExport();
+		static bool pushExportFrame(Pixel* pixels);
+		static bool pushExportDuplicateFrame();
 
-		void init(const char* projectFile)
+		void init(const char* projectFile, bool headless)
 		{
+			isHeadless = headless;
+
 			// Initialize these just in case this is a new project
 			editorCamera2D.position = Vec2{ viewportWidth / 2.0f, viewportHeight / 2.0f };
 			editorCamera2D.projectionSize = Vec2{ viewportWidth, viewportHeight };
@@ -97,9 +131,17 @@ namespace MathAnim
 			//globalThreadPool = new GlobalThreadPool(true);
 
 			// Initiaize GLFW/Glad
-			GladLayer::init();
-			window = new Window(1920, 1080, winTitle, WindowFlags::OpenMaximized);
-			window->setVSync(true);
+			GladLayer::init(isHeadless);
+			if (isHeadless)
+			{
+				// We only need the GL context, nothing is ever presented to this window
+				window = new Window(1, 1, winTitle, WindowFlags::Hidden);
+			}
+			else
+			{
+				window = new Window(1920, 1080, winTitle, WindowFlags::OpenMaximized);
+				window->setVSync(true);
+			}
 
 			// Initialize Onigiruma
 			OnigEncoding use_encs[1];
@@ -108,8 +150,11 @@ namespace MathAnim
 
 			Fonts::init();
 			Renderer::init();
-			ImGuiLayer::init(*window);
-			Audio::init();
+			if (!isHeadless)
+			{
+				ImGuiLayer::init(*window);
+				Audio::init();
+			}
 			GizmoManager::init();
 			Svg::init();
 			SceneManagementPanel::init();
@@ -119,7 +164,10 @@ namespace MathAnim
 			LaTexLayer::init();
 
 			mainFramebuffer = AnimationManager::prepareFramebuffer(outputWidth, outputHeight);
-			editorFramebuffer = AnimationManager::prepareFramebuffer(outputWidth, outputHeight);
+			if (!isHeadless)
+			{
+				editorFramebuffer = AnimationManager::prepareFramebuffer(outputWidth, outputHeight);
+			}
 
 			currentProjectRoot = std::filesystem::path(projectFile).parent_path().string() + "/";
 
@@ -131,11 +179,15 @@ namespace MathAnim
 				sceneData.currentScene = 0;
 			}
 
-			EditorGui::init(am, currentProjectRoot);
-			LuauLayer::init(currentProjectRoot + "/scripts", am);
+			if (!isHeadless)
+			{
+				EditorGui::init(am, currentProjectRoot);
+				LuauLayer::init(currentProjectRoot + "/scripts", am);
+			}
 
 			svgCache = new SvgCache();
 			svgCache->init();
+			svgCache->openDiskCache(currentProjectRoot + "cache/svg");
 
 			GL::enable(GL_BLEND);
 			GL::blendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
@@ -183,6 +235,11 @@ namespace MathAnim
 
 				absolutePrevFrame = absoluteCurrentFrame;
 
+				// Snapshot the scene state before anything this frame gets a chance to edit it
+				bool exportIsHold = outputVideoFile && !editorWasActive && isStaticHold(absoluteCurrentFrame);
+				uint64 editCounterBeforeRender = AnimationManager::getEditCounter(am);
+				bool hadPendingWork = LaTexLayer::hasPendingWork();
+
 				// Update systems all systems/collect systems draw calls
 				GizmoManager::update(am);
 				EditorCameraController::updateOrtho(editorCamera2D);
@@ -194,7 +251,10 @@ namespace MathAnim
 				// Render all animation draw calls to main framebuffer
 				bool renderPickingOutline = false;
 
-				if (EditorGui::mainViewportActive() || outputVideoFile)
+				// Held export frames reuse the last encoded frame, so there's no reason to
+				// render them unless the viewport is showing it or we're verifying holds
+				bool exportNeedsRender = outputVideoFile && (!exportIsHold || verifyHeldFrames);
+				if (EditorGui::mainViewportActive() || exportNeedsRender)
 				{
 					Renderer::renderToFramebuffer(mainFramebuffer, colors[(uint8)Color::GreenBrown], am, renderPickingOutline);
 				}
@@ -207,6 +267,8 @@ namespace MathAnim
 					Renderer::renderToFramebuffer(editorFramebuffer, Colors::Neutral[7], editorCamera2D, editorCamera3D, renderPickingOutline);
 				}
 				Renderer::endFrame();
+				// All draw calls have been flushed, so entries can safely move around in the SVG cache
+				svgCache->defragmentStep();
 
 				// Bind the window framebuffer and render ImGui results
 				GL::bindFramebuffer(GL_FRAMEBUFFER, 0);
@@ -221,6 +283,8 @@ namespace MathAnim
 				ImGui::ShowDemoWindow();
 				SceneManagementPanel::update(sceneData);
 				EditorGui::update(mainFramebuffer, editorFramebuffer, am);
+				// Anything being dragged or typed into can edit the scene behind our back
+				editorWasActive = ImGui::IsAnyItemActive();
 				ImGuiLayer::endFrame();
 				GL::popDebugGroup();
 
@@ -230,11 +294,9 @@ namespace MathAnim
 				// TODO: Abstract this stuff out of here
 				if (outputVideoFile && absoluteCurrentFrame > -1)
 				{
-					Pixel* pixels = mainFramebuffer.readAllPixelsRgb8(0, true);
-
 					// TODO: Add a hardware accelerated version that usee CUDA and NVENC
-					VideoWriter::pushFrame(pixels, outputWidth * outputHeight, encoder);
-					mainFramebuffer.freePixels(pixels);
+					encodeExportFrame(exportIsHold);
+					markFrameExported(absoluteCurrentFrame, exportIsHold, editCounterBeforeRender, hadPendingWork);
 
 					if (absoluteCurrentFrame >= AnimationManager::lastAnimatedFrame(am))
 					{
@@ -297,6 +359,101 @@ namespace MathAnim
 			mainFramebuffer.freePixels(pixels);
 		}
 
+		bool renderHeadless(const HeadlessRenderOptions& options)
+		{
+			g_logger_assert(isHeadless, "Application::renderHeadless called on an application initialized with an editor.");
+
+			if (options.sceneName != "" && options.sceneName != sceneData.sceneNames[sceneData.currentScene])
+			{
+				auto sceneIter = std::find(sceneData.sceneNames.begin(), sceneData.sceneNames.end(), options.sceneName);
+				if (sceneIter == sceneData.sceneNames.end())
+				{
+					g_logger_error("Project does not contain a scene named '%s'.", options.sceneName.c_str());
+					return false;
+				}
+
+				// Nothing to save here, just load the requested scene into a blank slate
+				sceneData.currentScene = (int)(sceneIter - sceneData.sceneNames.begin());
+				freeSceneSystems();
+				initializeSceneSystems();
+				loadScene(sceneData.sceneNames[sceneData.currentScene]);
+			}
+
+			int frameStart = options.frameStart;
+			int frameEnd = options.frameEnd >= 0
+				? options.frameEnd
+				: AnimationManager::lastAnimatedFrame(am);
+			if (frameEnd < frameStart)
+			{
+				g_logger_error("Invalid frame range [%d, %d] for scene '%s'.", frameStart, frameEnd, sceneData.sceneNames[sceneData.currentScene].c_str());
+				return false;
+			}
+
+			if (options.numWorkers > 1)
+			{
+				// This process only coordinates, the workers do the rendering. The SVG disk
+				// cache is closed first so the write lock goes to a worker instead of every
+				// worker opening it read only and throwing its rasters away.
+				svgCache->getDiskCache().close();
+				return ShardedExport::run(options, sceneData.sceneNames[sceneData.currentScene], frameStart, frameEnd);
+			}
+
+			g_logger_info("Rendering scene '%s' frames [%d, %d] to '%s'.",
+				sceneData.sceneNames[sceneData.currentScene].c_str(), frameStart, frameEnd, options.outputFilename.c_str());
+
+			svgCache->clearAll();
+			verifyHeldFrames = options.verifyHeldFrames;
+			rawFrameFormat = options.rawFormat;
+			bool success = true;
+			int framesEncoded = 0;
+			double startTime = glfwGetTime();
+
+			if (!options.useCheckpoints)
+			{
+				success = renderHeadlessRange(options.outputFilename, frameStart, frameEnd, &framesEncoded);
+			}
+			else
+			{
+				int framesPerSegment = options.framesPerShard > 0
+					? options.framesPerShard
+					: framerate * checkpointSegmentSeconds;
+
+				ExportManifest manifest;
+				bool manifestReady = options.resume
+					? ExportCheckpoint::resume(&manifest, options.outputFilename, sceneData.sceneNames[sceneData.currentScene], frameStart, frameEnd)
+					: ExportCheckpoint::create(&manifest, options.outputFilename, sceneData.sceneNames[sceneData.currentScene], frameStart, frameEnd, framesPerSegment);
+				if (!manifestReady)
+				{
+					return false;
+				}
+
+				for (size_t i = 0; i < manifest.segments.size(); i++)
+				{
+					const ExportSegment& segment = manifest.segments[i];
+					if (segment.complete)
+					{
+						continue;
+					}
+
+					if (!renderHeadlessRange(segment.filename, segment.frameStart, segment.frameEnd, &framesEncoded) ||
+						!ExportCheckpoint::markComplete(manifest, i))
+					{
+						g_logger_error("Export stopped. Finished segments are kept in '%s', run again with --resume to continue.", manifest.segmentDir.c_str());
+						success = false;
+						break;
+					}
+				}
+
+				success = success && ExportCheckpoint::finalize(manifest);
+			}
+
+			double elapsedTime = glfwGetTime() - startTime;
+			g_logger_info("Rendered %d frames in %2.3fs (%2.2f fps).",
+				framesEncoded, elapsedTime, elapsedTime > 0.0 ? (double)framesEncoded / elapsedTime : 0.0);
+
+			return success;
+		}
+
 		void free()
 		{
 			svgCache->free();
@@ -305,25 +462,38 @@ namespace MathAnim
 			// Free it just in case, if the encoder isn't active this does nothing
 			VideoWriter::freeEncoder(encoder);
 
-			saveProject();
+			// Headless renders never modify the project, so don't touch the files on disk
+			if (!isHeadless)
+			{
+				saveProject();
+			}
 
 			mainFramebuffer.destroy();
-			editorFramebuffer.destroy();
+			if (!isHeadless)
+			{
+				editorFramebuffer.destroy();
+			}
 
 			onig_end();
 			Highlighters::free();
 			LaTexLayer::free();
 			EditorSettings::free();
-			LuauLayer::free();
 			SceneManagementPanel::free();
-			EditorGui::free(am);
+			if (!isHeadless)
+			{
+				LuauLayer::free();
+				EditorGui::free(am);
+			}
 			AnimationManager::free(am);
 			Fonts::unloadAllFonts();
 			Renderer::free();
 			GizmoManager::free();
-			Audio::free();
 
-			ImGuiLayer::free();
+			if (!isHeadless)
+			{
+				Audio::free();
+				ImGuiLayer::free();
+			}
 			Window::cleanup();
 			globalThreadPool->free();
 			delete globalThreadPool;
@@ -436,8 +606,16 @@ namespace MathAnim
 			if (timelineData.data)
 			{
 				TimelineData timeline = Timeline::deserialize(timelineData);
-				EditorGui::setTimelineData(timeline);
 				loadedProjectCurrentFrame = timeline.currentFrame;
+				if (isHeadless)
+				{
+					// There's no timeline panel to hand this off to
+					Timeline::freeInstance(timeline);
+				}
+				else
+				{
+					EditorGui::setTimelineData(timeline);
+				}
 			}
 			if (animationData.data)
 			{
@@ -545,6 +723,7 @@ namespace MathAnim
 			{
 				absoluteCurrentFrame = -1;
 				outputVideoFile = true;
+				resetStaticHoldDetection();
 			}
 		}
 
@@ -555,16 +734,7 @@ namespace MathAnim
 
 		void endExport()
 		{
-			if (VideoWriter::finalizeEncodingFile(encoder))
-			{
-				g_logger_info("Finished exporting video file.");
-			}
-			else
-			{
-				g_logger_error("Failed to finalize encoding video file: %s", encoder.filename);
-			}
-			VideoWriter::freeEncoder(encoder);
-			outputVideoFile = false;
+			finishExport();
 		}
 
 		OrthoCamera* getEditorCamera()
@@ -634,6 +804,177 @@ namespace MathAnim
 			EditorGui::init(am, currentProjectRoot);
 		}
 
+		static bool renderHeadlessRange(const std::string& outputFilename, int frameStart, int frameEnd, int* framesEncoded)
+		{
+			bool started = rawFrameFormat != RawFrameFormat::None
+				? RawFrameWriter::open(&rawOutput, outputFilename.c_str(), rawFrameFormat, outputWidth, outputHeight, framerate)
+				: VideoWriter::startEncodingFile(&encoder, outputFilename.c_str(), outputWidth, outputHeight, framerate, 60, true);
+			if (!started)
+			{
+				return false;
+			}
+
+			outputVideoFile = true;
+			// Every file starts with a freshly rendered frame, there's nothing to duplicate yet
+			resetStaticHoldDetection();
+			bool success = true;
+
+			for (int frame = frameStart; frame <= frameEnd; frame++)
+			{
+				bool isHold = isStaticHold(frame);
+				uint64 editCounterBeforeRender = AnimationManager::getEditCounter(am);
+				bool hadPendingWork = LaTexLayer::hasPendingWork();
+
+				// Held frames don't touch the scene at all. The next frame that does get
+				// rendered just applies a bigger delta from the last rendered frame.
+				if (!isHold || verifyHeldFrames)
+				{
+					// The first iteration seeks straight to the start frame, every frame
+					// after that is a delta from the previous rendered frame
+					absoluteCurrentFrame = frame;
+					int deltaFrame = absoluteCurrentFrame - absolutePrevFrame;
+					absolutePrevFrame = absoluteCurrentFrame;
+
+					AnimationManager::render(am, deltaFrame);
+					LaTexLayer::update();
+
+					Renderer::renderToFramebuffer(mainFramebuffer, colors[(uint8)Color::GreenBrown], am, false);
+					Renderer::endFrame();
+					AnimationManager::endFrame(am);
+				}
+
+				success = encodeExportFrame(isHold);
+				if (!success)
+				{
+					g_logger_error("Failed to encode frame %d. Stopping render.", frame);
+					break;
+				}
+
+				markFrameExported(frame, isHold, editCounterBeforeRender, hadPendingWork);
+				(*framesEncoded)++;
+			}
+
+			return finishExport() && success;
+		}
+
+		static bool finishExport()
+		{
+			int duplicateFrameCount = rawFrameFormat != RawFrameFormat::None ? rawOutput.duplicateFrameCount : encoder.duplicateFrameCount;
+			int frameCount = rawFrameFormat != RawFrameFormat::None ? rawOutput.frameCounter : encoder.frameCounter;
+			g_logger_info("Skipped rendering %d of %d frames that were static holds.", duplicateFrameCount, frameCount);
+			if (heldFrameMismatches > 0)
+			{
+				g_logger_warning("%d frames were detected as static holds but rendered differently.", heldFrameMismatches);
+			}
+
+			if (rawFrameFormat != RawFrameFormat::None)
+			{
+				outputVideoFile = false;
+				return RawFrameWriter::close(rawOutput);
+			}
+
+			bool success = VideoWriter::finalizeEncodingFile(encoder);
+			if (success)
+			{
+				g_logger_info("Finished exporting video file.");
+			}
+			else
+			{
+				g_logger_error("Failed to finalize encoding video file: %s", encoder.filename);
+			}
+			VideoWriter::freeEncoder(encoder);
+			outputVideoFile = false;
+
+			return success;
+		}
+
+		static void resetStaticHoldDetection()
+		{
+			lastExportedFrame = -1;
+			lastExportedEditCounter = 0;
+			lastExportHadPendingWork = false;
+			lastExportedFrameHash = 0;
+			heldFrameMismatches = 0;
+		}
+
+		static bool isStaticHold(int frame)
+		{
+			if (lastExportedFrame < 0 || lastExportHadPendingWork)
+			{
+				return false;
+			}
+
+			if (AnimationManager::getEditCounter(am) != lastExportedEditCounter)
+			{
+				return false;
+			}
+
+			return !AnimationManager::hasAnimationsActiveBetween(am, lastExportedFrame, frame);
+		}
+
+		static void markFrameExported(int frame, bool wasHold, uint64 editCounterBeforeRender, bool hadPendingWork)
+		{
+			// Holds are measured from the last frame that actually got rendered
+			if (!wasHold)
+			{
+				lastExportedFrame = frame;
+			}
+
+			// Use the counter from before this frame was rendered. Any edits made while
+			// rendering (queued objects, inspector changes) force the next frame to render.
+			lastExportedEditCounter = editCounterBeforeRender;
+			lastExportHadPendingWork = hadPendingWork;
+		}
+
+		static bool encodeExportFrame(bool isHold)
+		{
+			if (isHold && !verifyHeldFrames)
+			{
+				return pushExportDuplicateFrame();
+			}
+
+			Pixel* pixels = mainFramebuffer.readAllPixelsRgb8(0, true);
+			bool res;
+			if (verifyHeldFrames)
+			{
+				// Only used to spot static holds, so a fast non-cryptographic hash is fine
+				uint64 hash = Hash::fnv1a(pixels, sizeof(Pixel) * (size_t)outputWidth * (size_t)outputHeight);
+				bool matchesLastFrame = hash == lastExportedFrameHash;
+				lastExportedFrameHash = hash;
+
+				if (isHold && !matchesLastFrame)
+				{
+					g_logger_warning("Frame %d was detected as a static hold but rendered differently. Encoding the rendered frame.", absoluteCurrentFrame);
+					heldFrameMismatches++;
+				}
+
+				res = isHold && matchesLastFrame
+					? pushExportDuplicateFrame()
+					: pushExportFrame(pixels);
+			}
+			else
+			{
+				res = pushExportFrame(pixels);
+			}
+			mainFramebuffer.freePixels(pixels);
+
+			return res;
+		}
+
+		static bool pushExportFrame(Pixel* pixels)
+		{
+			return rawFrameFormat != RawFrameFormat::None
+				? RawFrameWriter::pushFrame(pixels, outputWidth * outputHeight, rawOutput)
+				: VideoWriter::pushFrame(pixels, outputWidth * outputHeight, encoder);
+		}
+
+		static bool pushExportDuplicateFrame()
+		{
+			return rawFrameFormat != RawFrameFormat::None
+				? RawFrameWriter::pushDuplicateFrame(rawOutput)
+				: VideoWriter::pushDuplicateFrame(encoder);
+		}
+
 		static void freeSceneSystems()
 		{
 			AnimationManager::free(am);
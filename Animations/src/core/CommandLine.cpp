@@ -0,0 +1,240 @@
+#include "core/CommandLine.h"
+
+namespace MathAnim
+{
+	namespace CommandLine
+	{
+		// ------------- Internal Functions -------------
+		static bool parseFrameRange(const char* str, int* frameStart, int* frameEnd);
+
+		CommandLineMode parse(int argc, char** argv, HeadlessRenderOptions* options, SvgBenchmarkOptions* benchmarkOptions)
+		{
+			g_logger_assert(options != nullptr, "Cannot parse command line into null options.");
+			g_logger_assert(benchmarkOptions != nullptr, "Cannot parse command line into null benchmark options.");
+
+			options->projectFile = "";
+			options->sceneName = "";
+			options->outputFilename = "";
+			options->frameStart = 0;
+			options->frameEnd = -1;
+			options->numWorkers = 1;
+			options->framesPerShard = 0;
+			options->executablePath = argc > 0 ? argv[0] : "";
+			options->verifyHeldFrames = false;
+			options->useCheckpoints = true;
+			options->resume = false;
+			options->rawFormat = RawFrameFormat::None;
+			benchmarkOptions->corpusDir = "";
+			benchmarkOptions->iterations = 20;
+
+			if (argc <= 1)
+			{
+				return CommandLineMode::Editor;
+			}
+
+			bool isRender = false;
+			bool isBenchmark = false;
+			for (int i = 1; i < argc; i++)
+			{
+				const char* arg = argv[i];
+				bool hasValue = i + 1 < argc;
+
+				if (std::strcmp(arg, "--render") == 0 && hasValue)
+				{
+					isRender = true;
+					std::filesystem::path projectPath = argv[++i];
+					if (std::filesystem::is_directory(projectPath))
+					{
+						projectPath /= "project.bin";
+					}
+					options->projectFile = projectPath.string();
+				}
+				else if (std::strcmp(arg, "--scene") == 0 && hasValue)
+				{
+					options->sceneName = argv[++i];
+				}
+				else if (std::strcmp(arg, "--frames") == 0 && hasValue)
+				{
+					if (!parseFrameRange(argv[++i], &options->frameStart, &options->frameEnd))
+					{
+						g_logger_error("Invalid frame range '%s'. Expected '<start>:<end>'.", argv[i]);
+						return CommandLineMode::Invalid;
+					}
+				}
+				else if (std::strcmp(arg, "--workers") == 0 && hasValue)
+				{
+					options->numWorkers = std::atoi(argv[++i]);
+					if (options->numWorkers <= 0)
+					{
+						g_logger_error("Invalid worker count '%s'.", argv[i]);
+						return CommandLineMode::Invalid;
+					}
+				}
+				else if (std::strcmp(arg, "--shard-frames") == 0 && hasValue)
+				{
+					options->framesPerShard = std::atoi(argv[++i]);
+					if (options->framesPerShard <= 0)
+					{
+						g_logger_error("Invalid shard size '%s'.", argv[i]);
+						return CommandLineMode::Invalid;
+					}
+				}
+				else if (std::strcmp(arg, "--verify-holds") == 0)
+				{
+					options->verifyHeldFrames = true;
+				}
+				else if (std::strcmp(arg, "--resume") == 0)
+				{
+					options->resume = true;
+				}
+				else if (std::strcmp(arg, "--no-checkpoints") == 0)
+				{
+					options->useCheckpoints = false;
+				}
+				else if (std::strcmp(arg, "--raw") == 0 && hasValue)
+				{
+					options->rawFormat = RawFrameWriter::parseFormat(argv[++i]);
+					if (options->rawFormat == RawFrameFormat::None)
+					{
+						g_logger_error("Unknown raw frame format '%s'. Expected rgb24, yuv420p or y4m.", argv[i]);
+						return CommandLineMode::Invalid;
+					}
+				}
+				else if (std::strcmp(arg, "--out") == 0 && hasValue)
+				{
+					options->outputFilename = argv[++i];
+				}
+				else if (std::strcmp(arg, "--bench-svg") == 0 && hasValue)
+				{
+					isBenchmark = true;
+					benchmarkOptions->corpusDir = argv[++i];
+				}
+				else if (std::strcmp(arg, "--iterations") == 0 && hasValue)
+				{
+					benchmarkOptions->iterations = std::atoi(argv[++i]);
+					if (benchmarkOptions->iterations <= 0)
+					{
+						g_logger_error("Invalid iteration count '%s'.", argv[i]);
+						return CommandLineMode::Invalid;
+					}
+				}
+				else
+				{
+					g_logger_error("Unknown or incomplete command line argument '%s'.", arg);
+					return CommandLineMode::Invalid;
+				}
+			}
+
+			if (isBenchmark)
+			{
+				if (isRender)
+				{
+					g_logger_error("--bench-svg can't be combined with --render.");
+					return CommandLineMode::Invalid;
+				}
+
+				if (!std::filesystem::is_directory(benchmarkOptions->corpusDir))
+				{
+					g_logger_error("Could not find benchmark corpus directory '%s'.", benchmarkOptions->corpusDir.c_str());
+					return CommandLineMode::Invalid;
+				}
+
+				return CommandLineMode::BenchmarkSvgParser;
+			}
+
+			if (!isRender)
+			{
+				return CommandLineMode::Invalid;
+			}
+
+			if (!std::filesystem::exists(options->projectFile))
+			{
+				g_logger_error("Could not find project file '%s'.", options->projectFile.c_str());
+				return CommandLineMode::Invalid;
+			}
+
+			if (options->outputFilename == "")
+			{
+				g_logger_error("Headless render requires an output file. Use '--out <file.mp4>'.");
+				return CommandLineMode::Invalid;
+			}
+
+			if (options->rawFormat != RawFrameFormat::None)
+			{
+				// A stream can't be split up or picked back up later, it's consumed as it's written
+				if (options->numWorkers > 1 || options->resume)
+				{
+					g_logger_error("Raw frame output can't be used with --workers or --resume.");
+					return CommandLineMode::Invalid;
+				}
+				options->useCheckpoints = false;
+			}
+
+			if (options->resume && !options->useCheckpoints)
+			{
+				g_logger_error("Cannot resume an export without checkpoints.");
+				return CommandLineMode::Invalid;
+			}
+
+			return CommandLineMode::HeadlessRender;
+		}
+
+		void printUsage(const char* programName)
+		{
+			g_logger_info("Usage:\n"
+				"  %s                  Open the project selector and editor\n"
+				"  %s --render <projectDir> --out <file.mp4> [options]\n"
+				"  %s --bench-svg <corpusDir> [--iterations <n>]\n"
+				"\n"
+				"Headless render options:\n"
+				"  --scene <name>      Scene to render, defaults to the scene last open in the editor\n"
+				"  --frames <s>:<e>    Inclusive frame range to render, defaults to the whole scene\n"
+				"  --workers <n>       Split the range into shards rendered by <n> worker processes\n"
+				"  --shard-frames <n>  Frames per shard/checkpoint segment, picked automatically by default\n"
+				"  --verify-holds      Render frames that didn't change anyway and check they match\n"
+				"  --resume            Continue an interrupted export from its last finished segment\n"
+				"  --no-checkpoints    Write straight to the output file, an interrupted export can't be resumed\n"
+				"  --raw <format>      Stream rgb24, yuv420p or y4m frames to --out instead of encoding them.\n"
+				"                      --out can be a named pipe, or - for stdout\n"
+				"\n"
+				"SVG parser benchmark options:\n"
+				"  --iterations <n>    Times each file in the corpus gets parsed, defaults to 20",
+				programName, programName, programName);
+		}
+
+		// ------------- Internal Functions -------------
+		static bool parseFrameRange(const char* str, int* frameStart, int* frameEnd)
+		{
+			const char* separator = std::strchr(str, ':');
+			if (!separator)
+			{
+				return false;
+			}
+
+			char* parseEnd = nullptr;
+			long start = std::strtol(str, &parseEnd, 10);
+			if (parseEnd != separator || start < 0)
+			{
+				return false;
+			}
+
+			// An empty end means render until the last animated frame
+			if (*(separator + 1) == '\0')
+			{
+				*frameStart = (int)start;
+				*frameEnd = -1;
+				return true;
+			}
+
+			long end = std::strtol(separator + 1, &parseEnd, 10);
+			if (*parseEnd != '\0' || end < start)
+			{
+				return false;
+			}
+
+			*frameStart = (int)start;
+			*frameEnd = (int)end;
+			return true;
+		}
+	}
+}
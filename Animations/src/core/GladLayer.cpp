@@ -8,8 +8,23 @@ namespace MathAnim
 	{
 		static void GLAPIENTRY messageCallback(GLenum source, GLenum type, GLuint id, GLenum severity, GLsizei length, const GLchar* message, const void* userParam);
 
-		void init()
+		void init(bool headless)
 		{
+#ifndef _WIN32
+			if (headless)
+			{
+#ifdef GLFW_PLATFORM_NULL
+				// Don't try to connect to a display server at all
+				glfwInitHint(GLFW_PLATFORM, GLFW_PLATFORM_NULL);
+#else
+				g_logger_warning("GLFW was built without the null platform. Headless mode will still require a display server.");
+#endif
+				// Mesa picks a GPU render node if there is one and falls back to llvmpipe
+				// otherwise. An EGL_PLATFORM set by the user still wins.
+				setenv("EGL_PLATFORM", "surfaceless", 0);
+			}
+#endif
+
 			// Initialize glfw first
 			glfwInit();
 			g_logger_info("GLFW initialized.");
@@ -19,7 +34,27 @@ namespace MathAnim
 			glfwWindowHint(GLFW_CONTEXT_VERSION_MAJOR, 1);
 			glfwWindowHint(GLFW_CONTEXT_VERSION_MINOR, 0);
 
+#ifndef _WIN32
+			if (headless)
+			{
+				// NOTE: Window hints persist, so the real (hidden) window created
+				// after this will use the same context creation API
+				glfwWindowHint(GLFW_CONTEXT_CREATION_API, GLFW_EGL_CONTEXT_API);
+			}
+#endif
+
+			// Windows has no surfaceless contexts and a stock install has neither EGL nor
+			// OSMesa, so headless renders there just use a regular context on a hidden window
 			GLFWwindow* windowPtr = glfwCreateWindow(1, 1, "Dummy", nullptr, nullptr);
+#ifndef _WIN32
+			if (windowPtr == nullptr && headless)
+			{
+				g_logger_warning("Failed to create surfaceless EGL context. Falling back to OSMesa.");
+				glfwWindowHint(GLFW_CONTEXT_CREATION_API, GLFW_OSMESA_CONTEXT_API);
+				windowPtr = glfwCreateWindow(1, 1, "Dummy", nullptr, nullptr);
+			}
+#endif
+
 			if (windowPtr == nullptr)
 			{
 				glfwTerminate();
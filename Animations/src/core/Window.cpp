@@ -26,8 +26,19 @@ namespace MathAnim
 		glfwWindowHint(GLFW_CONTEXT_VERSION_MAJOR, 3);
 		glfwWindowHint(GLFW_CONTEXT_VERSION_MINOR, 2);
 		glfwWindowHint(GLFW_OPENGL_PROFILE, GLFW_OPENGL_CORE_PROFILE);
-		glfwWindowHint(GLFW_VISIBLE, GLFW_TRUE);
-		glfwWindowHint(GLFW_SAMPLES, 4);
+		if (flags & WindowFlags::Hidden)
+		{
+			// Everything is rendered to offscreen framebuffers, so the default
+			// framebuffer doesn't need multisampling
+			glfwWindowHint(GLFW_VISIBLE, GLFW_FALSE);
+			glfwWindowHint(GLFW_SAMPLES, 0);
+		}
+		else
+		{
+			glfwWindowHint(GLFW_VISIBLE, GLFW_TRUE);
+			glfwWindowHint(GLFW_SAMPLES, 4);
+		}
+
 		if (flags & WindowFlags::OpenMaximized)
 		{
 			glfwWindowHint(GLFW_MAXIMIZED, GLFW_TRUE);
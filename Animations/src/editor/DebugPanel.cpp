@@ -28,15 +28,40 @@ namespace MathAnim
 			ImGuiIO& io = ImGui::GetIO();
 
 			// Display SVG cache
+			ImGui::Checkbox("Background SVG Cache Defragmentation", &SvgCache::backgroundDefragmentation);
+
+			{
+				SvgDiskCache& diskCache = Application::getSvgCache()->getDiskCache();
+				int budgetMb = (int)(SvgDiskCache::sizeBudget / (1024 * 1024));
+				if (ImGui::DragInt("SVG Disk Cache Budget (MB)", &budgetMb, 8.0f, 16, 16 * 1024))
+				{
+					SvgDiskCache::sizeBudget = (uint64)glm::max(budgetMb, 16) * 1024 * 1024;
+					diskCache.trim(SvgDiskCache::sizeBudget);
+				}
+				ImGui::Text("SVG Disk Cache: %d entries, %2.1f MB%s", diskCache.getNumEntries(),
+					(float)diskCache.getSizeOnDisk() / (1024.0f * 1024.0f), diskCache.isReadOnly() ? " (read only)" : "");
+				if (ImGui::Button("Clear SVG Disk Cache"))
+				{
+					diskCache.clear();
+				}
+			}
+
 			if (ImGui::BeginTabBar("SVG Cache"))
 			{
 				SvgCache* svgCache = Application::getSvgCache();
 				const Framebuffer& framebuffer = svgCache->getFramebuffer();
-				for (size_t i = 0; i < framebuffer.colorAttachments.size(); i++)
+				for (int i = 0; i < svgCache->getNumPages(); i++)
 				{
 					std::string tabName = "CacheEntry_" + std::to_string(i);
 					if (ImGui::BeginTabItem(tabName.c_str()))
 					{
+						SvgCachePageStats stats = svgCache->getPageStats(i);
+						ImGui::Text("Entries: %d", stats.numEntries);
+						ImGui::Text("Occupancy: %2.1f%%", stats.occupancy * 100.0f);
+						ImGui::Text("Fragmentation: %2.1f%%", stats.fragmentation * 100.0f);
+						ImGui::Text("Evictions: %llu", (unsigned long long)stats.numEvictions);
+						ImGui::Text("Defragmentations: %llu", (unsigned long long)stats.numDefragmentations);
+
 						ImTextureID texId = (ImTextureID)framebuffer.colorAttachments[i].graphicsId;
 						ImVec2 pos = ImGui::GetCursorScreenPos();
 						ImVec4 tintCol = ImVec4(1.0f, 1.0f, 1.0f, 1.0f);   // No tint
@@ -1679,7 +1679,7 @@ namespace MathAnim
 		g_logger_assert(strBufferLength >= requiredBufferSize, "String buffer length must be at least '%d' characters.", requiredBufferSize);
 		if (numHours < 100 && numHours >= 0)
 		{
-			sprintf_s(strBuffer, strBufferLength, "%02d:%02d:%02d.%02d", numHours, numRelativeMinutes, numRelativeSeconds, relativeFrame);
+			snprintf(strBuffer, strBufferLength, "%02d:%02d:%02d.%02d", numHours, numRelativeMinutes, numRelativeSeconds, relativeFrame);
 		}
 		else
 		{
@@ -466,7 +466,7 @@ namespace MathAnim
 				counter = 0;
 			}
 			char counterString[3];
-			_itoa_s(counter, counterString, 10);
+			snprintf(counterString, sizeof(counterString), "%d", counter);
 
 			if (inTrackName)
 			{
@@ -958,6 +958,12 @@ namespace MathAnim
 			{
 				object->as.textObject.reInit(am, object);
 			}
+
+			// Characters only become objects of their own when they need to be animated separately
+			if (object->getGlyphRun() && ImGui::Button("Split Into Characters"))
+			{
+				object->as.textObject.glyphRun.splitIntoCharacters(am, object->id);
+			}
 		}
 
 		static void handleCodeBlockInspector(AnimationManagerData* am, AnimObject* object)
@@ -1004,6 +1010,11 @@ namespace MathAnim
 			{
 				object->as.codeBlock.reInit(am, object);
 			}
+
+			if (object->getGlyphRun() && ImGui::Button("Split Into Characters"))
+			{
+				object->as.codeBlock.glyphRun.splitIntoCharacters(am, object->id);
+			}
 		}
 
 		static void handleLaTexObjectInspector(AnimObject* object)
@@ -1454,6 +1465,10 @@ namespace MathAnim
 						{
 							if (child->_svgObjectStart)
 							{
+								// Scripts build their paths one command at a time, so the
+								// bbox and perimeter only get worked out once they're done
+								child->_svgObjectStart->calculateApproximatePerimeter();
+								child->_svgObjectStart->calculateBBox();
 								Svg::copy(child->svgObject, child->_svgObjectStart);
 							}
 						}
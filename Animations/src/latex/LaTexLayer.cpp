@@ -55,9 +55,18 @@ namespace MathAnim
 		static bool latexIsInstalled;
 		static char latexInstallLocation[_MAX_PATH];
 		static char latexProgram[_MAX_PATH];
+#ifdef _WIN32
+		static const char* latexInstallName = "miktex";
 		static const char* latexExeName = "/miktex/bin/x64/latex.exe";
 		static char dvisvgmProgram[_MAX_PATH];
 		static const char* dvisvgmExeName = "/miktex/bin/x64/dvisvgm.exe";
+#else
+		// TeX Live installs latex and dvisvgm side by side in a directory on the PATH
+		static const char* latexInstallName = "latex";
+		static const char* latexExeName = "/latex";
+		static char dvisvgmProgram[_MAX_PATH];
+		static const char* dvisvgmExeName = "/dvisvgm";
+#endif
 
 		static std::mutex latexQueueMutex;
 		static std::unordered_map<std::string, std::string> latexCachedMd5;
@@ -71,7 +80,7 @@ namespace MathAnim
 		void init()
 		{
 			// Check if the user has latex.exe installed
-			latexIsInstalled = Platform::getProgramInstallDir("miktex", latexInstallLocation, _MAX_PATH);
+			latexIsInstalled = Platform::getProgramInstallDir(latexInstallName, latexInstallLocation, _MAX_PATH);
 			if (!latexIsInstalled)
 			{
 				// TODO: Check alternative installation names
@@ -247,6 +256,12 @@ namespace MathAnim
 			}
 		}
 
+		bool hasPendingWork()
+		{
+			std::lock_guard<std::mutex> lock(latexQueueMutex);
+			return queuedLatex.size() > 0;
+		}
+
 		void free()
 		{
 			std::lock_guard<std::mutex> lock(latexQueueMutex);
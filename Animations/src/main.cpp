@@ -1,12 +1,48 @@
 #include "core.h"
 #include "core/Application.h"
 #include "core/ProjectApp.h"
+#include "core/CommandLine.h"
+#include "video/RawFrameWriter.h"
+#include "svg/SvgParserBenchmark.h"
 
 using namespace MathAnim;
-int main()
+int main(int argc, char** argv)
 {
 	g_memory_init(true);
 
+	HeadlessRenderOptions renderOptions;
+	SvgBenchmarkOptions benchmarkOptions;
+	CommandLineMode mode = CommandLine::parse(argc, argv, &renderOptions, &benchmarkOptions);
+	if (mode == CommandLineMode::Invalid)
+	{
+		CommandLine::printUsage(argv[0]);
+		return 1;
+	}
+
+	if (mode == CommandLineMode::BenchmarkSvgParser)
+	{
+		bool success = SvgParserBenchmark::run(benchmarkOptions);
+
+		g_memory_dumpMemoryLeaks();
+		return success ? 0 : 1;
+	}
+
+	if (mode == CommandLineMode::HeadlessRender)
+	{
+		if (renderOptions.rawFormat != RawFrameFormat::None && renderOptions.outputFilename == "-")
+		{
+			// Frames own stdout, make sure none of the startup logging ends up in there
+			RawFrameWriter::reserveStdout();
+		}
+
+		Application::init(renderOptions.projectFile.c_str(), true);
+		bool success = Application::renderHeadless(renderOptions);
+		Application::free();
+
+		g_memory_dumpMemoryLeaks();
+		return success ? 0 : 1;
+	}
+
 	ProjectApp::init();
 	std::string projectFile = ProjectApp::run();
 	ProjectApp::free();
@@ -21,4 +57,3 @@ int main()
 	g_memory_dumpMemoryLeaks();
 	return 0;
 }
-
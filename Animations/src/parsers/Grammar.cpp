@@ -2,6 +2,7 @@
 #include "platform/Platform.h"
 
 #include <nlohmann/json.hpp>
+#include <algorithm>
 
 namespace MathAnim
 {
@@ -12,8 +13,21 @@ namespace MathAnim
 	static SyntaxPattern parsePattern(const std::string& key, const json& json);
 	static std::vector<SyntaxPattern> parsePatternsArray(const json& json);
 	static regex_t* onigFromString(const std::string& str, bool multiline);
-	static std::optional<GrammarMatch> getFirstMatch(const std::string& str, size_t start, size_t end, regex_t* reg, OnigRegion* region);
-	static std::vector<GrammarMatch> checkForMatches(const std::string& str, size_t start, size_t end, regex_t* reg, OnigRegion* region, std::optional<CaptureList> captures);
+	static void compileGrammar(Grammar* grammar);
+	static uint32 compilePattern(Grammar* grammar, const SyntaxPattern& pattern, std::unordered_map<const SyntaxPattern*, uint32>& compiledIds);
+	static void compilePatterns(Grammar* grammar, const std::vector<SyntaxPattern>& patterns, std::unordered_map<const SyntaxPattern*, uint32>& compiledIds, uint32* outFirstChild, uint32* outNumChildren);
+	static void compileCaptures(Grammar* grammar, const std::optional<CaptureList>& captures, uint32* outFirstCapture, uint32* outNumCaptures);
+	static const SyntaxPattern* resolveInclude(const Grammar* grammar, const SyntaxPattern* pattern);
+	static bool matchPattern(const Grammar* grammar, uint32 patternId, const std::string& str, size_t start, size_t end, std::vector<GrammarMatch>* outMatches, size_t* searchedUntil);
+	static bool hasSearchStartAnchor(const std::string& regex);
+	static bool searchRegex(const std::string& str, size_t start, size_t range, regex_t* reg, OnigRegion* region);
+	static bool regionHasMatch(const OnigRegion* region, size_t group);
+	static void addCaptures(const Grammar* grammar, uint32 firstCapture, uint32 numCaptures, const OnigRegion* region, std::vector<GrammarMatch>* outMatches);
+	static size_t findLineIndex(const std::vector<GrammarLineState>& lines, size_t offset);
+	static void shiftMatch(GrammarMatch& match, int64 offset);
+
+	static constexpr uint32 invalidPatternId = UINT32_MAX;
+	static bool isBlankLine(const TokenizedCode& tokens, size_t line);
 
 	CaptureList CaptureList::from(const json& j)
 	{
@@ -54,32 +68,6 @@ namespace MathAnim
 		return res;
 	}
 
-	bool SimpleSyntaxPattern::match(const std::string& str, size_t start, size_t end, const PatternRepository& repo, OnigRegion* region, std::vector<GrammarMatch>* outMatches) const
-	{
-		std::vector<GrammarMatch> subMatches = checkForMatches(str, start, end, this->regMatch, region, this->captures);
-
-		bool captureWholePattern = false;
-		if (this->scope.has_value())
-		{
-			std::optional<GrammarMatch> match = getFirstMatch(str, start, end, this->regMatch, region);
-			if (match.has_value() && match->start < end && match->end <= end)
-			{
-				match->subMatches.insert(match->subMatches.end(), subMatches.begin(), subMatches.end());
-				match->scope = (*this->scope);
-				outMatches->push_back(*match);
-				captureWholePattern = true;
-			}
-		}
-
-		if (!captureWholePattern)
-		{
-			// If this rule has no scoped name, then add all the submatches by themselves
-			outMatches->insert(outMatches->end(), subMatches.begin(), subMatches.end());
-		}
-
-		return subMatches.size() > 0 || captureWholePattern;
-	}
-
 	void SimpleSyntaxPattern::free()
 	{
 		if (regMatch)
@@ -90,63 +78,6 @@ namespace MathAnim
 		regMatch = nullptr;
 	}
 
-	bool ComplexSyntaxPattern::match(const std::string& str, size_t start, size_t endOffset, const PatternRepository& repo, OnigRegion* region, std::vector<GrammarMatch>* outMatches) const
-	{
-		// If the begin/end pair doesn't have a match, then this rule isn't a success
-		std::optional<GrammarMatch> beginBlockMatch = getFirstMatch(str, start, endOffset, this->begin, region);
-		if (!beginBlockMatch.has_value() || beginBlockMatch->start >= endOffset)
-		{
-			return false;
-		}
-
-		size_t endBlockOffset = beginBlockMatch->end - start;
-		// This match can go to the end of the string
-		std::optional<GrammarMatch> endBlockMatch = getFirstMatch(str, start + endBlockOffset, str.length(), this->end, region);
-		if (!endBlockMatch.has_value())
-		{
-			GrammarMatch eof;
-			eof.start = str.length();
-			eof.end = str.length();
-			eof.scope = ScopeRule::from("EOF_NO_END_MATCH");
-
-			// If there was no end group matched, then automatically use the end of the file as the end block
-			// which is specified in the rules for textmates
-			endBlockMatch = eof;
-		}
-
-		// If the begin/end pair *does* have a match, then get all grammar matches for the begin/end blocks and
-		// run the extra patterns against the text between begin/end
-		std::vector<GrammarMatch> beginMatches = checkForMatches(str, beginBlockMatch->start, beginBlockMatch->end, this->begin, region, this->beginCaptures);
-		std::vector<GrammarMatch> endMatches = checkForMatches(str, endBlockMatch->start, endBlockMatch->end, this->end, region, this->endCaptures);
-
-		GrammarMatch res = {};
-		res.subMatches.insert(res.subMatches.end(), beginMatches.begin(), beginMatches.end());
-
-		if (this->patterns.has_value())
-		{
-			size_t inBetweenStart = beginBlockMatch->end;
-			size_t inBetweenEnd = endBlockMatch->start;
-			for (auto pattern : *patterns)
-			{
-				pattern.match(str, inBetweenStart, inBetweenEnd, repo, region, &res.subMatches);
-			}
-		}
-
-		res.subMatches.insert(res.subMatches.end(), endMatches.begin(), endMatches.end());
-
-		if (this->scope.has_value())
-		{
-			res.start = beginBlockMatch->start;
-			res.end = endBlockMatch->end;
-			res.scope = *this->scope;
-			outMatches->push_back(res);
-			return true;
-		}
-
-		outMatches->insert(outMatches->end(), res.subMatches.begin(), res.subMatches.end());
-		return res.subMatches.size() > 0;
-	}
-
 	void ComplexSyntaxPattern::free()
 	{
 		if (begin)
@@ -171,59 +102,6 @@ namespace MathAnim
 		}
 	}
 
-	bool SyntaxPattern::match(const std::string& str, size_t start, size_t end, const PatternRepository& repo, OnigRegion* region, std::vector<GrammarMatch>* outMatches) const
-	{
-		switch (type)
-		{
-		case PatternType::Array:
-		{
-			if (patternArray.has_value())
-			{
-				for (auto pattern : patternArray->patterns)
-				{
-					if (pattern.match(str, start, end, repo, region, outMatches))
-					{
-						return true;
-					}
-				}
-			}
-		}
-		break;
-		case PatternType::Complex:
-		{
-			if (complexPattern.has_value())
-			{
-				return complexPattern->match(str, start, end, repo, region, outMatches);
-			}
-		}
-		break;
-		case PatternType::Include:
-		{
-			if (patternInclude.has_value())
-			{
-				auto iter = repo.patterns.find(patternInclude.value());
-				if (iter != repo.patterns.end())
-				{
-					return iter->second.match(str, start, end, repo, region, outMatches);
-				}
-				g_logger_warning("Unable to resolve pattern reference '%s'.", patternInclude.value().c_str());
-			}
-		}
-		break;
-		case PatternType::Simple:
-		{
-			if (simplePattern.has_value())
-			{
-				return simplePattern->match(str, start, end, repo, region, outMatches);
-			}
-		}
-		case PatternType::Invalid:
-			break;
-		}
-
-		return false;
-	}
-
 	void SyntaxPattern::free()
 	{
 		switch (type)
@@ -258,17 +136,121 @@ namespace MathAnim
 		}
 	}
 
-	bool Grammar::getNextMatch(const std::string& code, std::vector<GrammarMatch>* outMatches) const
+	void Grammar::tokenize(const std::string& code, TokenizedCode* tokens) const
 	{
-		size_t start = 0;
-		if (outMatches->size() > 0)
+		if (tokens->grammar == this && tokens->code == code && tokens->lines.size() > 0)
 		{
-			start = (*outMatches)[outMatches->size() - 1].end;
+			return;
+		}
+
+		TokenizedCode old = std::move(*tokens);
+		tokens->grammar = this;
+		tokens->code = code;
+		tokens->matches.clear();
+		tokens->lines.clear();
+
+		// Lines before the edit keep their tokens, unless a match from one of them runs
+		// into the edited line. Matches that run to the end of the code, like blocks without
+		// an end, depend on where the code ends so they always get tokenized again.
+		bool hasOldTokens = old.grammar == this && old.lines.size() > 0;
+		size_t restartLine = 0;
+		size_t prefix = 0;
+		size_t suffix = 0;
+		if (hasOldTokens)
+		{
+			size_t maxCommonLength = glm::min(old.code.length(), code.length());
+			while (prefix < maxCommonLength && old.code[prefix] == code[prefix])
+			{
+				prefix++;
+			}
+
+			size_t maxSuffixLength = maxCommonLength - prefix;
+			while (suffix < maxSuffixLength && old.code[old.code.length() - 1 - suffix] == code[code.length() - 1 - suffix])
+			{
+				suffix++;
+			}
+
+			size_t restartOffset = prefix;
+			for (size_t i = old.matches.size(); i > 0 && old.matches[i - 1].end == old.code.length(); i--)
+			{
+				restartOffset = glm::min(restartOffset, old.matches[i - 1].start);
+			}
+
+			// A line's search can also start a match on the first character of the next line,
+			// and patterns like `\s*` carry matches over line breaks. So everything back to the
+			// line before the last line with code on it gets tokenized again too.
+			restartLine = findLineIndex(old.lines, restartOffset);
+			while (restartLine > 0)
+			{
+				restartLine--;
+				if (!isBlankLine(old, restartLine))
+				{
+					break;
+				}
+			}
+
+			if (restartLine > 0)
+			{
+				restartLine--;
+			}
+
+			while (restartLine > 0 && old.lines[restartLine].resume > old.lines[restartLine].start)
+			{
+				restartLine--;
+			}
+
+			tokens->lines.insert(tokens->lines.end(), old.lines.begin(), old.lines.begin() + restartLine);
+			tokens->matches.insert(
+				tokens->matches.end(),
+				std::make_move_iterator(old.matches.begin()),
+				std::make_move_iterator(old.matches.begin() + old.lines[restartLine].firstMatch)
+			);
 		}
 
-		size_t lineEnd = start;
-		while (lineEnd < code.length())
+		int64 offset = (int64)code.length() - (int64)old.code.length();
+		size_t suffixStart = code.length() - suffix;
+		size_t lineStart = hasOldTokens ? old.lines[restartLine].start : 0;
+		size_t start = lineStart;
+		while (true)
 		{
+			start = glm::max(start, lineStart);
+
+			GrammarLineState line;
+			line.start = lineStart;
+			line.resume = start;
+			line.firstMatch = tokens->matches.size();
+
+			// Once a line past the edit starts in the same state it did before, every token
+			// after it is the same as before, just moved
+			if (hasOldTokens && lineStart >= suffixStart && lineStart > prefix)
+			{
+				size_t oldLineStart = (size_t)((int64)lineStart - offset);
+				size_t oldLine = findLineIndex(old.lines, oldLineStart);
+				if (old.lines[oldLine].start == oldLineStart && (int64)old.lines[oldLine].resume + offset == (int64)line.resume)
+				{
+					size_t oldFirstMatch = old.lines[oldLine].firstMatch;
+					for (size_t i = oldLine; i < old.lines.size(); i++)
+					{
+						GrammarLineState oldState = old.lines[i];
+						oldState.start = (size_t)((int64)oldState.start + offset);
+						oldState.resume = (size_t)((int64)oldState.resume + offset);
+						oldState.firstMatch = oldState.firstMatch - oldFirstMatch + line.firstMatch;
+						tokens->lines.push_back(oldState);
+					}
+
+					for (size_t i = oldFirstMatch; i < old.matches.size(); i++)
+					{
+						shiftMatch(old.matches[i], offset);
+						tokens->matches.emplace_back(std::move(old.matches[i]));
+					}
+
+					return;
+				}
+			}
+
+			tokens->lines.push_back(line);
+
+			size_t lineEnd = lineStart;
 			for (; lineEnd < code.length(); lineEnd++)
 			{
 				if (code[lineEnd] == '\n')
@@ -278,30 +260,72 @@ namespace MathAnim
 				}
 			}
 
-			std::vector<GrammarMatch> tmpRes = {};
-			for (auto pattern : this->patterns)
+			// Lines that a match runs past don't get matched at all
+			scanner.beginLine(this, lineEnd);
+			while (start < lineEnd)
 			{
-				std::vector<GrammarMatch> currentRes = {};
-				if (pattern.match(code, start, lineEnd, this->repository, region, &currentRes))
+				if (!scanner.scan(this, code, start, &tokens->matches))
 				{
-					// The first match wins
-					if (tmpRes.size() == 0 || (
-						currentRes[0].start < tmpRes[0].start
-						))
-					{
-						tmpRes = currentRes;
-					}
+					break;
 				}
+
+				start = tokens->matches[tokens->matches.size() - 1].end;
+			}
+
+			// Code that ends with a new line has an empty last line
+			if (lineEnd == code.length() && (lineEnd == lineStart || code[lineEnd - 1] != '\n'))
+			{
+				break;
+			}
+
+			lineStart = lineEnd;
+		}
+	}
+
+	void PatternScanner::beginLine(const Grammar* grammar, size_t inLineEnd)
+	{
+		const CompiledPattern& root = grammar->compiledPatterns[grammar->rootPattern];
+		if (candidates.size() != root.numChildren)
+		{
+			candidates.resize(root.numChildren);
+		}
+
+		for (ScannerCandidate& candidate : candidates)
+		{
+			candidate.searched = false;
+		}
+
+		lineEnd = inLineEnd;
+	}
+
+	bool PatternScanner::scan(const Grammar* grammar, const std::string& code, size_t start, std::vector<GrammarMatch>* outMatches)
+	{
+		const CompiledPattern& root = grammar->compiledPatterns[grammar->rootPattern];
+		ScannerCandidate* best = nullptr;
+		for (uint32 i = 0; i < root.numChildren; i++)
+		{
+			ScannerCandidate& candidate = candidates[i];
+			if (!candidate.searched || start > candidate.validUntil)
+			{
+				candidate.matches.clear();
+				candidate.validUntil = SIZE_MAX;
+				candidate.searched = true;
+				matchPattern(grammar, grammar->compiledChildren[root.firstChild + i], code, start, lineEnd, &candidate.matches, &candidate.validUntil);
 			}
 
 			// The first match wins
-			if (tmpRes.size() > 0)
+			if (candidate.matches.size() > 0 && (!best || candidate.matches[0].start < best->matches[0].start))
 			{
-				outMatches->insert(outMatches->end(), tmpRes.begin(), tmpRes.end());
-				return true;
+				best = &candidate;
 			}
+		}
 
-			start = lineEnd;
+		if (best)
+		{
+			outMatches->insert(outMatches->end(), std::make_move_iterator(best->matches.begin()), std::make_move_iterator(best->matches.end()));
+			best->matches.clear();
+			best->searched = false;
+			return true;
 		}
 
 		return false;
@@ -392,6 +416,8 @@ namespace MathAnim
 			res->patterns = parsePatternsArray(patternsArray);
 		}
 
+		compileGrammar(res);
+
 		return res;
 	}
 
@@ -423,6 +449,7 @@ namespace MathAnim
 
 			SimpleSyntaxPattern p = {};
 			p.regMatch = onigFromString(json["match"], false);
+			p.anchoredToSearchStart = hasSearchStartAnchor(json["match"]);
 
 			if (json.contains("name"))
 			{
@@ -459,6 +486,7 @@ namespace MathAnim
 
 			ComplexSyntaxPattern c = {};
 			c.begin = onigFromString(json["begin"], false);
+			c.anchoredToSearchStart = hasSearchStartAnchor(json["begin"]);
 			c.end = onigFromString(json["end"], true);
 
 			if (json.contains("name"))
@@ -567,59 +595,283 @@ namespace MathAnim
 		return reg;
 	}
 
-	static std::optional<GrammarMatch> getFirstMatch(const std::string& str, size_t startOffset, size_t endOffset, regex_t* reg, OnigRegion* region)
+	static void compileGrammar(Grammar* grammar)
 	{
-		std::optional<GrammarMatch> res = std::nullopt;
+		grammar->compiledPatterns.clear();
+		grammar->compiledChildren.clear();
+		grammar->compiledCaptures.clear();
+
+		CompiledPattern root = {};
+		root.type = PatternType::Array;
+		root.scope = nullptr;
+		grammar->rootPattern = 0;
+		grammar->compiledPatterns.push_back(root);
+
+		// Repository patterns get compiled once, the first time something includes them
+		std::unordered_map<const SyntaxPattern*, uint32> compiledIds = {};
+		uint32 firstChild;
+		uint32 numChildren;
+		compilePatterns(grammar, grammar->patterns, compiledIds, &firstChild, &numChildren);
+		grammar->compiledPatterns[grammar->rootPattern].firstChild = firstChild;
+		grammar->compiledPatterns[grammar->rootPattern].numChildren = numChildren;
+	}
 
-		const char* cstr = str.c_str();
-		const char* start = cstr + startOffset;
-		const char* end = cstr + str.length();
-		const char* range = cstr + endOffset;
-		int searchRes = onig_search(
-			reg,
-			(uint8*)cstr,
-			(uint8*)end,
-			(uint8*)start,
-			(uint8*)range,
-			region,
-			ONIG_OPTION_NONE
-		);
+	static uint32 compilePattern(Grammar* grammar, const SyntaxPattern& pattern, std::unordered_map<const SyntaxPattern*, uint32>& compiledIds)
+	{
+		const SyntaxPattern* resolved = resolveInclude(grammar, &pattern);
+		if (!resolved)
+		{
+			return invalidPatternId;
+		}
 
-		if (searchRes >= 0)
+		auto iter = compiledIds.find(resolved);
+		if (iter != compiledIds.end())
 		{
-			if (region->num_regs > 0)
+			return iter->second;
+		}
+
+		// Patterns can include themselves, so the id has to be handed out before compiling
+		// the pattern's children. The table can grow while they compile, so this pattern is
+		// only written to the table once they're done.
+		uint32 id = (uint32)grammar->compiledPatterns.size();
+		compiledIds[resolved] = id;
+		grammar->compiledPatterns.emplace_back(CompiledPattern{});
+
+		CompiledPattern res = {};
+		res.type = resolved->type;
+		res.scope = nullptr;
+		switch (resolved->type)
+		{
+		case PatternType::Simple:
+		{
+			const SimpleSyntaxPattern& simplePattern = *resolved->simplePattern;
+			if (!simplePattern.regMatch)
 			{
-				// Only accept valid matches
-				if (region->beg[0] >= 0 && region->end[0] > region->beg[0])
-				{
-					GrammarMatch match = {};
-					match.start = (size_t)region->beg[0];
-					match.end = (size_t)region->end[0];
-					match.scope = ScopeRule::from("FIRST_MATCH");
-					res = match;
-				}
+				res.type = PatternType::Invalid;
+				break;
 			}
+
+			res.scope = simplePattern.scope.has_value() ? &(*simplePattern.scope) : nullptr;
+			res.begin = simplePattern.regMatch;
+			res.anchoredToSearchStart = simplePattern.anchoredToSearchStart;
+			compileCaptures(grammar, simplePattern.captures, &res.firstCapture, &res.numCaptures);
 		}
-		else if (searchRes != ONIG_MISMATCH)
+		break;
+		case PatternType::Complex:
 		{
-			// Error
-			char s[ONIG_MAX_ERROR_MESSAGE_LEN];
-			onig_error_code_to_str((UChar*)s, searchRes);
-			g_logger_error("Oniguruma Error: %s", s);
-			onig_region_free(region, 1 /* 1:free self, 0:free contents only */);
+			const ComplexSyntaxPattern& complexPattern = *resolved->complexPattern;
+			if (!complexPattern.begin || !complexPattern.end)
+			{
+				res.type = PatternType::Invalid;
+				break;
+			}
+
+			res.scope = complexPattern.scope.has_value() ? &(*complexPattern.scope) : nullptr;
+			res.begin = complexPattern.begin;
+			res.end = complexPattern.end;
+			res.anchoredToSearchStart = complexPattern.anchoredToSearchStart;
+			compileCaptures(grammar, complexPattern.beginCaptures, &res.firstCapture, &res.numCaptures);
+			compileCaptures(grammar, complexPattern.endCaptures, &res.firstEndCapture, &res.numEndCaptures);
+			if (complexPattern.patterns.has_value())
+			{
+				compilePatterns(grammar, *complexPattern.patterns, compiledIds, &res.firstChild, &res.numChildren);
+			}
+		}
+		break;
+		case PatternType::Array:
+			compilePatterns(grammar, resolved->patternArray->patterns, compiledIds, &res.firstChild, &res.numChildren);
+			break;
+		case PatternType::Include:
+		case PatternType::Invalid:
+			res.type = PatternType::Invalid;
+			break;
 		}
 
-		return res;
+		grammar->compiledPatterns[id] = res;
+		return id;
+	}
+
+	static void compilePatterns(Grammar* grammar, const std::vector<SyntaxPattern>& patterns, std::unordered_map<const SyntaxPattern*, uint32>& compiledIds, uint32* outFirstChild, uint32* outNumChildren)
+	{
+		// Children of a pattern have to sit next to each other in the table, and compiling
+		// a child can add the children of other patterns
+		std::vector<uint32> children = {};
+		for (const SyntaxPattern& pattern : patterns)
+		{
+			uint32 child = compilePattern(grammar, pattern, compiledIds);
+			if (child != invalidPatternId)
+			{
+				children.push_back(child);
+			}
+		}
+
+		*outFirstChild = (uint32)grammar->compiledChildren.size();
+		*outNumChildren = (uint32)children.size();
+		grammar->compiledChildren.insert(grammar->compiledChildren.end(), children.begin(), children.end());
 	}
 
-	static std::vector<GrammarMatch> checkForMatches(const std::string& str, size_t startOffset, size_t endOffset, regex_t* reg, OnigRegion* region, std::optional<CaptureList> captures)
+	static void compileCaptures(Grammar* grammar, const std::optional<CaptureList>& captures, uint32* outFirstCapture, uint32* outNumCaptures)
 	{
-		std::vector<GrammarMatch> res = {};
+		*outFirstCapture = (uint32)grammar->compiledCaptures.size();
+		*outNumCaptures = 0;
+		if (captures.has_value())
+		{
+			for (const Capture& capture : captures->captures)
+			{
+				CompiledCapture compiledCapture = {};
+				compiledCapture.index = capture.index;
+				compiledCapture.scope = &capture.scope;
+				grammar->compiledCaptures.push_back(compiledCapture);
+			}
+
+			*outNumCaptures = (uint32)captures->captures.size();
+		}
+	}
+
+	static const SyntaxPattern* resolveInclude(const Grammar* grammar, const SyntaxPattern* pattern)
+	{
+		// Includes can point at other includes, which could go around in a circle
+		for (size_t i = 0; i <= grammar->repository.patterns.size(); i++)
+		{
+			if (pattern->type != PatternType::Include)
+			{
+				return pattern;
+			}
+
+			if (!pattern->patternInclude.has_value())
+			{
+				return nullptr;
+			}
+
+			auto iter = grammar->repository.patterns.find(pattern->patternInclude.value());
+			if (iter == grammar->repository.patterns.end())
+			{
+				g_logger_warning("Unable to resolve pattern reference '%s'.", pattern->patternInclude.value().c_str());
+				return nullptr;
+			}
+
+			pattern = &iter->second;
+		}
+
+		g_logger_warning("Pattern reference '%s' never resolves to a pattern.", pattern->patternInclude.value().c_str());
+		return nullptr;
+	}
+
+	static bool matchPattern(const Grammar* grammar, uint32 patternId, const std::string& str, size_t start, size_t end, std::vector<GrammarMatch>* outMatches, size_t* searchedUntil)
+	{
+		const CompiledPattern& pattern = grammar->compiledPatterns[patternId];
+		OnigRegion* region = grammar->region;
+		switch (pattern.type)
+		{
+		case PatternType::Simple:
+		{
+			bool found = searchRegex(str, start, end, pattern.begin, region);
+			if (searchedUntil)
+			{
+				size_t foundAt = found ? (size_t)region->beg[0] : SIZE_MAX;
+				*searchedUntil = glm::min(*searchedUntil, pattern.anchoredToSearchStart ? start : foundAt);
+			}
+
+			if (!found)
+			{
+				return false;
+			}
+
+			if (pattern.scope && regionHasMatch(region, 0) && (size_t)region->beg[0] < end && (size_t)region->end[0] <= end)
+			{
+				GrammarMatch match = {};
+				match.start = (size_t)region->beg[0];
+				match.end = (size_t)region->end[0];
+				match.scope = pattern.scope;
+				addCaptures(grammar, pattern.firstCapture, pattern.numCaptures, region, &match.subMatches);
+				outMatches->emplace_back(std::move(match));
+				return true;
+			}
+
+			// If this rule has no scoped name, then add all the captures by themselves
+			size_t numMatches = outMatches->size();
+			addCaptures(grammar, pattern.firstCapture, pattern.numCaptures, region, outMatches);
+			return outMatches->size() > numMatches;
+		}
+		case PatternType::Complex:
+		{
+			// If the begin/end pair doesn't have a match, then this rule isn't a success
+			bool found = searchRegex(str, start, end, pattern.begin, region);
+			if (searchedUntil)
+			{
+				size_t foundAt = found ? (size_t)region->beg[0] : SIZE_MAX;
+				*searchedUntil = glm::min(*searchedUntil, pattern.anchoredToSearchStart ? start : foundAt);
+			}
+
+			if (!found || !regionHasMatch(region, 0) || (size_t)region->beg[0] >= end)
+			{
+				return false;
+			}
 
+			GrammarMatch res = {};
+			res.start = (size_t)region->beg[0];
+			size_t beginEnd = (size_t)region->end[0];
+			addCaptures(grammar, pattern.firstCapture, pattern.numCaptures, region, &res.subMatches);
+
+			// This match can go to the end of the string. If there was no end group matched, then
+			// automatically use the end of the file as the end block which is specified in the
+			// rules for textmates.
+			size_t endStart = str.length();
+			res.end = str.length();
+			bool hasEndMatch = searchRegex(str, beginEnd, str.length(), pattern.end, region) && regionHasMatch(region, 0);
+			if (hasEndMatch)
+			{
+				endStart = (size_t)region->beg[0];
+				res.end = (size_t)region->end[0];
+			}
+
+			// Run the extra patterns against the text between begin/end
+			for (uint32 i = 0; i < pattern.numChildren; i++)
+			{
+				matchPattern(grammar, grammar->compiledChildren[pattern.firstChild + i], str, beginEnd, endStart, &res.subMatches, nullptr);
+			}
+
+			// The patterns in between searched with the same region, so the end has to be found again
+			if (hasEndMatch && pattern.numEndCaptures > 0 && searchRegex(str, endStart, res.end, pattern.end, region))
+			{
+				addCaptures(grammar, pattern.firstEndCapture, pattern.numEndCaptures, region, &res.subMatches);
+			}
+
+			if (pattern.scope)
+			{
+				res.scope = pattern.scope;
+				outMatches->emplace_back(std::move(res));
+				return true;
+			}
+
+			outMatches->insert(outMatches->end(), std::make_move_iterator(res.subMatches.begin()), std::make_move_iterator(res.subMatches.end()));
+			return res.subMatches.size() > 0;
+		}
+		case PatternType::Array:
+		{
+			for (uint32 i = 0; i < pattern.numChildren; i++)
+			{
+				if (matchPattern(grammar, grammar->compiledChildren[pattern.firstChild + i], str, start, end, outMatches, searchedUntil))
+				{
+					return true;
+				}
+			}
+		}
+		break;
+		case PatternType::Include:
+		case PatternType::Invalid:
+			break;
+		}
+
+		return false;
+	}
+
+	static bool searchRegex(const std::string& str, size_t startOffset, size_t rangeOffset, regex_t* reg, OnigRegion* region)
+	{
 		const char* cstr = str.c_str();
 		const char* start = cstr + startOffset;
 		const char* end = cstr + str.length();
-		const char* range = cstr + endOffset;
+		const char* range = cstr + rangeOffset;
 		int searchRes = onig_search(
 			reg,
 			(uint8*)cstr,
@@ -632,24 +884,7 @@ namespace MathAnim
 
 		if (searchRes >= 0)
 		{
-			if (captures.has_value())
-			{
-				for (auto capture : captures->captures)
-				{
-					if (region->num_regs > capture.index)
-					{
-						// Only accept valid matches
-						if (region->beg[capture.index] >= 0 && region->end[capture.index] > region->beg[capture.index])
-						{
-							GrammarMatch match = {};
-							match.start = (size_t)region->beg[capture.index];
-							match.end = (size_t)region->end[capture.index];
-							match.scope = capture.scope;
-							res.emplace_back(match);
-						}
-					}
-				}
-			}
+			return true;
 		}
 		else if (searchRes != ONIG_MISMATCH)
 		{
@@ -657,9 +892,84 @@ namespace MathAnim
 			char s[ONIG_MAX_ERROR_MESSAGE_LEN];
 			onig_error_code_to_str((UChar*)s, searchRes);
 			g_logger_error("Oniguruma Error: %s", s);
-			onig_region_free(region, 1 /* 1:free self, 0:free contents only */);
 		}
 
-		return res;
+		return false;
+	}
+
+	static bool hasSearchStartAnchor(const std::string& regex)
+	{
+		for (size_t i = 0; i + 1 < regex.length(); i++)
+		{
+			if (regex[i] == '\\')
+			{
+				if (regex[i + 1] == 'G')
+				{
+					return true;
+				}
+
+				// Skip whatever is escaped, so \\G doesn't count
+				i++;
+			}
+		}
+
+		return false;
+	}
+
+	static bool regionHasMatch(const OnigRegion* region, size_t group)
+	{
+		// Only accept valid matches
+		return region->num_regs > (int)group && region->beg[group] >= 0 && region->end[group] > region->beg[group];
+	}
+
+	static void addCaptures(const Grammar* grammar, uint32 firstCapture, uint32 numCaptures, const OnigRegion* region, std::vector<GrammarMatch>* outMatches)
+	{
+		for (uint32 i = firstCapture; i < firstCapture + numCaptures; i++)
+		{
+			const CompiledCapture& capture = grammar->compiledCaptures[i];
+			if (regionHasMatch(region, capture.index))
+			{
+				GrammarMatch match = {};
+				match.start = (size_t)region->beg[capture.index];
+				match.end = (size_t)region->end[capture.index];
+				match.scope = capture.scope;
+				outMatches->emplace_back(std::move(match));
+			}
+		}
+	}
+
+	static size_t findLineIndex(const std::vector<GrammarLineState>& lines, size_t offset)
+	{
+		// Index of the last line that starts at or before offset
+		auto iter = std::upper_bound(lines.begin(), lines.end(), offset,
+			[](size_t offset, const GrammarLineState& line)
+			{
+				return offset < line.start;
+			});
+		return iter == lines.begin() ? 0 : (size_t)(iter - lines.begin()) - 1;
+	}
+
+	static bool isBlankLine(const TokenizedCode& tokens, size_t line)
+	{
+		size_t lineEnd = line + 1 < tokens.lines.size() ? tokens.lines[line + 1].start : tokens.code.length();
+		for (size_t i = tokens.lines[line].start; i < lineEnd; i++)
+		{
+			if (!std::isspace((unsigned char)tokens.code[i]))
+			{
+				return false;
+			}
+		}
+
+		return true;
+	}
+
+	static void shiftMatch(GrammarMatch& match, int64 offset)
+	{
+		match.start = (size_t)((int64)match.start + offset);
+		match.end = (size_t)((int64)match.end + offset);
+		for (GrammarMatch& subMatch : match.subMatches)
+		{
+			shiftMatch(subMatch, offset);
+		}
 	}
 }
\ No newline at end of file
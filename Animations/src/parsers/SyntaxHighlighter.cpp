@@ -17,16 +17,20 @@ namespace MathAnim
 	}
 
 	CodeHighlights SyntaxHighlighter::parse(const std::string& code, const SyntaxTheme& theme, bool printDebugInfo) const
+	{
+		TokenizedCode tokens = {};
+		return parse(code, theme, &tokens, printDebugInfo);
+	}
+
+	CodeHighlights SyntaxHighlighter::parse(const std::string& code, const SyntaxTheme& theme, TokenizedCode* tokens, bool printDebugInfo) const
 	{
 		if (!this->grammar)
 		{
 			return {};
 		}
 
-		std::vector<GrammarMatch> matches = {};
-		while (grammar->getNextMatch(code, &matches))
-		{
-		}
+		grammar->tokenize(code, tokens);
+		const std::vector<GrammarMatch>& matches = tokens->matches;
 
 		if (printDebugInfo)
 		{
@@ -175,7 +179,7 @@ namespace MathAnim
 
 		// First get this match's best color and default to parent's theme if this one doesn't
 		// have a best match
-		const TokenRule* myBestMatch = theme.match(match.scope);
+		const TokenRule* myBestMatch = theme.match(*match.scope);
 		if (!myBestMatch)
 		{
 			myBestMatch = parentRule;
@@ -240,11 +244,11 @@ namespace MathAnim
 		int numBytesWritten;
 		if (level > 1)
 		{
-			numBytesWritten = snprintf(bufferPtr, bufferSizeLeft, "%*c'%s': '%s'\n", level * 2, ' ', match.scope.friendlyName.c_str(), val.c_str());
+			numBytesWritten = snprintf(bufferPtr, bufferSizeLeft, "%*c'%s': '%s'\n", level * 2, ' ', match.scope->friendlyName.c_str(), val.c_str());
 		}
 		else
 		{
-			numBytesWritten = snprintf(bufferPtr, bufferSizeLeft, "'%s': '%s'\n", match.scope.friendlyName.c_str(), val.c_str());
+			numBytesWritten = snprintf(bufferPtr, bufferSizeLeft, "'%s': '%s'\n", match.scope->friendlyName.c_str(), val.c_str());
 		}
 
 		if (numBytesWritten > 0 && numBytesWritten < bufferSizeLeft)
@@ -14,39 +14,19 @@ namespace MathAnim
 	static SyntaxTheme* importThemeFromJson(const json& json, const char* filepath);
 	static SyntaxTheme* importThemeFromXml(const XMLDocument& document, const char* filepath);
 	static const XMLElement* getValue(const XMLElement* element, const std::string& keyName);
+	static void buildScopeTrie(SyntaxTheme* theme);
+	static const TokenRule* matchScopeTrie(const SyntaxTheme* theme, const ScopeRule& scope);
 
 	const TokenRule* SyntaxTheme::match(const ScopeRule& scope) const
 	{
-		const TokenRule* result = nullptr;
-		int maxLevelMatched = 0;
-
-		// Pick the best rule according to the guide laid out here https://macromates.com/manual/en/scope_selectors
-		// (At least I'm trying to follow these stupid esoteric instructions smh)
-		/*
-		* 1. Match the element deepest down in the scope e.g. string wins over source.php when
-		*    the scope is source.php string.quoted.
-		*
-		* 2. Match most of the deepest element e.g. string.quoted wins over string.
-		*
-		* 3. Rules 1 and 2 applied again to the scope selector when removing the deepest element
-		*    (in the case of a tie), e.g. text source string wins over source string.
-		*/
-		for (const auto& rule : tokenColors)
+		auto iter = matchCache.find(scope.friendlyName);
+		if (iter != matchCache.end())
 		{
-			for (const auto& ruleScope : rule.scopes)
-			{
-				int levelMatched;
-				if (scope.contains(ruleScope, &levelMatched))
-				{
-					if (levelMatched > maxLevelMatched)
-					{
-						result = &rule;
-						maxLevelMatched = levelMatched;
-					}
-				}
-			}
+			return iter->second;
 		}
 
+		const TokenRule* result = matchScopeTrie(this, scope);
+		matchCache[scope.friendlyName] = result;
 		return result;
 	}
 
@@ -102,6 +82,60 @@ namespace MathAnim
 	}
 
 	// -------------- Internal Functions --------------
+	static const TokenRule* matchScopeTrie(const SyntaxTheme* theme, const ScopeRule& scope)
+	{
+		// Pick the best rule according to the guide laid out here https://macromates.com/manual/en/scope_selectors
+		// (At least I'm trying to follow these stupid esoteric instructions smh)
+		/*
+		* 1. Match the element deepest down in the scope e.g. string wins over source.php when
+		*    the scope is source.php string.quoted.
+		*
+		* 2. Match most of the deepest element e.g. string.quoted wins over string.
+		*
+		* 3. Rules 1 and 2 applied again to the scope selector when removing the deepest element
+		*    (in the case of a tie), e.g. text source string wins over source string.
+		*
+		* Like ScopeRule::contains, only the first element of the scope and the selectors count.
+		* A selector matches as many dotted scopes as it shares with the scope, as long as none
+		* of them differ. Ties go to the first rule in the theme.
+		*/
+		if (scope.scopes.size() == 0 || theme->scopeTrie.size() == 0)
+		{
+			return nullptr;
+		}
+
+		// Follow the scope down the trie as far as it goes. The deepest selector that ends on
+		// the way down matches the most.
+		const std::vector<std::string>& scopeNames = scope.scopes[0].dotSeparatedScopes;
+		int32 ruleIndex = -1;
+		uint32 node = 0;
+		size_t depth = 0;
+		for (; depth < scopeNames.size(); depth++)
+		{
+			const ScopeTrieNode& trieNode = theme->scopeTrie[node];
+			auto iter = trieNode.children.find(scopeNames[depth]);
+			if (iter == trieNode.children.end())
+			{
+				break;
+			}
+
+			node = iter->second;
+			if (theme->scopeTrie[node].firstRule >= 0)
+			{
+				ruleIndex = theme->scopeTrie[node].firstRule;
+			}
+		}
+
+		// If the whole scope is in the trie, selectors that continue past the end of the scope
+		// match all of it too
+		if (depth > 0 && depth == scopeNames.size())
+		{
+			ruleIndex = theme->scopeTrie[node].firstRuleBelow;
+		}
+
+		return ruleIndex >= 0 ? &theme->tokenColors[ruleIndex] : nullptr;
+	}
+
 	static SyntaxTheme* importThemeFromJson(const json& j, const char* filepath)
 	{
 		if (!j.contains("tokenColors"))
@@ -252,6 +286,8 @@ namespace MathAnim
 			}
 		}
 
+		buildScopeTrie(theme);
+
 		return theme;
 	}
 
@@ -398,9 +434,65 @@ namespace MathAnim
 			}
 		}
 
+		buildScopeTrie(theme);
+
 		return theme;
 	}
 
+	static void buildScopeTrie(SyntaxTheme* theme)
+	{
+		theme->scopeTrie.clear();
+		theme->matchCache.clear();
+
+		ScopeTrieNode root = {};
+		root.firstRule = -1;
+		root.firstRuleBelow = -1;
+		theme->scopeTrie.push_back(root);
+
+		// Rules are added in order, so the first rule to reach a node is the one ties go to
+		for (size_t ruleIndex = 0; ruleIndex < theme->tokenColors.size(); ruleIndex++)
+		{
+			for (const ScopeRule& ruleScope : theme->tokenColors[ruleIndex].scopes)
+			{
+				if (ruleScope.scopes.size() == 0 || ruleScope.scopes[0].dotSeparatedScopes.size() == 0)
+				{
+					continue;
+				}
+
+				uint32 node = 0;
+				for (const std::string& scopeName : ruleScope.scopes[0].dotSeparatedScopes)
+				{
+					auto iter = theme->scopeTrie[node].children.find(scopeName);
+					uint32 child;
+					if (iter == theme->scopeTrie[node].children.end())
+					{
+						ScopeTrieNode newNode = {};
+						newNode.firstRule = -1;
+						newNode.firstRuleBelow = -1;
+						child = (uint32)theme->scopeTrie.size();
+						theme->scopeTrie.emplace_back(newNode);
+						theme->scopeTrie[node].children[scopeName] = child;
+					}
+					else
+					{
+						child = iter->second;
+					}
+
+					node = child;
+					if (theme->scopeTrie[node].firstRuleBelow < 0)
+					{
+						theme->scopeTrie[node].firstRuleBelow = (int32)ruleIndex;
+					}
+				}
+
+				if (theme->scopeTrie[node].firstRule < 0)
+				{
+					theme->scopeTrie[node].firstRule = (int32)ruleIndex;
+				}
+			}
+		}
+	}
+
 	static const XMLElement* getValue(const XMLElement* parentElement, const std::string& keyName)
 	{
 		const XMLElement* key = parentElement->FirstChildElement("key");
@@ -0,0 +1,461 @@
+#include "parsers/XmlReader.h"
+#include "utils/Utf8.h"
+
+#include <charconv>
+
+namespace MathAnim
+{
+	// ------------- Internal Functions -------------
+	static inline bool isXmlWhitespace(char c) { return c == ' ' || c == '\t' || c == '\n' || c == '\r'; }
+	static inline bool isNameTerminator(char c) { return isXmlWhitespace(c) || c == '/' || c == '>' || c == '=' || c == '<'; }
+
+	bool XmlSlice::equals(const char* str) const
+	{
+		size_t strLength = std::strlen(str);
+		return strLength == length && std::memcmp(text, str, length) == 0;
+	}
+
+	std::string XmlSlice::toString() const
+	{
+		return std::string(text, length);
+	}
+
+	bool XmlSlice::toFloat(float* out) const
+	{
+		const char* start = text;
+		const char* end = text + length;
+		while (start < end && isXmlWhitespace(*start))
+		{
+			start++;
+		}
+		while (end > start && isXmlWhitespace(*(end - 1)))
+		{
+			end--;
+		}
+
+		// from_chars doesn't take a leading plus sign
+		if (start < end && *start == '+')
+		{
+			start++;
+		}
+
+		std::from_chars_result result = std::from_chars(start, end, *out);
+		return result.ec == std::errc() && result.ptr == end;
+	}
+
+	XmlReader::XmlReader(const char* inText, size_t inLength) :
+		document(inText),
+		documentLength(inLength),
+		cursor(0),
+		errorCursor(0),
+		elementName({ inText, 0 }),
+		elementAttributes(),
+		textSlice({ inText, 0 }),
+		elementDepth(0),
+		openElements(),
+		pendingEndElement(false),
+		error()
+	{
+		// Skip the UTF-8 byte order mark
+		if (documentLength >= 3 && (uint8)document[0] == 0xEF && (uint8)document[1] == 0xBB && (uint8)document[2] == 0xBF)
+		{
+			cursor = 3;
+		}
+	}
+
+	XmlEventType XmlReader::next()
+	{
+		if (error.size() > 0)
+		{
+			return XmlEventType::Error;
+		}
+
+		if (pendingEndElement)
+		{
+			// Second half of a self closing element, its name and depth are still set
+			pendingEndElement = false;
+			elementAttributes.clear();
+			return XmlEventType::EndElement;
+		}
+
+		while (cursor < documentLength)
+		{
+			if (document[cursor] != '<')
+			{
+				const char* tagStart = (const char*)std::memchr(document + cursor, '<', documentLength - cursor);
+				size_t textEnd = tagStart ? (size_t)(tagStart - document) : documentLength;
+				textSlice = { document + cursor, textEnd - cursor };
+				cursor = textEnd;
+				return XmlEventType::Text;
+			}
+
+			XmlEventType event = readTag();
+			// Comments and the like don't produce anything, keep going
+			if (event != XmlEventType::EndOfDocument)
+			{
+				return event;
+			}
+		}
+
+		if (openElements.size() > 0)
+		{
+			return fail("Document ended before all of its elements were closed.");
+		}
+
+		return XmlEventType::EndOfDocument;
+	}
+
+	const XmlSlice* XmlReader::findAttribute(const char* attributeName) const
+	{
+		for (const XmlAttribute& attribute : elementAttributes)
+		{
+			if (attribute.name.equals(attributeName))
+			{
+				return &attribute.value;
+			}
+		}
+
+		return nullptr;
+	}
+
+	bool XmlReader::skipElement()
+	{
+		int startDepth = elementDepth;
+		for (;;)
+		{
+			XmlEventType event = next();
+			if (event == XmlEventType::EndElement && elementDepth == startDepth)
+			{
+				return true;
+			}
+
+			if (event == XmlEventType::Error || event == XmlEventType::EndOfDocument)
+			{
+				return false;
+			}
+		}
+	}
+
+	int XmlReader::getErrorLine() const
+	{
+		int line = 1;
+		for (size_t i = 0; i < errorCursor && i < documentLength; i++)
+		{
+			if (document[i] == '\n')
+			{
+				line++;
+			}
+		}
+
+		return line;
+	}
+
+	std::string XmlReader::unescape(const XmlSlice& slice)
+	{
+		std::string res;
+		res.reserve(slice.length);
+
+		size_t i = 0;
+		while (i < slice.length)
+		{
+			const char* entityStart = (const char*)std::memchr(slice.text + i, '&', slice.length - i);
+			size_t runEnd = entityStart ? (size_t)(entityStart - slice.text) : slice.length;
+			res.append(slice.text + i, runEnd - i);
+			i = runEnd;
+			if (i >= slice.length)
+			{
+				break;
+			}
+
+			const char* semicolon = (const char*)std::memchr(slice.text + i, ';', slice.length - i);
+			if (!semicolon)
+			{
+				// Not a reference, keep the ampersand as is
+				res += '&';
+				i++;
+				continue;
+			}
+
+			XmlSlice entity = { slice.text + i + 1, (size_t)(semicolon - slice.text) - i - 1 };
+			uint32 codepoint = 0;
+			bool isReference = true;
+			if (entity.equals("lt")) codepoint = '<';
+			else if (entity.equals("gt")) codepoint = '>';
+			else if (entity.equals("amp")) codepoint = '&';
+			else if (entity.equals("quot")) codepoint = '"';
+			else if (entity.equals("apos")) codepoint = '\'';
+			else if (entity.length > 1 && entity.text[0] == '#')
+			{
+				bool isHex = entity.text[1] == 'x' || entity.text[1] == 'X';
+				const char* digitsStart = entity.text + (isHex ? 2 : 1);
+				const char* digitsEnd = entity.text + entity.length;
+				std::from_chars_result result = std::from_chars(digitsStart, digitsEnd, codepoint, isHex ? 16 : 10);
+				isReference = result.ec == std::errc() && result.ptr == digitsEnd && digitsStart != digitsEnd;
+			}
+			else
+			{
+				isReference = false;
+			}
+
+			if (!isReference)
+			{
+				res += '&';
+				i++;
+				continue;
+			}
+
+			uint8 utf8[4];
+			int utf8Length = Utf8::encode(codepoint, utf8);
+			res.append((const char*)utf8, utf8Length);
+			i += entity.length + 2;
+		}
+
+		return res;
+	}
+
+	XmlEventType XmlReader::readTag()
+	{
+		// cursor is on the '<'
+		const char* tag = document + cursor;
+		size_t remaining = documentLength - cursor;
+		if (remaining >= 2 && tag[1] == '/')
+		{
+			return readEndTag();
+		}
+
+		if (remaining >= 2 && tag[1] == '?')
+		{
+			if (!skipPast("?>"))
+			{
+				return fail("Unterminated processing instruction.");
+			}
+			return XmlEventType::EndOfDocument;
+		}
+
+		if (remaining >= 4 && std::memcmp(tag, "<!--", 4) == 0)
+		{
+			if (!skipPast("-->"))
+			{
+				return fail("Unterminated comment.");
+			}
+			return XmlEventType::EndOfDocument;
+		}
+
+		if (remaining >= 9 && std::memcmp(tag, "<![CDATA[", 9) == 0)
+		{
+			size_t contentStart = cursor + 9;
+			cursor = contentStart;
+			if (!skipPast("]]>"))
+			{
+				return fail("Unterminated CDATA section.");
+			}
+			textSlice = { document + contentStart, cursor - 3 - contentStart };
+			return XmlEventType::CData;
+		}
+
+		if (remaining >= 2 && tag[1] == '!')
+		{
+			if (!skipDeclaration())
+			{
+				return fail("Unterminated declaration.");
+			}
+			return XmlEventType::EndOfDocument;
+		}
+
+		return readStartTag();
+	}
+
+	XmlEventType XmlReader::readStartTag()
+	{
+		size_t tagStart = cursor;
+		cursor++;
+		elementName = readName();
+		if (elementName.length == 0)
+		{
+			errorCursor = tagStart;
+			return fail("Expected an element name after '<'.");
+		}
+
+		// The vector keeps its capacity, so after the first few elements reading
+		// attributes doesn't allocate
+		elementAttributes.clear();
+		for (;;)
+		{
+			skipWhitespace();
+			if (cursor >= documentLength)
+			{
+				return fail("Document ended inside a start tag.");
+			}
+
+			char c = document[cursor];
+			if (c == '>')
+			{
+				cursor++;
+				openElements.push_back(elementName);
+				elementDepth = (int)openElements.size();
+				return XmlEventType::StartElement;
+			}
+
+			if (c == '/')
+			{
+				if (cursor + 1 >= documentLength || document[cursor + 1] != '>')
+				{
+					return fail("Expected '>' after '/' in a start tag.");
+				}
+				cursor += 2;
+				elementDepth = (int)openElements.size() + 1;
+				pendingEndElement = true;
+				return XmlEventType::StartElement;
+			}
+
+			XmlAttribute attribute;
+			attribute.name = readName();
+			if (attribute.name.length == 0)
+			{
+				return fail("Expected an attribute name.");
+			}
+
+			skipWhitespace();
+			if (cursor >= documentLength || document[cursor] != '=')
+			{
+				return fail("Expected '=' after an attribute name.");
+			}
+			cursor++;
+			skipWhitespace();
+
+			char quote = cursor < documentLength ? document[cursor] : '\0';
+			if (quote != '"' && quote != '\'')
+			{
+				return fail("Expected a quoted attribute value.");
+			}
+			cursor++;
+
+			const char* valueEnd = (const char*)std::memchr(document + cursor, quote, documentLength - cursor);
+			if (!valueEnd)
+			{
+				return fail("Unterminated attribute value.");
+			}
+			attribute.value = { document + cursor, (size_t)(valueEnd - document) - cursor };
+			cursor = (size_t)(valueEnd - document) + 1;
+
+			elementAttributes.push_back(attribute);
+		}
+	}
+
+	XmlEventType XmlReader::readEndTag()
+	{
+		size_t tagStart = cursor;
+		cursor += 2;
+		elementName = readName();
+		skipWhitespace();
+		if (cursor >= documentLength || document[cursor] != '>')
+		{
+			return fail("Expected '>' at the end of an end tag.");
+		}
+		cursor++;
+
+		if (openElements.size() == 0 ||
+			openElements.back().length != elementName.length ||
+			std::memcmp(openElements.back().text, elementName.text, elementName.length) != 0)
+		{
+			errorCursor = tagStart;
+			return fail("End tag doesn't match the element that's open.");
+		}
+
+		elementDepth = (int)openElements.size();
+		openElements.pop_back();
+		elementAttributes.clear();
+		return XmlEventType::EndElement;
+	}
+
+	bool XmlReader::skipPast(const char* terminator)
+	{
+		size_t terminatorLength = std::strlen(terminator);
+		while (cursor + terminatorLength <= documentLength)
+		{
+			const char* candidate = (const char*)std::memchr(document + cursor, terminator[0], documentLength - cursor);
+			if (!candidate || (size_t)(candidate - document) + terminatorLength > documentLength)
+			{
+				break;
+			}
+
+			cursor = (size_t)(candidate - document);
+			if (std::memcmp(candidate, terminator, terminatorLength) == 0)
+			{
+				cursor += terminatorLength;
+				return true;
+			}
+			cursor++;
+		}
+
+		cursor = documentLength;
+		return false;
+	}
+
+	bool XmlReader::skipDeclaration()
+	{
+		// <!DOCTYPE ...> can hold an internal subset in brackets, which has its own
+		// '>' characters and quoted strings
+		int bracketDepth = 0;
+		char quote = '\0';
+		for (cursor += 2; cursor < documentLength; cursor++)
+		{
+			char c = document[cursor];
+			if (quote != '\0')
+			{
+				if (c == quote)
+				{
+					quote = '\0';
+				}
+			}
+			else if (c == '"' || c == '\'')
+			{
+				quote = c;
+			}
+			else if (c == '[')
+			{
+				bracketDepth++;
+			}
+			else if (c == ']')
+			{
+				bracketDepth--;
+			}
+			else if (c == '>' && bracketDepth <= 0)
+			{
+				cursor++;
+				return true;
+			}
+		}
+
+		return false;
+	}
+
+	XmlSlice XmlReader::readName()
+	{
+		size_t nameStart = cursor;
+		while (cursor < documentLength && !isNameTerminator(document[cursor]))
+		{
+			cursor++;
+		}
+
+		return XmlSlice{ document + nameStart, cursor - nameStart };
+	}
+
+	void XmlReader::skipWhitespace()
+	{
+		while (cursor < documentLength && isXmlWhitespace(document[cursor]))
+		{
+			cursor++;
+		}
+	}
+
+	XmlEventType XmlReader::fail(const char* message)
+	{
+		if (errorCursor == 0)
+		{
+			errorCursor = cursor;
+		}
+		error = message;
+		return XmlEventType::Error;
+	}
+}
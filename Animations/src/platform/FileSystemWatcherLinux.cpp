@@ -0,0 +1,255 @@
+#ifdef __linux__
+#include "platform/FileSystemWatcher.h"
+#include "platform/Platform.h"
+
+#include <unistd.h>
+#include <poll.h>
+#include <sys/eventfd.h>
+#include <sys/inotify.h>
+
+namespace MathAnim
+{
+	// ------------- Internal Functions -------------
+	static void addWatches(int inotifyFd, const std::filesystem::path& root, const std::filesystem::path& relativeDir, uint32_t mask, bool recursive, std::unordered_map<int, std::filesystem::path>& watchDirs);
+
+	FileSystemWatcher::FileSystemWatcher()
+	{
+		stopEventHandle = nullptr;
+	}
+
+	void FileSystemWatcher::start()
+	{
+		// Created up front so stop() always has something to signal
+		stopEventHandle = (void*)(intptr_t)(eventfd(0, EFD_CLOEXEC) + 1);
+		fileWatcherThread = std::thread(&FileSystemWatcher::startThread, this);
+	}
+
+	void FileSystemWatcher::startThread()
+	{
+		if (path.empty() || !Platform::dirExists(path.string().c_str()))
+		{
+			g_logger_error("Path empty or directory does not exist. Could not create FileSystemWatcher for '%s'", path.string().c_str());
+			return;
+		}
+
+		int inotifyFd = inotify_init1(IN_CLOEXEC);
+		if (inotifyFd < 0)
+		{
+			g_logger_error("Could not create inotify instance for FileSystemWatcher '%s'", path.string().c_str());
+			return;
+		}
+
+		// Set up notification flags, inotify has no equivalent for the security and
+		// creation time filters
+		uint32_t mask = 0;
+		if (notifyFilters & NotifyFilters::FileName)
+		{
+			mask |= IN_CREATE | IN_DELETE | IN_MOVED_FROM | IN_MOVED_TO;
+		}
+
+		if (notifyFilters & NotifyFilters::DirectoryName)
+		{
+			mask |= IN_CREATE | IN_DELETE | IN_MOVED_FROM | IN_MOVED_TO;
+		}
+
+		if (notifyFilters & NotifyFilters::Attributes)
+		{
+			mask |= IN_ATTRIB;
+		}
+
+		if ((notifyFilters & NotifyFilters::Size) || (notifyFilters & NotifyFilters::LastWrite))
+		{
+			mask |= IN_MODIFY | IN_CLOSE_WRITE;
+		}
+
+		if (notifyFilters & NotifyFilters::LastAccess)
+		{
+			mask |= IN_ACCESS;
+		}
+
+		// New sub directories need their own watch, so creation is always watched
+		if (includeSubdirectories)
+		{
+			mask |= IN_CREATE;
+		}
+
+		// inotify only watches single directories, so every sub directory gets its own
+		// watch and events are reported relative to the watched path like on Windows
+		std::unordered_map<int, std::filesystem::path> watchDirs;
+		addWatches(inotifyFd, path, "", mask, includeSubdirectories, watchDirs);
+
+		int stopFd = (int)(intptr_t)stopEventHandle - 1;
+		alignas(struct inotify_event) char buffer[4096];
+		while (enableRaisingEvents)
+		{
+			struct pollfd fds[2];
+			fds[0] = { inotifyFd, POLLIN, 0 };
+			fds[1] = { stopFd, POLLIN, 0 };
+			if (::poll(fds, 2, -1) < 0)
+			{
+				if (errno == EINTR)
+				{
+					continue;
+				}
+				break;
+			}
+
+			if (fds[1].revents & POLLIN)
+			{
+				break;
+			}
+
+			ssize_t bytesRead = read(inotifyFd, buffer, sizeof(buffer));
+			if (bytesRead <= 0)
+			{
+				continue;
+			}
+
+			std::lock_guard<std::mutex> queueLock(queueMtx);
+			for (ssize_t offset = 0; offset < bytesRead;)
+			{
+				const struct inotify_event* event = (const struct inotify_event*)(buffer + offset);
+				offset += sizeof(struct inotify_event) + event->len;
+
+				auto dirIter = watchDirs.find(event->wd);
+				if (dirIter == watchDirs.end() || event->len == 0)
+				{
+					continue;
+				}
+
+				std::filesystem::path filename = dirIter->second / event->name;
+				if ((event->mask & IN_CREATE) && (event->mask & IN_ISDIR) && includeSubdirectories)
+				{
+					addWatches(inotifyFd, path, filename, mask, true, watchDirs);
+				}
+
+				if (event->mask & IN_CREATE)
+				{
+					createdQueue.insert(filename);
+				}
+				else if (event->mask & IN_DELETE)
+				{
+					deletedQueue.insert(filename);
+				}
+				else if (event->mask & IN_MOVED_TO)
+				{
+					renamedQueue.insert(filename);
+				}
+				else if (event->mask & (IN_MODIFY | IN_CLOSE_WRITE | IN_ATTRIB | IN_ACCESS))
+				{
+					changedQueue.insert(filename);
+				}
+			}
+		}
+
+		close(inotifyFd);
+	}
+
+	void FileSystemWatcher::stop()
+	{
+		if (enableRaisingEvents)
+		{
+			enableRaisingEvents = false;
+			int stopFd = (int)(intptr_t)stopEventHandle - 1;
+			if (stopFd >= 0)
+			{
+				uint64_t signal = 1;
+				if (write(stopFd, &signal, sizeof(signal)) < 0)
+				{
+					g_logger_warning("Could not signal FileSystemWatcher '%s' to stop.", path.string().c_str());
+				}
+			}
+
+			if (fileWatcherThread.joinable())
+			{
+				fileWatcherThread.join();
+			}
+
+			if (stopFd >= 0)
+			{
+				close(stopFd);
+			}
+		}
+	}
+
+	void FileSystemWatcher::poll()
+	{
+		// Editors often write a file several times in a row, so a file that was already
+		// reported last poll isn't reported again
+		std::lock_guard<std::mutex> queueLock(queueMtx);
+
+		for (const std::filesystem::path& file : changedQueue)
+		{
+			bool containsFile = prevChangedQueue.find(file) != prevChangedQueue.end();
+			if (onChanged && !containsFile)
+			{
+				onChanged(file);
+			}
+		}
+		prevChangedQueue = changedQueue;
+		changedQueue.clear();
+
+		for (const std::filesystem::path& file : renamedQueue)
+		{
+			bool containsFile = prevRenamedQueue.find(file) != prevRenamedQueue.end();
+			if (onRenamed && !containsFile)
+			{
+				onRenamed(file);
+			}
+		}
+		prevRenamedQueue = renamedQueue;
+		renamedQueue.clear();
+
+		for (const std::filesystem::path& file : deletedQueue)
+		{
+			bool containsFile = prevDeletedQueue.find(file) != prevDeletedQueue.end();
+			if (onDeleted && !containsFile)
+			{
+				onDeleted(file);
+			}
+		}
+		prevDeletedQueue = deletedQueue;
+		deletedQueue.clear();
+
+		for (const std::filesystem::path& file : createdQueue)
+		{
+			bool containsFile = prevCreatedQueue.find(file) != prevCreatedQueue.end();
+			if (onCreated && !containsFile)
+			{
+				onCreated(file);
+			}
+		}
+		prevCreatedQueue = createdQueue;
+		createdQueue.clear();
+	}
+
+	// ------------- Internal Functions -------------
+	static void addWatches(int inotifyFd, const std::filesystem::path& root, const std::filesystem::path& relativeDir, uint32_t mask, bool recursive, std::unordered_map<int, std::filesystem::path>& watchDirs)
+	{
+		std::filesystem::path dir = root / relativeDir;
+		int wd = inotify_add_watch(inotifyFd, dir.string().c_str(), mask);
+		if (wd < 0)
+		{
+			g_logger_warning("Could not watch directory '%s' for changes.", dir.string().c_str());
+			return;
+		}
+		watchDirs[wd] = relativeDir;
+
+		if (!recursive)
+		{
+			return;
+		}
+
+		std::error_code err;
+		for (auto iter = std::filesystem::directory_iterator(dir, err); !err && iter != std::filesystem::directory_iterator(); iter.increment(err))
+		{
+			// Symlinks are skipped so a link cycle can't recurse forever
+			if (iter->is_directory(err) && !iter->is_symlink(err))
+			{
+				addWatches(inotifyFd, root, relativeDir / iter->path().filename(), mask, true, watchDirs);
+			}
+		}
+	}
+}
+
+#endif
@@ -0,0 +1,668 @@
+#ifdef __linux__
+#include "platform/Platform.h"
+#include "core.h"
+
+#include <cerrno>
+#include <unistd.h>
+#include <fcntl.h>
+#include <signal.h>
+#include <sys/file.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <sys/wait.h>
+
+namespace MathAnim
+{
+	namespace Platform
+	{
+		// --------------- Internal Functions ---------------
+		static std::vector<std::string> splitCommandLine(const char* cmdLine);
+		static bool findProgramOnPath(const char* programName, std::string* outPath);
+		static pid_t spawnProcess(const char* programFilepath, const char* cmdLineArgs, const char* workingDirectory, const char* outputFilepath);
+		static bool spawnDetached(const std::vector<std::string>& args);
+		static void md5(const uint8* data, size_t length, uint8 outDigest[16]);
+		static std::vector<std::string> availableFonts = {};
+		static bool availableFontsCached = false;
+
+		const std::vector<std::string>& getAvailableFonts()
+		{
+			if (!availableFontsCached)
+			{
+				std::vector<std::filesystem::path> fontDirs = { "/usr/share/fonts", "/usr/local/share/fonts" };
+				const char* home = getenv("HOME");
+				if (home)
+				{
+					fontDirs.push_back(std::filesystem::path(home) / ".local/share/fonts");
+					fontDirs.push_back(std::filesystem::path(home) / ".fonts");
+				}
+
+				// Unlike the Windows fonts folder these are split into sub directories per family
+				for (const std::filesystem::path& fontDir : fontDirs)
+				{
+					std::error_code err;
+					for (auto iter = std::filesystem::recursive_directory_iterator(fontDir, err); !err && iter != std::filesystem::recursive_directory_iterator(); iter.increment(err))
+					{
+						const std::filesystem::path& file = iter->path();
+						if (file.extension() == ".ttf" || file.extension() == ".TTF")
+						{
+							availableFonts.push_back(file.string());
+						}
+					}
+				}
+
+				availableFontsCached = true;
+			}
+
+			return availableFonts;
+		}
+
+		const char* getDefaultMonoFontPath()
+		{
+			static std::string defaultMonoFont = "";
+			if (defaultMonoFont.empty())
+			{
+				// Where the common distros put DejaVu Sans Mono and Liberation Mono
+				const char* candidates[] = {
+					"/usr/share/fonts/truetype/dejavu/DejaVuSansMono.ttf",
+					"/usr/share/fonts/dejavu-sans-mono-fonts/DejaVuSansMono.ttf",
+					"/usr/share/fonts/TTF/DejaVuSansMono.ttf",
+					"/usr/share/fonts/truetype/liberation/LiberationMono-Regular.ttf",
+					"/usr/share/fonts/liberation-mono/LiberationMono-Regular.ttf",
+				};
+				for (const char* candidate : candidates)
+				{
+					if (fileExists(candidate))
+					{
+						defaultMonoFont = candidate;
+						break;
+					}
+				}
+
+				if (defaultMonoFont.empty())
+				{
+					for (const std::string& font : getAvailableFonts())
+					{
+						if (font.find("Mono") != std::string::npos)
+						{
+							defaultMonoFont = font;
+							break;
+						}
+					}
+				}
+
+				if (defaultMonoFont.empty())
+				{
+					g_logger_warning("Could not find a monospaced font. Install DejaVu Sans Mono or Liberation Mono.");
+					defaultMonoFont = candidates[0];
+				}
+			}
+
+			return defaultMonoFont.c_str();
+		}
+
+		bool isProgramInstalled(const char* displayName)
+		{
+			// There's no registry of installed programs, anything on the path counts
+			return findProgramOnPath(displayName, nullptr);
+		}
+
+		bool getProgramInstallDir(const char* programDisplayName, char* buffer, size_t bufferLength)
+		{
+			if (bufferLength <= 0)
+			{
+				return false;
+			}
+
+			std::string programPath;
+			if (!findProgramOnPath(programDisplayName, &programPath))
+			{
+				return false;
+			}
+
+			std::string installDir = std::filesystem::path(programPath).parent_path().string();
+			if (installDir.length() + 1 > bufferLength)
+			{
+				g_logger_warning("Buffer too small to contain install location for '%s'.", programDisplayName);
+				buffer[0] = '\0';
+				return false;
+			}
+
+			g_memory_copyMem(buffer, (void*)installDir.c_str(), sizeof(char) * (installDir.length() + 1));
+			return true;
+		}
+
+		bool executeProgram(const char* programFilepath, const char* cmdLineArgs, const char* workingDirectory, const char* executionOutputFilename)
+		{
+			std::string outputFilepath = "";
+			if (executionOutputFilename)
+			{
+				outputFilepath = executionOutputFilename;
+				if (workingDirectory)
+				{
+					outputFilepath = std::string(workingDirectory) + std::string("/") + executionOutputFilename;
+				}
+			}
+
+			g_logger_log("Running program: '%s' %s", programFilepath, cmdLineArgs ? cmdLineArgs : "");
+			pid_t pid = spawnProcess(programFilepath, cmdLineArgs, workingDirectory, executionOutputFilename ? outputFilepath.c_str() : nullptr);
+			if (pid < 0)
+			{
+				return false;
+			}
+
+			// Same 25 second limit as the Windows version
+			constexpr int timeoutMs = 25000;
+			constexpr int pollIntervalMs = 10;
+			for (int waitedMs = 0; waitedMs < timeoutMs; waitedMs += pollIntervalMs)
+			{
+				int status = 0;
+				if (waitpid(pid, &status, WNOHANG) != 0)
+				{
+					return true;
+				}
+				usleep(pollIntervalMs * 1000);
+			}
+
+			kill(pid, SIGKILL);
+			waitpid(pid, nullptr, 0);
+			return true;
+		}
+
+		bool executeProgramAndWait(const char* programFilepath, const char* cmdLineArgs, int* exitCode)
+		{
+			pid_t pid = spawnProcess(programFilepath, cmdLineArgs, nullptr, nullptr);
+			if (pid < 0)
+			{
+				return false;
+			}
+
+			int status = 0;
+			while (waitpid(pid, &status, 0) < 0)
+			{
+				if (errno != EINTR)
+				{
+					g_logger_error("Failed to wait for process '%s': %s", programFilepath, strerror(errno));
+					return false;
+				}
+			}
+
+			if (exitCode)
+			{
+				// Killed by a signal is reported like the shell does it
+				*exitCode = WIFEXITED(status) ? WEXITSTATUS(status) : 128 + WTERMSIG(status);
+			}
+
+			return true;
+		}
+
+		bool openFileWithDefaultProgram(const char* filepath)
+		{
+			return spawnDetached({ "xdg-open", filepath });
+		}
+
+		bool openFileWithVsCode(const char* filepath, int lineNumber)
+		{
+			std::string location = lineNumber >= 0
+				? std::string(filepath) + ":" + std::to_string(lineNumber)
+				: std::string(filepath);
+			return spawnDetached({ "code", "--goto", location });
+		}
+
+		bool fileExists(const char* filename)
+		{
+			struct stat info;
+			return stat(filename, &info) == 0 && !S_ISDIR(info.st_mode);
+		}
+
+		bool dirExists(const char* dirName)
+		{
+			struct stat info;
+			return stat(dirName, &info) == 0 && S_ISDIR(info.st_mode);
+		}
+
+		bool deleteFile(const char* filename)
+		{
+			if (unlink(filename) != 0)
+			{
+				g_logger_error("Delete file '%s' failed with: %s", filename, strerror(errno));
+				return false;
+			}
+
+			return true;
+		}
+
+		std::string tmpFilename()
+		{
+			// Like _mktemp_s this only picks a name, nothing gets created
+			constexpr char characters[] = "abcdefghijklmnopqrstuvwxyz0123456789";
+			static std::mt19937 generator{ std::random_device{}() };
+			std::uniform_int_distribution<int> distribution(0, (int)sizeof(characters) - 2);
+
+			for (int attempt = 0; attempt < 100; attempt++)
+			{
+				std::string res = "fn";
+				for (int i = 0; i < 6; i++)
+				{
+					res += characters[distribution(generator)];
+				}
+
+				if (access(res.c_str(), F_OK) != 0)
+				{
+					return res;
+				}
+			}
+
+			return std::string("");
+		}
+
+		std::string getSpecialAppDir()
+		{
+			const char* dataHome = getenv("XDG_DATA_HOME");
+			if (dataHome && dataHome[0] != '\0')
+			{
+				return std::string(dataHome);
+			}
+
+			const char* home = getenv("HOME");
+			if (home)
+			{
+				return std::string(home) + "/.local/share";
+			}
+
+			return "";
+		}
+
+		void createDirIfNotExists(const char* dirName)
+		{
+			mkdir(dirName, 0755);
+		}
+
+		std::string md5FromString(const std::string& str, int md5Length)
+		{
+			return md5FromString(str.c_str(), str.length(), md5Length);
+		}
+
+		std::string md5FromString(const char* str, size_t length, int md5Length)
+		{
+			constexpr int maxMd5Length = 1024;
+			g_logger_assert(md5Length < maxMd5Length, "Cannot generate md5 greater than %d characters.", maxMd5Length);
+
+			uint8 digest[16];
+			md5((const uint8*)str, length, digest);
+
+			const char hexDigits[] = "0123456789abcdef";
+			std::string hashRes = "";
+			for (int i = 0; i < md5Length && i < 16; i++)
+			{
+				hashRes += hexDigits[digest[i] >> 4];
+				hashRes += hexDigits[digest[i] & 0xf];
+			}
+
+			return hashRes;
+		}
+
+		MemoryMappedFile* memoryMapFile(const char* filename)
+		{
+			int fd = open(filename, O_RDONLY | O_CLOEXEC);
+			if (fd < 0)
+			{
+				return nullptr;
+			}
+
+			struct stat info;
+			if (fstat(fd, &info) != 0 || info.st_size == 0)
+			{
+				close(fd);
+				return nullptr;
+			}
+
+			void* data = mmap(nullptr, (size_t)info.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+			// The mapping keeps the file alive on its own
+			close(fd);
+			if (data == MAP_FAILED)
+			{
+				g_logger_error("mmap for '%s' failed with: %s", filename, strerror(errno));
+				return nullptr;
+			}
+
+			MemoryMappedFile* res = (MemoryMappedFile*)g_memory_allocate(sizeof(MemoryMappedFile));
+			res->data = (const uint8*)data;
+			res->dataSize = (size_t)info.st_size;
+			res->fileHandle = nullptr;
+			res->mappingHandle = nullptr;
+			return res;
+		}
+
+		void unmapFile(MemoryMappedFile* file)
+		{
+			if (file == nullptr)
+			{
+				return;
+			}
+
+			munmap((void*)file->data, file->dataSize);
+			g_memory_free(file);
+		}
+
+		void* tryLockFile(const char* filename)
+		{
+			// Close on exec so child processes never end up holding the lock too
+			int fd = open(filename, O_RDWR | O_CREAT | O_CLOEXEC, 0644);
+			if (fd < 0)
+			{
+				return nullptr;
+			}
+
+			if (flock(fd, LOCK_EX | LOCK_NB) != 0)
+			{
+				close(fd);
+				return nullptr;
+			}
+
+			// Offset by one so a lock on fd 0 isn't mistaken for a failure
+			return (void*)(intptr_t)(fd + 1);
+		}
+
+		void unlockFile(void* lock)
+		{
+			if (lock != nullptr)
+			{
+				// Closing the last descriptor releases the flock
+				close((int)(intptr_t)lock - 1);
+			}
+		}
+
+		// --------------- Internal Functions ---------------
+		static std::vector<std::string> splitCommandLine(const char* cmdLine)
+		{
+			// Argument strings are built for CreateProcess, so they're split the way
+			// CommandLineToArgvW does it. Backslashes are only special in front of a quote.
+			std::vector<std::string> res;
+			if (cmdLine == nullptr)
+			{
+				return res;
+			}
+
+			const char* c = cmdLine;
+			while (*c != '\0')
+			{
+				while (*c == ' ' || *c == '\t')
+				{
+					c++;
+				}
+
+				if (*c == '\0')
+				{
+					break;
+				}
+
+				std::string arg = "";
+				bool inQuotes = false;
+				while (*c != '\0' && (inQuotes || (*c != ' ' && *c != '\t')))
+				{
+					int numBackslashes = 0;
+					while (*c == '\\')
+					{
+						numBackslashes++;
+						c++;
+					}
+
+					if (*c == '"')
+					{
+						// 2n backslashes are n backslashes and the quote toggles quoting,
+						// 2n + 1 backslashes are n backslashes and a literal quote
+						arg.append(numBackslashes / 2, '\\');
+						if (numBackslashes % 2 == 0)
+						{
+							inQuotes = !inQuotes;
+						}
+						else
+						{
+							arg += '"';
+						}
+						c++;
+					}
+					else
+					{
+						arg.append(numBackslashes, '\\');
+						if (*c != '\0' && (inQuotes || (*c != ' ' && *c != '\t')))
+						{
+							arg += *c;
+							c++;
+						}
+					}
+				}
+
+				res.push_back(arg);
+			}
+
+			return res;
+		}
+
+		static bool findProgramOnPath(const char* programName, std::string* outPath)
+		{
+			if (std::strchr(programName, '/') != nullptr)
+			{
+				if (access(programName, X_OK) == 0)
+				{
+					if (outPath)
+					{
+						*outPath = programName;
+					}
+					return true;
+				}
+				return false;
+			}
+
+			const char* path = getenv("PATH");
+			if (path == nullptr)
+			{
+				return false;
+			}
+
+			std::stringstream pathStream(path);
+			std::string dir;
+			while (std::getline(pathStream, dir, ':'))
+			{
+				std::string candidate = (dir.empty() ? std::string(".") : dir) + "/" + programName;
+				if (access(candidate.c_str(), X_OK) == 0 && fileExists(candidate.c_str()))
+				{
+					if (outPath)
+					{
+						*outPath = candidate;
+					}
+					return true;
+				}
+			}
+
+			return false;
+		}
+
+		static pid_t spawnProcess(const char* programFilepath, const char* cmdLineArgs, const char* workingDirectory, const char* outputFilepath)
+		{
+			std::vector<std::string> args = splitCommandLine(cmdLineArgs);
+			args.insert(args.begin(), programFilepath);
+
+			// Everything the child needs is built before the fork, it may only call
+			// async-signal-safe functions afterwards
+			std::vector<char*> argv;
+			for (std::string& arg : args)
+			{
+				argv.push_back(arg.data());
+			}
+			argv.push_back(nullptr);
+
+			int outputFd = -1;
+			if (outputFilepath)
+			{
+				outputFd = open(outputFilepath, O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, 0644);
+				if (outputFd < 0)
+				{
+					g_logger_warning("Could not open '%s' for the output of '%s'.", outputFilepath, programFilepath);
+				}
+			}
+
+			pid_t pid = fork();
+			if (pid == 0)
+			{
+				if (workingDirectory && chdir(workingDirectory) != 0)
+				{
+					_exit(127);
+				}
+
+				if (outputFd >= 0)
+				{
+					dup2(outputFd, STDOUT_FILENO);
+					dup2(outputFd, STDERR_FILENO);
+				}
+
+				// execvp so bare program names are looked up on the path like CreateProcess does
+				execvp(argv[0], argv.data());
+				_exit(127);
+			}
+
+			if (outputFd >= 0)
+			{
+				close(outputFd);
+			}
+
+			if (pid < 0)
+			{
+				g_logger_error("Failed to launch process '%s': %s", programFilepath, strerror(errno));
+			}
+
+			return pid;
+		}
+
+		static bool spawnDetached(const std::vector<std::string>& args)
+		{
+			std::vector<std::string> argsCopy = args;
+			std::vector<char*> argv;
+			for (std::string& arg : argsCopy)
+			{
+				argv.push_back(arg.data());
+			}
+			argv.push_back(nullptr);
+
+			// Fork twice so the program gets reparented to init and never has to be waited on
+			pid_t pid = fork();
+			if (pid == 0)
+			{
+				if (fork() == 0)
+				{
+					setsid();
+					execvp(argv[0], argv.data());
+					_exit(127);
+				}
+				_exit(0);
+			}
+
+			if (pid < 0)
+			{
+				g_logger_error("Failed to launch process '%s': %s", args[0].c_str(), strerror(errno));
+				return false;
+			}
+
+			waitpid(pid, nullptr, 0);
+			return true;
+		}
+
+		// RFC 1321, the same digest CryptoAPI's CALG_MD5 produces
+		static void md5(const uint8* data, size_t length, uint8 outDigest[16])
+		{
+			static const uint32 shifts[64] = {
+				7, 12, 17, 22, 7, 12, 17, 22, 7, 12, 17, 22, 7, 12, 17, 22,
+				5, 9, 14, 20, 5, 9, 14, 20, 5, 9, 14, 20, 5, 9, 14, 20,
+				4, 11, 16, 23, 4, 11, 16, 23, 4, 11, 16, 23, 4, 11, 16, 23,
+				6, 10, 15, 21, 6, 10, 15, 21, 6, 10, 15, 21, 6, 10, 15, 21
+			};
+			// Initialized once, even when several threads hash at the same time
+			static const std::array<uint32, 64> sines = []() {
+				std::array<uint32, 64> res;
+				for (int i = 0; i < 64; i++)
+				{
+					res[i] = (uint32)(uint64)(std::abs(std::sin((double)(i + 1))) * 4294967296.0);
+				}
+				return res;
+			}();
+
+			uint32 state[4] = { 0x67452301, 0xefcdab89, 0x98badcfe, 0x10325476 };
+
+			// The message is padded with a 1 bit, zeros and the length in bits to a
+			// multiple of 64 bytes
+			size_t paddedLength = ((length + 8) / 64 + 1) * 64;
+			std::vector<uint8> message(paddedLength, 0);
+			if (length > 0)
+			{
+				g_memory_copyMem(message.data(), (void*)data, length);
+			}
+			message[length] = 0x80;
+			uint64 lengthInBits = (uint64)length * 8;
+			for (int i = 0; i < 8; i++)
+			{
+				message[paddedLength - 8 + i] = (uint8)(lengthInBits >> (8 * i));
+			}
+
+			for (size_t chunk = 0; chunk < paddedLength; chunk += 64)
+			{
+				uint32 words[16];
+				for (int i = 0; i < 16; i++)
+				{
+					const uint8* w = &message[chunk + i * 4];
+					words[i] = (uint32)w[0] | ((uint32)w[1] << 8) | ((uint32)w[2] << 16) | ((uint32)w[3] << 24);
+				}
+
+				uint32 a = state[0];
+				uint32 b = state[1];
+				uint32 c = state[2];
+				uint32 d = state[3];
+				for (int i = 0; i < 64; i++)
+				{
+					uint32 f;
+					int g;
+					if (i < 16)
+					{
+						f = (b & c) | (~b & d);
+						g = i;
+					}
+					else if (i < 32)
+					{
+						f = (d & b) | (~d & c);
+						g = (5 * i + 1) % 16;
+					}
+					else if (i < 48)
+					{
+						f = b ^ c ^ d;
+						g = (3 * i + 5) % 16;
+					}
+					else
+					{
+						f = c ^ (b | ~d);
+						g = (7 * i) % 16;
+					}
+
+					uint32 rotated = a + f + sines[i] + words[g];
+					a = d;
+					d = c;
+					c = b;
+					b = b + ((rotated << shifts[i]) | (rotated >> (32 - shifts[i])));
+				}
+
+				state[0] += a;
+				state[1] += b;
+				state[2] += c;
+				state[3] += d;
+			}
+
+			for (int i = 0; i < 4; i++)
+			{
+				for (int j = 0; j < 4; j++)
+				{
+					outDigest[i * 4 + j] = (uint8)(state[i] >> (8 * j));
+				}
+			}
+		}
+	}
+}
+
+#endif
@@ -46,6 +46,11 @@ namespace MathAnim
 			return availableFonts;
 		}
 
+		const char* getDefaultMonoFontPath()
+		{
+			return "C:\\Windows\\Fonts\\consola.ttf";
+		}
+
 		// Adapted from https://stackoverflow.com/questions/2467429/c-check-installed-programms
 		bool isProgramInstalled(const char* displayName)
 		{
@@ -320,6 +325,45 @@ namespace MathAnim
 			return true;
 		}
 
+		bool executeProgramAndWait(const char* programFilepath, const char* cmdLineArgs, int* exitCode)
+		{
+			STARTUPINFOA si = { 0 };
+			si.cb = sizeof(si);
+			PROCESS_INFORMATION pi = { 0 };
+
+			std::string finalArgs = std::string("\"") + programFilepath + std::string("\" ") + cmdLineArgs;
+			if (!CreateProcessA(
+				NULL,
+				(char*)finalArgs.c_str(),
+				NULL,
+				NULL,
+				TRUE,
+				0,
+				NULL,
+				NULL,
+				&si,
+				&pi
+			))
+			{
+				DWORD dwStatus = GetLastError();
+				g_logger_error("Failed to launch process '%s': %d", finalArgs.c_str(), dwStatus);
+				return false;
+			}
+
+			WaitForSingleObject(pi.hProcess, INFINITE);
+
+			DWORD processExitCode = 0;
+			GetExitCodeProcess(pi.hProcess, &processExitCode);
+			if (exitCode)
+			{
+				*exitCode = (int)processExitCode;
+			}
+
+			CloseHandle(pi.hProcess);
+			CloseHandle(pi.hThread);
+			return true;
+		}
+
 		bool openFileWithDefaultProgram(const char* filepath)
 		{
 			return (uint64)ShellExecuteA(NULL, "code", filepath, NULL, NULL, SW_SHOW) > 32;
@@ -456,6 +500,79 @@ namespace MathAnim
 			return hashRes;
 		}
 
+		MemoryMappedFile* memoryMapFile(const char* filename)
+		{
+			HANDLE fileHandle = CreateFileA(filename, GENERIC_READ, FILE_SHARE_READ | FILE_SHARE_WRITE | FILE_SHARE_DELETE, NULL, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, NULL);
+			if (fileHandle == INVALID_HANDLE_VALUE)
+			{
+				return nullptr;
+			}
+
+			LARGE_INTEGER fileSize;
+			if (!GetFileSizeEx(fileHandle, &fileSize) || fileSize.QuadPart == 0)
+			{
+				CloseHandle(fileHandle);
+				return nullptr;
+			}
+
+			HANDLE mappingHandle = CreateFileMappingA(fileHandle, NULL, PAGE_READONLY, 0, 0, NULL);
+			if (mappingHandle == NULL)
+			{
+				g_logger_error("CreateFileMapping for '%s' failed with: %d", filename, GetLastError());
+				CloseHandle(fileHandle);
+				return nullptr;
+			}
+
+			const uint8* data = (const uint8*)MapViewOfFile(mappingHandle, FILE_MAP_READ, 0, 0, 0);
+			if (data == nullptr)
+			{
+				g_logger_error("MapViewOfFile for '%s' failed with: %d", filename, GetLastError());
+				CloseHandle(mappingHandle);
+				CloseHandle(fileHandle);
+				return nullptr;
+			}
+
+			MemoryMappedFile* res = (MemoryMappedFile*)g_memory_allocate(sizeof(MemoryMappedFile));
+			res->data = data;
+			res->dataSize = (size_t)fileSize.QuadPart;
+			res->fileHandle = fileHandle;
+			res->mappingHandle = mappingHandle;
+			return res;
+		}
+
+		void unmapFile(MemoryMappedFile* file)
+		{
+			if (file == nullptr)
+			{
+				return;
+			}
+
+			UnmapViewOfFile(file->data);
+			CloseHandle((HANDLE)file->mappingHandle);
+			CloseHandle((HANDLE)file->fileHandle);
+			g_memory_free(file);
+		}
+
+		void* tryLockFile(const char* filename)
+		{
+			// No sharing means nobody else can open it until the handle gets closed
+			HANDLE lockHandle = CreateFileA(filename, GENERIC_READ | GENERIC_WRITE, 0, NULL, OPEN_ALWAYS, FILE_ATTRIBUTE_NORMAL | FILE_FLAG_DELETE_ON_CLOSE, NULL);
+			if (lockHandle == INVALID_HANDLE_VALUE)
+			{
+				return nullptr;
+			}
+
+			return (void*)lockHandle;
+		}
+
+		void unlockFile(void* lock)
+		{
+			if (lock != nullptr)
+			{
+				CloseHandle((HANDLE)lock);
+			}
+		}
+
 		// --------------- Internal Functions ---------------
 		static void wideToChar(const WCHAR* wide, char* buffer, size_t bufferLength)
 		{
@@ -1,8 +1,13 @@
 #include "renderer/Fonts.h"
 #include "renderer/Renderer.h"
+#include "renderer/TextLayout.h"
 #include "core/Application.h"
 #include "svg/Svg.h"
 #include "utils/CMath.h"
+#include "utils/RectPacker.h"
+#include "utils/Utf8.h"
+#include "platform/Platform.h"
+#include "multithreading/GlobalThreadPool.h"
 
 #include <freetype/ftglyph.h>
 #include <freetype/freetype.h>
@@ -86,6 +91,7 @@ inline MathAnim::Vec2 FT_Vector_ToVec2(const FT_Vector& vec, float glyphLeft, fl
 namespace MathAnim
 {
 	CharRange CharRange::Ascii = { 32, 126 };
+	CharRange CharRange::None = { 1, 0 };
 
 	struct SharedFont
 	{
@@ -99,53 +105,140 @@ namespace MathAnim
 		int referenceCount;
 	};
 
-	const GlyphOutline& Font::getGlyphInfo(uint32 glyphIndex) const
+	struct SdfGlyphJob
 	{
-		auto iter = glyphMap.find(glyphIndex);
+		SdfAtlasJob* atlasJob;
+		// The worker gets its own copy of the outline since the font can be unloaded
+		// before it's done
+		SvgObject svg;
+		PackedRect rect;
+		// Where the glyph's pixels start in SdfAtlasJob::pixels
+		size_t pixelOffset;
+	};
+
+	struct SdfAtlasJob
+	{
+		SdfGlyphJob* glyphJobs;
+		uint32* codepoints;
+		int numGlyphs;
+		// Every glyph job writes to its own slice of this, the rows of a glyph are
+		// rect.width pixels apart
+		uint8* pixels;
+		// Size of the atlas the glyphs were placed in
+		int width;
+		int height;
+		// Guarded by sdfMtx
+		int glyphsLeft;
+		bool abandoned;
+	};
+
+	struct FontOutlineJob
+	{
+		FontLoadJob* loadJob;
+		uint32 firstCodepoint;
+		uint32 lastCodepoint;
+	};
+
+	struct FontLoadJob
+	{
+		char* filepath;
+		MemoryMappedFile* fileData;
+		CharRange charset;
+		// One per codepoint in charset, every outline job fills in its own range
+		GlyphOutline* outlines;
+		FontOutlineJob* outlineJobs;
+		int numOutlineJobs;
+		int tasksLeft;
+		bool failed;
+		bool abandoned;
+	};
+
+	// A FreeType library can only be used by one thread at a time, so every thread
+	// that reads fonts gets its own
+	struct ThreadFreeTypeLibrary
+	{
+		FT_Library library = nullptr;
+
+		~ThreadFreeTypeLibrary()
+		{
+			if (library)
+			{
+				FT_Done_FreeType(library);
+			}
+		}
+	};
+
+	const GlyphOutline& Font::getGlyphInfo(uint32 codepoint)
+	{
+		auto iter = glyphMap.find(codepoint);
 		if (iter != glyphMap.end())
 		{
 			return iter->second;
 		}
 
-		g_logger_error("Glyph index '%d' does not exist in font '%s'.", glyphIndex, fontFilepath.c_str());
-		static GlyphOutline defaultGlyph = {};
-		return defaultGlyph;
-	}
-
-	float Font::getKerning(uint32 leftCodepoint, uint32 rightCodepoint) const
-	{
-		FT_Vector kerning;
+		// The default charset shows up in the glyph map once the font is loaded
+		if (pendingLoad)
+		{
+			Fonts::waitUntilFontReady(this);
+			iter = glyphMap.find(codepoint);
+			if (iter != glyphMap.end())
+			{
+				return iter->second;
+			}
+		}
 
-		FT_UInt leftGlyph = FT_Get_Char_Index(fontFace, leftCodepoint);
-		FT_UInt rightGlyph = FT_Get_Char_Index(fontFace, rightCodepoint);
-		int error = FT_Get_Kerning(fontFace, leftGlyph, rightGlyph, FT_Kerning_Mode::FT_KERNING_DEFAULT, &kerning);
-		if (error)
+		// Missing glyphs are remembered too, so they only get looked up once
+		GlyphOutline outline = {};
+		if (loadState != FontLoadState::Loaded || Fonts::createOutline(this, codepoint, &outline))
 		{
-			return 0.0f;
+			outline = {};
 		}
 
-		return (float)kerning.x / unitsPerEM;
+		if (outline.hasGeometry())
+		{
+			numVisibleOutlines++;
+		}
+		return glyphMap.emplace(codepoint, outline).first->second;
 	}
 
-	glm::vec2 Font::getSizeOfString(const std::string& string) const
+	float Font::getKerning(uint32 leftCodepoint, uint32 rightCodepoint)
 	{
-		glm::vec2 cursor = glm::vec2();
-		for (int i = 0; i < string.length(); i++)
+		if (pendingLoad)
 		{
-			const GlyphOutline& outline = getGlyphInfo((uint32)string[i]);
-			cursor.x += outline.advanceX;
+			Fonts::waitUntilFontReady(this);
+		}
 
-			if (string[i] == '\n')
-			{
-				cursor.y += lineHeight;
-			}
+		if (!hasKerning)
+		{
+			return 0.0f;
+		}
+
+		uint64 pairKey = ((uint64)leftCodepoint << 32) | (uint64)rightCodepoint;
+		auto iter = kerningPairs.find(pairKey);
+		if (iter != kerningPairs.end())
+		{
+			return iter->second;
 		}
 
-		cursor.y += lineHeight;
-		return cursor;
+		// NOTE: The face's pixel size changes with every glyph that gets rasterized, so
+		//       ask for the kerning in font units instead of the current scale
+		FT_Vector kerning;
+		FT_UInt leftGlyph = FT_Get_Char_Index(fontFace, leftCodepoint);
+		FT_UInt rightGlyph = FT_Get_Char_Index(fontFace, rightCodepoint);
+		int error = FT_Get_Kerning(fontFace, leftGlyph, rightGlyph, FT_Kerning_Mode::FT_KERNING_UNSCALED, &kerning);
+
+		float res = error ? 0.0f : (float)kerning.x / unitsPerEM;
+		kerningPairs[pairKey] = res;
+		return res;
+	}
+
+	glm::vec2 Font::getSizeOfString(const std::string& string)
+	{
+		const TextLayout* layout = TextLayouts::layout(this, 1.0f, string);
+		return glm::vec2(layout->size.x, layout->size.y);
 	}
 
-	glm::vec2 Font::getSizeOfString(const std::string& string, int fontSizePixels) const
+	glm::vec2 Font::getSizeOfString(const std::string& string, int fontSizePixels)
 	{
 		return getSizeOfString(string) * (float)fontSizePixels;
 	}
@@ -164,20 +257,20 @@ namespace MathAnim
 		descentY = 0.0f;
 	}
 
-	const GlyphTexture& SizedFont::getGlyphTexture(uint32 codepoint) const
+	namespace Fonts
+	{
+		static GlyphTexture rasterizeGlyph(SizedFont& font, uint32 codepoint);
+	}
+
+	const GlyphTexture& SizedFont::getGlyphTexture(uint32 codepoint)
 	{
-		if (this->glyphTextureCoords.find(codepoint) == this->glyphTextureCoords.end())
+		auto iter = glyphTextureCoords.find(codepoint);
+		if (iter != glyphTextureCoords.end())
 		{
-			g_logger_warning("Trying to access glyph texture for unloaded glyph: '%c' in font '%s'.", codepoint, this->unsizedFont->fontFilepath.c_str());
-			static GlyphTexture nullTexture = {
-				0,
-				Vec2{0, 0},
-				Vec2{0, 0}
-			};
-			return nullTexture;
+			return iter->second;
 		}
 
-		return this->glyphTextureCoords.at(codepoint);
+		return glyphTextureCoords.emplace(codepoint, Fonts::rasterizeGlyph(*this, codepoint)).first->second;
 	}
 
 	namespace Fonts
@@ -185,17 +278,63 @@ namespace MathAnim
 		static bool initialized = false;
 		static const int hzPadding = 2;
 		static const int vtPadding = 2;
+		static constexpr int glyphPageSize = 1024;
 		static FT_Library library;
 		static Font* defaultMonoFont = nullptr;
 		static std::unordered_map<std::string, SharedFont> loadedFonts;
 		static std::unordered_map<std::string, SharedSizedFont> loadedSizedFonts;
 
-		static void generateDefaultCharset(Font& font, CharRange defaultCharset);
+		// Distance fields are generated at sdfEmSize pixels per em. Every texel stores the
+		// distance to the outline, clamped to sdfPixelRange pixels on either side.
+		static constexpr int sdfEmSize = 48;
+		static constexpr int sdfPixelRange = 4;
+		static constexpr int sdfMinAtlasSize = 256;
+		static constexpr int sdfMaxAtlasSize = 4096;
+		static constexpr uint32 sdfCacheMagic = 0x46445353; // "SSDF"
+		static constexpr uint32 sdfCacheVersion = 2;
+		static std::string sdfCacheDirectory;
+		static std::mutex sdfMtx;
+		static std::condition_variable sdfCv;
+
+		// Codepoints in a font's default charset are split into jobs of this many
+		// outlines each
+		static constexpr uint32 outlineJobSize = 32;
+		static std::mutex fontLoadMtx;
+		static std::condition_variable fontLoadCv;
+		static thread_local ThreadFreeTypeLibrary threadLibrary;
+
+		static void loadFontTask(void* data, size_t dataSize);
+		static void extractOutlinesTask(void* data, size_t dataSize);
+		static void completeFontLoadTask(FontLoadJob* job);
+		static void finishFontLoad(Font& font);
+		static void freeFontLoadJob(FontLoadJob* job);
+		static void freeFont(Font& font);
+		static FT_Library getThreadLibrary();
+		static uint32 getNumCodepoints(CharRange range);
+		static int createOutlineFromFace(FT_Face fontFace, const char* filepath, uint32 character, GlyphOutline* outlineResult);
+		static GlyphAtlasPage createGlyphPage();
+		static void freeGlyphPages(SizedFont& font);
 		static int getOutline(FT_Glyph glyph, FT_OutlineGlyph* Outg);
 		static GlyphOutline createOutlineInternal(FT_OutlineGlyph outlineGlyph, FT_Face face);
-		static std::string getSizedFontKey(const char* filepath, int fontSizePixels);
+		static std::string getSizedFontKey(const char* filepath, int fontSizePixels, FontAtlasMode atlasMode);
 		static std::string getUnsizedFontKey(const char* filepath);
 
+		static void beginSdfAtlas(Font& font);
+		static void finishSdfAtlas(Font& font);
+		static void freeSdfAtlas(Font& font);
+		static bool placeSdfGlyph(SdfFontAtlas& atlas, int width, int height, PackedRect* outRect);
+		static void growSdfAtlas(SdfFontAtlas& atlas, int width, int height);
+		static void createSdfAtlasTexture(SdfFontAtlas& atlas);
+		static bool loadSdfAtlasFromDisk(Font& font);
+		static void saveSdfAtlasToDisk(const Font& font);
+		static std::string getSdfCacheFilename(const Font& font);
+		static int getSdfGlyphSize(float emSize);
+		static SdfGlyph createSdfGlyph(const PackedRect& rect, int atlasWidth, int atlasHeight);
+		static void generateSdfGlyphTask(void* data, size_t dataSize);
+		static void flattenOutline(const SvgObject& svg, float scale, const Vec2& offset, std::vector<Vec2>& outSegments);
+		static float distanceToSegmentSquared(const Vec2& p, const Vec2& a, const Vec2& b);
+		static void freeSdfAtlasJob(SdfAtlasJob* job);
+
 		void init()
 		{
 			int error = FT_Init_FreeType(&library);
@@ -207,50 +346,34 @@ namespace MathAnim
 			g_logger_info("Initialized freetype library.");
 			initialized = true;
 
-			defaultMonoFont = loadFont("C:\\Windows\\Fonts\\consola.ttf");
-		}
-
-		int createOutline(Font* font, uint32 character, GlyphOutline* outlineResult)
-		{
-			g_logger_assert(font->fontFace != nullptr, "Cannot create outline for uninitialized font '%s'.", font->fontFilepath.c_str());
-
-			FT_Face fontFace = font->fontFace;
-			FT_UInt glyphIndex = FT_Get_Char_Index(fontFace, character);
-			if (glyphIndex == 0)
-			{
-				g_logger_warning("Character code '%c' not found. Missing glyph.", character);
-				return 1;
-			}
-
-			// Load the glyph
-			FT_Error error = FT_Load_Glyph(fontFace, glyphIndex, FT_LOAD_NO_SCALE);
-			if (error)
+			// Distance field atlases only depend on the font file, so they're cached per
+			// user instead of per project
+			std::filesystem::path sdfCachePath = std::filesystem::path(Platform::getSpecialAppDir()) / "MathAnimationEditor" / "cache" / "fonts";
+			std::error_code err;
+			std::filesystem::create_directories(sdfCachePath, err);
+			if (err)
 			{
-				g_logger_error("Freetype could not load glyph for character code '%c'.", character);
-				return 2;
+				g_logger_warning("Could not create font cache directory '%s'. Distance field atlases won't be cached.", sdfCachePath.string().c_str());
 			}
-
-			FT_Glyph glyph;
-			FT_Get_Glyph(fontFace->glyph, &glyph);
-			FT_OutlineGlyph outline;
-
-			error = getOutline(glyph, &outline);
-			if (error)
+			else
 			{
-				g_logger_error("Could not get outline for '%c'.", character);
-				return 3;
+				sdfCacheDirectory = sdfCachePath.string() + "/";
 			}
 
-			*outlineResult = createOutlineInternal(outline, fontFace);
-			FT_Done_Glyph(glyph);
+			// Code blocks use this, but nothing needs it before the first frame
+			defaultMonoFont = loadFontAsync(Platform::getDefaultMonoFontPath(), CharRange::Ascii);
+		}
 
-			return 0;
+		int createOutline(Font* font, uint32 character, GlyphOutline* outlineResult)
+		{
+			g_logger_assert(font->fontFace != nullptr, "Cannot create outline for uninitialized font '%s'.", font->fontFilepath.c_str());
+			return createOutlineFromFace(font->fontFace, font->fontFilepath.c_str(), character, outlineResult);
 		}
 
-		SizedFont* loadSizedFont(const char* filepath, int fontSizePixels, CharRange defaultCharset)
+		SizedFont* loadSizedFont(const char* filepath, int fontSizePixels, CharRange defaultCharset, FontAtlasMode atlasMode)
 		{
 			// Check if the sized font is already loaded
-			std::string sizedFontKey = getSizedFontKey(filepath, fontSizePixels);
+			std::string sizedFontKey = getSizedFontKey(filepath, fontSizePixels, atlasMode);
 			{
 				auto iter = loadedSizedFonts.find(sizedFontKey);
 				if (iter != loadedSizedFonts.end())
@@ -265,9 +388,28 @@ namespace MathAnim
 
 			SizedFont res;
 			res.unsizedFont = loadFont(filepath, defaultCharset);
+			if (!res.unsizedFont)
+			{
+				return nullptr;
+			}
 			res.fontSizePixels = fontSizePixels;
+			res.atlasMode = atlasMode;
+
+			if (atlasMode == FontAtlasMode::DistanceField)
+			{
+				// Nothing gets rasterized at this size, just make sure the shared atlas
+				// is on its way
+				getSdfAtlas(res.unsizedFont);
+
+				loadedSizedFonts[sizedFontKey].font = res;
+				loadedSizedFonts[sizedFontKey].referenceCount = 1;
+
+				return &loadedSizedFonts[sizedFontKey].font;
+			}
 
 			{
+				// Glyphs are rasterized the first time they're drawn, but sizes freetype
+				// can't handle should still fail here
 				FT_Error error = FT_Set_Pixel_Sizes(res.unsizedFont->fontFace, fontSizePixels, fontSizePixels);
 				if (error)
 				{
@@ -277,83 +419,6 @@ namespace MathAnim
 				}
 			}
 
-			constexpr uint32 textureWidth = 2048;
-			constexpr uint32 textureHeight = 2048;
-			res.texture = TextureBuilder()
-				.setFormat(ByteFormat::R8_UI)
-				.setWidth(textureWidth)
-				.setHeight(textureHeight)
-				.setMagFilter(FilterMode::Linear)
-				.setMinFilter(FilterMode::Linear)
-				.setWrapS(WrapMode::None)
-				.setWrapT(WrapMode::None)
-				.generate();
-
-			// Generate the texture and upload it to the GPU
-			uint8* textureMemory = (uint8*)g_memory_allocate(sizeof(uint8) * textureWidth * textureHeight);
-			g_memory_zeroMem(textureMemory, sizeof(uint8) * textureWidth * textureHeight);
-			uint32 cursorX = 0;
-			uint32 cursorY = 0;
-			uint32 lineHeight = 0;
-			for (uint32 codepoint = defaultCharset.firstCharCode; codepoint <= defaultCharset.lastCharCode; codepoint++)
-			{
-				FT_UInt glyphIndex = FT_Get_Char_Index(res.unsizedFont->fontFace, codepoint);
-				if (glyphIndex == 0)
-				{
-					g_logger_warning("Character code '%c' not found. Missing glyph.", codepoint);
-					continue;
-				}
-
-				// Load the glyph
-				FT_Error error = FT_Load_Glyph(res.unsizedFont->fontFace, glyphIndex, FT_LOAD_RENDER);
-				if (error)
-				{
-					g_logger_error("Freetype could not load glyph for character code '%c'.", codepoint);
-				}
-
-				FT_Bitmap& bitmap = res.unsizedFont->fontFace->glyph->bitmap;
-				if (cursorX + bitmap.width >= textureWidth)
-				{
-					cursorY += lineHeight;
-					lineHeight = 0;
-					cursorX = 0;
-				}
-				lineHeight = glm::max(bitmap.rows, lineHeight);
-
-				if (cursorY + bitmap.rows >= textureHeight)
-				{
-					g_logger_error("Ran out of texture room for font '%s'", filepath);
-					continue;
-				}
-
-				// Copy every row into our bitmap
-				for (uint32 y = 0; y < bitmap.rows; y++)
-				{
-					uint8* dst = textureMemory + cursorX + ((cursorY + y) * textureWidth);
-					uint8* src = bitmap.buffer + (y * bitmap.width);
-					g_memory_copyMem(dst, src, sizeof(uint8) * bitmap.width);
-				}
-
-				// Add normalized glyph position
-				res.glyphTextureCoords[codepoint].lruCacheId = 0;
-				res.glyphTextureCoords[codepoint].uvMin = Vec2{
-					(float)cursorX / (float)textureWidth,
-					(float)cursorY / (float)textureHeight
-				};
-				res.glyphTextureCoords[codepoint].uvMax = Vec2{
-					(float)cursorX / (float)textureWidth + (float)bitmap.width / (float)textureWidth,
-					(float)cursorY / (float)textureHeight + (float)bitmap.rows / (float)textureHeight
-				};
-
-				// Increment our write cursor
-				cursorX += bitmap.width;
-			}
-
-			// Upload texture memory to the GPU
-			res.texture.uploadSubImage(0, 0, textureWidth, textureHeight, textureMemory, sizeof(uint8) * textureWidth * textureHeight);
-
-			g_memory_free(textureMemory);
-
 			// All done now cache the result and return it
 			loadedSizedFonts[sizedFontKey].font = res;
 			loadedSizedFonts[sizedFontKey].referenceCount = 1;
@@ -375,7 +440,7 @@ namespace MathAnim
 				return;
 			}
 
-			std::string fontKey = getSizedFontKey(sizedFont->unsizedFont->fontFilepath.c_str(), sizedFont->fontSizePixels);
+			std::string fontKey = getSizedFontKey(sizedFont->unsizedFont->fontFilepath.c_str(), sizedFont->fontSizePixels, sizedFont->atlasMode);
 			auto iter = loadedSizedFonts.find(fontKey);
 			if (iter == loadedSizedFonts.end())
 			{
@@ -394,14 +459,14 @@ namespace MathAnim
 			if (iter->second.referenceCount <= 0)
 			{
 				// Really unload the font now
-				font->texture.destroy();
+				freeGlyphPages(*font);
 				loadedSizedFonts.erase(iter);
 			}
 		}
 
-		void unloadSizedFont(const char* filepath, int fontSizePixels)
+		void unloadSizedFont(const char* filepath, int fontSizePixels, FontAtlasMode atlasMode)
 		{
-			std::string fontKey = getSizedFontKey(filepath, fontSizePixels);
+			std::string fontKey = getSizedFontKey(filepath, fontSizePixels, atlasMode);
 			auto iter = loadedSizedFonts.find(fontKey);
 			if (iter == loadedSizedFonts.end())
 			{
@@ -414,6 +479,19 @@ namespace MathAnim
 		}
 
 		Font* loadFont(const char* filepath, CharRange defaultCharset)
+		{
+			Font* font = loadFontAsync(filepath, defaultCharset);
+			waitUntilFontReady(font);
+			if (font->loadState == FontLoadState::Failed)
+			{
+				unloadFont(font);
+				return nullptr;
+			}
+
+			return font;
+		}
+
+		Font* loadFontAsync(const char* filepath, CharRange defaultCharset)
 		{
 			g_logger_assert(initialized, "Font library must be initialized to load a font.");
 
@@ -429,34 +507,86 @@ namespace MathAnim
 
 			g_logger_info("Caching unsized font '%s'.", unsizedFontKey.c_str());
 
-			// Load the new font into freetype.
-			FT_Face face;
-			int error = FT_New_Face(library, filepath, 0, &face);
-			if (error == FT_Err_Unknown_File_Format)
+			size_t filepathLength = std::strlen(filepath);
+			FontLoadJob* job = (FontLoadJob*)g_memory_allocate(sizeof(FontLoadJob));
+			job->filepath = (char*)g_memory_allocate(sizeof(char) * (filepathLength + 1));
+			g_memory_copyMem(job->filepath, (void*)filepath, sizeof(char) * (filepathLength + 1));
+			job->fileData = nullptr;
+			job->charset = defaultCharset;
+			job->outlines = nullptr;
+			job->outlineJobs = nullptr;
+			job->numOutlineJobs = 0;
+			job->tasksLeft = 1;
+			job->failed = false;
+			job->abandoned = false;
+
+			// The metrics get filled in once the font is loaded
+			Font font;
+			font.fontFilepath = filepath;
+			font.fontFace = nullptr;
+			font.fileData = nullptr;
+			font.numVisibleOutlines = 0;
+			font.unitsPerEM = 0.0f;
+			font.lineHeight = 0.0f;
+			font.sdfAtlas.packer.init(sdfMinAtlasSize, sdfMinAtlasSize);
+			font.sdfAtlas.pixels = nullptr;
+			font.sdfAtlas.width = 0;
+			font.sdfAtlas.height = 0;
+			font.sdfAtlas.pendingJob = nullptr;
+			font.sdfAtlas.numSourceGlyphs = 0;
+			font.sdfAtlas.isReady = false;
+			font.hasKerning = false;
+			font.loadState = FontLoadState::Loading;
+			font.pendingLoad = job;
+
+			loadedFonts[unsizedFontKey].font = font;
+			loadedFonts[unsizedFontKey].referenceCount = 1;
+
+			Application::threadPool()->queueTask(
+				loadFontTask,
+				"Load Font",
+				job,
+				sizeof(FontLoadJob)
+			);
+
+			return &loadedFonts[unsizedFontKey].font;
+		}
+
+		bool isFontReady(Font* font)
+		{
+			g_logger_assert(font != nullptr, "Cannot check if a null font is ready.");
+			if (!font->pendingLoad)
 			{
-				g_logger_error("Unsupported font file format for '%s'. Could not load font.", filepath);
-				return {};
+				return true;
 			}
-			else if (error)
+
 			{
-				g_logger_error("Font could not be opened or read or is broken '%s'. Could not load font.", filepath);
-				return {};
+				std::lock_guard<std::mutex> lock(fontLoadMtx);
+				if (font->pendingLoad->tasksLeft > 0)
+				{
+					return false;
+				}
 			}
 
-			// Generate a texture for the font and initialize the font structure
-			Font font;
-			font.fontFilepath = filepath;
-			font.fontFace = face;
-			font.unitsPerEM = (float)face->units_per_EM;
-			font.lineHeight = (float)face->height / font.unitsPerEM;
+			finishFontLoad(*font);
+			return true;
+		}
 
-			// TODO: Turn the preset characters into a parameter
-			generateDefaultCharset(font, defaultCharset);
+		void waitUntilFontReady(Font* font)
+		{
+			g_logger_assert(font != nullptr, "Cannot wait for a null font.");
+			if (!font->pendingLoad)
+			{
+				return;
+			}
 
-			loadedFonts[unsizedFontKey].font = font;
-			loadedFonts[unsizedFontKey].referenceCount = 1;
+			{
+				FontLoadJob* job = font->pendingLoad;
+				std::unique_lock<std::mutex> lock(fontLoadMtx);
+				fontLoadCv.wait(lock, [job] { return job->tasksLeft == 0; });
+			}
 
-			return &loadedFonts[unsizedFontKey].font;
+			finishFontLoad(*font);
 		}
 
 		void unloadFont(Font* font)
@@ -484,14 +614,8 @@ namespace MathAnim
 			// If the reference count is <= 0 then really unload it
 			g_logger_info("Unloading font '%s' from cache.", unsizedFontKey.c_str());
 
-			for (std::pair<const uint32, GlyphOutline>& kv : font->glyphMap)
-			{
-				GlyphOutline& outline = kv.second;
-				outline.free();
-			}
-
-			FT_Done_Face(font->fontFace);
-			font->fontFace = nullptr;
+			TextLayouts::evictFont(font);
+			freeFont(*font);
 			loadedFonts.erase(fontIter);
 		}
 
@@ -512,19 +636,12 @@ namespace MathAnim
 		{
 			unloadFont(defaultMonoFont);
 			defaultMonoFont = nullptr;
+			TextLayouts::clear();
 
 			// Delete all unsized fonts
 			for (auto iter = loadedFonts.begin(); iter != loadedFonts.end();)
 			{
-				Font& font = iter->second.font;
-				for (std::pair<const uint32, GlyphOutline>& kv : font.glyphMap)
-				{
-					GlyphOutline& outline = kv.second;
-					outline.free();
-				}
-
-				FT_Done_Face(font.fontFace);
-				font.fontFace = nullptr;
+				freeFont(iter->second.font);
 				iter->second.referenceCount = 0;
 
 				iter = loadedFonts.erase(iter);
@@ -534,7 +651,7 @@ namespace MathAnim
 			for (auto iter = loadedSizedFonts.begin(); iter != loadedSizedFonts.end();)
 			{
 				SizedFont& font = iter->second.font;
-				font.texture.destroy();
+				freeGlyphPages(font);
 				iter->second.referenceCount = 0;
 				iter = loadedSizedFonts.erase(iter);
 			}
@@ -545,80 +662,503 @@ namespace MathAnim
 			return defaultMonoFont;
 		}
 
-		static void generateDefaultCharset(Font& font, CharRange defaultCharset)
+		const SdfFontAtlas* getSdfAtlas(Font* font, bool waitUntilReady)
 		{
-			for (uint32 i = defaultCharset.firstCharCode; i <= defaultCharset.lastCharCode; i++)
+			g_logger_assert(font != nullptr, "Cannot get the distance field atlas of a null font.");
+			waitUntilFontReady(font);
+
+			// The atlas keeps getting used without the new glyphs while they're generated
+			SdfFontAtlas& atlas = font->sdfAtlas;
+			if (atlas.pendingJob == nullptr && (!atlas.isReady || atlas.numSourceGlyphs != font->numVisibleOutlines))
 			{
-				GlyphOutline outlineResult;
-				int error = createOutline(&font, i, &outlineResult);
-				if (error)
+				beginSdfAtlas(*font);
+			}
+
+			if (atlas.pendingJob)
+			{
+				SdfAtlasJob* job = atlas.pendingJob;
 				{
-					g_logger_warning("Could not create glyph outline for character '%c'", i);
-					continue;
+					std::unique_lock<std::mutex> lock(sdfMtx);
+					if (waitUntilReady)
+					{
+						sdfCv.wait(lock, [job] { return job->glyphsLeft == 0; });
+					}
+
+					if (job->glyphsLeft > 0)
+					{
+						return atlas.isReady ? &atlas : nullptr;
+					}
 				}
 
-				font.glyphMap[i] = outlineResult;
+				finishSdfAtlas(*font);
 			}
+
+			return &atlas;
 		}
 
-		//******************* check error code ********************
-		void Check(FT_Error ErrCode, const char* OKMsg, const char* ErrMsg)
+		static void loadFontTask(void* data, size_t dataSize)
 		{
-			if (ErrCode != 0)
+			g_logger_assert(dataSize == sizeof(FontLoadJob), "Invalid font load job.");
+			FontLoadJob* job = (FontLoadJob*)data;
+
+			// Only the parts of the file FreeType actually reads get paged in
+			job->fileData = Platform::memoryMapFile(job->filepath);
+			if (!job->fileData)
 			{
-				std::cout << ErrMsg << ": " << ErrCode << "\n";
-				std::cout << "program halted\n";
-				exit(1);
+				g_logger_error("Font could not be opened or read '%s'. Could not load font.", job->filepath);
+				job->failed = true;
+				completeFontLoadTask(job);
+				return;
 			}
-			else
-				std::cout << OKMsg << "\n";
-		}
 
-		//******************** get outline ************************
-		static int getOutline(FT_Glyph glyph, FT_OutlineGlyph* Outg)
-		{
-			int error = 0;
+			// Make sure FreeType can read the file before the outline jobs start on it
+			FT_Face face;
+			FT_Error error = FT_New_Memory_Face(getThreadLibrary(), job->fileData->data, (FT_Long)job->fileData->dataSize, 0, &face);
+			if (error == FT_Err_Unknown_File_Format)
+			{
+				g_logger_error("Unsupported font file format for '%s'. Could not load font.", job->filepath);
+				job->failed = true;
+				completeFontLoadTask(job);
+				return;
+			}
+			else if (error)
+			{
+				g_logger_error("Font could not be opened or read or is broken '%s'. Could not load font.", job->filepath);
+				job->failed = true;
+				completeFontLoadTask(job);
+				return;
+			}
+			FT_Done_Face(face);
 
-			switch (glyph->format)
+			uint32 numCodepoints = getNumCodepoints(job->charset);
+			if (numCodepoints > 0)
 			{
-			case FT_GLYPH_FORMAT_BITMAP:
-				error = 1;
-				break;
+				job->outlines = (GlyphOutline*)g_memory_allocate(sizeof(GlyphOutline) * numCodepoints);
+				g_memory_zeroMem(job->outlines, sizeof(GlyphOutline) * numCodepoints);
+				job->numOutlineJobs = (int)((numCodepoints + outlineJobSize - 1) / outlineJobSize);
+				job->outlineJobs = (FontOutlineJob*)g_memory_allocate(sizeof(FontOutlineJob) * job->numOutlineJobs);
+				for (int i = 0; i < job->numOutlineJobs; i++)
+				{
+					FontOutlineJob& outlineJob = job->outlineJobs[i];
+					outlineJob.loadJob = job;
+					outlineJob.firstCodepoint = job->charset.firstCharCode + (uint32)i * outlineJobSize;
+					outlineJob.lastCodepoint = glm::min(outlineJob.firstCodepoint + outlineJobSize - 1, job->charset.lastCharCode);
+				}
 
-			case FT_GLYPH_FORMAT_OUTLINE:
-				*Outg = (FT_OutlineGlyph)glyph;
-				break;
+				{
+					std::lock_guard<std::mutex> lock(fontLoadMtx);
+					job->tasksLeft += job->numOutlineJobs;
+				}
 
-			default:
-				break;
+				for (int i = 0; i < job->numOutlineJobs; i++)
+				{
+					Application::threadPool()->queueTask(
+						extractOutlinesTask,
+						"Extract Glyph Outlines",
+						&job->outlineJobs[i],
+						sizeof(FontOutlineJob)
+					);
+				}
 			}
-			return error;
+
+			completeFontLoadTask(job);
 		}
 
-		static GlyphOutline createOutlineInternal(FT_OutlineGlyph outlineGlyph, FT_Face face)
+		static void extractOutlinesTask(void* data, size_t dataSize)
 		{
-			FT_Outline* outline = &outlineGlyph->outline;
-
-			GlyphOutline res;
-			FT_GlyphSlot glyphSlot = face->glyph;
-
-			float upem = (float)face->units_per_EM;
-			float glyphLeft = (float)face->glyph->metrics.horiBearingX;
-			float descentY = (float)(glyphSlot->metrics.height - glyphSlot->metrics.horiBearingY);
+			g_logger_assert(dataSize == sizeof(FontOutlineJob), "Invalid glyph outline job.");
+			FontOutlineJob* outlineJob = (FontOutlineJob*)data;
+			FontLoadJob* job = outlineJob->loadJob;
 
-			res.advanceX = (float)glyphSlot->advance.x / upem;
-			res.bearingX = (float)glyphSlot->metrics.horiBearingX / upem;
-			res.bearingY = (float)glyphSlot->metrics.horiBearingY / upem;
-			res.descentY = descentY / upem;
-			res.glyphWidth = (float)glyphSlot->metrics.width / upem;
-			res.glyphHeight = (float)glyphSlot->metrics.height / upem;
+			// Faces can't be shared between threads either, but opening another one over
+			// the mapped file is cheap
+			FT_Face face;
+			FT_Error error = FT_New_Memory_Face(getThreadLibrary(), job->fileData->data, (FT_Long)job->fileData->dataSize, 0, &face);
+			if (!error)
+			{
+				for (uint32 codepoint = outlineJob->firstCodepoint; codepoint <= outlineJob->lastCodepoint; codepoint++)
+				{
+					GlyphOutline& outline = job->outlines[codepoint - job->charset.firstCharCode];
+					if (createOutlineFromFace(face, job->filepath, codepoint, &outline))
+					{
+						outline = {};
+					}
+				}
+				FT_Done_Face(face);
+			}
+			else
+			{
+				g_logger_error("Freetype could not open font '%s' to extract glyph outlines.", job->filepath);
+			}
 
-			res.svg = (SvgObject*)g_memory_allocate(sizeof(SvgObject));
-			*res.svg = Svg::createDefault();
+			completeFontLoadTask(job);
+		}
 
+		static void completeFontLoadTask(FontLoadJob* job)
+		{
+			bool isDone = false;
 			{
-				bool shouldCloseContour = false;
-
+				std::lock_guard<std::mutex> lock(fontLoadMtx);
+				job->tasksLeft--;
+				isDone = job->tasksLeft == 0;
+				if (isDone && job->abandoned)
+				{
+					freeFontLoadJob(job);
+					return;
+				}
+			}
+
+			if (isDone)
+			{
+				fontLoadCv.notify_all();
+			}
+		}
+
+		static void finishFontLoad(Font& font)
+		{
+			FontLoadJob* job = font.pendingLoad;
+			font.pendingLoad = nullptr;
+
+			if (!job->failed)
+			{
+				// The faces the workers opened were only for reading outlines, the font's own
+				// face belongs to the main thread's library
+				FT_Face face;
+				FT_Error error = FT_New_Memory_Face(library, job->fileData->data, (FT_Long)job->fileData->dataSize, 0, &face);
+				if (error)
+				{
+					g_logger_error("Font could not be opened or read or is broken '%s'. Could not load font.", job->filepath);
+					job->failed = true;
+				}
+				else
+				{
+					font.fontFace = face;
+					font.fileData = job->fileData;
+					job->fileData = nullptr;
+					font.unitsPerEM = (float)face->units_per_EM;
+					font.lineHeight = (float)face->height / font.unitsPerEM;
+					font.hasKerning = FT_HAS_KERNING(face);
+
+					uint32 numCodepoints = getNumCodepoints(job->charset);
+					for (uint32 i = 0; i < numCodepoints && job->outlines; i++)
+					{
+						font.glyphMap.emplace(job->charset.firstCharCode + i, job->outlines[i]);
+						if (job->outlines[i].hasGeometry())
+						{
+							font.numVisibleOutlines++;
+						}
+					}
+
+					// The glyph map owns the outlines now
+					if (job->outlines)
+					{
+						g_memory_free(job->outlines);
+						job->outlines = nullptr;
+					}
+				}
+			}
+
+			font.loadState = job->failed ? FontLoadState::Failed : FontLoadState::Loaded;
+			freeFontLoadJob(job);
+		}
+
+		static void freeFontLoadJob(FontLoadJob* job)
+		{
+			if (job->outlines)
+			{
+				uint32 numCodepoints = getNumCodepoints(job->charset);
+				for (uint32 i = 0; i < numCodepoints; i++)
+				{
+					job->outlines[i].free();
+				}
+				g_memory_free(job->outlines);
+			}
+
+			if (job->outlineJobs)
+			{
+				g_memory_free(job->outlineJobs);
+			}
+
+			if (job->fileData)
+			{
+				Platform::unmapFile(job->fileData);
+			}
+
+			g_memory_free(job->filepath);
+			g_memory_free(job);
+		}
+
+		static void freeFont(Font& font)
+		{
+			if (font.pendingLoad)
+			{
+				std::lock_guard<std::mutex> lock(fontLoadMtx);
+				if (font.pendingLoad->tasksLeft == 0)
+				{
+					freeFontLoadJob(font.pendingLoad);
+				}
+				else
+				{
+					// The last worker cleans up after the job once it's done
+					font.pendingLoad->abandoned = true;
+				}
+				font.pendingLoad = nullptr;
+			}
+
+			for (std::pair<const uint32, GlyphOutline>& kv : font.glyphMap)
+			{
+				GlyphOutline& outline = kv.second;
+				outline.free();
+			}
+
+			freeSdfAtlas(font);
+			if (font.fontFace)
+			{
+				FT_Done_Face(font.fontFace);
+				font.fontFace = nullptr;
+			}
+
+			// The face reads from the mapping, so it has to go first
+			if (font.fileData)
+			{
+				Platform::unmapFile(font.fileData);
+				font.fileData = nullptr;
+			}
+		}
+
+		static FT_Library getThreadLibrary()
+		{
+			if (!threadLibrary.library)
+			{
+				FT_Error error = FT_Init_FreeType(&threadLibrary.library);
+				if (error)
+				{
+					g_logger_error("An error occurred while initializing freetype on a worker thread.");
+					threadLibrary.library = nullptr;
+				}
+			}
+
+			return threadLibrary.library;
+		}
+
+		static uint32 getNumCodepoints(CharRange range)
+		{
+			return range.lastCharCode >= range.firstCharCode
+				? range.lastCharCode - range.firstCharCode + 1
+				: 0;
+		}
+
+		static GlyphTexture rasterizeGlyph(SizedFont& font, uint32 codepoint)
+		{
+			GlyphTexture res = {};
+			res.page = -1;
+
+			FT_Face fontFace = font.unsizedFont->fontFace;
+			FT_UInt glyphIndex = FT_Get_Char_Index(fontFace, codepoint);
+			if (glyphIndex == 0)
+			{
+				g_logger_warning("Character code 'U+%04X' not found in font '%s'. Missing glyph.", codepoint, font.unsizedFont->fontFilepath.c_str());
+				return res;
+			}
+
+			// Every size shares the font's face, so the size has to be set for each glyph
+			FT_Error error = FT_Set_Pixel_Sizes(fontFace, font.fontSizePixels, font.fontSizePixels);
+			if (!error)
+			{
+				error = FT_Load_Glyph(fontFace, glyphIndex, FT_LOAD_RENDER);
+			}
+
+			if (error)
+			{
+				g_logger_error("Freetype could not load glyph for character code 'U+%04X'.", codepoint);
+				return res;
+			}
+
+			// Spaces don't have a bitmap
+			const FT_Bitmap& bitmap = fontFace->glyph->bitmap;
+			if (bitmap.width == 0 || bitmap.rows == 0)
+			{
+				return res;
+			}
+
+			// The padding keeps linear filtering from bleeding neighbours into the glyph.
+			// Rounding the width up keeps every uploaded row 4 byte aligned.
+			int32 slotWidth = ((int32)bitmap.width + hzPadding + 3) & ~3;
+			int32 slotHeight = (int32)bitmap.rows + vtPadding;
+			if (slotWidth > glyphPageSize || slotHeight > glyphPageSize)
+			{
+				g_logger_error("Glyph 'U+%04X' is too big for a glyph page at size %d.", codepoint, font.fontSizePixels);
+				return res;
+			}
+
+			PackedRect rect;
+			int page = -1;
+			for (size_t i = 0; i < font.pages.size(); i++)
+			{
+				if (font.pages[i].packer.allocate(slotWidth, slotHeight, &rect))
+				{
+					page = (int)i;
+					break;
+				}
+			}
+
+			if (page < 0)
+			{
+				font.pages.emplace_back(createGlyphPage());
+				page = (int)font.pages.size() - 1;
+				bool fits = font.pages[page].packer.allocate(slotWidth, slotHeight, &rect);
+				g_logger_assert(fits, "Glyph should always fit on an empty page.");
+			}
+
+			size_t numBytes = sizeof(uint8) * slotWidth * bitmap.rows;
+			uint8* pixels = (uint8*)g_memory_allocate(numBytes);
+			g_memory_zeroMem(pixels, numBytes);
+			for (uint32 y = 0; y < bitmap.rows; y++)
+			{
+				g_memory_copyMem(pixels + y * slotWidth, bitmap.buffer + (int)y * bitmap.pitch, sizeof(uint8) * bitmap.width);
+			}
+			font.pages[page].texture.uploadSubImage(rect.x, rect.y, slotWidth, (int)bitmap.rows, pixels, numBytes);
+			g_memory_free(pixels);
+
+			res.page = page;
+			res.uvMin = Vec2{
+				(float)rect.x / (float)glyphPageSize,
+				(float)rect.y / (float)glyphPageSize
+			};
+			res.uvMax = Vec2{
+				(float)(rect.x + (int32)bitmap.width) / (float)glyphPageSize,
+				(float)(rect.y + (int32)bitmap.rows) / (float)glyphPageSize
+			};
+			return res;
+		}
+
+		static GlyphAtlasPage createGlyphPage()
+		{
+			GlyphAtlasPage res;
+			res.texture = TextureBuilder()
+				.setFormat(ByteFormat::R8_UI)
+				.setWidth(glyphPageSize)
+				.setHeight(glyphPageSize)
+				.setMagFilter(FilterMode::Linear)
+				.setMinFilter(FilterMode::Linear)
+				.setWrapS(WrapMode::None)
+				.setWrapT(WrapMode::None)
+				.generate();
+			res.packer.init(glyphPageSize, glyphPageSize);
+
+			// Start out empty so the padding around glyphs samples as nothing
+			size_t numBytes = sizeof(uint8) * glyphPageSize * glyphPageSize;
+			uint8* pixels = (uint8*)g_memory_allocate(numBytes);
+			g_memory_zeroMem(pixels, numBytes);
+			res.texture.uploadSubImage(0, 0, glyphPageSize, glyphPageSize, pixels, numBytes);
+			g_memory_free(pixels);
+
+			return res;
+		}
+
+		static void freeGlyphPages(SizedFont& font)
+		{
+			for (GlyphAtlasPage& page : font.pages)
+			{
+				page.texture.destroy();
+				page.packer.free();
+			}
+			font.pages.clear();
+			font.glyphTextureCoords.clear();
+		}
+
+		//******************* check error code ********************
+		void Check(FT_Error ErrCode, const char* OKMsg, const char* ErrMsg)
+		{
+			if (ErrCode != 0)
+			{
+				std::cout << ErrMsg << ": " << ErrCode << "\n";
+				std::cout << "program halted\n";
+				exit(1);
+			}
+			else
+				std::cout << OKMsg << "\n";
+		}
+
+		static int createOutlineFromFace(FT_Face fontFace, const char* filepath, uint32 character, GlyphOutline* outlineResult)
+		{
+			FT_UInt glyphIndex = FT_Get_Char_Index(fontFace, character);
+			if (glyphIndex == 0)
+			{
+				g_logger_warning("Character code 'U+%04X' not found in font '%s'. Missing glyph.", character, filepath);
+				return 1;
+			}
+
+			// Load the glyph
+			FT_Error error = FT_Load_Glyph(fontFace, glyphIndex, FT_LOAD_NO_SCALE);
+			if (error)
+			{
+				g_logger_error("Freetype could not load glyph for character code 'U+%04X'.", character);
+				return 2;
+			}
+
+			FT_Glyph glyph;
+			FT_Get_Glyph(fontFace->glyph, &glyph);
+			FT_OutlineGlyph outline;
+
+			error = getOutline(glyph, &outline);
+			if (error)
+			{
+				g_logger_error("Could not get outline for 'U+%04X'.", character);
+				return 3;
+			}
+
+			*outlineResult = createOutlineInternal(outline, fontFace);
+			FT_Done_Glyph(glyph);
+
+			return 0;
+		}
+
+		//******************** get outline ************************
+		static int getOutline(FT_Glyph glyph, FT_OutlineGlyph* Outg)
+		{
+			int error = 0;
+
+			switch (glyph->format)
+			{
+			case FT_GLYPH_FORMAT_BITMAP:
+				error = 1;
+				break;
+
+			case FT_GLYPH_FORMAT_OUTLINE:
+				*Outg = (FT_OutlineGlyph)glyph;
+				break;
+
+			default:
+				break;
+			}
+			return error;
+		}
+
+		static GlyphOutline createOutlineInternal(FT_OutlineGlyph outlineGlyph, FT_Face face)
+		{
+			FT_Outline* outline = &outlineGlyph->outline;
+
+			GlyphOutline res;
+			FT_GlyphSlot glyphSlot = face->glyph;
+
+			float upem = (float)face->units_per_EM;
+			float glyphLeft = (float)face->glyph->metrics.horiBearingX;
+			float descentY = (float)(glyphSlot->metrics.height - glyphSlot->metrics.horiBearingY);
+
+			res.advanceX = (float)glyphSlot->advance.x / upem;
+			res.bearingX = (float)glyphSlot->metrics.horiBearingX / upem;
+			res.bearingY = (float)glyphSlot->metrics.horiBearingY / upem;
+			res.descentY = descentY / upem;
+			res.glyphWidth = (float)glyphSlot->metrics.width / upem;
+			res.glyphHeight = (float)glyphSlot->metrics.height / upem;
+
+			res.svg = (SvgObject*)g_memory_allocate(sizeof(SvgObject));
+			*res.svg = Svg::createDefault();
+
+			{
+				bool shouldCloseContour = false;
+
 				short* contourEnds = outline->contours;     // pointer to contour ends
 				FT_Vector* basePoints = outline->points;    // pointer to outline point
 				char* baseFlags = outline->tags;            // pointer to flag
@@ -768,9 +1308,14 @@ namespace MathAnim
 			return res;
 		}
 
-		static std::string getSizedFontKey(const char* filepath, int fontSizePixels)
+		static std::string getSizedFontKey(const char* filepath, int fontSizePixels, FontAtlasMode atlasMode)
 		{
-			return getUnsizedFontKey(filepath) + "_Size_" + std::to_string(fontSizePixels);
+			std::string res = getUnsizedFontKey(filepath) + "_Size_" + std::to_string(fontSizePixels);
+			if (atlasMode == FontAtlasMode::DistanceField)
+			{
+				res += "_Sdf";
+			}
+			return res;
 		}
 
 		static std::string getUnsizedFontKey(const char* filepath)
@@ -813,5 +1358,579 @@ namespace MathAnim
 
 			return res;
 		}
+
+		static void beginSdfAtlas(Font& font)
+		{
+			SdfFontAtlas& atlas = font.sdfAtlas;
+			atlas.numSourceGlyphs = font.numVisibleOutlines;
+
+			// Only the first update looks at the disk cache, whatever glyphs it's missing
+			// get added below like any other new glyph
+			if (!atlas.isReady)
+			{
+				loadSdfAtlasFromDisk(font);
+			}
+
+			std::vector<uint32> codepoints;
+			for (const auto& [codepoint, outline] : font.glyphMap)
+			{
+				if (outline.hasGeometry() && atlas.glyphs.find(codepoint) == atlas.glyphs.end())
+				{
+					codepoints.push_back(codepoint);
+				}
+			}
+
+			if (codepoints.size() == 0)
+			{
+				atlas.isReady = true;
+				return;
+			}
+
+			// Placing the tallest glyphs first packs them tighter
+			std::sort(codepoints.begin(), codepoints.end(), [&font](uint32 a, uint32 b) {
+				float aHeight = font.glyphMap.at(a).glyphHeight;
+				float bHeight = font.glyphMap.at(b).glyphHeight;
+				return aHeight != bHeight ? aHeight > bHeight : a < b;
+			});
+
+			std::vector<PackedRect> rects(codepoints.size());
+			size_t numPlaced = 0;
+			for (; numPlaced < codepoints.size(); numPlaced++)
+			{
+				// Rounding the width up keeps every uploaded row 4 byte aligned, the extra
+				// column is just more of the distance field
+				const GlyphOutline& outline = font.glyphMap.at(codepoints[numPlaced]);
+				int width = (getSdfGlyphSize(outline.glyphWidth) + 3) & ~3;
+				int height = getSdfGlyphSize(outline.glyphHeight);
+				if (!placeSdfGlyph(atlas, width, height, &rects[numPlaced]))
+				{
+					g_logger_error("Ran out of texture room for the distance field atlas of font '%s'.", font.fontFilepath.c_str());
+					break;
+				}
+			}
+
+			if (numPlaced == 0)
+			{
+				atlas.isReady = true;
+				return;
+			}
+
+			SdfAtlasJob* job = (SdfAtlasJob*)g_memory_allocate(sizeof(SdfAtlasJob));
+			job->numGlyphs = (int)numPlaced;
+			job->glyphJobs = (SdfGlyphJob*)g_memory_allocate(sizeof(SdfGlyphJob) * job->numGlyphs);
+			job->codepoints = (uint32*)g_memory_allocate(sizeof(uint32) * job->numGlyphs);
+			job->width = atlas.packer.width;
+			job->height = atlas.packer.height;
+			job->glyphsLeft = job->numGlyphs;
+			job->abandoned = false;
+
+			size_t numPixels = 0;
+			for (int i = 0; i < job->numGlyphs; i++)
+			{
+				SdfGlyphJob& glyphJob = job->glyphJobs[i];
+				glyphJob.atlasJob = job;
+				glyphJob.svg = Svg::createDefault();
+				Svg::copy(&glyphJob.svg, font.glyphMap.at(codepoints[i]).svg);
+				glyphJob.rect = rects[i];
+				glyphJob.pixelOffset = numPixels;
+				numPixels += (size_t)rects[i].width * (size_t)rects[i].height;
+				job->codepoints[i] = codepoints[i];
+			}
+			job->pixels = (uint8*)g_memory_allocate(sizeof(uint8) * numPixels);
+
+			atlas.pendingJob = job;
+			g_logger_info("Generating %d distance field glyphs for font '%s'.", job->numGlyphs, font.fontFilepath.c_str());
+
+			for (int i = 0; i < job->numGlyphs; i++)
+			{
+				Application::threadPool()->queueTask(
+					generateSdfGlyphTask,
+					"Generate Glyph Distance Field",
+					&job->glyphJobs[i],
+					sizeof(SdfGlyphJob)
+				);
+			}
+		}
+
+		static void finishSdfAtlas(Font& font)
+		{
+			SdfFontAtlas& atlas = font.sdfAtlas;
+			SdfAtlasJob* job = atlas.pendingJob;
+			atlas.pendingJob = nullptr;
+
+			// The texture only grows once the new glyphs are ready, until then the old
+			// glyphs keep drawing from the old one
+			if (job->width != atlas.width || job->height != atlas.height)
+			{
+				growSdfAtlas(atlas, job->width, job->height);
+			}
+
+			for (int i = 0; i < job->numGlyphs; i++)
+			{
+				const PackedRect& rect = job->glyphJobs[i].rect;
+				uint8* glyphPixels = job->pixels + job->glyphJobs[i].pixelOffset;
+				for (int y = 0; y < rect.height; y++)
+				{
+					g_memory_copyMem(
+						atlas.pixels + (size_t)(rect.y + y) * atlas.width + rect.x,
+						glyphPixels + (size_t)y * rect.width,
+						sizeof(uint8) * rect.width
+					);
+				}
+
+				atlas.texture.uploadSubImage(rect.x, rect.y, rect.width, rect.height, glyphPixels, sizeof(uint8) * rect.width * rect.height);
+				atlas.glyphs[job->codepoints[i]] = createSdfGlyph(rect, atlas.width, atlas.height);
+			}
+
+			atlas.isReady = true;
+			saveSdfAtlasToDisk(font);
+			freeSdfAtlasJob(job);
+		}
+
+		static void freeSdfAtlas(Font& font)
+		{
+			SdfFontAtlas& atlas = font.sdfAtlas;
+			if (atlas.pendingJob)
+			{
+				std::lock_guard<std::mutex> lock(sdfMtx);
+				if (atlas.pendingJob->glyphsLeft == 0)
+				{
+					freeSdfAtlasJob(atlas.pendingJob);
+				}
+				else
+				{
+					// The last worker cleans up after the job once it's done
+					atlas.pendingJob->abandoned = true;
+				}
+				atlas.pendingJob = nullptr;
+			}
+
+			// Fonts without any visible glyphs never get a texture
+			if (atlas.pixels)
+			{
+				atlas.texture.destroy();
+				g_memory_free(atlas.pixels);
+				atlas.pixels = nullptr;
+			}
+			atlas.width = 0;
+			atlas.height = 0;
+			atlas.glyphs.clear();
+			atlas.packer.free();
+			atlas.isReady = false;
+		}
+
+		static bool placeSdfGlyph(SdfFontAtlas& atlas, int width, int height, PackedRect* outRect)
+		{
+			while (!atlas.packer.allocate(width, height, outRect))
+			{
+				if (atlas.packer.width >= sdfMaxAtlasSize && atlas.packer.height >= sdfMaxAtlasSize)
+				{
+					return false;
+				}
+
+				// Growing the shorter side keeps the atlas close to square
+				if (atlas.packer.width <= atlas.packer.height)
+				{
+					atlas.packer.grow(glm::min(atlas.packer.width * 2, sdfMaxAtlasSize), atlas.packer.height);
+				}
+				else
+				{
+					atlas.packer.grow(atlas.packer.width, glm::min(atlas.packer.height * 2, sdfMaxAtlasSize));
+				}
+			}
+
+			return true;
+		}
+
+		static void growSdfAtlas(SdfFontAtlas& atlas, int width, int height)
+		{
+			uint8* pixels = (uint8*)g_memory_allocate(sizeof(uint8) * width * height);
+			g_memory_zeroMem(pixels, sizeof(uint8) * width * height);
+			if (atlas.pixels)
+			{
+				for (int y = 0; y < atlas.height; y++)
+				{
+					g_memory_copyMem(pixels + (size_t)y * width, atlas.pixels + (size_t)y * atlas.width, sizeof(uint8) * atlas.width);
+				}
+
+				// The old glyphs stay where they are, only their uvs shrink
+				float scaleX = (float)atlas.width / (float)width;
+				float scaleY = (float)atlas.height / (float)height;
+				for (auto& [codepoint, glyph] : atlas.glyphs)
+				{
+					glyph.uvMin = Vec2{ glyph.uvMin.x * scaleX, glyph.uvMin.y * scaleY };
+					glyph.uvMax = Vec2{ glyph.uvMax.x * scaleX, glyph.uvMax.y * scaleY };
+				}
+
+				atlas.texture.destroy();
+				g_memory_free(atlas.pixels);
+			}
+
+			atlas.pixels = pixels;
+			atlas.width = width;
+			atlas.height = height;
+			createSdfAtlasTexture(atlas);
+		}
+
+		static void createSdfAtlasTexture(SdfFontAtlas& atlas)
+		{
+			atlas.texture = TextureBuilder()
+				.setFormat(ByteFormat::R8_UNORM)
+				.setWidth(atlas.width)
+				.setHeight(atlas.height)
+				.setMagFilter(FilterMode::Linear)
+				.setMinFilter(FilterMode::Linear)
+				.setWrapS(WrapMode::None)
+				.setWrapT(WrapMode::None)
+				.generate();
+			atlas.texture.uploadSubImage(0, 0, atlas.width, atlas.height, atlas.pixels, sizeof(uint8) * atlas.width * atlas.height);
+		}
+
+		static bool loadSdfAtlasFromDisk(Font& font)
+		{
+			if (sdfCacheDirectory.empty())
+			{
+				return false;
+			}
+
+			std::string filename = getSdfCacheFilename(font);
+			FILE* fp = fopen(filename.c_str(), "rb");
+			if (!fp)
+			{
+				return false;
+			}
+
+			fseek(fp, 0, SEEK_END);
+			size_t fileSize = ftell(fp);
+			fseek(fp, 0, SEEK_SET);
+
+			RawMemory memory;
+			memory.init(fileSize);
+			bool success = fread(memory.data, fileSize, 1, fp) == 1;
+			fclose(fp);
+
+			uint32 magic = 0;
+			uint32 version = 0;
+			int32 emSize = 0;
+			int32 pixelRange = 0;
+			success = success &&
+				memory.read<uint32>(&magic) &&
+				memory.read<uint32>(&version) &&
+				memory.read<int32>(&emSize) &&
+				memory.read<int32>(&pixelRange) &&
+				magic == sdfCacheMagic &&
+				version == sdfCacheVersion &&
+				emSize == sdfEmSize &&
+				pixelRange == sdfPixelRange;
+
+			int32 width = 0;
+			int32 height = 0;
+			uint32 numGlyphs = 0;
+			success = success &&
+				memory.read<int32>(&width) &&
+				memory.read<int32>(&height) &&
+				memory.read<uint32>(&numGlyphs) &&
+				width > 0 && width <= sdfMaxAtlasSize &&
+				height > 0 && height <= sdfMaxAtlasSize;
+
+			std::unordered_map<uint32, SdfGlyph> glyphs;
+			for (uint32 i = 0; success && i < numGlyphs; i++)
+			{
+				uint32 codepoint;
+				SdfGlyph glyph;
+				success = memory.read<uint32>(&codepoint) && memory.read<SdfGlyph>(&glyph);
+				glyphs[codepoint] = glyph;
+			}
+
+			// The packer's skyline is saved too, so new glyphs can go around the cached ones
+			int64 usedArea = 0;
+			uint32 numSkylineNodes = 0;
+			success = success &&
+				memory.read<int64>(&usedArea) &&
+				memory.read<uint32>(&numSkylineNodes);
+
+			std::vector<SkylineNode> skyline;
+			for (uint32 i = 0; success && i < numSkylineNodes; i++)
+			{
+				SkylineNode node;
+				success = memory.read<SkylineNode>(&node);
+				skyline.push_back(node);
+			}
+
+			size_t numPixels = (size_t)width * (size_t)height;
+			success = success && memory.offset + numPixels <= memory.size;
+			if (!success)
+			{
+				g_logger_info("Distance field atlas '%s' is outdated or corrupt, generating a new one.", filename.c_str());
+				memory.free();
+				return false;
+			}
+
+			SdfFontAtlas& atlas = font.sdfAtlas;
+			atlas.packer.init(width, height);
+			atlas.packer.skyline = std::move(skyline);
+			atlas.packer.usedArea = usedArea;
+			atlas.glyphs = std::move(glyphs);
+			atlas.pixels = (uint8*)g_memory_allocate(sizeof(uint8) * numPixels);
+			g_memory_copyMem(atlas.pixels, memory.data + memory.offset, sizeof(uint8) * numPixels);
+			atlas.width = width;
+			atlas.height = height;
+			createSdfAtlasTexture(atlas);
+			atlas.isReady = true;
+
+			memory.free();
+			return true;
+		}
+
+		static void saveSdfAtlasToDisk(const Font& font)
+		{
+			if (sdfCacheDirectory.empty())
+			{
+				return;
+			}
+
+			const SdfFontAtlas& atlas = font.sdfAtlas;
+			size_t numPixels = (size_t)atlas.width * (size_t)atlas.height;
+
+			RawMemory memory;
+			memory.init(
+				sizeof(uint32) * 8 + sizeof(int64) +
+				atlas.glyphs.size() * (sizeof(uint32) + sizeof(SdfGlyph)) +
+				atlas.packer.skyline.size() * sizeof(SkylineNode) +
+				numPixels
+			);
+			memory.write<uint32>(&sdfCacheMagic);
+			memory.write<uint32>(&sdfCacheVersion);
+			memory.write<int32>(&sdfEmSize);
+			memory.write<int32>(&sdfPixelRange);
+			memory.write<int32>(&atlas.width);
+			memory.write<int32>(&atlas.height);
+
+			uint32 numGlyphs = (uint32)atlas.glyphs.size();
+			memory.write<uint32>(&numGlyphs);
+			for (const auto& [codepoint, glyph] : atlas.glyphs)
+			{
+				memory.write<uint32>(&codepoint);
+				memory.write<SdfGlyph>(&glyph);
+			}
+
+			uint32 numSkylineNodes = (uint32)atlas.packer.skyline.size();
+			memory.write<int64>(&atlas.packer.usedArea);
+			memory.write<uint32>(&numSkylineNodes);
+			for (const SkylineNode& node : atlas.packer.skyline)
+			{
+				memory.write<SkylineNode>(&node);
+			}
+			memory.writeDangerous(atlas.pixels, numPixels);
+
+			// Write to a temporary file first so a crash never leaves a half written atlas
+			std::string filename = getSdfCacheFilename(font);
+			std::string tmpFilename = filename + ".tmp";
+			FILE* fp = fopen(tmpFilename.c_str(), "wb");
+			if (!fp)
+			{
+				g_logger_warning("Could not write distance field atlas '%s'.", tmpFilename.c_str());
+				memory.free();
+				return;
+			}
+
+			bool success = fwrite(memory.data, memory.offset, 1, fp) == 1;
+			fclose(fp);
+			memory.free();
+
+			std::error_code err;
+			if (success)
+			{
+				std::filesystem::rename(tmpFilename, filename, err);
+			}
+
+			if (!success || err)
+			{
+				g_logger_warning("Could not write distance field atlas '%s'.", filename.c_str());
+			}
+		}
+
+		static std::string getSdfCacheFilename(const Font& font)
+		{
+			// The font file's size and write time are part of the key, so an updated font
+			// never picks up a stale atlas
+			std::error_code err;
+			uint64 fileSize = (uint64)std::filesystem::file_size(font.fontFilepath, err);
+			int64 writeTime = 0;
+			if (!err)
+			{
+				writeTime = (int64)std::filesystem::last_write_time(font.fontFilepath, err).time_since_epoch().count();
+			}
+
+			std::string key = getUnsizedFontKey(font.fontFilepath.c_str()) + "_" + std::to_string(fileSize) + "_" + std::to_string(writeTime);
+			return sdfCacheDirectory + Platform::md5FromString(key) + ".sdf";
+		}
+
+		static int getSdfGlyphSize(float emSize)
+		{
+			return (int)glm::ceil(emSize * (float)sdfEmSize) + sdfPixelRange * 2;
+		}
+
+		static SdfGlyph createSdfGlyph(const PackedRect& rect, int atlasWidth, int atlasHeight)
+		{
+			SdfGlyph res;
+			res.uvMin = Vec2{
+				(float)rect.x / (float)atlasWidth,
+				(float)rect.y / (float)atlasHeight
+			};
+			res.uvMax = Vec2{
+				(float)(rect.x + rect.width) / (float)atlasWidth,
+				(float)(rect.y + rect.height) / (float)atlasHeight
+			};
+
+			// The outline starts sdfPixelRange pixels into the rect
+			float padding = (float)sdfPixelRange / (float)sdfEmSize;
+			res.planeMin = Vec2{ -padding, -padding };
+			res.planeMax = Vec2{
+				(float)rect.width / (float)sdfEmSize - padding,
+				(float)rect.height / (float)sdfEmSize - padding
+			};
+			return res;
+		}
+
+		static void generateSdfGlyphTask(void* data, size_t dataSize)
+		{
+			g_logger_assert(dataSize == sizeof(SdfGlyphJob), "Invalid glyph distance field job.");
+			SdfGlyphJob* glyphJob = (SdfGlyphJob*)data;
+			SdfAtlasJob* job = glyphJob->atlasJob;
+			const PackedRect& rect = glyphJob->rect;
+
+			// Outlines are in em units with y pointing down, so scaling them puts them
+			// straight into the glyph's pixels
+			std::vector<Vec2> segments;
+			flattenOutline(glyphJob->svg, (float)sdfEmSize, Vec2{ (float)sdfPixelRange, (float)sdfPixelRange }, segments);
+			glyphJob->svg.free();
+
+			for (int y = 0; y < rect.height; y++)
+			{
+				uint8* row = job->pixels + glyphJob->pixelOffset + (size_t)y * rect.width;
+				for (int x = 0; x < rect.width; x++)
+				{
+					Vec2 p = Vec2{ (float)x + 0.5f, (float)y + 0.5f };
+
+					// Glyph outlines use the non-zero fill rule, so the winding number of a
+					// ray going right decides whether the texel is inside
+					float minDistanceSq = FLT_MAX;
+					int winding = 0;
+					for (size_t s = 0; s < segments.size(); s += 2)
+					{
+						const Vec2& a = segments[s];
+						const Vec2& b = segments[s + 1];
+						minDistanceSq = glm::min(minDistanceSq, distanceToSegmentSquared(p, a, b));
+
+						if ((a.y <= p.y) != (b.y <= p.y))
+						{
+							float t = (p.y - a.y) / (b.y - a.y);
+							if (a.x + t * (b.x - a.x) > p.x)
+							{
+								winding += b.y > a.y ? 1 : -1;
+							}
+						}
+					}
+
+					float distance = glm::sqrt(minDistanceSq);
+					if (winding == 0)
+					{
+						distance = -distance;
+					}
+
+					// 0.5 is right on the outline, values above it are inside
+					float value = glm::clamp(0.5f + distance / (float)(sdfPixelRange * 2), 0.0f, 1.0f);
+					row[x] = (uint8)(value * 255.0f + 0.5f);
+				}
+			}
+
+			bool isDone = false;
+			{
+				std::lock_guard<std::mutex> lock(sdfMtx);
+				job->glyphsLeft--;
+				isDone = job->glyphsLeft == 0;
+				if (isDone && job->abandoned)
+				{
+					freeSdfAtlasJob(job);
+					return;
+				}
+			}
+
+			if (isDone)
+			{
+				sdfCv.notify_all();
+			}
+		}
+
+		static void flattenOutline(const SvgObject& svg, float scale, const Vec2& offset, std::vector<Vec2>& outSegments)
+		{
+			// Enough to keep curves within a fraction of a pixel at sdfEmSize
+			constexpr int numCurveSegments = 8;
+
+			for (int pathi = 0; pathi < svg.numPaths; pathi++)
+			{
+				if (svg.paths[pathi].numCurves == 0)
+				{
+					continue;
+				}
+
+				Vec2 pathStart = svg.getPathStart(pathi) * scale + offset;
+				Vec2 previous = pathStart;
+				for (int curvei = 0; curvei < svg.paths[pathi].numCurves; curvei++)
+				{
+					Curve curve = svg.getCurve(pathi, curvei);
+					int numSegments = curve.type == CurveType::Line ? 1 : numCurveSegments;
+					for (int i = 1; i <= numSegments; i++)
+					{
+						float t = (float)i / (float)numSegments;
+						Vec2 point = previous;
+						switch (curve.type)
+						{
+						case CurveType::Line:
+							point = curve.as.line.p1 * scale + offset;
+							break;
+						case CurveType::Bezier2:
+							point = CMath::bezier2(curve.p0, curve.as.bezier2.p1, curve.as.bezier2.p2, t) * scale + offset;
+							break;
+						case CurveType::Bezier3:
+							point = CMath::bezier3(curve.p0, curve.as.bezier3.p1, curve.as.bezier3.p2, curve.as.bezier3.p3, t) * scale + offset;
+							break;
+						case CurveType::None:
+							break;
+						}
+
+						outSegments.push_back(previous);
+						outSegments.push_back(point);
+						previous = point;
+					}
+				}
+
+				// Outlines are always filled as closed shapes
+				if (previous.x != pathStart.x || previous.y != pathStart.y)
+				{
+					outSegments.push_back(previous);
+					outSegments.push_back(pathStart);
+				}
+			}
+		}
+
+		static float distanceToSegmentSquared(const Vec2& p, const Vec2& a, const Vec2& b)
+		{
+			Vec2 ab = b - a;
+			Vec2 ap = p - a;
+			float lengthSq = CMath::dot(ab, ab);
+			float t = lengthSq > 0.0f ? glm::clamp(CMath::dot(ap, ab) / lengthSq, 0.0f, 1.0f) : 0.0f;
+			Vec2 closest = p - (a + ab * t);
+			return CMath::dot(closest, closest);
+		}
+
+		static void freeSdfAtlasJob(SdfAtlasJob* job)
+		{
+			g_memory_free(job->pixels);
+			g_memory_free(job->codepoints);
+			g_memory_free(job->glyphJobs);
+			g_memory_free(job);
+		}
 	}
 }
\ No newline at end of file
@@ -135,6 +135,11 @@ namespace MathAnim
 			return glCheckFramebufferStatus(target);
 		}
 
+		void blitFramebuffer(GLint srcX0, GLint srcY0, GLint srcX1, GLint srcY1, GLint dstX0, GLint dstY0, GLint dstX1, GLint dstY1, GLbitfield mask, GLenum filter)
+		{
+			glBlitFramebuffer(srcX0, srcY0, srcX1, srcY1, dstX0, dstY0, dstX1, dstY1, mask, filter);
+		}
+
 		// Vaos
 		void bindVertexArray(GLuint array)
 		{
@@ -457,6 +462,11 @@ namespace MathAnim
 			glViewport(x, y, width, height);
 		}
 
+		void scissor(GLint x, GLint y, GLsizei width, GLsizei height)
+		{
+			glScissor(x, y, width, height);
+		}
+
 		void lineWidth(GLfloat width)
 		{
 			glLineWidth(width);
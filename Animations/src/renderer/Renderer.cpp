@@ -6,6 +6,7 @@
 #include "renderer/Framebuffer.h"
 #include "renderer/Texture.h"
 #include "renderer/Fonts.h"
+#include "renderer/TextLayout.h"
 #include "renderer/Colors.h"
 #include "renderer/Fonts.h"
 #include "renderer/GLApi.h"
@@ -190,6 +191,8 @@ namespace MathAnim
 	{
 		std::vector<Vec4> colors;
 		std::vector<Curve> rawCurves;
+		// Cumulative arc lengths of rawCurves, laid out like SvgObject::arcLengths
+		std::vector<float> arcLengths;
 		std::vector<Path_Vertex2DLine> data;
 		glm::mat4 transform;
 		float approximateLength;
@@ -257,6 +260,8 @@ namespace MathAnim
 		// Internal variables
 		static DrawList2D drawList2D;
 		static DrawListFont2D drawListFont2D;
+		// Glyphs from distance field atlases, drawn with shaderFontSdf2D
+		static DrawListFont2D drawListFontSdf2D;
 		static DrawList3DLine drawList3DLine;
 		static DrawList3D drawList3D;
 
@@ -270,6 +275,7 @@ namespace MathAnim
 
 		static Shader shader2D;
 		static Shader shaderFont2D;
+		static Shader shaderFontSdf2D;
 		static Shader shader3DLine;
 		static Shader screenShader;
 		static Shader shader3DOpaque;
@@ -282,7 +288,7 @@ namespace MathAnim
 		static glm::vec4 colorStack[MAX_STACK_SIZE];
 		static float strokeWidthStack[MAX_STACK_SIZE];
 		static CapType lineEndingStack[MAX_STACK_SIZE];
-		static const SizedFont* fontStack[MAX_STACK_SIZE];
+		static SizedFont* fontStack[MAX_STACK_SIZE];
 
 		static int colorStackPtr;
 		static int strokeWidthStackPtr;
@@ -323,6 +329,8 @@ namespace MathAnim
 		static void generateMiter3D(const Vec3& previousPoint, const Vec3& currentPoint, const Vec3& nextPoint, float strokeWidth, Vec2* outNormal, float* outStrokeWidth);
 		static void lineToInternal(Path2DContext* path, const Vec2& point, bool addToRawCurve);
 		static void lineToInternal(Path2DContext* path, const Path_Vertex2DLine& vert, bool addToRawCurve);
+		static void pushRawCurve(Path2DContext* path, const Curve& curve);
+		static void drawStringSdf(SizedFont* font, const std::string& string, const Vec2& start, AnimObjId objId);
 
 		void init()
 		{
@@ -336,6 +344,7 @@ namespace MathAnim
 #ifdef _DEBUG
 			shader2D.compile("assets/shaders/default.glsl");
 			shaderFont2D.compile("assets/shaders/shaderFont2D.glsl");
+			shaderFontSdf2D.compile("assets/shaders/shaderFontSdf2D.glsl");
 			screenShader.compile("assets/shaders/screen.glsl");
 			shader3DLine.compile("assets/shaders/shader3DLine.glsl");
 			shader3DOpaque.compile("assets/shaders/shader3DOpaque.glsl");
@@ -346,6 +355,7 @@ namespace MathAnim
 			// TODO: Replace these with hardcoded strings
 			shader2D.compile("assets/shaders/default.glsl");
 			shaderFont2D.compile("assets/shaders/shaderFont2D.glsl");
+			shaderFontSdf2D.compile("assets/shaders/shaderFontSdf2D.glsl");
 			screenShader.compile("assets/shaders/screen.glsl");
 			shader3DLine.compile("assets/shaders/shader3DLine.glsl");
 			shader3DOpaque.compile("assets/shaders/shader3DOpaque.glsl");
@@ -356,6 +366,7 @@ namespace MathAnim
 
 			drawList2D.init();
 			drawListFont2D.init();
+			drawListFontSdf2D.init();
 			drawList3DLine.init();
 			drawList3D.init();
 			setupScreenVao();
@@ -365,6 +376,7 @@ namespace MathAnim
 		void free()
 		{
 			shaderFont2D.destroy();
+			shaderFontSdf2D.destroy();
 			screenShader.destroy();
 			shader3DLine.destroy();
 			shader3DOpaque.destroy();
@@ -373,6 +385,7 @@ namespace MathAnim
 
 			drawList2D.free();
 			drawListFont2D.free();
+			drawListFontSdf2D.free();
 			drawList3DLine.free();
 			drawList3D.free();
 		}
@@ -401,6 +414,7 @@ namespace MathAnim
 			// Draw lines and strings
 			drawList3DLine.render(shader3DLine, perspectiveCamera);
 			drawListFont2D.render(shaderFont2D, orthoCamera);
+			drawListFontSdf2D.render(shaderFontSdf2D, orthoCamera);
 
 			// Draw 3D objects after the lines so that we can do appropriate blending
 			// using OIT
@@ -454,16 +468,17 @@ namespace MathAnim
 		{
 			// Track metrics
 			list2DNumDrawCalls = drawList2D.drawCommands.size();
-			listFont2DNumDrawCalls = drawListFont2D.drawCommands.size();
+			listFont2DNumDrawCalls = drawListFont2D.drawCommands.size() + drawListFontSdf2D.drawCommands.size();
 			list3DNumDrawCalls = drawList3D.drawCommands.size();
 
 			list2DNumTris = drawList2D.indices.size() / 3;
-			listFont2DNumTris = drawListFont2D.indices.size() / 3;
+			listFont2DNumTris = (drawListFont2D.indices.size() + drawListFontSdf2D.indices.size()) / 3;
 			list3DNumTris = drawList3D.indices.size() / 3;
 
 			// Do all the draw calls
 			drawList3DLine.reset();
 			drawListFont2D.reset();
+			drawListFontSdf2D.reset();
 			drawList3D.reset();
 			drawList2D.reset();
 
@@ -517,7 +532,7 @@ namespace MathAnim
 			lineEndingStackPtr++;
 		}
 
-		void pushFont(const SizedFont* font)
+		void pushFont(SizedFont* font)
 		{
 			g_logger_assert(fontStackPtr < MAX_STACK_SIZE, "Ran out of room on the font stack.");
 			fontStack[fontStackPtr] = font;
@@ -685,36 +700,43 @@ namespace MathAnim
 		{
 			g_logger_assert(fontStackPtr > 0, "Cannot draw string without a font provided. Did you forget a pushFont() call?");
 
-			const SizedFont* font = fontStack[fontStackPtr - 1];
+			SizedFont* font = fontStack[fontStackPtr - 1];
+			if (font->atlasMode == FontAtlasMode::DistanceField)
+			{
+				drawStringSdf(font, string, start, objId);
+				return;
+			}
+
 			const Vec4& color = getColor();
-			Vec2 cursorPos = start;
+			const TextLayout* layout = TextLayouts::layout(font->unsizedFont, (float)font->fontSizePixels, string);
 
-			for (int i = 0; i < string.length(); i++)
+			for (const LayoutGlyph& glyph : layout->glyphs)
 			{
-				char c = string[i];
-				const GlyphTexture& glyphTexture = font->getGlyphTexture(c);
-				const GlyphOutline& glyphOutline = font->getGlyphInfo(c);
+				if (!glyph.outline || glyph.codepoint == '\t')
+				{
+					continue;
+				}
+
+				const GlyphTexture& glyphTexture = font->getGlyphTexture(glyph.codepoint);
+				const GlyphOutline& glyphOutline = *glyph.outline;
+				Vec2 cursorPos = start + glyph.position;
 				float charWidth = glyphOutline.glyphWidth * (float)font->fontSizePixels;
 				float bearingX = glyphOutline.bearingX * (float)font->fontSizePixels;
 				float descentY = glyphOutline.descentY * (float)font->fontSizePixels;
 				float bearingY = glyphOutline.bearingY * (float)font->fontSizePixels;
 
-				drawListFont2D.addGlyph(
-					cursorPos + Vec2{ bearingX, -bearingY },
-					cursorPos + Vec2{ bearingX + charWidth, descentY },
-					glyphTexture.uvMin,
-					glyphTexture.uvMax,
-					color,
-					font->texture.graphicsId,
-					objId
-				);
-
-				float kerning = 0.0f;
-				if (i < string.length() - 1)
+				if (glyphTexture.page >= 0)
 				{
-					//kerning = font->getKerning((uint32)string[i], (uint32)string[i + 1]);
+					drawListFont2D.addGlyph(
+						cursorPos + Vec2{ bearingX, -bearingY },
+						cursorPos + Vec2{ bearingX + charWidth, descentY },
+						glyphTexture.uvMin,
+						glyphTexture.uvMax,
+						color,
+						font->pages[glyphTexture.page].texture.graphicsId,
+						objId
+					);
 				}
-				cursorPos.x += (glyphOutline.advanceX + kerning) * font->fontSizePixels;
 			}
 		}
 
@@ -908,153 +930,71 @@ namespace MathAnim
 			startT = glm::clamp(startT, 0.0f, 1.0f);
 			endT = glm::clamp(endT, startT, 1.0f);
 
-			// Start the fade in after 80% of the svg object is drawn
-			const float lengthToDraw = (endT - startT) * (float)path->approximateLength;
-			float currentT = 0.0f;
-
-			if (lengthToDraw > 0 && path->rawCurves.size() > 0)
+			int numCurves = (int)path->rawCurves.size();
+			if (endT <= startT || numCurves == 0 || path->approximateLength <= 0.0f)
 			{
-				float lengthDrawn = 0.0f;
-
-				Path2DContext* context = nullptr;
+				return;
+			}
 
-				for (int curvei = 0; curvei < path->rawCurves.size(); curvei++)
+			// Both ends of the visible part get looked up in the arc length table, every
+			// curve between them is drawn in full
+			int startCurve = 0;
+			float startCurveT = 0.0f;
+			int endCurve = 0;
+			float endCurveT = 0.0f;
+			Svg::findCurveAtLength(path->arcLengths.data(), numCurves, startT * path->approximateLength, &startCurve, &startCurveT);
+			Svg::findCurveAtLength(path->arcLengths.data(), numCurves, endT * path->approximateLength, &endCurve, &endCurveT);
+
+			Path2DContext* context = nullptr;
+			for (int curvei = startCurve; curvei <= endCurve; curvei++)
+			{
+				float t0 = curvei == startCurve ? startCurveT : 0.0f;
+				float t1 = curvei == endCurve ? endCurveT : 1.0f;
+				Curve curve = path->rawCurves[curvei];
+				if (t0 > 0.0f || t1 < 1.0f)
 				{
-					float lengthLeft = lengthToDraw - lengthDrawn;
-					if (lengthLeft < 0.0f)
-					{
-						break;
-					}
-
-					Curve curve = path->rawCurves[curvei];
-					float approxLength = curve.calculateApproximatePerimeter();
-					float approxLengthTVal = approxLength / (float)path->approximateLength;
-
-					if (context == nullptr)
-					{
-						Renderer::pushColor(path->colors[curvei]);
-						if (currentT >= startT)
-						{
-							context = Renderer::beginPath(path->rawCurves[curvei].p0);
-						}
-						else if (currentT + approxLengthTVal >= startT)
-						{
-							float tSplit0 = 1.0f - ((currentT + approxLengthTVal - startT) / approxLengthTVal);
-							curve = curve.split(tSplit0, 1.0f);
-							currentT = startT;
-							approxLength = curve.calculateApproximatePerimeter();
-							approxLengthTVal = approxLength / (float)path->approximateLength;
-
-							context = Renderer::beginPath(curve.p0);
-						}
-						Renderer::popColor();
-					}
-
-					const Vec2& p0 = curve.p0;
-					Renderer::pushColor(path->colors[curvei + 1]);
-
-					switch (curve.type)
-					{
-					case CurveType::Bezier3:
-					{
-						if (currentT < startT)
-						{
-							break;
-						}
-
-						if (lengthLeft < approxLength)
-						{
-							// Interpolate the curve
-							float percentOfCurveToDraw = lengthLeft / approxLength;
-							curve = curve.split(0.0f, percentOfCurveToDraw);
-						}
-
-						lengthDrawn += approxLength;
-						Renderer::cubicTo(
-							context,
-							curve.as.bezier3.p1,
-							curve.as.bezier3.p2,
-							curve.as.bezier3.p3
-						);
-					}
-					break;
-					case CurveType::Bezier2:
-					{
-						if (currentT < startT)
-						{
-							break;
-						}
-
-						const Vec2& p1 = curve.as.bezier2.p1;
-						const Vec2& p2 = curve.as.bezier2.p1;
-						const Vec2& p3 = curve.as.bezier2.p2;
-
-						// Degree elevated quadratic bezier curve
-						Vec2 pr0 = p0;
-						Vec2 pr1 = (1.0f / 3.0f) * p0 + (2.0f / 3.0f) * p1;
-						Vec2 pr2 = (2.0f / 3.0f) * p1 + (1.0f / 3.0f) * p2;
-						Vec2 pr3 = p3;
-
-						if (lengthLeft < approxLength)
-						{
-							// Interpolate the curve
-							float percentOfCurveToDraw = lengthLeft / approxLength;
-							curve = curve.split(0.0f, percentOfCurveToDraw);
-
-							pr1 = curve.as.bezier3.p1;
-							pr2 = curve.as.bezier3.p2;
-							pr3 = curve.as.bezier3.p3;
-						}
-
-						lengthDrawn += approxLength;
-						Renderer::cubicTo(
-							context,
-							pr1,
-							pr2,
-							pr3
-						);
-					}
-					break;
-					case CurveType::Line:
-					{
-						if (currentT < startT)
-						{
-							break;
-						}
-
-						if (lengthLeft < approxLength)
-						{
-							float percentOfCurveToDraw = lengthLeft / approxLength;
-							curve = curve.split(0.0f, percentOfCurveToDraw);
-						}
-
-						const Vec2& p1 = curve.as.line.p1;
-						lengthDrawn += approxLength;
-						Renderer::lineTo(
-							context,
-							p1
-						);
-					}
-					break;
-					case CurveType::None:
-						break;
-					}
-
-					Renderer::popColor();
-					currentT += approxLengthTVal;
+					curve = curve.split(t0, t1);
 				}
 
-				if (endT < 1.0f)
+				if (context == nullptr)
 				{
-					Renderer::endPath(context, false);
-					Renderer::free(context);
+					Renderer::pushColor(path->colors[curvei]);
+					context = Renderer::beginPath(curve.p0);
+					Renderer::popColor();
 				}
-				else
+
+				Renderer::pushColor(path->colors[curvei + 1]);
+				switch (curve.type)
 				{
-					Renderer::endPath(context, closePath);
-					Renderer::free(context);
+				case CurveType::Bezier3:
+					Renderer::cubicTo(
+						context,
+						curve.as.bezier3.p1,
+						curve.as.bezier3.p2,
+						curve.as.bezier3.p3
+					);
+					break;
+				case CurveType::Bezier2:
+					Renderer::quadTo(
+						context,
+						curve.as.bezier2.p1,
+						curve.as.bezier2.p2
+					);
+					break;
+				case CurveType::Line:
+					Renderer::lineTo(
+						context,
+						curve.as.line.p1
+					);
+					break;
+				case CurveType::None:
+					break;
 				}
+				Renderer::popColor();
 			}
+
+			Renderer::endPath(context, endT < 1.0f ? false : closePath);
+			Renderer::free(context);
 		}
 
 		void lineTo(Path2DContext* path, const Vec2& point, bool applyTransform)
@@ -1111,8 +1051,7 @@ namespace MathAnim
 				rawCurve.as.bezier2.p1 = transformedP1;
 				rawCurve.as.bezier2.p2 = transformedP2;
 
-				path->approximateLength += rawCurve.calculateApproximatePerimeter();
-				path->rawCurves.emplace_back(rawCurve);
+				pushRawCurve(path, rawCurve);
 
 				glm::vec4 color = colorStackPtr > 0
 					? colorStack[colorStackPtr - 1]
@@ -1165,8 +1104,7 @@ namespace MathAnim
 				rawCurve.as.bezier3.p2 = transformedP2;
 				rawCurve.as.bezier3.p3 = transformedP3;
 
-				path->approximateLength += rawCurve.calculateApproximatePerimeter();
-				path->rawCurves.emplace_back(rawCurve);
+				pushRawCurve(path, rawCurve);
 
 				glm::vec4 color = colorStackPtr > 0
 					? colorStack[colorStackPtr - 1]
@@ -1645,8 +1583,7 @@ namespace MathAnim
 					rawCurve.p0 = path->data[path->data.size() - 1].position;
 					rawCurve.as.line.p1 = vert.position;
 
-					path->approximateLength += rawCurve.calculateApproximatePerimeter();
-					path->rawCurves.emplace_back(rawCurve);
+					pushRawCurve(path, rawCurve);
 				}
 
 				path->data.emplace_back(vert);
@@ -1667,8 +1604,7 @@ namespace MathAnim
 					rawCurve.p0 = path->data[path->data.size() - 1].position;
 					rawCurve.as.line.p1 = vert.position;
 
-					path->approximateLength += rawCurve.calculateApproximatePerimeter();
-					path->rawCurves.emplace_back(rawCurve);
+					pushRawCurve(path, rawCurve);
 
 					glm::vec4 color = colorStackPtr > 0
 						? colorStack[colorStackPtr - 1]
@@ -1679,6 +1615,63 @@ namespace MathAnim
 				path->data.emplace_back(vert);
 			}
 		}
+
+		static void pushRawCurve(Path2DContext* path, const Curve& curve)
+		{
+			size_t firstSample = path->arcLengths.size();
+			path->arcLengths.resize(firstSample + Curve::numArcLengthSamples);
+			float* curveLengths = path->arcLengths.data() + firstSample;
+			curve.calculateArcLengths(curveLengths);
+			for (int samplei = 0; samplei < Curve::numArcLengthSamples; samplei++)
+			{
+				curveLengths[samplei] += path->approximateLength;
+			}
+
+			path->approximateLength = curveLengths[Curve::numArcLengthSamples - 1];
+			path->rawCurves.emplace_back(curve);
+		}
+
+		static void drawStringSdf(SizedFont* font, const std::string& string, const Vec2& start, AnimObjId objId)
+		{
+			// Laying the string out creates any missing outlines, so the atlas picks them up
+			float fontSize = (float)font->fontSizePixels;
+			const TextLayout* layout = TextLayouts::layout(font->unsizedFont, fontSize, string);
+
+			// Exports can't skip text while the atlas is still being generated
+			const SdfFontAtlas* atlas = Fonts::getSdfAtlas(font->unsizedFont, Application::isExportingVideo());
+			if (!atlas)
+			{
+				return;
+			}
+
+			const Vec4& color = getColor();
+			for (const LayoutGlyph& glyph : layout->glyphs)
+			{
+				if (!glyph.outline)
+				{
+					continue;
+				}
+
+				// Glyphs without an outline like spaces aren't in the atlas
+				const GlyphOutline& glyphOutline = *glyph.outline;
+				Vec2 cursorPos = start + glyph.position;
+				auto iter = atlas->glyphs.find(glyph.codepoint);
+				if (iter != atlas->glyphs.end())
+				{
+					const SdfGlyph& glyph = iter->second;
+					Vec2 glyphTopLeft = cursorPos + Vec2{ glyphOutline.bearingX, -glyphOutline.bearingY } * fontSize;
+					drawListFontSdf2D.addGlyph(
+						glyphTopLeft + glyph.planeMin * fontSize,
+						glyphTopLeft + glyph.planeMax * fontSize,
+						glyph.uvMin,
+						glyph.uvMax,
+						color,
+						atlas->texture.graphicsId,
+						objId
+					);
+				}
+			}
+		}
 		// ---------------------- End Internal Functions ----------------------
 	}
 
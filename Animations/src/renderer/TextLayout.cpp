@@ -0,0 +1,357 @@
+#include "renderer/TextLayout.h"
+#include "renderer/Fonts.h"
+#include "utils/LRUCache.hpp"
+#include "utils/Utf8.h"
+#include "utils/Hash.h"
+
+namespace MathAnim
+{
+	namespace TextLayouts
+	{
+		struct LayoutPen
+		{
+			Vec2 position;
+			// Codepoint of the glyph before the pen, 0 at the start of a line
+			uint32 previousCodepoint;
+		};
+
+		// Layouts are small next to the glyphs they point to. This mostly keeps every
+		// intermediate string from piling up while text is being typed.
+		static constexpr size_t maxCachedLayouts = 512;
+
+		static LRUCache<uint64, TextLayout*> cachedLayouts;
+
+		// ------------- Internal Functions -------------
+		static uint64 hashLayoutKey(const Font* font, float fontSize, const char* text, size_t textLength);
+		static void layoutRange(TextLayout& layout, Font* font, size_t start, size_t end, LayoutPen& pen);
+		static void layoutIncremental(TextLayout& layout, Font* font, const TextLayout& previous);
+		static size_t findGlyphAtOffset(const TextLayout& layout, size_t textOffset);
+		static LayoutPen penAfterGlyph(const TextLayout& layout, const LayoutGlyph& glyph);
+		static void buildLines(TextLayout& layout);
+		static inline bool isContinuationByte(char c) { return ((uint8)c & 0xC0) == 0x80; }
+		static void evictOldest();
+		static void freeLayout(TextLayout* layout);
+
+		const TextLayout* layout(Font* font, float fontSize, const char* text, size_t textLength, uint64 previousKey)
+		{
+			g_logger_assert(font != nullptr, "Cannot lay out text without a font.");
+			Fonts::waitUntilFontReady(font);
+
+			uint64 key = hashLayoutKey(font, fontSize, text, textLength);
+			std::optional<TextLayout*> cached = cachedLayouts.get(key);
+			if (cached.has_value())
+			{
+				TextLayout* res = cached.value();
+				if (res->font == font && res->fontSize == fontSize && res->text.compare(0, std::string::npos, text, textLength) == 0)
+				{
+					return res;
+				}
+
+				// Hash collision, the new layout takes its place
+				cachedLayouts.evict(key);
+				freeLayout(res);
+			}
+
+			TextLayout* res = (TextLayout*)g_memory_allocate(sizeof(TextLayout));
+			new(res)TextLayout();
+			res->key = key;
+			res->font = font;
+			res->fontSize = fontSize;
+			res->lineHeight = font->lineHeight * fontSize;
+			res->text = std::string(text, textLength);
+			res->size = Vec2{ 0.0f, 0.0f };
+
+			const TextLayout* previous = nullptr;
+			if (previousKey != 0 && previousKey != key)
+			{
+				std::optional<TextLayout*> previousLayout = cachedLayouts.get(previousKey);
+				if (previousLayout.has_value() && previousLayout.value()->font == font && previousLayout.value()->fontSize == fontSize)
+				{
+					previous = previousLayout.value();
+				}
+			}
+
+			if (previous)
+			{
+				layoutIncremental(*res, font, *previous);
+			}
+			else
+			{
+				LayoutPen pen = {};
+				res->glyphs.reserve(textLength);
+				layoutRange(*res, font, 0, textLength, pen);
+			}
+			buildLines(*res);
+
+			while (cachedLayouts.size() >= maxCachedLayouts)
+			{
+				evictOldest();
+			}
+			cachedLayouts.insert(key, res);
+
+			return res;
+		}
+
+		const TextLayout* layout(Font* font, float fontSize, const std::string& text, uint64 previousKey)
+		{
+			return layout(font, fontSize, text.c_str(), text.length(), previousKey);
+		}
+
+		void evictFont(const Font* font)
+		{
+			std::vector<uint64> keysToEvict;
+			for (LRUCacheEntry<uint64, TextLayout*>* entry = cachedLayouts.getOldest(); entry != nullptr; entry = entry->next)
+			{
+				if (entry->data->font == font)
+				{
+					keysToEvict.push_back(entry->key);
+				}
+			}
+
+			for (uint64 key : keysToEvict)
+			{
+				std::optional<TextLayout*> layout = cachedLayouts.get(key);
+				cachedLayouts.evict(key);
+				freeLayout(layout.value());
+			}
+		}
+
+		void clear()
+		{
+			for (LRUCacheEntry<uint64, TextLayout*>* entry = cachedLayouts.getOldest(); entry != nullptr; entry = entry->next)
+			{
+				freeLayout(entry->data);
+			}
+
+			cachedLayouts.clear();
+		}
+
+		int getNumCachedLayouts()
+		{
+			return (int)cachedLayouts.size();
+		}
+
+		// ------------- Internal Functions -------------
+		static uint64 hashLayoutKey(const Font* font, float fontSize, const char* text, size_t textLength)
+		{
+			uint64 hash = Hash::fnv1a(&font, sizeof(const Font*));
+			hash = Hash::fnv1a(&fontSize, sizeof(float), hash);
+			hash = Hash::fnv1a(text, textLength, hash);
+
+			// 0 means there's no previous layout
+			return hash == 0 ? 1 : hash;
+		}
+
+		static void layoutRange(TextLayout& layout, Font* font, size_t start, size_t end, LayoutPen& pen)
+		{
+			const uint8* text = (const uint8*)layout.text.c_str();
+			int numBytes = 1;
+			for (size_t i = start; i < end; i += numBytes)
+			{
+				uint32 codepoint = Utf8::decode(text + i, end - i, &numBytes);
+
+				LayoutGlyph glyph;
+				glyph.codepoint = codepoint;
+				glyph.textOffset = (uint32)i;
+
+				if (codepoint == '\n')
+				{
+					glyph.position = pen.position;
+					glyph.advance = 0.0f;
+					glyph.outline = nullptr;
+					layout.glyphs.push_back(glyph);
+
+					pen.position = Vec2{ 0.0f, pen.position.y + layout.lineHeight };
+					pen.previousCodepoint = 0;
+					continue;
+				}
+
+				// Tabs are laid out as wide spaces
+				bool isTab = codepoint == '\t';
+				const GlyphOutline& outline = font->getGlyphInfo(isTab ? (uint32)' ' : codepoint);
+
+				if (pen.previousCodepoint != 0)
+				{
+					pen.position.x += font->getKerning(pen.previousCodepoint, codepoint) * layout.fontSize;
+				}
+
+				glyph.position = pen.position;
+				glyph.advance = outline.advanceX * layout.fontSize;
+				if (isTab)
+				{
+					glyph.advance *= (float)tabDepth;
+				}
+				glyph.outline = &outline;
+				layout.glyphs.push_back(glyph);
+
+				pen.position.x += glyph.advance;
+				pen.previousCodepoint = codepoint;
+			}
+		}
+
+		static void layoutIncremental(TextLayout& layout, Font* font, const TextLayout& previous)
+		{
+			const std::string& oldText = previous.text;
+			const std::string& newText = layout.text;
+			size_t maxCommonLength = glm::min(oldText.length(), newText.length());
+
+			// Find the bytes the edit didn't touch, on codepoint boundaries in both strings
+			size_t prefix = 0;
+			while (prefix < maxCommonLength && oldText[prefix] == newText[prefix])
+			{
+				prefix++;
+			}
+			while (prefix > 0 &&
+				((prefix < oldText.length() && isContinuationByte(oldText[prefix])) ||
+					(prefix < newText.length() && isContinuationByte(newText[prefix]))))
+			{
+				prefix--;
+			}
+
+			size_t suffix = 0;
+			size_t maxSuffixLength = maxCommonLength - prefix;
+			while (suffix < maxSuffixLength && oldText[oldText.length() - 1 - suffix] == newText[newText.length() - 1 - suffix])
+			{
+				suffix++;
+			}
+			while (suffix > 0 && isContinuationByte(newText[newText.length() - suffix]))
+			{
+				suffix--;
+			}
+
+			// Glyphs before the edit don't move
+			size_t numPrefixGlyphs = findGlyphAtOffset(previous, prefix);
+			layout.glyphs.reserve(previous.glyphs.size() + (newText.length() - glm::min(newText.length(), oldText.length())));
+			layout.glyphs.insert(layout.glyphs.end(), previous.glyphs.begin(), previous.glyphs.begin() + numPrefixGlyphs);
+
+			LayoutPen pen = {};
+			if (numPrefixGlyphs > 0)
+			{
+				pen = penAfterGlyph(layout, previous.glyphs[numPrefixGlyphs - 1]);
+			}
+
+			size_t oldSuffixStart = oldText.length() - suffix;
+			size_t newSuffixStart = newText.length() - suffix;
+			layoutRange(layout, font, prefix, newSuffixStart, pen);
+
+			size_t firstSuffixGlyph = findGlyphAtOffset(previous, oldSuffixStart);
+			if (firstSuffixGlyph >= previous.glyphs.size())
+			{
+				return;
+			}
+
+			// The first glyph after the edit gets laid out again since its kerning depends on
+			// the glyph before it. Everything after it keeps its spacing and only moves.
+			int64 offsetShift = (int64)newText.length() - (int64)oldText.length();
+			size_t firstSuffixGlyphEnd = firstSuffixGlyph + 1 < previous.glyphs.size()
+				? (size_t)((int64)previous.glyphs[firstSuffixGlyph + 1].textOffset + offsetShift)
+				: newText.length();
+			layoutRange(layout, font, newSuffixStart, firstSuffixGlyphEnd, pen);
+
+			const LayoutGlyph& oldFirstSuffixGlyph = previous.glyphs[firstSuffixGlyph];
+			Vec2 delta = layout.glyphs[layout.glyphs.size() - 1].position - oldFirstSuffixGlyph.position;
+
+			// Glyphs on the edited line move with the edit, later lines only move up or down
+			bool onEditedLine = oldFirstSuffixGlyph.codepoint != '\n';
+			for (size_t i = firstSuffixGlyph + 1; i < previous.glyphs.size(); i++)
+			{
+				LayoutGlyph glyph = previous.glyphs[i];
+				glyph.textOffset = (uint32)((int64)glyph.textOffset + offsetShift);
+				if (onEditedLine)
+				{
+					glyph.position = glyph.position + delta;
+				}
+				else
+				{
+					glyph.position.y += delta.y;
+				}
+				layout.glyphs.push_back(glyph);
+
+				if (glyph.codepoint == '\n')
+				{
+					onEditedLine = false;
+				}
+			}
+		}
+
+		static size_t findGlyphAtOffset(const TextLayout& layout, size_t textOffset)
+		{
+			// Index of the first glyph at or after textOffset
+			auto iter = std::lower_bound(layout.glyphs.begin(), layout.glyphs.end(), textOffset,
+				[](const LayoutGlyph& glyph, size_t offset)
+				{
+					return (size_t)glyph.textOffset < offset;
+				});
+			return (size_t)(iter - layout.glyphs.begin());
+		}
+
+		static LayoutPen penAfterGlyph(const TextLayout& layout, const LayoutGlyph& glyph)
+		{
+			LayoutPen res;
+			if (glyph.codepoint == '\n')
+			{
+				res.position = Vec2{ 0.0f, glyph.position.y + layout.lineHeight };
+				res.previousCodepoint = 0;
+			}
+			else
+			{
+				res.position = Vec2{ glyph.position.x + glyph.advance, glyph.position.y };
+				res.previousCodepoint = glyph.codepoint;
+			}
+
+			return res;
+		}
+
+		static void buildLines(TextLayout& layout)
+		{
+			layout.lines.clear();
+
+			TextLayoutLine line = { 0, 0, 0.0f };
+			float maxLineWidth = 0.0f;
+			for (size_t i = 0; i < layout.glyphs.size(); i++)
+			{
+				const LayoutGlyph& glyph = layout.glyphs[i];
+				line.numGlyphs++;
+				if (glyph.codepoint == '\n')
+				{
+					line.width = glyph.position.x;
+					maxLineWidth = glm::max(maxLineWidth, line.width);
+					layout.lines.push_back(line);
+
+					line = { (uint32)(i + 1), 0, 0.0f };
+				}
+			}
+
+			// Text that ends with a line break still has an empty last line
+			if (line.numGlyphs > 0)
+			{
+				const LayoutGlyph& lastGlyph = layout.glyphs[layout.glyphs.size() - 1];
+				line.width = lastGlyph.position.x + lastGlyph.advance;
+			}
+			maxLineWidth = glm::max(maxLineWidth, line.width);
+			layout.lines.push_back(line);
+
+			layout.size = Vec2{ maxLineWidth, (float)layout.lines.size() * layout.lineHeight };
+		}
+
+		static void evictOldest()
+		{
+			LRUCacheEntry<uint64, TextLayout*>* oldest = cachedLayouts.getOldest();
+			if (!oldest)
+			{
+				return;
+			}
+
+			uint64 key = oldest->key;
+			TextLayout* layout = oldest->data;
+			cachedLayouts.evict(key);
+			freeLayout(layout);
+		}
+
+		static void freeLayout(TextLayout* layout)
+		{
+			layout->~TextLayout();
+			g_memory_free(layout);
+		}
+	}
+}
@@ -218,6 +218,8 @@ namespace MathAnim
 				return GL_R8UI;
 			case ByteFormat::R8_F:
 				return GL_R8;
+			case ByteFormat::R8_UNORM:
+				return GL_R8;
 			case ByteFormat::None:
 				return GL_NONE;
 			}
@@ -243,6 +245,8 @@ namespace MathAnim
 				return GL_RED_INTEGER;
 			case ByteFormat::R8_F:
 				return GL_RED;
+			case ByteFormat::R8_UNORM:
+				return GL_RED;
 			case ByteFormat::None:
 				return GL_NONE;
 			}
@@ -268,6 +272,8 @@ namespace MathAnim
 				return GL_UNSIGNED_BYTE;
 			case ByteFormat::R8_F:
 				return GL_FLOAT;
+			case ByteFormat::R8_UNORM:
+				return GL_UNSIGNED_BYTE;
 			case ByteFormat::None:
 				return GL_NONE;
 			}
@@ -291,6 +297,8 @@ namespace MathAnim
 				return false;
 			case ByteFormat::R8_UI:
 				return true;
+			case ByteFormat::R8_UNORM:
+				return false;
 			case ByteFormat::None:
 				return false;
 			case ByteFormat::R8_F:
@@ -317,6 +325,8 @@ namespace MathAnim
 				return false;
 			case ByteFormat::R8_UI:
 				return false;
+			case ByteFormat::R8_UNORM:
+				return false;
 			case ByteFormat::None:
 				return false;
 			case ByteFormat::R8_F:
@@ -342,6 +352,8 @@ namespace MathAnim
 				return true;
 			case ByteFormat::R8_UI:
 				return false;
+			case ByteFormat::R8_UNORM:
+				return false;
 			case ByteFormat::None:
 				return false;
 			case ByteFormat::R8_F:
@@ -392,6 +404,8 @@ namespace MathAnim
 				return sizeof(uint8);
 			case ByteFormat::R8_F:
 				return sizeof(uint8);
+			case ByteFormat::R8_UNORM:
+				return sizeof(uint8);
 			case ByteFormat::None:
 				return 0;
 			}
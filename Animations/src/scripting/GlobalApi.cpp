@@ -350,6 +350,7 @@ extern "C"
 
 		if (svgPtr->numPaths > 0)
 		{
+			Svg::makeArenaUnique(svgPtr);
 			svgPtr->paths[svgPtr->numPaths - 1].isHole = true;
 		}
 
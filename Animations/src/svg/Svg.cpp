@@ -3,6 +3,7 @@
 #include "svg/SvgCache.h"
 #include "animation/Animation.h"
 #include "utils/CMath.h"
+#include "utils/Hash.h"
 #include "renderer/Renderer.h"
 #include "renderer/Framebuffer.h"
 #include "renderer/Texture.h"
@@ -12,6 +13,8 @@
 
 #include <plutovg.h>
 
+#include <algorithm>
+
 namespace MathAnim
 {
 	namespace Svg
@@ -19,22 +22,45 @@ namespace MathAnim
 		// ----------------- Private Variables -----------------
 		constexpr int initialMaxCapacity = 5;
 
+		// Sits in front of the streams in every arena. Objects that share geometry
+		// point at the same arena and the last one to let go of it frees it.
+		struct ArenaHeader
+		{
+			uint32 refCount;
+		};
+
 		// ----------------- Internal functions -----------------
-		static void checkResize(Path& path);
+		static void reserveArena(SvgObject* object, int numPaths, int numCurves, int numPoints);
+		static void releaseArena(SvgObject* object);
+		static ArenaHeader* getArenaHeader(const SvgObject* object);
+		static Vec2* pushCurve(SvgObject* object, CurveType type, const Vec2& p0, int numCurvePoints);
+		static void splitToMatchingCurves(const SvgObject* src, const SvgObject* dst, SvgObject* outSrc, SvgObject* outDst);
+		static void toCubic(const Curve& curve, Vec2* p1, Vec2* p2, Vec2* p3);
+		static void lerpPoints(const float* src, const float* dst, float* out, int numFloats, float t);
 
 		SvgObject createDefault()
 		{
 			SvgObject res = {};
 			res.approximatePerimeter = 0.0f;
-			// Dummy allocation to allow memory tracking when reallocing 
-			// TODO: Fix the dang memory allocation library so I don't have to do this!
-			res.paths = (Path*)g_memory_allocate(sizeof(Path));
+			// The arena gets allocated with the first path
+			res.arena = nullptr;
+			res.paths = nullptr;
+			res.points = nullptr;
+			res.curvePointOffsets = nullptr;
+			res.arcLengths = nullptr;
+			res.curveTypes = nullptr;
 			res.numPaths = 0;
+			res.numCurves = 0;
+			res.numPoints = 0;
+			res.maxPaths = 0;
+			res.maxCurves = 0;
+			res.maxPoints = 0;
 			res.bbox.min = Vec2{ 0, 0 };
 			res.bbox.max = Vec2{ 0, 0 };
 			res._cursor = Vec2{ 0, 0 };
 			res.fillColor = Vec4{ 1, 1, 1, 1 };
 			res.fillType = FillType::NonZeroFillType;
+			res.geometryHash = 0;
 			return res;
 		}
 
@@ -108,14 +134,7 @@ namespace MathAnim
 				g_logger_assert(object->numPaths > 0, "Cannot have non-absolute beginPath without prior paths.");
 			}
 
-			object->numPaths++;
-			object->paths = (Path*)g_memory_realloc(object->paths, sizeof(Path) * object->numPaths);
-			g_logger_assert(object->paths != nullptr, "Ran out of RAM.");
-
-			object->paths[object->numPaths - 1].maxCapacity = initialMaxCapacity;
-			object->paths[object->numPaths - 1].curves = (Curve*)g_memory_allocate(sizeof(Curve) * initialMaxCapacity);
-			object->paths[object->numPaths - 1].numCurves = 0;
-			object->paths[object->numPaths - 1].isHole = false;
+			reserveArena(object, object->numPaths + 1, object->numCurves, object->numPoints + 1);
 
 			if (isAbsolute)
 			{
@@ -125,7 +144,15 @@ namespace MathAnim
 			{
 				object->_cursor = firstPoint + object->_cursor;
 			}
-			object->paths[object->numPaths - 1].curves[0].p0 = object->_cursor;
+
+			Path& path = object->paths[object->numPaths];
+			path.firstCurve = object->numCurves;
+			path.numCurves = 0;
+			path.firstPoint = object->numPoints;
+			path.isHole = false;
+			object->points[object->numPoints] = object->_cursor;
+			object->numPoints++;
+			object->numPaths++;
 		}
 
 		void closePath(SvgObject* object, bool lineToEndpoint, bool isHole)
@@ -133,12 +160,13 @@ namespace MathAnim
 			g_logger_assert(object->numPaths > 0, "object->numContours == 0. Cannot close contour when no contour exists.");
 			g_logger_assert(object->paths[object->numPaths - 1].numCurves > 0, "contour->numCurves == 0. Cannot close contour with 0 vertices. There must be at least one vertex to close a contour.");
 
+			makeArenaUnique(object);
 			object->paths[object->numPaths - 1].isHole = isHole;
 			if (lineToEndpoint)
 			{
 				if (object->paths[object->numPaths - 1].numCurves > 0)
 				{
-					Vec2 firstPoint = object->paths[object->numPaths - 1].curves[0].p0;
+					Vec2 firstPoint = object->getPathStart(object->numPaths - 1);
 					lineTo(object, firstPoint, true);
 				}
 			}
@@ -176,15 +204,10 @@ namespace MathAnim
 		void lineTo(SvgObject* object, const Vec2& point, bool absolute)
 		{
 			g_logger_assert(object->numPaths > 0, "object->numPaths == 0. Cannot create a lineTo when no path exists.");
-			Path& path = object->paths[object->numPaths - 1];
-			path.numCurves++;
-			checkResize(path);
-
-			path.curves[path.numCurves - 1].p0 = object->_cursor;
-			path.curves[path.numCurves - 1].as.line.p1 = absolute ? point : point + object->_cursor;
-			path.curves[path.numCurves - 1].type = CurveType::Line;
+			Vec2* points = pushCurve(object, CurveType::Line, object->_cursor, 1);
+			points[0] = absolute ? point : point + object->_cursor;
 
-			object->_cursor = path.curves[path.numCurves - 1].as.line.p1;
+			object->_cursor = points[0];
 		}
 
 		void hzLineTo(SvgObject* object, float xPoint, bool absolute)
@@ -206,95 +229,75 @@ namespace MathAnim
 		void bezier2To(SvgObject* object, const Vec2& control, const Vec2& dest, bool absolute)
 		{
 			g_logger_assert(object->numPaths > 0, "object->numPaths == 0. Cannot create a bezier2To when no path exists.");
-			Path& path = object->paths[object->numPaths - 1];
-			path.numCurves++;
-			checkResize(path);
-
-			path.curves[path.numCurves - 1].p0 = object->_cursor;
-
-			path.curves[path.numCurves - 1].as.bezier2.p1 = absolute ? control : control + object->_cursor;
-			path.curves[path.numCurves - 1].as.bezier2.p2 = absolute ? dest : dest + object->_cursor;
+			Vec2* points = pushCurve(object, CurveType::Bezier2, object->_cursor, 2);
+			points[0] = absolute ? control : control + object->_cursor;
+			points[1] = absolute ? dest : dest + object->_cursor;
 
 			// Only update the cursor to the final point of the curve
-			object->_cursor = path.curves[path.numCurves - 1].as.bezier2.p2;
-
-			path.curves[path.numCurves - 1].type = CurveType::Bezier2;
+			object->_cursor = points[1];
 		}
 
 		void bezier3To(SvgObject* object, const Vec2& control0, const Vec2& control1, const Vec2& dest, bool absolute)
 		{
 			g_logger_assert(object->numPaths > 0, "object->numPaths == 0. Cannot create a bezier3To when no path exists.");
-			Path& path = object->paths[object->numPaths - 1];
-			path.numCurves++;
-			checkResize(path);
-
-			path.curves[path.numCurves - 1].p0 = object->_cursor;
-
-			path.curves[path.numCurves - 1].as.bezier3.p1 = absolute ? control0 : control0 + object->_cursor;
-			path.curves[path.numCurves - 1].as.bezier3.p2 = absolute ? control1 : control1 + object->_cursor;
-			path.curves[path.numCurves - 1].as.bezier3.p3 = absolute ? dest : dest + object->_cursor;
+			Vec2* points = pushCurve(object, CurveType::Bezier3, object->_cursor, 3);
+			points[0] = absolute ? control0 : control0 + object->_cursor;
+			points[1] = absolute ? control1 : control1 + object->_cursor;
+			points[2] = absolute ? dest : dest + object->_cursor;
 
 			// Only update the cursor to the final point of the curve
-			object->_cursor = path.curves[path.numCurves - 1].as.bezier3.p3;
-
-			path.curves[path.numCurves - 1].type = CurveType::Bezier3;
+			object->_cursor = points[2];
 		}
 
 		void smoothBezier2To(SvgObject* object, const Vec2& dest, bool absolute)
 		{
 			g_logger_assert(object->numPaths > 0, "object->numPaths == 0. Cannot create a bezier3To when no path exists.");
-			Path& path = object->paths[object->numPaths - 1];
-			path.numCurves++;
-			checkResize(path);
-
-			path.curves[path.numCurves - 1].p0 = object->_cursor;
+			const Path& path = object->paths[object->numPaths - 1];
 
 			Vec2 control0 = object->_cursor;
-			if (path.numCurves > 1)
+			if (path.numCurves > 0)
 			{
-				if (path.curves[path.numCurves - 2].type == CurveType::Bezier2)
+				int prevCurve = object->numCurves - 1;
+				if (object->curveTypes[prevCurve] == CurveType::Bezier2)
 				{
-					Vec2 prevControl1 = path.curves[path.numCurves - 2].as.bezier2.p1;
+					Vec2 prevControl1 = object->points[object->curvePointOffsets[prevCurve]];
 					// Reflect the previous c2 about the current cursor
 					control0 = (-1.0f * (prevControl1 - object->_cursor)) + object->_cursor;
 				}
 			}
-			path.curves[path.numCurves - 1].as.bezier2.p1 = control0;
-			path.curves[path.numCurves - 1].as.bezier2.p2 = absolute ? dest : dest + object->_cursor;
 
-			// Only update the cursor to the final point on the curve
-			object->_cursor = path.curves[path.numCurves - 1].as.bezier2.p2;
+			Vec2* points = pushCurve(object, CurveType::Bezier2, object->_cursor, 2);
+			points[0] = control0;
+			points[1] = absolute ? dest : dest + object->_cursor;
 
-			path.curves[path.numCurves - 1].type = CurveType::Bezier2;
+			// Only update the cursor to the final point on the curve
+			object->_cursor = points[1];
 		}
 
 		void smoothBezier3To(SvgObject* object, const Vec2& control1, const Vec2& dest, bool absolute)
 		{
 			g_logger_assert(object->numPaths > 0, "object->numPaths == 0. Cannot create a bezier3To when no path exists.");
-			Path& path = object->paths[object->numPaths - 1];
-			path.numCurves++;
-			checkResize(path);
-
-			path.curves[path.numCurves - 1].p0 = object->_cursor;
+			const Path& path = object->paths[object->numPaths - 1];
 
 			Vec2 control0 = object->_cursor;
-			if (path.numCurves > 1)
+			if (path.numCurves > 0)
 			{
-				if (path.curves[path.numCurves - 2].type == CurveType::Bezier3)
+				int prevCurve = object->numCurves - 1;
+				if (object->curveTypes[prevCurve] == CurveType::Bezier3)
 				{
-					Vec2 prevControl1 = path.curves[path.numCurves - 2].as.bezier3.p2;
+					Vec2 prevControl1 = object->points[object->curvePointOffsets[prevCurve] + 1];
 					// Reflect the previous c2 about the current cursor
 					control0 = (-1.0f * (prevControl1 - object->_cursor)) + object->_cursor;
 				}
 			}
-			path.curves[path.numCurves - 1].as.bezier3.p1 = control0;
-			path.curves[path.numCurves - 1].as.bezier3.p2 = absolute ? control1 : control1 + object->_cursor;
-			path.curves[path.numCurves - 1].as.bezier3.p3 = absolute ? dest : dest + object->_cursor;
 
-			// Only update the cursor to the final point on the curve
-			object->_cursor = path.curves[path.numCurves - 1].as.bezier3.p3;
+			Vec2* points = pushCurve(object, CurveType::Bezier3, object->_cursor, 3);
+			points[0] = control0;
+			points[1] = absolute ? control1 : control1 + object->_cursor;
+			points[2] = absolute ? dest : dest + object->_cursor;
 
-			path.curves[path.numCurves - 1].type = CurveType::Bezier3;
+			// Only update the cursor to the final point on the curve
+			object->_cursor = points[2];
 		}
 
 		// Implementation taken from https://github.com/BigBadaboom/androidsvg/blob/5db71ef0007b41644258c1f139f941017aef7de3/androidsvg/src/main/java/com/caverock/androidsvg/utils/SVGAndroidRenderer.java#L2889
@@ -496,23 +499,35 @@ namespace MathAnim
 		void addCurveManually(SvgObject* object, const Curve& curve)
 		{
 			g_logger_assert(object->numPaths > 0, "object->numPaths == 0. Cannot create a lineTo when no path exists.");
-			Path& path = object->paths[object->numPaths - 1];
-			path.numCurves++;
-			checkResize(path);
-
-			path.curves[path.numCurves - 1] = curve;
 
+			// curve.p0 only gets stored if this is the first curve of the path, every
+			// other curve starts where the last one ended
 			switch (curve.type)
 			{
 			case CurveType::Line:
+			{
+				Vec2* points = pushCurve(object, CurveType::Line, curve.p0, 1);
+				points[0] = curve.as.line.p1;
 				object->_cursor = curve.as.line.p1;
-				break;
+			}
+			break;
 			case CurveType::Bezier2:
+			{
+				Vec2* points = pushCurve(object, CurveType::Bezier2, curve.p0, 2);
+				points[0] = curve.as.bezier2.p1;
+				points[1] = curve.as.bezier2.p2;
 				object->_cursor = curve.as.bezier2.p2;
-				break;
+			}
+			break;
 			case CurveType::Bezier3:
+			{
+				Vec2* points = pushCurve(object, CurveType::Bezier3, curve.p0, 3);
+				points[0] = curve.as.bezier3.p1;
+				points[1] = curve.as.bezier3.p2;
+				points[2] = curve.as.bezier3.p3;
 				object->_cursor = curve.as.bezier3.p3;
-				break;
+			}
+			break;
 			case CurveType::None:
 				break;
 			}
@@ -520,68 +535,371 @@ namespace MathAnim
 
 		void copy(SvgObject* dest, const SvgObject* src)
 		{
-			if (dest->numPaths != src->numPaths)
+			reserveArena(dest, src->numPaths, src->numCurves, src->numPoints);
+
+			// Everything in the streams is relative to the start of its stream, so
+			// they can be copied over as they are
+			if (src->numPaths > 0)
 			{
-				// Free any extra paths the destination has
-				// If the destination has less, this loop doesn't run
-				for (int contouri = src->numPaths; contouri < dest->numPaths; contouri++)
-				{
-					g_memory_free(dest->paths[contouri].curves);
-					dest->paths[contouri].curves = nullptr;
-					dest->paths[contouri].numCurves = 0;
-					dest->paths[contouri].maxCapacity = 0;
-				}
+				g_memory_copyMem(dest->paths, (void*)src->paths, sizeof(Path) * src->numPaths);
+				g_memory_copyMem(dest->points, (void*)src->points, sizeof(Vec2) * src->numPoints);
+				g_memory_copyMem(dest->curvePointOffsets, (void*)src->curvePointOffsets, sizeof(int) * src->numCurves);
+				g_memory_copyMem(dest->arcLengths, (void*)src->arcLengths, sizeof(float) * src->numCurves * Curve::numArcLengthSamples);
+				g_memory_copyMem(dest->curveTypes, (void*)src->curveTypes, sizeof(CurveType) * src->numCurves);
+			}
+			dest->numPaths = src->numPaths;
+			dest->numCurves = src->numCurves;
+			dest->numPoints = src->numPoints;
+
+			dest->fillType = src->fillType;
+			dest->fillColor = src->fillColor;
 
-				// Then reallocate memory. If dest had less, this will acquire enough new memory
-				// If dest had more, this will get rid of the extra memory
-				dest->paths = (Path*)g_memory_realloc(dest->paths, sizeof(Path) * src->numPaths);
+			dest->approximatePerimeter = src->approximatePerimeter;
+			dest->bbox = src->bbox;
+			dest->geometryHash = src->geometryHash;
+		}
 
-				// Go through and initialize the curves for any new curves that were added
-				for (int contouri = dest->numPaths; contouri < src->numPaths; contouri++)
+		void share(SvgObject* dest, const SvgObject* src)
+		{
+			if (dest->arena != src->arena)
+			{
+				releaseArena(dest);
+				if (src->arena)
 				{
-					dest->paths[contouri].curves = (Curve*)g_memory_allocate(sizeof(Curve) * initialMaxCapacity);
-					dest->paths[contouri].maxCapacity = initialMaxCapacity;
-					dest->paths[contouri].numCurves = 0;
+					getArenaHeader(src)->refCount++;
 				}
 
-				// Then set the number of paths equal
-				dest->numPaths = src->numPaths;
+				dest->arena = src->arena;
+				dest->paths = src->paths;
+				dest->points = src->points;
+				dest->curvePointOffsets = src->curvePointOffsets;
+				dest->arcLengths = src->arcLengths;
+				dest->curveTypes = src->curveTypes;
+				dest->maxPaths = src->maxPaths;
+				dest->maxCurves = src->maxCurves;
+				dest->maxPoints = src->maxPoints;
 			}
 
-			g_logger_assert(dest->numPaths == src->numPaths, "How did this happen?");
+			dest->numPaths = src->numPaths;
+			dest->numCurves = src->numCurves;
+			dest->numPoints = src->numPoints;
+			dest->_cursor = src->_cursor;
 
-			// Finally we can just go through and set all the data equal to each other
-			for (int pathi = 0; pathi < src->numPaths; pathi++)
+			dest->fillType = src->fillType;
+			dest->fillColor = src->fillColor;
+
+			dest->approximatePerimeter = src->approximatePerimeter;
+			dest->bbox = src->bbox;
+			dest->geometryHash = src->geometryHash;
+		}
+
+		void makeArenaUnique(SvgObject* object)
+		{
+			reserveArena(object, object->numPaths, object->numCurves, object->numPoints);
+		}
+
+		SvgMorph createDefaultMorph()
+		{
+			SvgMorph res = {};
+			res.pathNumCurves = nullptr;
+			res.srcIsHole = nullptr;
+			res.dstIsHole = nullptr;
+			res.srcPoints = nullptr;
+			res.dstPoints = nullptr;
+			res.points = nullptr;
+			return res;
+		}
+
+		bool prepareMorph(SvgMorph* morph, const SvgObject* src, const SvgObject* dst)
+		{
+			morph->free();
+			morph->srcGeometryHash = src->geometryHash;
+			morph->dstGeometryHash = dst->geometryHash;
+			morph->srcFillType = src->fillType;
+			morph->dstFillType = dst->fillType;
+
+			if (src->numPaths <= 0 || dst->numPaths <= 0)
 			{
-				Path& dstPath = dest->paths[pathi];
-				dstPath.numCurves = 0;
-				dstPath.isHole = src->paths[pathi].isHole;
+				return false;
+			}
 
-				for (int curvei = 0; curvei < src->paths[pathi].numCurves; curvei++)
-				{
-					const Curve& srcCurve = src->paths[pathi].curves[curvei];
+			SvgObject modifiedSrc = Svg::createDefault();
+			SvgObject modifiedDst = Svg::createDefault();
+			splitToMatchingCurves(src, dst, &modifiedSrc, &modifiedDst);
+
+			// Every path is its start point followed by the three control points
+			// of each curve
+			int numPoints = 0;
+			for (int pathi = 0; pathi < modifiedSrc.numPaths; pathi++)
+			{
+				numPoints += 1 + modifiedSrc.paths[pathi].numCurves * 3;
+			}
+
+			morph->numPaths = modifiedSrc.numPaths;
+			morph->numFloats = numPoints * 2;
+			morph->pathNumCurves = (int*)g_memory_allocate(sizeof(int) * morph->numPaths);
+			morph->srcIsHole = (bool*)g_memory_allocate(sizeof(bool) * morph->numPaths);
+			morph->dstIsHole = (bool*)g_memory_allocate(sizeof(bool) * morph->numPaths);
+			morph->srcPoints = (float*)g_memory_allocate(sizeof(float) * morph->numFloats);
+			morph->dstPoints = (float*)g_memory_allocate(sizeof(float) * morph->numFloats);
+			morph->points = (float*)g_memory_allocate(sizeof(float) * morph->numFloats);
+
+			Vec2* srcPoints = (Vec2*)morph->srcPoints;
+			Vec2* dstPoints = (Vec2*)morph->dstPoints;
+			for (int pathi = 0; pathi < modifiedSrc.numPaths; pathi++)
+			{
+				const Path& path0 = modifiedSrc.paths[pathi];
+				const Path& path1 = modifiedDst.paths[pathi];
+				g_logger_assert(path0.numCurves == path1.numCurves, "Somehow the interpolated objects didn't end up with the same number of curves in a sub-path.");
 
-					dstPath.numCurves++;
-					checkResize(dstPath);
+				morph->pathNumCurves[pathi] = path0.numCurves;
+				morph->srcIsHole[pathi] = path0.isHole;
+				morph->dstIsHole[pathi] = path1.isHole;
 
-					// Copy the data
-					Curve& dstCurve = dstPath.curves[curvei];
-					dstCurve.p0 = srcCurve.p0;
-					dstCurve.as = srcCurve.as;
-					dstCurve.type = srcCurve.type;
+				*(srcPoints++) = modifiedSrc.getPathStart(pathi);
+				*(dstPoints++) = modifiedDst.getPathStart(pathi);
+				for (int curvei = 0; curvei < path0.numCurves; curvei++)
+				{
+					// Treat both curves as bezier3 curves no matter what to make it easier
+					toCubic(modifiedSrc.getCurve(pathi, curvei), srcPoints, srcPoints + 1, srcPoints + 2);
+					toCubic(modifiedDst.getCurve(pathi, curvei), dstPoints, dstPoints + 1, dstPoints + 2);
+					srcPoints += 3;
+					dstPoints += 3;
 				}
+			}
+
+			modifiedSrc.free();
+			modifiedDst.free();
+			return true;
+		}
+
+		bool morphMatches(const SvgMorph& morph, const SvgObject* src, const SvgObject* dst)
+		{
+			return morph.srcPoints != nullptr &&
+				morph.srcGeometryHash == src->geometryHash &&
+				morph.dstGeometryHash == dst->geometryHash;
+		}
 
-				g_logger_assert(dstPath.numCurves == src->paths[pathi].numCurves, "How did this happen?");
+		void morph(SvgMorph& morph, float t, SvgObject* dest)
+		{
+			lerpPoints(morph.srcPoints, morph.dstPoints, morph.points, morph.numFloats, t);
+
+			// Every path gets a line back to its start point on top of the cubics
+			int numCurves = 0;
+			for (int pathi = 0; pathi < morph.numPaths; pathi++)
+			{
+				numCurves += morph.pathNumCurves[pathi] + 1;
 			}
+			int numPoints = morph.numFloats / 2 + morph.numPaths;
 
-			dest->fillType = src->fillType;
-			dest->fillColor = src->fillColor;
+			// Only allocates when dest doesn't have room for the morph yet
+			reserveArena(dest, morph.numPaths, numCurves, numPoints);
+			dest->numPaths = morph.numPaths;
+			dest->numCurves = 0;
+			dest->numPoints = 0;
+
+			const Vec2* points = (const Vec2*)morph.points;
+			for (int pathi = 0; pathi < morph.numPaths; pathi++)
+			{
+				Path& path = dest->paths[pathi];
+				int pathNumCurves = morph.pathNumCurves[pathi];
+				path.firstCurve = dest->numCurves;
+				path.numCurves = pathNumCurves + 1;
+				path.firstPoint = dest->numPoints;
+				path.isHole = t < 0.5f
+					? morph.srcIsHole[pathi]
+					: morph.dstIsHole[pathi];
+
+				// The blended points are already laid out the way the point stream
+				// wants them, start point first and then p1, p2, p3 of every cubic
+				int numPathPoints = 1 + pathNumCurves * 3;
+				g_memory_copyMem(dest->points + dest->numPoints, (void*)points, sizeof(Vec2) * numPathPoints);
+				for (int curvei = 0; curvei < pathNumCurves; curvei++)
+				{
+					dest->curveTypes[dest->numCurves] = CurveType::Bezier3;
+					dest->curvePointOffsets[dest->numCurves] = dest->numPoints + 1 + curvei * 3;
+					dest->numCurves++;
+				}
+				dest->numPoints += numPathPoints;
+
+				Vec2 firstPoint = points[0];
+				dest->curveTypes[dest->numCurves] = CurveType::Line;
+				dest->curvePointOffsets[dest->numCurves] = dest->numPoints;
+				dest->numCurves++;
+				dest->points[dest->numPoints] = firstPoint;
+				dest->numPoints++;
+
+				points += numPathPoints;
+				dest->_cursor = firstPoint;
+			}
 
+			dest->fillType = t < 0.5f
+				? morph.srcFillType
+				: morph.dstFillType;
+			// The arc lengths have to be measured again, the curves don't stretch evenly
+			// while they blend
 			dest->calculateApproximatePerimeter();
 			dest->calculateBBox();
 		}
 
 		SvgObject* interpolate(const SvgObject* src, const SvgObject* dst, float t)
+		{
+			SvgObject* res = (SvgObject*)g_memory_allocate(sizeof(SvgObject));
+			*res = Svg::createDefault();
+
+			SvgMorph tmpMorph = createDefaultMorph();
+			if (prepareMorph(&tmpMorph, src, dst))
+			{
+				morph(tmpMorph, t, res);
+			}
+			tmpMorph.free();
+
+			return res;
+		}
+
+		void findCurveAtLength(const float* arcLengths, int numCurves, float length, int* outCurve, float* outT)
+		{
+			g_logger_assert(numCurves > 0, "Cannot search the arc lengths of an empty outline.");
+			constexpr int numSamples = Curve::numArcLengthSamples;
+			const float* samplesEnd = arcLengths + numCurves * numSamples;
+
+			// First sample that reaches length, the lengths only ever grow so this can
+			// be a binary search
+			const float* sample = std::lower_bound(arcLengths, samplesEnd, length);
+			if (sample == samplesEnd)
+			{
+				*outCurve = numCurves - 1;
+				*outT = 1.0f;
+				return;
+			}
+
+			// Samples are evenly spaced in t, so the position inside the sample maps
+			// linearly onto the curve's t
+			int samplei = (int)(sample - arcLengths);
+			float sampleStart = samplei > 0 ? arcLengths[samplei - 1] : 0.0f;
+			float sampleLength = *sample - sampleStart;
+			float tInSample = sampleLength > 0.0f
+				? glm::clamp((length - sampleStart) / sampleLength, 0.0f, 1.0f)
+				: 1.0f;
+
+			*outCurve = samplei / numSamples;
+			*outT = ((float)(samplei % numSamples) + tInSample) / (float)numSamples;
+		}
+
+		// ----------------- Internal functions -----------------
+		static void reserveArena(SvgObject* object, int numPaths, int numCurves, int numPoints)
+		{
+			// Shared arenas are read only, anything that's about to write to one gets
+			// its own copy first
+			bool isShared = object->arena && getArenaHeader(object)->refCount > 1;
+			if (!isShared && numPaths <= object->maxPaths && numCurves <= object->maxCurves && numPoints <= object->maxPoints)
+			{
+				return;
+			}
+
+			// Streams that ran out of room double in size, the rest stay the same
+			int maxPaths = object->maxPaths;
+			int maxCurves = object->maxCurves;
+			int maxPoints = object->maxPoints;
+			if (numPaths > maxPaths)
+			{
+				maxPaths = glm::max(glm::max(numPaths, maxPaths * 2), initialMaxCapacity);
+			}
+			if (numCurves > maxCurves)
+			{
+				maxCurves = glm::max(glm::max(numCurves, maxCurves * 2), initialMaxCapacity);
+			}
+			if (numPoints > maxPoints)
+			{
+				maxPoints = glm::max(glm::max(numPoints, maxPoints * 2), initialMaxCapacity);
+			}
+
+			// Curve types are the only thing that isn't 4 byte aligned, so they go last
+			size_t pathsSize = sizeof(Path) * maxPaths;
+			size_t pointsSize = sizeof(Vec2) * maxPoints;
+			size_t offsetsSize = sizeof(int) * maxCurves;
+			size_t arcLengthsSize = sizeof(float) * maxCurves * Curve::numArcLengthSamples;
+			size_t typesSize = sizeof(CurveType) * maxCurves;
+			size_t headerSize = sizeof(ArenaHeader);
+			uint8* arena = (uint8*)g_memory_allocate(headerSize + pathsSize + pointsSize + offsetsSize + arcLengthsSize + typesSize);
+			g_logger_assert(arena != nullptr, "Ran out of RAM.");
+			((ArenaHeader*)arena)->refCount = 1;
+
+			uint8* streams = arena + headerSize;
+			Path* paths = (Path*)streams;
+			Vec2* points = (Vec2*)(streams + pathsSize);
+			int* curvePointOffsets = (int*)(streams + pathsSize + pointsSize);
+			float* arcLengths = (float*)(streams + pathsSize + pointsSize + offsetsSize);
+			CurveType* curveTypes = (CurveType*)(streams + pathsSize + pointsSize + offsetsSize + arcLengthsSize);
+
+			if (object->arena)
+			{
+				g_memory_copyMem(paths, object->paths, sizeof(Path) * object->numPaths);
+				g_memory_copyMem(points, object->points, sizeof(Vec2) * object->numPoints);
+				g_memory_copyMem(curvePointOffsets, object->curvePointOffsets, sizeof(int) * object->numCurves);
+				g_memory_copyMem(arcLengths, object->arcLengths, sizeof(float) * object->numCurves * Curve::numArcLengthSamples);
+				g_memory_copyMem(curveTypes, object->curveTypes, sizeof(CurveType) * object->numCurves);
+				releaseArena(object);
+			}
+
+			object->arena = arena;
+			object->paths = paths;
+			object->points = points;
+			object->curvePointOffsets = curvePointOffsets;
+			object->arcLengths = arcLengths;
+			object->curveTypes = curveTypes;
+			object->maxPaths = maxPaths;
+			object->maxCurves = maxCurves;
+			object->maxPoints = maxPoints;
+		}
+
+		static void releaseArena(SvgObject* object)
+		{
+			if (!object->arena)
+			{
+				return;
+			}
+
+			ArenaHeader* header = getArenaHeader(object);
+			g_logger_assert(header->refCount > 0, "Released an SVG arena that nothing references.");
+			header->refCount--;
+			if (header->refCount == 0)
+			{
+				g_memory_free(object->arena);
+			}
+			object->arena = nullptr;
+		}
+
+		static ArenaHeader* getArenaHeader(const SvgObject* object)
+		{
+			return (ArenaHeader*)object->arena;
+		}
+
+		static Vec2* pushCurve(SvgObject* object, CurveType type, const Vec2& p0, int numCurvePoints)
+		{
+			reserveArena(object, object->numPaths, object->numCurves + 1, object->numPoints + numCurvePoints);
+
+			// Curves only ever get added to the last path, so its curves and points
+			// are always at the end of the streams
+			Path& path = object->paths[object->numPaths - 1];
+			if (path.numCurves == 0)
+			{
+				// The cursor can move between beginPath and the first curve, the path
+				// starts wherever its first curve does
+				object->points[path.firstPoint] = p0;
+			}
+
+			object->curveTypes[object->numCurves] = type;
+			object->curvePointOffsets[object->numCurves] = object->numPoints;
+			object->numCurves++;
+			path.numCurves++;
+
+			Vec2* res = object->points + object->numPoints;
+			object->numPoints += numCurvePoints;
+			return res;
+		}
+
+		static void splitToMatchingCurves(const SvgObject* src, const SvgObject* dst, SvgObject* outSrc, SvgObject* outDst)
 		{
 			// Count the total number of curves in all paths
 			int srcNumCurves = 0;
@@ -595,11 +913,6 @@ namespace MathAnim
 				dstNumCurves += dst->paths[pathi].numCurves;
 			}
 
-			SvgObject* modifiedSrcObject = (SvgObject*)g_memory_allocate(sizeof(SvgObject));
-			SvgObject* modifiedDstObject = (SvgObject*)g_memory_allocate(sizeof(SvgObject));
-			*modifiedSrcObject = Svg::createDefault();
-			*modifiedDstObject = Svg::createDefault();
-
 			const SvgObject* splitObj = srcNumCurves < dstNumCurves
 				? src
 				: dst;
@@ -607,9 +920,10 @@ namespace MathAnim
 				? dst
 				: src;
 
-			// After we finish splitting everything, we may need to swap
-			// the objects so that we interpolate in the proper direction
-			bool shouldSwapSplitObjs = splitObj != src;
+			// The split curves go to whichever output belongs to the object
+			// being split, so the outputs keep the direction of src and dst
+			SvgObject* modifiedSplitObject = splitObj == src ? outSrc : outDst;
+			SvgObject* modifiedNonSplitObject = splitObj == src ? outDst : outSrc;
 
 			// We need to make them equal to interpolate properly.
 			// So this algorithm will make sure we end up with two
@@ -627,8 +941,8 @@ namespace MathAnim
 			g_logger_assert(nonSplitPath->numCurves > 0, "It's undefined to interpolate between a path with 0 curves.");
 
 			// Begin the paths
-			Svg::beginPath(modifiedSrcObject, splitPath->curves[0].p0);
-			Svg::beginPath(modifiedDstObject, nonSplitPath->curves[0].p0);
+			Svg::beginPath(modifiedSplitObject, splitObj->getPathStart(splitPathi));
+			Svg::beginPath(modifiedNonSplitObject, nonSplitObj->getPathStart(nonSplitPathi));
 
 			// Sometimes math is beautiful...
 			// This algorithm works by splitting each curve a similar number of times
@@ -696,23 +1010,23 @@ namespace MathAnim
 					if (beginNewSubpath)
 					{
 						// Close both paths so we have equal sub-path splits
-						Svg::closePath(modifiedSrcObject, true, splitIsHole);
-						Svg::closePath(modifiedDstObject, true, nonSplitIsHole);
+						Svg::closePath(modifiedSplitObject, true, splitIsHole);
+						Svg::closePath(modifiedNonSplitObject, true, nonSplitIsHole);
 
-						//Vec2 splitFirstPathP0 = splitPath->curves[0].p0;
-						//Vec2 nonSplitFirstPathP0 = nonSplitPath->curves[0].p0;
-						//Svg::beginPath(modifiedSrcObject, splitFirstPathP0);
-						//Svg::beginPath(modifiedDstObject, nonSplitFirstPathP0);
+						//Vec2 splitFirstPathP0 = splitObj->getCurve(splitPathi, 0).p0;
+						//Vec2 nonSplitFirstPathP0 = nonSplitObj->getCurve(nonSplitPathi, 0).p0;
+						//Svg::beginPath(modifiedSplitObject, splitFirstPathP0);
+						//Svg::beginPath(modifiedNonSplitObject, nonSplitFirstPathP0);
 						//
-						//Vec2 splitFirstP0 = splitPath->curves[splitCurvei].p0;
-						//Vec2 nonSplitFirstP0 = nonSplitPath->curves[nonSplitCurvei].p0;
-						//Svg::lineTo(modifiedSrcObject, splitFirstP0);
-						//Svg::lineTo(modifiedDstObject, nonSplitFirstP0);
-
-						Vec2 splitFirstP0 = splitPath->curves[splitCurvei].p0;
-						Vec2 nonSplitFirstP0 = nonSplitPath->curves[nonSplitCurvei].p0;
-						Svg::beginPath(modifiedSrcObject, splitFirstP0);
-						Svg::beginPath(modifiedDstObject, nonSplitFirstP0);
+						//Vec2 splitFirstP0 = splitObj->getCurve(splitPathi, splitCurvei).p0;
+						//Vec2 nonSplitFirstP0 = nonSplitObj->getCurve(nonSplitPathi, nonSplitCurvei).p0;
+						//Svg::lineTo(modifiedSplitObject, splitFirstP0);
+						//Svg::lineTo(modifiedNonSplitObject, nonSplitFirstP0);
+
+						Vec2 splitFirstP0 = splitObj->getCurve(splitPathi, splitCurvei).p0;
+						Vec2 nonSplitFirstP0 = nonSplitObj->getCurve(nonSplitPathi, nonSplitCurvei).p0;
+						Svg::beginPath(modifiedSplitObject, splitFirstP0);
+						Svg::beginPath(modifiedNonSplitObject, nonSplitFirstP0);
 					}
 				}
 
@@ -748,20 +1062,20 @@ namespace MathAnim
 						nonSplitCurvei = 0;
 
 						// Begin new path so that things don't get weird
-						Svg::closePath(modifiedDstObject, true, isHole);
+						Svg::closePath(modifiedNonSplitObject, true, isHole);
 
-						Vec2 nonSplitFirstP0 = nonSplitPath->curves[nonSplitCurvei].p0;
-						Svg::beginPath(modifiedDstObject, nonSplitFirstP0);
+						Vec2 nonSplitFirstP0 = nonSplitObj->getCurve(nonSplitPathi, nonSplitCurvei).p0;
+						Svg::beginPath(modifiedNonSplitObject, nonSplitFirstP0);
 					}
 
-					Svg::addCurveManually(modifiedDstObject, nonSplitPath->curves[nonSplitCurvei]);
+					Svg::addCurveManually(modifiedNonSplitObject, nonSplitObj->getCurve(nonSplitPathi, nonSplitCurvei));
 					nonSplitCurvei++;
 				}
 
 				// Then add the split curves to the other new object
 				// Split this curve roundedNumSplits number of times evenly
 				// Copy the curve because it gets modified
-				Curve nextCurve = splitPath->curves[splitCurvei];
+				Curve nextCurve = splitObj->getCurve(splitPathi, splitCurvei);
 				while (roundedNumSplits > 0)
 				{
 					float tSplit = 1.0f / (float)roundedNumSplits;
@@ -774,8 +1088,8 @@ namespace MathAnim
 						bool isHole = splitObj->paths[splitPathi].isHole;
 
 						// Begin new path so that things don't get weird
-						Svg::closePath(modifiedSrcObject, true, isHole);
-						Svg::beginPath(modifiedSrcObject, p0);
+						Svg::closePath(modifiedSplitObject, true, isHole);
+						Svg::beginPath(modifiedSplitObject, p0);
 					}
 
 					// Interpolate the curve by tSplit
@@ -817,7 +1131,7 @@ namespace MathAnim
 									((t1 * t1 * t1) * p3);
 
 								// Copy the split position into output curve
-								Svg::bezier3To(modifiedSrcObject, q1, q2, q3);
+								Svg::bezier3To(modifiedSplitObject, q1, q2, q3);
 								nextCurve.p0 = q3;
 							}
 
@@ -892,7 +1206,7 @@ namespace MathAnim
 									((t1 * t1 * t1) * p3);
 
 								// Copy the split position into output curve
-								Svg::bezier3To(modifiedSrcObject, q1, q2, q3);
+								Svg::bezier3To(modifiedSplitObject, q1, q2, q3);
 								nextCurve.p0 = q3;
 							}
 
@@ -934,7 +1248,7 @@ namespace MathAnim
 
 							// First split
 							Vec2 interpP1 = ((p1 - p0) * percentOfCurveToDraw) + p0;
-							Svg::lineTo(modifiedSrcObject, interpP1);
+							Svg::lineTo(modifiedSplitObject, interpP1);
 
 							// Set up next split
 							nextCurve.type = CurveType::Line;
@@ -949,7 +1263,7 @@ namespace MathAnim
 					else
 					{
 						// Add the last curve manually
-						Svg::addCurveManually(modifiedSrcObject, nextCurve);
+						Svg::addCurveManually(modifiedSplitObject, nextCurve);
 					}
 
 					roundedNumSplits--;
@@ -960,305 +1274,162 @@ namespace MathAnim
 			}
 
 			// Close the paths
-			//Svg::lineTo(modifiedSrcObject, splitPath->curves[0].p0);
-			//Svg::lineTo(modifiedDstObject, nonSplitPath->curves[0].p0);
-			Svg::closePath(modifiedSrcObject, false, splitPath->isHole);
-			Svg::closePath(modifiedDstObject, false, nonSplitPath->isHole);
-
-			if (shouldSwapSplitObjs)
-			{
-				SvgObject* tmp = modifiedDstObject;
-				modifiedDstObject = modifiedSrcObject;
-				modifiedSrcObject = tmp;
-			}
+			//Svg::lineTo(modifiedSplitObject, splitObj->getCurve(splitPathi, 0).p0);
+			//Svg::lineTo(modifiedNonSplitObject, nonSplitObj->getCurve(nonSplitPathi, 0).p0);
+			Svg::closePath(modifiedSplitObject, false, splitPath->isHole);
+			Svg::closePath(modifiedNonSplitObject, false, nonSplitPath->isHole);
 
-			g_logger_assert(modifiedDstObject->numPaths == modifiedSrcObject->numPaths, "Somehow the interpolated objects didn't end up with the same number of sub-paths.");
+			g_logger_assert(outSrc->numPaths == outDst->numPaths, "Somehow the interpolated objects didn't end up with the same number of sub-paths.");
+		}
 
-			SvgObject* res = (SvgObject*)g_memory_allocate(sizeof(SvgObject));
-			*res = Svg::createDefault();
-			for (int pathi = 0; pathi < modifiedSrcObject->numPaths; pathi++)
+		static void toCubic(const Curve& curve, Vec2* p1, Vec2* p2, Vec2* p3)
+		{
+			switch (curve.type)
 			{
-				const Path* path0 = modifiedSrcObject->paths + pathi;
-				const Path* path1 = modifiedDstObject->paths + pathi;
-
-				g_logger_assert(path0->numCurves == path1->numCurves, "Somehow the interpolated objects didn't end up with the same number of curves in a sub-path.");
-
-				// Move to the start, which is the interpolation between both of the
-				// first vertices
-				const Vec2& p0a = path0->curves[0].p0;
-				const Vec2& p0b = path1->curves[0].p0;
-				Vec2 interpP0 = {
-					(p0b.x - p0a.x) * t + p0a.x,
-					(p0b.y - p0a.y) * t + p0a.y
-				};
-
-				Svg::beginPath(res, interpP0, true);
-
-				for (int curvei = 0; curvei < path0->numCurves; curvei++)
-				{
-					// Interpolate between the two curves, treat both curves
-					// as bezier3 curves no matter what to make it easier
-					Vec2 p1a, p2a, p3a;
-					Vec2 p1b, p2b, p3b;
-
-					const Curve& srcCurve = path0->curves[curvei];
-					const Curve& dstCurve = path1->curves[curvei];
-
-					// First get the control points depending on the type of the curve
-					switch (srcCurve.type)
-					{
-					case CurveType::Bezier3:
-						p1a = srcCurve.as.bezier3.p1;
-						p2a = srcCurve.as.bezier3.p2;
-						p3a = srcCurve.as.bezier3.p3;
-						break;
-					case CurveType::Bezier2:
-					{
-						Vec2 p0 = srcCurve.p0;
-						Vec2 p1 = srcCurve.as.bezier2.p1;
-						Vec2 p2 = srcCurve.as.bezier2.p2;
-
-						// Degree elevated quadratic bezier curve
-						p1a = ((1.0f / 3.0f) * p0) + ((2.0f / 3.0f) * p1);
-						p2a = ((2.0f / 3.0f) * p1) + ((1.0f / 3.0f) * p2);
-						p3a = p2;
-					}
-					break;
-					case CurveType::Line:
-					{
-						Vec2 tmpP1a = (srcCurve.as.line.p1 - srcCurve.p0) * (1.0f / 3.0f) + srcCurve.p0;
-						Vec2 tmpP2a = (srcCurve.as.line.p1 - srcCurve.p0) * (2.0f / 3.0f) + srcCurve.p0;
-						p1a = tmpP1a;
-						p2a = tmpP2a;
-						p3a = srcCurve.as.line.p1;
-					}
-					break;
-					case CurveType::None:
-						break;
-					}
-
-					switch (dstCurve.type)
-					{
-					case CurveType::Bezier3:
-						p1b = dstCurve.as.bezier3.p1;
-						p2b = dstCurve.as.bezier3.p2;
-						p3b = dstCurve.as.bezier3.p3;
-						break;
-					case CurveType::Bezier2:
-					{
-						Vec2 p0 = dstCurve.p0;
-						Vec2 p1 = dstCurve.as.bezier2.p1;
-						Vec2 p2 = dstCurve.as.bezier2.p2;
-
-						// Degree elevated quadratic bezier curve
-						p1b = ((1.0f / 3.0f) * p0) + ((2.0f / 3.0f) * p1);
-						p2b = ((2.0f / 3.0f) * p1) + ((1.0f / 3.0f) * p2);
-						p3b = p2;
-					}
-					break;
-					case CurveType::Line:
-					{
-						Vec2 tmpP1b = (dstCurve.as.line.p1 - dstCurve.p0) * (1.0f / 3.0f) + dstCurve.p0;
-						Vec2 tmpP2b = (dstCurve.as.line.p1 - dstCurve.p0) * (2.0f / 3.0f) + dstCurve.p0;
-						p1b = tmpP1b;
-						p2b = tmpP2b;
-						p3b = dstCurve.as.line.p1;
-					}
-					break;
-					case CurveType::None:
-						break;
-					}
-
-					// Then interpolate between the control points
-					Vec2 interpP1 = (p1b - p1a) * t + p1a;
-					Vec2 interpP2 = (p2b - p2a) * t + p2a;
-					Vec2 interpP3 = (p3b - p3a) * t + p3a;
-
-					// Then draw
-					Svg::bezier3To(res, interpP1, interpP2, interpP3);
-				}
-
-				bool isHole = t < 0.5
-					? path0->isHole
-					: path1->isHole;
-				Svg::closePath(res, true, isHole);
+			case CurveType::Bezier3:
+				*p1 = curve.as.bezier3.p1;
+				*p2 = curve.as.bezier3.p2;
+				*p3 = curve.as.bezier3.p3;
+				break;
+			case CurveType::Bezier2:
+				// Degree elevated quadratic bezier curve
+				*p1 = ((1.0f / 3.0f) * curve.p0) + ((2.0f / 3.0f) * curve.as.bezier2.p1);
+				*p2 = ((2.0f / 3.0f) * curve.as.bezier2.p1) + ((1.0f / 3.0f) * curve.as.bezier2.p2);
+				*p3 = curve.as.bezier2.p2;
+				break;
+			case CurveType::Line:
+				*p1 = (curve.as.line.p1 - curve.p0) * (1.0f / 3.0f) + curve.p0;
+				*p2 = (curve.as.line.p1 - curve.p0) * (2.0f / 3.0f) + curve.p0;
+				*p3 = curve.as.line.p1;
+				break;
+			case CurveType::None:
+				*p1 = curve.p0;
+				*p2 = curve.p0;
+				*p3 = curve.p0;
+				break;
 			}
-
-			res->calculateApproximatePerimeter();
-			res->calculateBBox();
-
-			// Free temporary memory
-			modifiedSrcObject->free();
-			modifiedDstObject->free();
-			g_memory_free(modifiedSrcObject);
-			g_memory_free(modifiedDstObject);
-			modifiedSrcObject = nullptr;
-			modifiedDstObject = nullptr;
-
-			return res;
 		}
 
-		// ----------------- Internal functions -----------------
-		static void checkResize(Path& path)
+		static void lerpPoints(const float* src, const float* dst, float* out, int numFloats, float t)
 		{
-			if (path.numCurves > path.maxCapacity)
+			// Four floats (two points) at a time, then whatever is left over
+			__m128 tVec = _mm_set1_ps(t);
+			int i = 0;
+			for (; i + 4 <= numFloats; i += 4)
 			{
-				path.maxCapacity *= 2;
-				path.curves = (Curve*)g_memory_realloc(path.curves, sizeof(Curve) * path.maxCapacity);
-				g_logger_assert(path.curves != nullptr, "Ran out of RAM.");
+				__m128 a = _mm_loadu_ps(src + i);
+				__m128 b = _mm_loadu_ps(dst + i);
+				_mm_storeu_ps(out + i, _mm_add_ps(a, _mm_mul_ps(_mm_sub_ps(b, a), tVec)));
+			}
+
+			for (; i < numFloats; i++)
+			{
+				out[i] = (dst[i] - src[i]) * t + src[i];
 			}
 		}
 	}
 
 	// ----------------- SvgObject functions -----------------
 	// SvgObject internal functions
-	static void fillWithPluto(plutovg_t* pluto, const AnimObject* parent, const SvgObject* obj);
-	static void renderOutline2D(float t, const AnimObject* parent, const SvgObject* obj);
+	static void fillWithPluto(plutovg_t* pluto, const SvgObject* obj, float rasterScale);
+	static void renderOutline2D(float t, const glm::mat4& transform, const glm::u8vec4& strokeColor, float strokeWidth, const SvgObject* obj);
+	static bool deserializePathTextV1(RawMemory& memory, SvgObject* obj);
+	static bool deserializeGeometryV2(RawMemory& memory, SvgObject* obj);
 
 	void SvgObject::normalize()
 	{
+		Svg::makeArenaUnique(this);
+
 		// First find the min max of the entire curve
 		Vec2 min = { FLT_MAX, FLT_MAX };
 		Vec2 max = { FLT_MIN, FLT_MIN };
-		for (int pathi = 0; pathi < this->numPaths; pathi++)
+		for (int pointi = 0; pointi < this->numPoints; pointi++)
 		{
-			for (int curvei = 0; curvei < this->paths[pathi].numCurves; curvei++)
-			{
-				const Curve& curve = paths[pathi].curves[curvei];
-				const Vec2& p0 = curve.p0;
-
-				min = CMath::min(p0, min);
-				max = CMath::max(p0, max);
-
-				switch (curve.type)
-				{
-				case CurveType::Bezier3:
-				{
-					const Vec2& p1 = curve.as.bezier3.p1;
-					const Vec2& p2 = curve.as.bezier3.p2;
-					const Vec2& p3 = curve.as.bezier3.p3;
-
-					min = CMath::min(p1, min);
-					max = CMath::max(p1, max);
-
-					min = CMath::min(p2, min);
-					max = CMath::max(p2, max);
-
-					min = CMath::min(p3, min);
-					max = CMath::max(p3, max);
-				}
-				break;
-				case CurveType::Bezier2:
-				{
-					const Vec2& p1 = curve.as.bezier2.p1;
-					const Vec2& p2 = curve.as.bezier2.p2;
-
-					min = CMath::min(p1, min);
-					max = CMath::max(p1, max);
-
-					min = CMath::min(p2, min);
-					max = CMath::max(p2, max);
-				}
-				break;
-				case CurveType::Line:
-				{
-					const Vec2& p1 = curve.as.line.p1;
-
-					min = CMath::min(p1, min);
-					max = CMath::max(p1, max);
-				}
-				break;
-				case CurveType::None:
-					break;
-				}
-			}
+			min = CMath::min(points[pointi], min);
+			max = CMath::max(points[pointi], max);
 		}
 
 		// Then map everything to a [0.0-1.0] range from there
 		Vec2 hzOutputRange = Vec2{ 0.0f, 1.0f };
 		// Maintain aspect ratio while normalizing
 		Vec2 vtOutputRange = Vec2{ 0.0f, (max.y - min.y) / (max.x - min.x) };
-		for (int pathi = 0; pathi < this->numPaths; pathi++)
+		for (int pointi = 0; pointi < this->numPoints; pointi++)
 		{
-			for (int curvei = 0; curvei < this->paths[pathi].numCurves; curvei++)
-			{
-				Curve& curve = paths[pathi].curves[curvei];
-				curve.p0.x = CMath::mapRange(Vec2{ min.x, max.x }, hzOutputRange, curve.p0.x);
-				curve.p0.y = CMath::mapRange(Vec2{ min.y, max.y }, vtOutputRange, curve.p0.y);
+			Vec2& point = points[pointi];
+			point.x = CMath::mapRange(Vec2{ min.x, max.x }, hzOutputRange, point.x);
+			point.y = CMath::mapRange(Vec2{ min.y, max.y }, vtOutputRange, point.y);
+		}
+	}
 
-				switch (curve.type)
-				{
-				case CurveType::Bezier3:
-				{
-					curve.as.bezier3.p1.x = CMath::mapRange(Vec2{ min.x, max.x }, hzOutputRange, curve.as.bezier3.p1.x);
-					curve.as.bezier3.p1.y = CMath::mapRange(Vec2{ min.y, max.y }, vtOutputRange, curve.as.bezier3.p1.y);
+	Curve SvgObject::getCurve(int pathi, int curvei) const
+	{
+		g_logger_assert(curvei >= 0 && curvei < paths[pathi].numCurves, "Curve %d is out of bounds for a path with %d curves.", curvei, paths[pathi].numCurves);
+		int curveIndex = paths[pathi].firstCurve + curvei;
+		const Vec2* curvePoints = points + curvePointOffsets[curveIndex];
 
-					curve.as.bezier3.p2.x = CMath::mapRange(Vec2{ min.x, max.x }, hzOutputRange, curve.as.bezier3.p2.x);
-					curve.as.bezier3.p2.y = CMath::mapRange(Vec2{ min.y, max.y }, vtOutputRange, curve.as.bezier3.p2.y);
+		Curve res{};
+		res.type = curveTypes[curveIndex];
+		res.p0 = curvePoints[-1];
+		switch (res.type)
+		{
+		case CurveType::Bezier3:
+			res.as.bezier3.p1 = curvePoints[0];
+			res.as.bezier3.p2 = curvePoints[1];
+			res.as.bezier3.p3 = curvePoints[2];
+			break;
+		case CurveType::Bezier2:
+			res.as.bezier2.p1 = curvePoints[0];
+			res.as.bezier2.p2 = curvePoints[1];
+			break;
+		case CurveType::Line:
+			res.as.line.p1 = curvePoints[0];
+			break;
+		case CurveType::None:
+			break;
+		}
 
-					curve.as.bezier3.p3.x = CMath::mapRange(Vec2{ min.x, max.x }, hzOutputRange, curve.as.bezier3.p3.x);
-					curve.as.bezier3.p3.y = CMath::mapRange(Vec2{ min.y, max.y }, vtOutputRange, curve.as.bezier3.p3.y);
+		return res;
+	}
 
-				}
-				break;
-				case CurveType::Bezier2:
-				{
-					curve.as.bezier2.p1.x = CMath::mapRange(Vec2{ min.x, max.x }, hzOutputRange, curve.as.bezier2.p1.x);
-					curve.as.bezier2.p1.y = CMath::mapRange(Vec2{ min.y, max.y }, vtOutputRange, curve.as.bezier2.p1.y);
+	const Vec2& SvgObject::getPathStart(int pathi) const
+	{
+		return points[paths[pathi].firstPoint];
+	}
 
-					curve.as.bezier2.p2.x = CMath::mapRange(Vec2{ min.x, max.x }, hzOutputRange, curve.as.bezier2.p2.x);
-					curve.as.bezier2.p2.y = CMath::mapRange(Vec2{ min.y, max.y }, vtOutputRange, curve.as.bezier2.p2.y);
-				}
+	void Curve::calculateArcLengths(float* outLengths) const
+	{
+		float length = 0.0f;
+		Vec2 previousPoint = p0;
+		for (int samplei = 0; samplei < numArcLengthSamples; samplei++)
+		{
+			float t = (float)(samplei + 1) / (float)numArcLengthSamples;
+			Vec2 point = p0;
+			switch (type)
+			{
+			case CurveType::Bezier3:
+				point = CMath::bezier3(p0, as.bezier3.p1, as.bezier3.p2, as.bezier3.p3, t);
 				break;
-				case CurveType::Line:
-				{
-					curve.as.line.p1.x = CMath::mapRange(Vec2{ min.x, max.x }, hzOutputRange, curve.as.line.p1.x);
-					curve.as.line.p1.y = CMath::mapRange(Vec2{ min.y, max.y }, vtOutputRange, curve.as.line.p1.y);
-				}
+			case CurveType::Bezier2:
+				point = CMath::bezier2(p0, as.bezier2.p1, as.bezier2.p2, t);
+				break;
+			case CurveType::Line:
+				point = (as.line.p1 - p0) * t + p0;
+				break;
+			case CurveType::None:
 				break;
-				case CurveType::None:
-					break;
-				}
 			}
+
+			length += CMath::length(point - previousPoint);
+			outLengths[samplei] = length;
+			previousPoint = point;
 		}
 	}
 
 	float Curve::calculateApproximatePerimeter() const
 	{
-		switch (type)
-		{
-		case CurveType::Bezier3:
-		{
-			const Vec2& p1 = this->as.bezier3.p1;
-			const Vec2& p2 = this->as.bezier3.p2;
-			const Vec2& p3 = this->as.bezier3.p3;
-			float chordLength = CMath::length(p3 - p0);
-			float controlNetLength = CMath::length(p1 - p0) + CMath::length(p2 - p1) + CMath::length(p3 - p2);
-			float approxLength = (chordLength + controlNetLength) / 2.0f;
-			return approxLength;
-		}
-		break;
-		case CurveType::Bezier2:
-		{
-			const Vec2& p1 = this->as.bezier2.p1;
-			const Vec2& p2 = this->as.bezier2.p2;
-			float chordLength = CMath::length(p2 - p0);
-			float controlNetLength = CMath::length(p1 - p0) + CMath::length(p2 - p1);
-			float approxLength = (chordLength + controlNetLength) / 2.0f;
-			return approxLength;
-		}
-		break;
-		case CurveType::Line:
-		{
-			const Vec2& p1 = this->as.line.p1;
-			return CMath::length(p1 - p0);
-		}
-		break;
-		case CurveType::None:
-			break;
-		}
-
-		return 0.0f;
+		float lengths[numArcLengthSamples];
+		calculateArcLengths(lengths);
+		return lengths[numArcLengthSamples - 1];
 	}
 
 	Curve Curve::split(float _t0, float _t1) const
@@ -1309,14 +1480,13 @@ namespace MathAnim
 			res.type = CurveType::Bezier3;
 
 			const Vec2& p1 = as.bezier2.p1;
-			const Vec2& p2 = as.bezier2.p1;
-			const Vec2& p3 = as.bezier2.p2;
+			const Vec2& p2 = as.bezier2.p2;
 
 			// Degree elevated quadratic bezier curve
 			Vec2 pr0 = p0;
 			Vec2 pr1 = (1.0f / 3.0f) * p0 + (2.0f / 3.0f) * p1;
 			Vec2 pr2 = (2.0f / 3.0f) * p1 + (1.0f / 3.0f) * p2;
-			Vec2 pr3 = p3;
+			Vec2 pr3 = p2;
 
 			// Interpolate the curve
 			// Taken from https://stackoverflow.com/questions/878862/drawing-part-of-a-bzier-curve-by-reusing-a-basic-bzier-curve-function
@@ -1362,25 +1532,25 @@ namespace MathAnim
 		return res;
 	}
 
-	float Path::calculateApproximatePerimeter() const
-	{
-		float approxPerimeter = 0.0f;
-		for (int curvei = 0; curvei < this->numCurves; curvei++)
-		{
-			const Curve& curve = this->curves[curvei];
-			approxPerimeter += curve.calculateApproximatePerimeter();
-		}
-
-		return approxPerimeter;
-	}
-
 	void SvgObject::calculateApproximatePerimeter()
 	{
 		approximatePerimeter = 0.0f;
 
+		// Curves are stored path after path, so the lengths just keep adding up
+		// across paths
 		for (int pathi = 0; pathi < this->numPaths; pathi++)
 		{
-			approximatePerimeter += this->paths[pathi].calculateApproximatePerimeter();
+			const Path& path = this->paths[pathi];
+			for (int curvei = 0; curvei < path.numCurves; curvei++)
+			{
+				float* curveLengths = arcLengths + (path.firstCurve + curvei) * Curve::numArcLengthSamples;
+				getCurve(pathi, curvei).calculateArcLengths(curveLengths);
+				for (int samplei = 0; samplei < Curve::numArcLengthSamples; samplei++)
+				{
+					curveLengths[samplei] += approximatePerimeter;
+				}
+				approximatePerimeter = curveLengths[Curve::numArcLengthSamples - 1];
+			}
 		}
 	}
 
@@ -1397,7 +1567,7 @@ namespace MathAnim
 			{
 				for (int curvei = 0; curvei < paths[pathi].numCurves; curvei++)
 				{
-					const Curve& curve = paths[pathi].curves[curvei];
+					const Curve curve = getCurve(pathi, curvei);
 
 					switch (curve.type)
 					{
@@ -1428,197 +1598,166 @@ namespace MathAnim
 				}
 			}
 		}
+
+		calculateGeometryHash();
+	}
+
+	void SvgObject::calculateGeometryHash()
+	{
+		uint64 hash = Hash::fnv1a(&fillType, sizeof(fillType));
+		hash = Hash::fnv1a(&numPaths, sizeof(numPaths), hash);
+		for (int pathi = 0; pathi < numPaths; pathi++)
+		{
+			// The stream offsets follow from the curve counts, so they don't need hashing
+			const Path& path = paths[pathi];
+			hash = Hash::fnv1a(&path.isHole, sizeof(path.isHole), hash);
+			hash = Hash::fnv1a(&path.numCurves, sizeof(path.numCurves), hash);
+		}
+		hash = Hash::fnv1a(curveTypes, sizeof(CurveType) * numCurves, hash);
+		hash = Hash::fnv1a(points, sizeof(Vec2) * numPoints, hash);
+
+		geometryHash = hash;
 	}
 
-	void SvgObject::render(const AnimObject* parent, const Texture& texture, const Vec2& textureOffset) const
+	uint8* SvgObject::rasterize(float rasterScale, int* outWidth, int* outHeight) const
 	{
-		Vec2 bboxSize = (bbox.max - bbox.min) * parent->svgScale;
+		Vec2 bboxSize = (bbox.max - bbox.min) * rasterScale;
 
 		// Setup pluto context to render SVG to
 		plutovg_surface_t* surface = plutovg_surface_create((int)bboxSize.x, (int)bboxSize.y);
 		plutovg_t* pluto = plutovg_create(surface);
 
-		fillWithPluto(pluto, parent, this);
+		fillWithPluto(pluto, this, rasterScale);
 
-		unsigned char* pixels = plutovg_surface_get_data(surface);
 		int surfaceWidth = plutovg_surface_get_width(surface);
 		int surfaceHeight = plutovg_surface_get_height(surface);
-		texture.uploadSubImage(
-			(int)textureOffset.x,
-			(int)(texture.height - textureOffset.y - surfaceHeight),
-			surfaceWidth,
-			surfaceHeight,
-			pixels,
-			surfaceWidth * surfaceHeight * sizeof(uint8) * 4,
-			true
-		);
+		size_t pixelsSize = sizeof(uint8) * 4 * surfaceWidth * surfaceHeight;
+		uint8* pixels = (uint8*)g_memory_allocate(pixelsSize);
+		g_memory_copyMem(pixels, plutovg_surface_get_data(surface), pixelsSize);
 
 		plutovg_surface_destroy(surface);
 		plutovg_destroy(pluto);
+
+		*outWidth = surfaceWidth;
+		*outHeight = surfaceHeight;
+		return pixels;
 	}
 
 	void SvgObject::renderOutline(float t, const AnimObject* parent) const
 	{
-		renderOutline2D(t, parent, this);
+		renderOutline2D(t, parent->globalTransform, parent->strokeColor, parent->strokeWidth, this);
 	}
 
-	void SvgObject::free()
+	void SvgObject::renderOutline(float t, const glm::mat4& transform, const glm::u8vec4& strokeColor, float strokeWidth) const
 	{
-		for (int pathi = 0; pathi < numPaths; pathi++)
-		{
-			if (paths[pathi].curves)
-			{
-				g_memory_free(paths[pathi].curves);
-			}
-			paths[pathi].numCurves = 0;
-			paths[pathi].maxCapacity = 0;
-		}
+		renderOutline2D(t, transform, strokeColor, strokeWidth, this);
+	}
 
-		if (paths)
-		{
-			g_memory_free(paths);
-		}
+	void SvgObject::free()
+	{
+		Svg::releaseArena(this);
 
+		paths = nullptr;
+		points = nullptr;
+		curvePointOffsets = nullptr;
+		arcLengths = nullptr;
+		curveTypes = nullptr;
 		numPaths = 0;
+		numCurves = 0;
+		numPoints = 0;
+		maxPaths = 0;
+		maxCurves = 0;
+		maxPoints = 0;
 		approximatePerimeter = 0.0f;
 	}
 
-	static void growBufferIfNeeded(uint8** buffer, size_t* capacity, size_t numElements, size_t numElementsToAdd)
+	void SvgMorph::free()
 	{
-		if (numElements + numElementsToAdd >= *capacity)
+		if (pathNumCurves)
 		{
-			*capacity = (numElements + numElementsToAdd) * 2;
-			*buffer = (uint8*)g_memory_realloc(*buffer, *capacity);
-			g_logger_assert(*buffer != nullptr, "Ran out of RAM.");
+			g_memory_free(pathNumCurves);
+			g_memory_free(srcIsHole);
+			g_memory_free(dstIsHole);
+			g_memory_free(srcPoints);
+			g_memory_free(dstPoints);
+			g_memory_free(points);
 		}
-	}
 
-	static void writeBuffer(uint8** buffer, size_t* capacity, size_t* numElements, const char* string, size_t stringLength = 0)
-	{
-		if (stringLength == 0)
-		{
-			stringLength = std::strlen(string);
-		}
-
-		growBufferIfNeeded(buffer, capacity, *numElements, stringLength);
-		g_memory_copyMem(*buffer + *numElements, (void*)string, stringLength * sizeof(uint8));
-		*numElements += stringLength;
+		pathNumCurves = nullptr;
+		srcIsHole = nullptr;
+		dstIsHole = nullptr;
+		srcPoints = nullptr;
+		dstPoints = nullptr;
+		points = nullptr;
+		numPaths = 0;
+		numFloats = 0;
 	}
 
 	void SvgObject::serialize(RawMemory& memory) const
 	{
-		size_t numElements = 0;
-		size_t capacity = 256;
-		uint8* buffer = (uint8*)g_memory_allocate(sizeof(uint8) * capacity);
-		constexpr size_t tmpBufferSize = 256;
-		char tmpBuffer[tmpBufferSize];
-		tmpBuffer[0] = '\0';
-
-		for (int pathi = 0; pathi < numPaths; pathi++)
-		{
-			// Move to the first path point
-			Path& path = paths[pathi];
-			if (path.numCurves > 0)
-			{
-				size_t numBytesWritten = snprintf(tmpBuffer, tmpBufferSize, "M%0.6f %0.6f ", path.curves[0].p0.x, path.curves[0].p0.y);
-				g_logger_assert(numBytesWritten >= 0 && numBytesWritten < tmpBufferSize, "Tmp buffer is too small to write out.");
-				writeBuffer(&buffer, &capacity, &numElements, tmpBuffer);
-			}
-
-			for (int curvei = 0; curvei < path.numCurves; curvei++)
-			{
-				Curve& curve = path.curves[curvei];
-				switch (curve.type)
-				{
-				case CurveType::Line:
-				{
-					writeBuffer(&buffer, &capacity, &numElements, "L", 1);
-					size_t numBytesWritten = snprintf(tmpBuffer, tmpBufferSize, "%0.6f %0.6f ", curve.as.line.p1.x, curve.as.line.p1.y);
-					g_logger_assert(numBytesWritten >= 0 && numBytesWritten < tmpBufferSize, "Tmp buffer is too small to write out.");
-					writeBuffer(&buffer, &capacity, &numElements, tmpBuffer);
-				}
-				break;
-				case CurveType::Bezier2:
-				{
-					writeBuffer(&buffer, &capacity, &numElements, "Q", 1);
-					size_t numBytesWritten = snprintf(
-						tmpBuffer,
-						tmpBufferSize,
-						"%0.6f %0.6f %0.6f %0.6f ",
-						curve.as.bezier2.p1.x,
-						curve.as.bezier2.p1.y,
-						curve.as.bezier2.p2.x,
-						curve.as.bezier2.p2.y
-					);
-					g_logger_assert(numBytesWritten >= 0 && numBytesWritten < tmpBufferSize, "Tmp buffer is too small to write out.");
-					writeBuffer(&buffer, &capacity, &numElements, tmpBuffer);
-				}
-				break;
-				case CurveType::Bezier3:
-				{
-					writeBuffer(&buffer, &capacity, &numElements, "C", 1);
-					size_t numBytesWritten = snprintf(
-						tmpBuffer,
-						tmpBufferSize,
-						"%0.6f %0.6f %0.6f %0.6f %0.6f %0.6f ",
-						curve.as.bezier3.p1.x,
-						curve.as.bezier3.p1.y,
-						curve.as.bezier3.p2.x,
-						curve.as.bezier3.p2.y,
-						curve.as.bezier3.p3.x,
-						curve.as.bezier3.p3.y
-					);
-					g_logger_assert(numBytesWritten >= 0 && numBytesWritten < tmpBufferSize, "Tmp buffer is too small to write out.");
-					writeBuffer(&buffer, &capacity, &numElements, tmpBuffer);
-				}
-				break;
-				case CurveType::None:
-					break;
-				}
-			}
-		}
-
 		// fillType         -> u8
 		// fillColor        -> Vec4
-		// pathLength       -> u64
-		// path             -> u8[pathLength]
+		// numPaths         -> u32
+		// numCurves        -> u32
+		// numPoints        -> u32
+		// paths            -> { numCurves: u32, isHole: u8 }[numPaths]
+		// curveTypes       -> u8[numCurves]
+		// points           -> Vec2[numPoints]
 		memory.write<FillType>(&fillType);
 		CMath::serialize(memory, fillColor);
-		uint64 stringLength = (uint64)numElements;
-		memory.write<uint64>(&stringLength);
-		memory.writeDangerous(buffer, numElements);
 
-		g_memory_free(buffer);
+		uint32 u32NumPaths = (uint32)numPaths;
+		uint32 u32NumCurves = (uint32)numCurves;
+		uint32 u32NumPoints = (uint32)numPoints;
+		memory.write<uint32>(&u32NumPaths);
+		memory.write<uint32>(&u32NumCurves);
+		memory.write<uint32>(&u32NumPoints);
+		for (int pathi = 0; pathi < numPaths; pathi++)
+		{
+			// The stream offsets get rebuilt from the curve counts when reading
+			uint32 pathNumCurves = (uint32)paths[pathi].numCurves;
+			uint8 isHole = paths[pathi].isHole ? 1 : 0;
+			memory.write<uint32>(&pathNumCurves);
+			memory.write<uint8>(&isHole);
+		}
+
+		// The streams go out as they are in memory, so reading them back gives
+		// the exact same points and the same geometry hash
+		if (numCurves > 0)
+		{
+			memory.writeDangerous((const uint8*)curveTypes, sizeof(CurveType) * numCurves);
+		}
+		if (numPoints > 0)
+		{
+			memory.writeDangerous((const uint8*)points, sizeof(Vec2) * numPoints);
+		}
 	}
 
 	SvgObject* SvgObject::deserialize(RawMemory& memory, uint32 version)
 	{
 		SvgObject* res = (SvgObject*)g_memory_allocate(sizeof(SvgObject));
+		*res = Svg::createDefault();
 
 		// fillType         -> u8
 		// fillColor        -> Vec4
-		// pathLength       -> u64
-		// path             -> u8[pathLength]
-		memory.read<FillType>(&res->fillType);
-		res->fillColor = CMath::deserializeVec4(memory);
-		uint64 stringLength;
-		memory.read<uint64>(&stringLength);
-		uint8* string = (uint8*)g_memory_allocate(sizeof(uint8) * (stringLength + 1));
-		memory.readDangerous(string, stringLength);
-		string[stringLength] = '\0';
-
-		if (stringLength > 0)
-		{
-			if (!SvgParser::parseSvgPath((const char*)string, stringLength, res))
-			{
-				g_logger_error("Error deserializing SVG. Bad path data: '%s'", string);
-			}
-		}
-		else
+		FillType fillType;
+		memory.read<FillType>(&fillType);
+		Vec4 fillColor = CMath::deserializeVec4(memory);
+
+		// Version 1 projects stored the geometry as SVG path text
+		bool success = version == 1
+			? deserializePathTextV1(memory, res)
+			: deserializeGeometryV2(memory, res);
+		if (!success)
 		{
+			res->free();
 			*res = Svg::createDefault();
 		}
-		g_memory_free(string);
+
+		res->fillType = fillType;
+		res->fillColor = fillColor;
+		res->calculateApproximatePerimeter();
+		res->calculateBBox();
 
 		return res;
 	}
@@ -1643,47 +1782,12 @@ namespace MathAnim
 			float outputHeight = (obj.bbox.max.y - obj.bbox.min.y) / svgGroupSize.y * (svgGroupSize.y / svgGroupSize.x);
 			Vec2 hzOutputRange = Vec2{ 0.0f, outputWidth };
 			Vec2 vtOutputRange = Vec2{ 0.0f, outputHeight };
-			for (int pathi = 0; pathi < obj.numPaths; pathi++)
+			Svg::makeArenaUnique(&obj);
+			for (int pointi = 0; pointi < obj.numPoints; pointi++)
 			{
-				for (int curvei = 0; curvei < obj.paths[pathi].numCurves; curvei++)
-				{
-					Curve& curve = obj.paths[pathi].curves[curvei];
-					curve.p0.x = CMath::mapRange(hzInputRange, hzOutputRange, curve.p0.x);
-					curve.p0.y = CMath::mapRange(vtInputRange, vtOutputRange, curve.p0.y);
-
-					switch (curve.type)
-					{
-					case CurveType::Bezier3:
-					{
-						curve.as.bezier3.p1.x = CMath::mapRange(hzInputRange, hzOutputRange, curve.as.bezier3.p1.x);
-						curve.as.bezier3.p1.y = CMath::mapRange(vtInputRange, vtOutputRange, curve.as.bezier3.p1.y);
-
-						curve.as.bezier3.p2.x = CMath::mapRange(hzInputRange, hzOutputRange, curve.as.bezier3.p2.x);
-						curve.as.bezier3.p2.y = CMath::mapRange(vtInputRange, vtOutputRange, curve.as.bezier3.p2.y);
-
-						curve.as.bezier3.p3.x = CMath::mapRange(hzInputRange, hzOutputRange, curve.as.bezier3.p3.x);
-						curve.as.bezier3.p3.y = CMath::mapRange(vtInputRange, vtOutputRange, curve.as.bezier3.p3.y);
-					}
-					break;
-					case CurveType::Bezier2:
-					{
-						curve.as.bezier2.p1.x = CMath::mapRange(hzInputRange, hzOutputRange, curve.as.bezier2.p1.x);
-						curve.as.bezier2.p1.y = CMath::mapRange(vtInputRange, vtOutputRange, curve.as.bezier2.p1.y);
-
-						curve.as.bezier2.p2.x = CMath::mapRange(hzInputRange, hzOutputRange, curve.as.bezier2.p2.x);
-						curve.as.bezier2.p2.y = CMath::mapRange(vtInputRange, vtOutputRange, curve.as.bezier2.p2.y);
-					}
-					break;
-					case CurveType::Line:
-					{
-						curve.as.line.p1.x = CMath::mapRange(hzInputRange, hzOutputRange, curve.as.line.p1.x);
-						curve.as.line.p1.y = CMath::mapRange(vtInputRange, vtOutputRange, curve.as.line.p1.y);
-					}
-					break;
-					case CurveType::None:
-						break;
-					}
-				}
+				Vec2& point = obj.points[pointi];
+				point.x = CMath::mapRange(hzInputRange, hzOutputRange, point.x);
+				point.y = CMath::mapRange(vtInputRange, vtOutputRange, point.y);
 			}
 
 			Vec2 originalBboxMin = obj.bbox.min;
@@ -1795,7 +1899,7 @@ namespace MathAnim
 	}
 
 	// ------------------- Svg Object Internal functions -------------------
-	static void fillWithPluto(plutovg_t* pluto, const AnimObject* parent, const SvgObject* obj)
+	static void fillWithPluto(plutovg_t* pluto, const SvgObject* obj, float rasterScale)
 	{
 		// Can't render SVG's with 0 paths
 		if (obj->numPaths <= 0)
@@ -1805,8 +1909,8 @@ namespace MathAnim
 
 		// Instead of translating, we'll map every coordinate from the SVG min-max range to
 		// the preferred coordinate range
-		Vec2 scaledBboxMin = obj->bbox.min * parent->svgScale;
-		Vec2 scaledBboxMax = obj->bbox.max * parent->svgScale;
+		Vec2 scaledBboxMin = obj->bbox.min * rasterScale;
+		Vec2 scaledBboxMax = obj->bbox.max * rasterScale;
 		Vec2 inXRange = Vec2{ scaledBboxMin.x, scaledBboxMax.x };
 		Vec2 inYRange = Vec2{ scaledBboxMin.y, scaledBboxMax.y };
 
@@ -1823,9 +1927,9 @@ namespace MathAnim
 			if (obj->paths[pathi].numCurves > 0)
 			{
 				{
-					Vec2 p0 = obj->paths[pathi].curves[0].p0;
-					p0.x *= parent->svgScale;
-					p0.y *= parent->svgScale;
+					Vec2 p0 = obj->getPathStart(pathi);
+					p0.x *= rasterScale;
+					p0.y *= rasterScale;
 					p0.x = CMath::mapRange(inXRange, outXRange, p0.x);
 					p0.y = CMath::mapRange(inYRange, outYRange, p0.y);
 
@@ -1837,7 +1941,7 @@ namespace MathAnim
 
 				for (int curvei = 0; curvei < obj->paths[pathi].numCurves; curvei++)
 				{
-					const Curve& curve = obj->paths[pathi].curves[curvei];
+					const Curve curve = obj->getCurve(pathi, curvei);
 					Vec2 p0 = curve.p0;
 
 					switch (curve.type)
@@ -1848,18 +1952,18 @@ namespace MathAnim
 						Vec2 p2 = curve.as.bezier3.p2;
 						Vec2 p3 = curve.as.bezier3.p3;
 
-						p1.x *= parent->svgScale;
-						p1.y *= parent->svgScale;
+						p1.x *= rasterScale;
+						p1.y *= rasterScale;
 						p1.x = CMath::mapRange(inXRange, outXRange, p1.x);
 						p1.y = CMath::mapRange(inYRange, outYRange, p1.y);
 
-						p2.x *= parent->svgScale;
-						p2.y *= parent->svgScale;
+						p2.x *= rasterScale;
+						p2.y *= rasterScale;
 						p2.x = CMath::mapRange(inXRange, outXRange, p2.x);
 						p2.y = CMath::mapRange(inYRange, outYRange, p2.y);
 
-						p3.x *= parent->svgScale;
-						p3.y *= parent->svgScale;
+						p3.x *= rasterScale;
+						p3.y *= rasterScale;
 						p3.x = CMath::mapRange(inXRange, outXRange, p3.x);
 						p3.y = CMath::mapRange(inYRange, outYRange, p3.y);
 
@@ -1876,13 +1980,13 @@ namespace MathAnim
 						Vec2 p1 = curve.as.bezier2.p1;
 						Vec2 p2 = curve.as.bezier2.p2;
 
-						p1.x *= parent->svgScale;
-						p1.y *= parent->svgScale;
+						p1.x *= rasterScale;
+						p1.y *= rasterScale;
 						p1.x = CMath::mapRange(inXRange, outXRange, p1.x);
 						p1.y = CMath::mapRange(inYRange, outYRange, p1.y);
 
-						p2.x *= parent->svgScale;
-						p2.y *= parent->svgScale;
+						p2.x *= rasterScale;
+						p2.y *= rasterScale;
 						p2.x = CMath::mapRange(inXRange, outXRange, p2.x);
 						p2.y = CMath::mapRange(inYRange, outYRange, p2.y);
 
@@ -1897,8 +2001,8 @@ namespace MathAnim
 					{
 						Vec2 p1 = curve.as.line.p1;
 
-						p1.x *= parent->svgScale;
-						p1.y *= parent->svgScale;
+						p1.x *= rasterScale;
+						p1.y *= rasterScale;
 						p1.x = CMath::mapRange(inXRange, outXRange, p1.x);
 						p1.y = CMath::mapRange(inYRange, outYRange, p1.y);
 
@@ -1916,7 +2020,6 @@ namespace MathAnim
 		}
 
 		// Draw the SVG with full alpha since we apply alpha changes at the compositing level
-		const glm::u8vec4& fillColor = parent->fillColor;
 		// Render the SVG in white then color it when blitting the
 		// texture to a quad
 		plutovg_set_rgba(pluto, 1.0, 1.0, 1.0, 1.0);
@@ -1932,235 +2035,227 @@ namespace MathAnim
 		plutovg_fill_preserve(pluto);
 	}
 
-	static void renderOutline2D(float t, const AnimObject* parent, const SvgObject* obj)
+	static bool deserializePathTextV1(RawMemory& memory, SvgObject* obj)
 	{
-		constexpr float defaultStrokeWidth = 0.02f;
-
-		// Start the fade in after 80% of the svg object is drawn
-		float lengthToDraw = t * (float)obj->approximatePerimeter;
-		Vec2 svgSize = obj->bbox.max - obj->bbox.min;
-
-		Vec2 inXRange = Vec2{ obj->bbox.min.x, obj->bbox.max.x };
-		Vec2 inYRange = Vec2{ obj->bbox.min.y, obj->bbox.max.y };
-		Vec2 outXRange = Vec2{ -svgSize.x / 2.0f, svgSize.x / 2.0f };
-		Vec2 outYRange = Vec2{ svgSize.y / 2.0f, -svgSize.y / 2.0f };
-
-		if (lengthToDraw > 0 && obj->numPaths > 0)
+		// pathLength       -> u64
+		// path             -> u8[pathLength]
+		uint64 stringLength;
+		if (!memory.read<uint64>(&stringLength))
 		{
-			float lengthDrawn = 0.0f;
-
-			for (int pathi = 0; pathi < obj->numPaths; pathi++)
-			{
-				Path2DContext* context = nullptr;
-				if (obj->paths[pathi].numCurves > 0)
-				{
-					Renderer::pushColor(parent->strokeColor);
-					if (glm::epsilonEqual(parent->strokeWidth, 0.0f, 0.01f))
-					{
-						Renderer::pushStrokeWidth(defaultStrokeWidth);
-					}
-					else
-					{
-						Renderer::pushStrokeWidth(parent->strokeWidth);
-					}
-
-					{
-						Vec2 p0 = obj->paths[pathi].curves[0].p0;
-
-						p0.x = CMath::mapRange(inXRange, outXRange, p0.x);
-						p0.y = CMath::mapRange(inYRange, outYRange, p0.y);
-
-						context = Renderer::beginPath(Vec2{ p0.x, p0.y }, parent->globalTransform);
-					}
-					g_logger_assert(context != nullptr, "We have bigger problems.");
-
-					for (int curvei = 0; curvei < obj->paths[pathi].numCurves; curvei++)
-					{
-						float lengthLeft = lengthToDraw - lengthDrawn;
-						if (lengthLeft < 0.0f)
-						{
-							break;
-						}
-
-						const Curve& curve = obj->paths[pathi].curves[curvei];
-						Vec2 p0 = curve.p0;
-
-						switch (curve.type)
-						{
-						case CurveType::Bezier3:
-						{
-							Vec2 p1 = curve.as.bezier3.p1;
-							Vec2 p2 = curve.as.bezier3.p2;
-							Vec2 p3 = curve.as.bezier3.p3;
-
-							float chordLength = CMath::length(p3 - p0);
-							float controlNetLength = CMath::length(p1 - p0) + CMath::length(p2 - p1) + CMath::length(p3 - p2);
-							float approxLength = (chordLength + controlNetLength) / 2.0f;
-							lengthDrawn += approxLength;
-
-							if (lengthLeft < approxLength)
-							{
-								// Interpolate the curve
-								float percentOfCurveToDraw = lengthLeft / approxLength;
-
-								// Taken from https://stackoverflow.com/questions/878862/drawing-part-of-a-bzier-curve-by-reusing-a-basic-bzier-curve-function
-								float t0 = 0.0f;
-								float t1 = percentOfCurveToDraw;
-								float u0 = 1.0f;
-								float u1 = (1.0f - t1);
+			return false;
+		}
 
-								Vec2 q0 = ((u0 * u0 * u0) * p0) +
-									((t0 * u0 * u0 + u0 * t0 * u0 + u0 * u0 * t0) * p1) +
-									((t0 * t0 * u0 + u0 * t0 * t0 + t0 * u0 * t0) * p2) +
-									((t0 * t0 * t0) * p3);
-								Vec2 q1 = ((u0 * u0 * u1) * p0) +
-									((t0 * u0 * u1 + u0 * t0 * u1 + u0 * u0 * t1) * p1) +
-									((t0 * t0 * u1 + u0 * t0 * t1 + t0 * u0 * t1) * p2) +
-									((t0 * t0 * t1) * p3);
-								Vec2 q2 = ((u0 * u1 * u1) * p0) +
-									((t0 * u1 * u1 + u0 * t1 * u1 + u0 * u1 * t1) * p1) +
-									((t0 * t1 * u1 + u0 * t1 * t1 + t0 * u1 * t1) * p2) +
-									((t0 * t1 * t1) * p3);
-								Vec2 q3 = ((u1 * u1 * u1) * p0) +
-									((t1 * u1 * u1 + u1 * t1 * u1 + u1 * u1 * t1) * p1) +
-									((t1 * t1 * u1 + u1 * t1 * t1 + t1 * u1 * t1) * p2) +
-									((t1 * t1 * t1) * p3);
+		if (stringLength == 0)
+		{
+			return true;
+		}
 
-								p1 = q1;
-								p2 = q2;
-								p3 = q3;
-							}
+		uint8* string = (uint8*)g_memory_allocate(sizeof(uint8) * (stringLength + 1));
+		bool success = memory.readDangerous(string, stringLength);
+		string[stringLength] = '\0';
 
-							p1.x = CMath::mapRange(inXRange, outXRange, p1.x);
-							p1.y = CMath::mapRange(inYRange, outYRange, p1.y);
+		if (success && !SvgParser::parseSvgPath((const char*)string, stringLength, obj))
+		{
+			g_logger_error("Error deserializing SVG. Bad path data: '%s'", string);
+			success = false;
+		}
+		g_memory_free(string);
 
-							p2.x = CMath::mapRange(inXRange, outXRange, p2.x);
-							p2.y = CMath::mapRange(inYRange, outYRange, p2.y);
+		return success;
+	}
 
-							p3.x = CMath::mapRange(inXRange, outXRange, p3.x);
-							p3.y = CMath::mapRange(inYRange, outYRange, p3.y);
+	static bool deserializeGeometryV2(RawMemory& memory, SvgObject* obj)
+	{
+		uint32 numPaths, numCurves, numPoints;
+		if (!memory.read<uint32>(&numPaths) || !memory.read<uint32>(&numCurves) || !memory.read<uint32>(&numPoints))
+		{
+			return false;
+		}
 
-							Renderer::cubicTo(
-								context,
-								p1,
-								p2,
-								p3
-							);
-						}
-						break;
-						case CurveType::Bezier2:
-						{
-							Vec2 p1 = curve.as.bezier2.p1;
-							Vec2 p2 = curve.as.bezier2.p1;
-							Vec2 p3 = curve.as.bezier2.p2;
+		// Check the counts against what's left before allocating anything for them
+		size_t bytesLeft = memory.size - memory.offset;
+		size_t bytesNeeded = (size_t)numPaths * (sizeof(uint32) + sizeof(uint8)) +
+			(size_t)numCurves * sizeof(CurveType) +
+			(size_t)numPoints * sizeof(Vec2);
+		if (numPaths > INT32_MAX || numCurves > INT32_MAX || numPoints > INT32_MAX || bytesNeeded > bytesLeft)
+		{
+			g_logger_error("Error deserializing SVG. Geometry with %u paths, %u curves and %u points doesn't fit in the remaining %zu bytes.", numPaths, numCurves, numPoints, bytesLeft);
+			return false;
+		}
 
-							// Degree elevated quadratic bezier curve
-							Vec2 pr0 = p0;
-							Vec2 pr1 = (1.0f / 3.0f) * p0 + (2.0f / 3.0f) * p1;
-							Vec2 pr2 = (2.0f / 3.0f) * p1 + (1.0f / 3.0f) * p2;
-							Vec2 pr3 = p3;
+		Svg::reserveArena(obj, (int)numPaths, (int)numCurves, (int)numPoints);
+		for (uint32 pathi = 0; pathi < numPaths; pathi++)
+		{
+			uint32 pathNumCurves;
+			uint8 isHole;
+			memory.read<uint32>(&pathNumCurves);
+			memory.read<uint8>(&isHole);
+			obj->paths[pathi].numCurves = (int)pathNumCurves;
+			obj->paths[pathi].isHole = isHole != 0;
+		}
+		memory.readDangerous((uint8*)obj->curveTypes, sizeof(CurveType) * numCurves);
+		memory.readDangerous((uint8*)obj->points, sizeof(Vec2) * numPoints);
 
-							float chordLength = CMath::length(pr3 - pr0);
-							float controlNetLength = CMath::length(pr1 - pr0) + CMath::length(pr2 - pr1) + CMath::length(pr3 - pr2);
-							float approxLength = (chordLength + controlNetLength) / 2.0f;
-							lengthDrawn += approxLength;
+		// Walk the verbs to find where every path and curve starts in the streams
+		int curvei = 0;
+		int pointi = 0;
+		for (uint32 pathi = 0; pathi < numPaths; pathi++)
+		{
+			Path& path = obj->paths[pathi];
+			if (path.numCurves > (int)numCurves - curvei)
+			{
+				g_logger_error("Error deserializing SVG. Path %u has more curves than the SVG.", pathi);
+				return false;
+			}
 
-							if (lengthLeft < approxLength)
-							{
-								// Interpolate the curve
-								float percentOfCurveToDraw = lengthLeft / approxLength;
+			path.firstCurve = curvei;
+			path.firstPoint = pointi;
+			pointi++;
+			for (int i = 0; i < path.numCurves; i++, curvei++)
+			{
+				obj->curvePointOffsets[curvei] = pointi;
+				switch (obj->curveTypes[curvei])
+				{
+				case CurveType::Line:
+					pointi += 1;
+					break;
+				case CurveType::Bezier2:
+					pointi += 2;
+					break;
+				case CurveType::Bezier3:
+					pointi += 3;
+					break;
+				default:
+					g_logger_error("Error deserializing SVG. Unknown curve type '%d'.", (int)obj->curveTypes[curvei]);
+					return false;
+				}
+			}
+		}
 
-								p1 = (pr1 - pr0) * percentOfCurveToDraw + pr0;
-								p2 = (pr2 - pr1) * percentOfCurveToDraw + pr1;
-								p3 = (pr3 - pr2) * percentOfCurveToDraw + pr2;
+		if (curvei != (int)numCurves || pointi != (int)numPoints)
+		{
+			g_logger_error("Error deserializing SVG. The curves use %d points but %u were stored.", pointi, numPoints);
+			return false;
+		}
 
-								// Taken from https://stackoverflow.com/questions/878862/drawing-part-of-a-bzier-curve-by-reusing-a-basic-bzier-curve-function
-								float t0 = 0.0f;
-								float t1 = percentOfCurveToDraw;
-								float u0 = 1.0f;
-								float u1 = (1.0f - t1);
+		obj->numPaths = (int)numPaths;
+		obj->numCurves = (int)numCurves;
+		obj->numPoints = (int)numPoints;
+		if (numPoints > 0)
+		{
+			obj->_cursor = obj->points[numPoints - 1];
+		}
 
-								Vec2 q0 = ((u0 * u0 * u0) * p0) +
-									((t0 * u0 * u0 + u0 * t0 * u0 + u0 * u0 * t0) * p1) +
-									((t0 * t0 * u0 + u0 * t0 * t0 + t0 * u0 * t0) * p2) +
-									((t0 * t0 * t0) * p3);
-								Vec2 q1 = ((u0 * u0 * u1) * p0) +
-									((t0 * u0 * u1 + u0 * t0 * u1 + u0 * u0 * t1) * p1) +
-									((t0 * t0 * u1 + u0 * t0 * t1 + t0 * u0 * t1) * p2) +
-									((t0 * t0 * t1) * p3);
-								Vec2 q2 = ((u0 * u1 * u1) * p0) +
-									((t0 * u1 * u1 + u0 * t1 * u1 + u0 * u1 * t1) * p1) +
-									((t0 * t1 * u1 + u0 * t1 * t1 + t0 * u1 * t1) * p2) +
-									((t0 * t1 * t1) * p3);
-								Vec2 q3 = ((u1 * u1 * u1) * p0) +
-									((t1 * u1 * u1 + u1 * t1 * u1 + u1 * u1 * t1) * p1) +
-									((t1 * t1 * u1 + u1 * t1 * t1 + t1 * u1 * t1) * p2) +
-									((t1 * t1 * t1) * p3);
+		return true;
+	}
 
-								pr1 = q1;
-								pr2 = q2;
-								pr3 = q3;
-							}
+	static void renderOutline2D(float t, const glm::mat4& transform, const glm::u8vec4& strokeColor, float strokeWidth, const SvgObject* obj)
+	{
+		constexpr float defaultStrokeWidth = 0.02f;
 
-							pr1.x = CMath::mapRange(inXRange, outXRange, pr1.x);
-							pr1.y = CMath::mapRange(inYRange, outYRange, pr1.y);
+		float lengthToDraw = t * (float)obj->approximatePerimeter;
+		if (lengthToDraw <= 0.0f || obj->numCurves == 0)
+		{
+			return;
+		}
 
-							pr2.x = CMath::mapRange(inXRange, outXRange, pr2.x);
-							pr2.y = CMath::mapRange(inYRange, outYRange, pr2.y);
+		// Every curve before cutCurve gets drawn in full and cutCurve gets drawn up to cutT
+		int cutCurve = 0;
+		float cutT = 0.0f;
+		Svg::findCurveAtLength(obj->arcLengths, obj->numCurves, lengthToDraw, &cutCurve, &cutT);
 
-							pr3.x = CMath::mapRange(inXRange, outXRange, pr3.x);
-							pr3.y = CMath::mapRange(inYRange, outYRange, pr3.y);
+		Vec2 svgSize = obj->bbox.max - obj->bbox.min;
+		Vec2 inXRange = Vec2{ obj->bbox.min.x, obj->bbox.max.x };
+		Vec2 inYRange = Vec2{ obj->bbox.min.y, obj->bbox.max.y };
+		Vec2 outXRange = Vec2{ -svgSize.x / 2.0f, svgSize.x / 2.0f };
+		Vec2 outYRange = Vec2{ svgSize.y / 2.0f, -svgSize.y / 2.0f };
+		auto toOutlineSpace = [&](const Vec2& point)
+		{
+			return Vec2{
+				CMath::mapRange(inXRange, outXRange, point.x),
+				CMath::mapRange(inYRange, outYRange, point.y)
+			};
+		};
 
-							Renderer::cubicTo(
-								context,
-								pr1,
-								pr2,
-								pr3
-							);
-						}
-						break;
-						case CurveType::Line:
-						{
-							Vec2 p1 = curve.as.line.p1;
-							float curveLength = CMath::length(p1 - p0);
-							lengthDrawn += curveLength;
+		for (int pathi = 0; pathi < obj->numPaths; pathi++)
+		{
+			const Path& path = obj->paths[pathi];
+			if (path.numCurves == 0)
+			{
+				continue;
+			}
 
-							if (lengthLeft < curveLength)
-							{
-								float percentOfCurveToDraw = lengthLeft / curveLength;
-								p1 = ((p1 - p0) * percentOfCurveToDraw) + p0;
-							}
+			Renderer::pushColor(strokeColor);
+			if (glm::epsilonEqual(strokeWidth, 0.0f, 0.01f))
+			{
+				Renderer::pushStrokeWidth(defaultStrokeWidth);
+			}
+			else
+			{
+				Renderer::pushStrokeWidth(strokeWidth);
+			}
 
-							p1.x = CMath::mapRange(inXRange, outXRange, p1.x);
-							p1.y = CMath::mapRange(inYRange, outYRange, p1.y);
+			Path2DContext* context = Renderer::beginPath(toOutlineSpace(obj->getPathStart(pathi)), transform);
+			g_logger_assert(context != nullptr, "We have bigger problems.");
 
-							Renderer::lineTo(
-								context,
-								p1
-							);
-						}
-						break;
-						case CurveType::None:
-							break;
-						}
+			bool reachedCut = false;
+			for (int curvei = 0; curvei < path.numCurves; curvei++)
+			{
+				Curve curve = obj->getCurve(pathi, curvei);
+				if (path.firstCurve + curvei == cutCurve)
+				{
+					reachedCut = true;
+					if (cutT < 1.0f)
+					{
+						curve = curve.split(0.0f, cutT);
 					}
-
-					Renderer::popStrokeWidth();
-					Renderer::popColor();
 				}
 
-				if (lengthDrawn >= lengthToDraw && t < 1.0f)
+				switch (curve.type)
 				{
-					Renderer::endPath(context, false);
-					Renderer::free(context);
+				case CurveType::Bezier3:
+					Renderer::cubicTo(
+						context,
+						toOutlineSpace(curve.as.bezier3.p1),
+						toOutlineSpace(curve.as.bezier3.p2),
+						toOutlineSpace(curve.as.bezier3.p3)
+					);
+					break;
+				case CurveType::Bezier2:
+					Renderer::quadTo(
+						context,
+						toOutlineSpace(curve.as.bezier2.p1),
+						toOutlineSpace(curve.as.bezier2.p2)
+					);
+					break;
+				case CurveType::Line:
+					Renderer::lineTo(
+						context,
+						toOutlineSpace(curve.as.line.p1)
+					);
+					break;
+				case CurveType::None:
 					break;
 				}
-				else
+
+				if (reachedCut)
 				{
-					Renderer::endPath(context);
-					Renderer::free(context);
+					break;
 				}
 			}
+
+			Renderer::popStrokeWidth();
+			Renderer::popColor();
+
+			if (reachedCut && t < 1.0f)
+			{
+				Renderer::endPath(context, false);
+				Renderer::free(context);
+				break;
+			}
+
+			Renderer::endPath(context);
+			Renderer::free(context);
 		}
 	}
 }
\ No newline at end of file
@@ -6,10 +6,55 @@
 #include "renderer/Renderer.h"
 #include "renderer/GLApi.h"
 #include "utils/CMath.h"
+#include "core/Application.h"
+#include "multithreading/GlobalThreadPool.h"
 
 namespace MathAnim
 {
 	Vec2 SvgCache::cachePadding = { 10.0f, 10.0f };
+	bool SvgCache::backgroundDefragmentation = true;
+
+	// Pages whose free space is more scattered than this get repacked in the background
+	static constexpr float defragmentationThreshold = 0.5f;
+
+	// SVGs are rasterized at discrete resolutions rasterLevelStep^level times svgScale, so
+	// animating the scale of an object or zooming the camera only rasterizes it again when
+	// it crosses into a new level instead of on every frame
+	static constexpr float rasterLevelStep = 1.25f;
+	static constexpr int minRasterLevel = -10;
+	static constexpr int maxRasterLevel = 8;
+	// 1.25^3 is just under 2x
+	static constexpr int maxReusedRasterLevels = 3;
+	// 1.25^-6 is about a quarter of the resolution, which is around 6% of the pixels
+	static constexpr int placeholderRasterLevels = 6;
+
+	struct SvgRasterJob
+	{
+		uint64 key;
+		SvgObject svg;
+		float rasterScale;
+		Vec2 svgSize;
+
+		// Filled in by the worker
+		uint8* pixels;
+		int width;
+		int height;
+
+		// Guarded by rasterMtx
+		bool done;
+		// Set when the cache got cleared while the worker was still busy. The worker
+		// frees the job instead of handing it back.
+		bool abandoned;
+	};
+
+	// These outlive the cache so workers that finish after it's gone can still clean up
+	static std::mutex rasterMtx;
+	static std::condition_variable rasterCv;
+
+	// ------------- Internal Functions -------------
+	static void rasterizeTask(void* data, size_t dataSize);
+	static void freeRasterJob(SvgRasterJob* job);
+	static const Texture& getDummyTexture();
 
 	void SvgCache::init()
 	{
@@ -19,24 +64,47 @@ namespace MathAnim
 
 	void SvgCache::free()
 	{
+		abandonPendingRasters();
+		lastShownRaster.clear();
+
 		framebuffer.destroy();
-		for (size_t i = 0; i < cachedSvgs.size(); i++)
+		if (defragFramebuffer.colorAttachments.size() > 0)
 		{
-			cachedSvgs[i].clear();
+			defragFramebuffer.destroy();
 		}
-		this->cachedSvgs.clear();
+
+		diskCache.close();
+
+		cachedSvgs.clear();
+		for (size_t i = 0; i < pages.size(); i++)
+		{
+			pages[i].free();
+		}
+		pages.clear();
+		pageStats.clear();
+		pageNeedsDefrag.clear();
+	}
+
+	void SvgCache::openDiskCache(const std::string& directory)
+	{
+		diskCache.open(directory);
+	}
+
+	SvgDiskCache& SvgCache::getDiskCache()
+	{
+		return diskCache;
 	}
 
 	bool SvgCache::exists(AnimationManagerData* am, AnimObjId obj)
 	{
 		const AnimObject* animObj = AnimationManager::getObject(am, obj);
-		return existsInternal(hash(obj, animObj->svgScale, animObj->percentReplacementTransformed));
+		return findRaster(am, animObj, animObj->svgObject, nullptr).has_value();
 	}
 
 	SvgCacheEntry SvgCache::get(AnimationManagerData* am, AnimObjId obj)
 	{
 		const AnimObject* animObj = AnimationManager::getObject(am, obj);
-		auto entry = getInternal(hash(obj, animObj->svgScale, animObj->percentReplacementTransformed));
+		auto entry = findRaster(am, animObj, animObj->svgObject, nullptr);
 		if (entry.has_value())
 		{
 			return SvgCacheEntry{
@@ -46,22 +114,17 @@ namespace MathAnim
 			};
 		}
 
-		static Texture dummy = TextureBuilder()
-			.setWidth(1)
-			.setHeight(1)
-			.setFormat(ByteFormat::RGB8_UI)
-			.setMagFilter(FilterMode::Linear)
-			.setMinFilter(FilterMode::Linear)
-			.generate();
-		return SvgCacheEntry{ Vec2{0, 0}, Vec2{1, 1}, dummy };
+		return SvgCacheEntry{ Vec2{0, 0}, Vec2{1, 1}, getDummyTexture() };
 	}
 
 	SvgCacheEntry SvgCache::getOrCreateIfNotExist(AnimationManagerData* am, SvgObject* svg, AnimObjId obj)
 	{
 		const AnimObject* animObj = AnimationManager::getObject(am, obj);
-		auto entry = getInternal(hash(obj, animObj->svgScale, animObj->percentReplacementTransformed));
+		uint64 key;
+		auto entry = findOrRasterize(am, animObj, svg, obj, &key);
 		if (entry.has_value())
 		{
+			lastShownRaster[obj] = key;
 			return SvgCacheEntry{
 				entry->texCoordsMin,
 				entry->texCoordsMax,
@@ -69,140 +132,108 @@ namespace MathAnim
 			};
 		}
 
-		put(animObj, svg);
 		return get(am, obj);
 	}
 
-	void SvgCache::put(const AnimObject* parent, SvgObject* svg)
+	SvgCacheEntry SvgCache::getOrCreateIfNotExist(AnimationManagerData* am, const AnimObject* parent, SvgObject* svg)
+	{
+		uint64 key;
+		auto entry = findOrRasterize(am, parent, svg, NULL_ANIM_OBJECT, &key);
+		if (entry.has_value())
+		{
+			return SvgCacheEntry{
+				entry->texCoordsMin,
+				entry->texCoordsMax,
+				framebuffer.getColorAttachment(entry->colorAttachment)
+			};
+		}
+
+		return SvgCacheEntry{ Vec2{0, 0}, Vec2{1, 1}, getDummyTexture() };
+	}
+
+	void SvgCache::put(const AnimObject* parent, SvgObject* svg, int rasterLevel)
 	{
-		uint64 hashValue = hash(parent->id, parent->svgScale, parent->percentReplacementTransformed);
+		uint64 hashValue = hash(svg, parent->svgScale, rasterLevel);
+		float rasterScale = getRasterScale(parent->svgScale, rasterLevel);
 
 		// Only add the SVG if it hasn't already been added
-		if (!existsInternal(hashValue))
+		if (existsInternal(hashValue) || loadFromDisk(hashValue))
 		{
-			// Setup the texture coords and everything 
-			const Vec2& svgTextureOffset = cacheCurrentPos;
+			return;
+		}
 
-			// Check if the SVG cache needs to regenerate
-			float svgTotalWidth = ((svg->bbox.max.x - svg->bbox.min.x) * parent->svgScale);
-			float svgTotalHeight = ((svg->bbox.max.y - svg->bbox.min.y) * parent->svgScale);
-			if (svgTotalWidth <= 0.0f || svgTotalHeight <= 0.0f)
-			{
-				return;
-			}
+		Vec2 svgSize = (svg->bbox.max - svg->bbox.min) * rasterScale;
+		if (svgSize.x <= 0.0f || svgSize.y <= 0.0f)
+		{
+			return;
+		}
 
-			Vec2 allottedSize = Vec2{ svgTotalWidth, svgTotalHeight };
-			{
-				int newRightX = (int)(svgTextureOffset.x + svgTotalWidth + cachePadding.x);
-				if (newRightX >= framebuffer.width)
-				{
-					// Move to the newline
-					incrementCacheCurrentY();
-				}
+		int width, height;
+		uint8* pixels = svg->rasterize(rasterScale, &width, &height);
+		insertRaster(hashValue, pixels, width, height, svgSize);
+		diskCache.store(hashValue, pixels, width, height, svgSize);
+		g_memory_free(pixels);
+	}
 
-				float newBottomY = svgTextureOffset.y + svgTotalHeight + cachePadding.y;
-				if (newBottomY >= framebuffer.height)
-				{
-					growCache();
-					// TODO: FIXME
-					// Evict the first potential result from the LRU cache that
-					// can contain the size of this SVG
-					//LRUCacheEntry<uint64, _SvgCacheEntryInternal>* oldest = this->cachedSvgs[this->cacheCurrentColorAttachment].getOldest();
-					//while (oldest != nullptr)
-					//{
-					//	if (oldest->data.allottedSize.x >= svgTotalWidth && oldest->data.allottedSize.y >= svgTotalHeight)
-					//	{
-					//		allottedSize = oldest->data.allottedSize;
-
-					//		// We found an entry that will fit this 
-					//		// in the future we could evict this entry, 
-					//		// repack the texture and then insert the new svg
-					//		// but in practice this will probably be too slow
-					//		// 
-					//		// So for now I'll just "evict" then re-insert the new entry
-					//		svgTextureOffset = oldest->data.textureOffset;
-					//		if (!this->cachedSvgs[this->cacheCurrentColorAttachment].evict(oldest->key))
-					//		{
-					//			g_logger_error("Eviction failed: 0x%8x", oldest->key);
-					//		}
-					//		// The svg will get reinserted below
-					//		break;
-					//	}
-
-					//	// Try to find an entry that will fit this new SVG
-					//	oldest = oldest->next;
-					//}
-
-					//if (oldest == nullptr)
-					//{
-					//	// Didn't find room
-					//	static bool displayMessage = true;
-					//	if (displayMessage)
-					//	{
-					//		g_logger_error("Ran out of room in LRU-Cache.");
-					//		displayMessage = false;
-					//	}
-					//	return;
-					//}
-
-					//uint32 clearColor[] = { 0, 0, 0, 0 };
-					//GL::clearTexSubImage(
-					//	framebuffer.colorAttachments[this->cacheCurrentColorAttachment].graphicsId,
-					//	0,
-					//	svgTextureOffset.x, svgTextureOffset.y, 0,
-					//	allottedSize.x, allottedSize.y, 0,
-					//	GL_RGBA, GL_UNSIGNED_INT,
-					//	clearColor
-					//);
-				}
-			}
+	void SvgCache::prefetch(AnimationManagerData* am, const AnimObject* obj)
+	{
+		prefetch(am, obj, obj->svgObject);
+	}
 
-			svg->render(
-				parent,
-				framebuffer.colorAttachments[this->cacheCurrentColorAttachment],
-				svgTextureOffset
-			);
+	void SvgCache::prefetch(AnimationManagerData* am, const AnimObject* parent, const SvgObject* svg)
+	{
+		if (svg == nullptr || findRaster(am, parent, svg, nullptr).has_value())
+		{
+			return;
+		}
 
-			Vec2 cacheUvMin = Vec2{
-				svgTextureOffset.x / framebuffer.width,
-				1.0f - (svgTextureOffset.y / framebuffer.width) - (svgTotalHeight / framebuffer.height)
-			};
-			Vec2 cacheUvMax = cacheUvMin +
-				Vec2{
-					svgTotalWidth / framebuffer.width,
-					svgTotalHeight / framebuffer.height
-			};
+		int rasterLevel = getRasterLevel(am, parent, svg);
+		uint64 key = hash(svg, parent->svgScale, rasterLevel);
+		if (!loadFromDisk(key))
+		{
+			queueRaster(parent, svg, rasterLevel, key);
+		}
+	}
 
-			incrementCacheCurrentX(svgTotalWidth + cachePadding.x);
-			checkLineHeight(svgTotalHeight);
+	void SvgCache::update()
+	{
+		std::vector<SvgRasterJob*> finishedJobs;
+		{
+			std::lock_guard<std::mutex> lock(rasterMtx);
+			for (auto& [key, job] : pendingRasters)
+			{
+				if (job->done)
+				{
+					finishedJobs.push_back(job);
+				}
+			}
+		}
 
-			// Finally store the results
-			_SvgCacheEntryInternal res;
-			res.colorAttachment = cacheCurrentColorAttachment;
-			res.texCoordsMin = cacheUvMin;
-			res.texCoordsMax = cacheUvMax;
-			res.svgSize = Vec2{ svgTotalWidth, svgTotalHeight };
-			res.allottedSize = allottedSize;
-			res.textureOffset = svgTextureOffset;
-			this->cachedSvgs[this->cacheCurrentColorAttachment].insert(hashValue, res);
+		for (SvgRasterJob* job : finishedJobs)
+		{
+			finishRaster(job);
 		}
 	}
 
+	bool SvgCache::hasPendingWork() const
+	{
+		return pendingRasters.size() > 0;
+	}
+
 	void SvgCache::render(AnimationManagerData* am, SvgObject* svg, AnimObjId obj)
 	{
 		const AnimObject* parent = AnimationManager::getObject(am, obj);
 		if (parent)
 		{
 			SvgCacheEntry metadata = getOrCreateIfNotExist(am, svg, obj);
-			// TODO: See if I can get rid of this duplication, see the function above
-			float svgTotalWidth = ((svg->bbox.max.x - svg->bbox.min.x) * parent->svgScale);
-			float svgTotalHeight = ((svg->bbox.max.y - svg->bbox.min.y) * parent->svgScale);
+			// The quad always covers the SVG's bounds, whichever raster level ends up on it
+			Vec2 svgSize = svg->bbox.max - svg->bbox.min;
 
 			if (parent->is3D)
 			{
 				Renderer::drawTexturedQuad3D(
 					metadata.textureRef,
-					Vec2{ svgTotalWidth / parent->svgScale, svgTotalHeight / parent->svgScale },
+					svgSize,
 					metadata.texCoordsMin,
 					metadata.texCoordsMax,
 					parent->globalTransform,
@@ -213,7 +244,7 @@ namespace MathAnim
 			{
 				Renderer::drawTexturedQuad(
 					metadata.textureRef,
-					Vec2{ svgTotalWidth / parent->svgScale, svgTotalHeight / parent->svgScale },
+					svgSize,
 					metadata.texCoordsMin,
 					metadata.texCoordsMax,
 					Vec4{
@@ -229,20 +260,67 @@ namespace MathAnim
 		}
 	}
 
+	void SvgCache::defragmentStep()
+	{
+		if (!backgroundDefragmentation)
+		{
+			return;
+		}
+
+		// Only pages that lost entries since they were last packed can be fragmented
+		int worstPage = -1;
+		float worstFragmentation = defragmentationThreshold;
+		for (size_t i = 0; i < pages.size(); i++)
+		{
+			if (!pageNeedsDefrag[i])
+			{
+				continue;
+			}
+
+			float fragmentation = pages[i].fragmentation();
+			if (fragmentation > worstFragmentation)
+			{
+				worstPage = (int)i;
+				worstFragmentation = fragmentation;
+			}
+		}
+
+		if (worstPage >= 0)
+		{
+			defragmentPage(worstPage);
+		}
+	}
+
 	const Framebuffer& SvgCache::getFramebuffer()
 	{
 		return framebuffer;
 	}
 
+	int SvgCache::getNumPages() const
+	{
+		return (int)pages.size();
+	}
+
+	SvgCachePageStats SvgCache::getPageStats(int page) const
+	{
+		g_logger_assert(page >= 0 && page < (int)pages.size(), "SVG cache page %d out of bounds.", page);
+
+		SvgCachePageStats res = pageStats[page];
+		res.occupancy = pages[page].occupancy();
+		res.fragmentation = pages[page].fragmentation();
+		res.numEntries = pages[page].numAllocations;
+		return res;
+	}
+
 	void SvgCache::clearAll()
 	{
-		cacheCurrentPos.x = 0;
-		cacheCurrentPos.y = 0;
-		cacheCurrentColorAttachment = 0;
-		cacheLineHeight = 0;
-		for (size_t i = 0; i < cachedSvgs.size(); i++)
+		abandonPendingRasters();
+		lastShownRaster.clear();
+		cachedSvgs.clear();
+		for (size_t i = 0; i < pages.size(); i++)
 		{
-			cachedSvgs[i].clear();
+			pages[i].clear();
+			pageNeedsDefrag[i] = false;
 		}
 
 		GL::pushDebugGroup(GL_DEBUG_SOURCE_APPLICATION, 0, -1, "SVG_Cache_Reset");
@@ -259,57 +337,167 @@ namespace MathAnim
 	}
 
 	// --------------------- Private ---------------------
-	void SvgCache::incrementCacheCurrentY()
+	bool SvgCache::allocate(int32 width, int32 height, PackedRect* outRect, int* outPage)
 	{
-		cacheCurrentPos.y += cacheLineHeight + cachePadding.y;
-		cacheLineHeight = 0;
-		cacheCurrentPos.x = 0;
-	}
+		for (size_t i = 0; i < pages.size(); i++)
+		{
+			if (pages[i].allocate(width, height, outRect))
+			{
+				*outPage = (int)i;
+				return true;
+			}
+		}
 
-	void SvgCache::incrementCacheCurrentX(float distance)
-	{
-		cacheCurrentPos.x += distance;
+		return false;
 	}
 
-	void SvgCache::checkLineHeight(float newLineHeight)
+	int SvgCache::evictOldest()
 	{
-		cacheLineHeight = glm::max(cacheLineHeight, newLineHeight);
+		LRUCacheEntry<uint64, _SvgCacheEntryInternal>* oldest = cachedSvgs.getOldest();
+		if (oldest == nullptr)
+		{
+			return -1;
+		}
+
+		int page = oldest->data.colorAttachment;
+		pages[page].release(oldest->data.allottedRect);
+		pageStats[page].numEvictions++;
+		pageNeedsDefrag[page] = true;
+		if (!cachedSvgs.evict(oldest->key))
+		{
+			g_logger_error("Eviction failed: 0x%8x", oldest->key);
+		}
+
+		return page;
 	}
 
-	void SvgCache::growCache()
+	void SvgCache::clearRect(int page, const PackedRect& rect)
 	{
-		// TODO: This should just add a new color attachment
-		cacheCurrentColorAttachment = (cacheCurrentColorAttachment + 1) % framebuffer.colorAttachments.size();
-		this->cachedSvgs[cacheCurrentColorAttachment].clear();
-		this->cacheCurrentPos = Vec2{ 0, 0 };
+		framebuffer.bind();
+		GL::enable(GL_SCISSOR_TEST);
+		// Rects are stored top down like the texture offsets, GL wants them bottom up
+		GL::scissor(rect.x, framebuffer.height - rect.y - rect.height, rect.width, rect.height);
+		framebuffer.clearColorAttachmentRgba(page, "#00000000"_hex);
+		GL::disable(GL_SCISSOR_TEST);
 	}
 
-	std::optional<_SvgCacheEntryInternal> SvgCache::getInternal(uint64 hash)
+	void SvgCache::defragmentPage(int page)
 	{
-		for (size_t i = 0; i < cachedSvgs.size(); i++)
+		GL::pushDebugGroup(GL_DEBUG_SOURCE_APPLICATION, 0, -1, "SVG_Cache_Defragment");
+
+		if (defragFramebuffer.colorAttachments.size() == 0)
 		{
-			const auto& res = cachedSvgs[(cacheCurrentColorAttachment + i) % cachedSvgs.size()].get(hash);
-			if (res.has_value())
+			Texture scratchTexture = TextureBuilder()
+				.setFormat(ByteFormat::RGBA8_UI)
+				.setMinFilter(FilterMode::Nearest)
+				.setMagFilter(FilterMode::Nearest)
+				.setWidth(framebuffer.width)
+				.setHeight(framebuffer.height)
+				.build();
+			defragFramebuffer = FramebufferBuilder(framebuffer.width, framebuffer.height)
+				.addColorAttachment(scratchTexture)
+				.generate();
+		}
+
+		// Copy the page out so the entries can be copied back in their new spots
+		GL::bindFramebuffer(GL_READ_FRAMEBUFFER, framebuffer.fbo);
+		GL::readBuffer(GL_COLOR_ATTACHMENT0 + page);
+		GL::bindFramebuffer(GL_DRAW_FRAMEBUFFER, defragFramebuffer.fbo);
+		GL::blitFramebuffer(
+			0, 0, framebuffer.width, framebuffer.height,
+			0, 0, framebuffer.width, framebuffer.height,
+			GL_COLOR_BUFFER_BIT, GL_NEAREST
+		);
+
+		// Tallest first packs the tightest
+		std::vector<LRUCacheEntry<uint64, _SvgCacheEntryInternal>*> entries;
+		for (auto* entry = cachedSvgs.getOldest(); entry != nullptr; entry = entry->next)
+		{
+			if (entry->data.colorAttachment == page)
 			{
-				return res;
+				entries.push_back(entry);
 			}
 		}
+		std::sort(entries.begin(), entries.end(), [](const auto* a, const auto* b)
+			{
+				if (a->data.allottedRect.height != b->data.allottedRect.height)
+				{
+					return a->data.allottedRect.height > b->data.allottedRect.height;
+				}
+				return a->data.allottedRect.width > b->data.allottedRect.width;
+			});
 
-		return std::nullopt;
-	}
+		pages[page].clear();
+		clearRect(page, PackedRect{ 0, 0, framebuffer.width, framebuffer.height });
 
-	bool SvgCache::existsInternal(uint64 hash)
-	{
-		for (size_t i = 0; i < cachedSvgs.size(); i++)
+		// Blits write to every draw buffer, so only leave this page bound while copying
+		GLenum pageAttachment = GL_COLOR_ATTACHMENT0 + page;
+		GL::bindFramebuffer(GL_READ_FRAMEBUFFER, defragFramebuffer.fbo);
+		GL::readBuffer(GL_COLOR_ATTACHMENT0);
+		GL::bindFramebuffer(GL_DRAW_FRAMEBUFFER, framebuffer.fbo);
+		GL::drawBuffers(1, &pageAttachment);
+
+		std::vector<uint64> entriesThatDidNotFit;
+		for (auto* entry : entries)
 		{
-			const auto& res = cachedSvgs[(cacheCurrentColorAttachment + i) % cachedSvgs.size()].get(hash);
-			if (res.has_value())
+			const PackedRect oldRect = entry->data.allottedRect;
+			PackedRect newRect;
+			if (!pages[page].allocate(oldRect.width, oldRect.height, &newRect))
 			{
-				return true;
+				entriesThatDidNotFit.push_back(entry->key);
+				continue;
 			}
+
+			GL::blitFramebuffer(
+				oldRect.x, framebuffer.height - oldRect.y - oldRect.height, oldRect.x + oldRect.width, framebuffer.height - oldRect.y,
+				newRect.x, framebuffer.height - newRect.y - newRect.height, newRect.x + newRect.width, framebuffer.height - newRect.y,
+				GL_COLOR_BUFFER_BIT, GL_NEAREST
+			);
+
+			entry->data.allottedRect = newRect;
+			updateTexCoords(entry->data);
 		}
 
-		return false;
+		static GLenum colorBufferAttachments[8] = { GL_COLOR_ATTACHMENT0, GL_COLOR_ATTACHMENT1, GL_COLOR_ATTACHMENT2, GL_COLOR_ATTACHMENT3, GL_COLOR_ATTACHMENT4, GL_COLOR_ATTACHMENT5, GL_COLOR_ATTACHMENT6, GL_COLOR_ATTACHMENT7 };
+		GL::drawBuffers((GLsizei)framebuffer.colorAttachments.size(), colorBufferAttachments);
+		GL::bindFramebuffer(GL_FRAMEBUFFER, 0);
+
+		// Packing order changed, so in rare cases an entry won't fit anymore. It just
+		// gets rasterized again the next time it's needed.
+		for (uint64 key : entriesThatDidNotFit)
+		{
+			cachedSvgs.evict(key);
+			pageStats[page].numEvictions++;
+		}
+
+		pageStats[page].numDefragmentations++;
+		pageNeedsDefrag[page] = false;
+
+		GL::popDebugGroup();
+	}
+
+	void SvgCache::updateTexCoords(_SvgCacheEntryInternal& entry) const
+	{
+		// The texture is stored upside down, so flip the offset to get the bottom left UV
+		entry.texCoordsMin = Vec2{
+			(float)entry.allottedRect.x / framebuffer.width,
+			1.0f - ((float)entry.allottedRect.y / framebuffer.height) - (entry.svgSize.y / framebuffer.height)
+		};
+		entry.texCoordsMax = entry.texCoordsMin +
+			Vec2{
+				entry.svgSize.x / framebuffer.width,
+				entry.svgSize.y / framebuffer.height
+		};
+	}
+
+	std::optional<_SvgCacheEntryInternal> SvgCache::getInternal(uint64 hash)
+	{
+		return cachedSvgs.get(hash);
+	}
+
+	bool SvgCache::existsInternal(uint64 hash)
+	{
+		return cachedSvgs.exists(hash);
 	}
 
 	void SvgCache::generateDefaultFramebuffer(uint32 width, uint32 height)
@@ -329,8 +517,7 @@ namespace MathAnim
 			.setWidth(width)
 			.setHeight(height)
 			.build();
-		// Add four cached textures and increment through them
-		// for more space when "growing" the svg cache
+		// Add four cached textures, each one is a separate page of the atlas
 		framebuffer = FramebufferBuilder(width, height)
 			.addColorAttachment(cacheTexture)
 			.addColorAttachment(cacheTexture)
@@ -338,21 +525,373 @@ namespace MathAnim
 			.addColorAttachment(cacheTexture)
 			.includeDepthStencil()
 			.generate();
-		// Push back four caches since we have four color attachments
-		cachedSvgs.push_back({});
-		cachedSvgs.push_back({});
-		cachedSvgs.push_back({});
-		cachedSvgs.push_back({});
+		// Every color attachment is a page with its own packer
+		for (size_t i = 0; i < framebuffer.colorAttachments.size(); i++)
+		{
+			RectPacker packer;
+			packer.init(width, height);
+			pages.push_back(packer);
+			pageStats.push_back(SvgCachePageStats{ 0.0f, 0.0f, 0, 0, 0 });
+			pageNeedsDefrag.push_back(false);
+		}
+	}
+
+	void SvgCache::insertRaster(uint64 key, const uint8* pixels, int width, int height, const Vec2& svgSize)
+	{
+		// The padding keeps linear filtering from bleeding neighbouring SVGs into this one
+		int32 rectWidth = (int32)glm::ceil(svgSize.x + cachePadding.x);
+		int32 rectHeight = (int32)glm::ceil(svgSize.y + cachePadding.y);
+		if (rectWidth > framebuffer.width || rectHeight > framebuffer.height)
+		{
+			g_logger_warning("SVG of size %dx%d is too big for the SVG cache, pages are %dx%d.",
+				rectWidth, rectHeight, framebuffer.width, framebuffer.height);
+			return;
+		}
+
+		PackedRect rect;
+		int page;
+		if (!allocate(rectWidth, rectHeight, &rect, &page))
+		{
+			// Evict the least recently used SVGs one at a time until one of the holes they
+			// leave behind is big enough. Since the SVG fits on an empty page, this always
+			// succeeds eventually.
+			page = -1;
+			int evictedPage;
+			while ((evictedPage = evictOldest()) >= 0)
+			{
+				if (pages[evictedPage].allocate(rectWidth, rectHeight, &rect))
+				{
+					page = evictedPage;
+					break;
+				}
+			}
+
+			if (page < 0)
+			{
+				g_logger_error("Ran out of room in the SVG cache.");
+				return;
+			}
+		}
+
+		// The rect may still hold pixels from whatever got evicted there
+		clearRect(page, rect);
+		const Texture& texture = framebuffer.colorAttachments[page];
+		texture.uploadSubImage(
+			rect.x,
+			texture.height - rect.y - height,
+			width,
+			height,
+			(uint8*)pixels,
+			sizeof(uint8) * 4 * width * height,
+			true
+		);
+
+		// Finally store the results
+		_SvgCacheEntryInternal res;
+		res.colorAttachment = page;
+		res.svgSize = svgSize;
+		res.allottedRect = rect;
+		updateTexCoords(res);
+		this->cachedSvgs.insert(key, res);
+	}
+
+	bool SvgCache::loadFromDisk(uint64 key)
+	{
+		int width, height;
+		Vec2 svgSize;
+		const uint8* pixels = diskCache.find(key, &width, &height, &svgSize);
+		if (pixels == nullptr)
+		{
+			return false;
+		}
+
+		insertRaster(key, pixels, width, height, svgSize);
+		return existsInternal(key);
+	}
+
+	SvgRasterJob* SvgCache::queueRaster(const AnimObject* parent, const SvgObject* svg, int rasterLevel, uint64 key)
+	{
+		auto iter = pendingRasters.find(key);
+		if (iter != pendingRasters.end())
+		{
+			return iter->second;
+		}
+
+		float rasterScale = getRasterScale(parent->svgScale, rasterLevel);
+		Vec2 svgSize = (svg->bbox.max - svg->bbox.min) * rasterScale;
+		if (svgSize.x <= 0.0f || svgSize.y <= 0.0f)
+		{
+			return nullptr;
+		}
+
+		// The worker gets its own copy of the geometry since the object's SVG can be
+		// modified or freed before the raster is done
+		SvgRasterJob* job = (SvgRasterJob*)g_memory_allocate(sizeof(SvgRasterJob));
+		job->key = key;
+		job->svg = Svg::createDefault();
+		Svg::copy(&job->svg, svg);
+		job->svg.bbox = svg->bbox;
+		job->rasterScale = rasterScale;
+		job->svgSize = svgSize;
+		job->pixels = nullptr;
+		job->width = 0;
+		job->height = 0;
+		job->done = false;
+		job->abandoned = false;
+		pendingRasters[key] = job;
+
+		Application::threadPool()->queueTask(
+			rasterizeTask,
+			"Rasterize SVG",
+			job,
+			sizeof(SvgRasterJob)
+		);
+
+		return job;
+	}
+
+	bool SvgCache::isRasterDone(SvgRasterJob* job) const
+	{
+		std::lock_guard<std::mutex> lock(rasterMtx);
+		return job->done;
+	}
+
+	void SvgCache::waitForRaster(SvgRasterJob* job) const
+	{
+		std::unique_lock<std::mutex> lock(rasterMtx);
+		rasterCv.wait(lock, [job] { return job->done; });
 	}
 
-	uint64 SvgCache::hash(AnimObjId obj, float svgScale, float replacementTransform)
+	void SvgCache::finishRaster(SvgRasterJob* job)
 	{
-		uint64 hash = obj;
+		pendingRasters.erase(job->key);
+		if (!existsInternal(job->key))
+		{
+			insertRaster(job->key, job->pixels, job->width, job->height, job->svgSize);
+			diskCache.store(job->key, job->pixels, job->width, job->height, job->svgSize);
+		}
+		freeRasterJob(job);
+	}
+
+	void SvgCache::abandonPendingRasters()
+	{
+		std::lock_guard<std::mutex> lock(rasterMtx);
+		for (auto& [key, job] : pendingRasters)
+		{
+			if (job->done)
+			{
+				freeRasterJob(job);
+			}
+			else
+			{
+				// The worker cleans up after itself once it's done
+				job->abandoned = true;
+			}
+		}
+		pendingRasters.clear();
+	}
+
+	std::optional<_SvgCacheEntryInternal> SvgCache::findOrRasterize(AnimationManagerData* am, const AnimObject* parent, SvgObject* svg, AnimObjId lastShownId, uint64* outKey)
+	{
+		auto entry = findRaster(am, parent, svg, outKey);
+		if (entry.has_value())
+		{
+			return entry;
+		}
+
+		int rasterLevel = getRasterLevel(am, parent, svg);
+		uint64 key = hash(svg, parent->svgScale, rasterLevel);
+		SvgRasterJob* job = nullptr;
+		if (loadFromDisk(key))
+		{
+			entry = getInternal(key);
+		}
+		else
+		{
+			job = queueRaster(parent, svg, rasterLevel, key);
+		}
+
+		if (job)
+		{
+			// Exports have to come out the same every time, so they wait for the real
+			// raster. Everything else this frame needs was already queued by prefetch
+			// and keeps rasterizing on the other workers in the meantime.
+			if (Application::isExportingVideo())
+			{
+				waitForRaster(job);
+			}
+
+			if (isRasterDone(job))
+			{
+				finishRaster(job);
+				entry = getInternal(key);
+			}
+		}
+
+		if (!entry.has_value())
+		{
+			return getPlaceholder(parent, svg, rasterLevel, lastShownId, outKey);
+		}
+
+		*outKey = key;
+		return entry;
+	}
+
+	std::optional<_SvgCacheEntryInternal> SvgCache::getPlaceholder(const AnimObject* parent, SvgObject* svg, int rasterLevel, AnimObjId lastShownId, uint64* outKey)
+	{
+		// Keep showing whatever this object showed last until the new raster is ready
+		auto lastIter = lastShownRaster.find(lastShownId);
+		if (lastIter != lastShownRaster.end())
+		{
+			auto entry = getInternal(lastIter->second);
+			if (entry.has_value())
+			{
+				*outKey = lastIter->second;
+				return entry;
+			}
+		}
+
+		// Nothing to fall back on, so rasterize a low resolution version right away. It's
+		// a small fraction of the pixels, so it doesn't cause the hitch the full one would.
+		int placeholderLevel = glm::max(rasterLevel - placeholderRasterLevels, minRasterLevel);
+		uint64 placeholderKey = hash(svg, parent->svgScale, placeholderLevel);
+		put(parent, svg, placeholderLevel);
+		*outKey = placeholderKey;
+		return getInternal(placeholderKey);
+	}
+
+	std::optional<_SvgCacheEntryInternal> SvgCache::findRaster(AnimationManagerData* am, const AnimObject* parent, const SvgObject* svg, uint64* outKey)
+	{
+		if (svg == nullptr)
+		{
+			return std::nullopt;
+		}
+
+		// Linear filtering handles minifying by up to 2x without visible aliasing, so a
+		// slightly bigger raster that's already in the cache is just as good as a new one.
+		// This is what keeps a shrinking object from rasterizing again on every level.
+		int rasterLevel = getRasterLevel(am, parent, svg);
+		int largestLevel = glm::min(rasterLevel + maxReusedRasterLevels, maxRasterLevel);
+		for (int level = rasterLevel; level <= largestLevel; level++)
+		{
+			uint64 key = hash(svg, parent->svgScale, level);
+			auto entry = getInternal(key);
+			if (entry.has_value())
+			{
+				if (outKey)
+				{
+					*outKey = key;
+				}
+				return entry;
+			}
+		}
+
+		return std::nullopt;
+	}
+
+	int SvgCache::getRasterLevel(AnimationManagerData* am, const AnimObject* parent, const SvgObject* svg) const
+	{
+		// svgScale is the resolution at a scale of 1 through an unzoomed camera. Scale
+		// that by how big the object actually ends up on screen.
+		float onScreenScale = glm::max(
+			glm::length(glm::vec3(parent->globalTransform[0])),
+			glm::length(glm::vec3(parent->globalTransform[1]))
+		);
+		if (!parent->is3D)
+		{
+			const AnimObject* camera = AnimationManager::getActiveOrthoCamera(am);
+			if (camera && camera->as.camera.camera2D.zoom > 0.0f)
+			{
+				onScreenScale /= camera->as.camera.camera2D.zoom;
+			}
+		}
+
+		if (onScreenScale <= 0.0f || !std::isfinite(onScreenScale))
+		{
+			return 0;
+		}
+
+		// Round up to the next level so the raster is never blurrier than the screen. The
+		// epsilon keeps float noise from bumping an unscaled object up a level.
+		constexpr float levelEpsilon = 0.001f;
+		int rasterLevel = (int)glm::ceil(glm::log(onScreenScale) / glm::log(rasterLevelStep) - levelEpsilon);
+		rasterLevel = glm::clamp(rasterLevel, minRasterLevel, maxRasterLevel);
+
+		// Step down until the raster fits on a page
+		if (svg)
+		{
+			Vec2 svgSize = svg->bbox.max - svg->bbox.min;
+			while (rasterLevel > minRasterLevel)
+			{
+				float rasterScale = getRasterScale(parent->svgScale, rasterLevel);
+				if (svgSize.x * rasterScale + cachePadding.x <= (float)framebuffer.width &&
+					svgSize.y * rasterScale + cachePadding.y <= (float)framebuffer.height)
+				{
+					break;
+				}
+				rasterLevel--;
+			}
+		}
+
+		return rasterLevel;
+	}
+
+	float SvgCache::getRasterScale(float svgScale, int rasterLevel)
+	{
+		return svgScale * glm::pow(rasterLevelStep, (float)rasterLevel);
+	}
+
+	uint64 SvgCache::hash(const SvgObject* svg, float svgScale, int rasterLevel)
+	{
+		// Rasters only depend on the shape and the resolution, so every object with the
+		// same geometry shares them. The fill color is applied when the quad is drawn.
+		uint64 hash = svg->geometryHash;
 		// Only hash floating point numbers to 3 decimal places
-		int roundedSvgScale = (int)(svgScale * 1000.0f);
-		hash = CMath::combineHash<int>(roundedSvgScale, hash);
-		int roundedTransform = (int)(replacementTransform * 100.0f);
-		hash = CMath::combineHash<int>(roundedTransform, hash);
+		int roundedRasterScale = (int)(getRasterScale(svgScale, rasterLevel) * 1000.0f);
+		hash = CMath::combineHash<int>(roundedRasterScale, hash);
 		return hash;
 	}
+
+	// ------------- Internal Functions -------------
+	static void rasterizeTask(void* data, size_t dataSize)
+	{
+		g_logger_assert(dataSize == sizeof(SvgRasterJob), "Invalid SVG raster job.");
+		SvgRasterJob* job = (SvgRasterJob*)data;
+
+		uint8* pixels = job->svg.rasterize(job->rasterScale, &job->width, &job->height);
+
+		{
+			std::lock_guard<std::mutex> lock(rasterMtx);
+			job->pixels = pixels;
+			job->done = true;
+			if (job->abandoned)
+			{
+				freeRasterJob(job);
+				return;
+			}
+		}
+		rasterCv.notify_all();
+	}
+
+	static void freeRasterJob(SvgRasterJob* job)
+	{
+		if (job->pixels)
+		{
+			g_memory_free(job->pixels);
+		}
+		job->svg.free();
+		g_memory_free(job);
+	}
+
+	static const Texture& getDummyTexture()
+	{
+		static Texture dummy = TextureBuilder()
+			.setWidth(1)
+			.setHeight(1)
+			.setFormat(ByteFormat::RGB8_UI)
+			.setMagFilter(FilterMode::Linear)
+			.setMinFilter(FilterMode::Linear)
+			.generate();
+		return dummy;
+	}
 }
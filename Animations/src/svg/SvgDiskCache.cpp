@@ -0,0 +1,508 @@
+#include "svg/SvgDiskCache.h"
+#include "platform/Platform.h"
+
+namespace MathAnim
+{
+	uint64 SvgDiskCache::sizeBudget = 512ull * 1024ull * 1024ull;
+
+	// Big enough for the largest raster the SVG cache can hold, 4096x4096 RGBA
+	static constexpr uint64 maxPageSize = 64ull * 1024ull * 1024ull;
+	static constexpr uint32 indexMagic = 0x43475653; // "SVGC"
+	// Bump this whenever the index layout or the way cache keys are hashed changes
+	static constexpr uint32 indexVersion = 2;
+	static constexpr uint64 bytesPerPixel = 4;
+
+	void SvgDiskCache::open(const std::string& inDirectory)
+	{
+		if (isOpen())
+		{
+			close();
+		}
+
+		directory = inDirectory;
+		if (directory.size() > 0 && directory.back() != '/' && directory.back() != '\\')
+		{
+			directory += "/";
+		}
+
+		std::error_code err;
+		std::filesystem::create_directories(directory, err);
+		if (err)
+		{
+			g_logger_warning("Could not create SVG disk cache directory '%s': %s", directory.c_str(), err.message().c_str());
+			directory.clear();
+			return;
+		}
+
+		lock = Platform::tryLockFile((directory + "lock").c_str());
+		if (!lock)
+		{
+			g_logger_info("SVG disk cache '%s' is in use by another process, opening it read only.", directory.c_str());
+		}
+
+		if (!loadIndex())
+		{
+			entries.clear();
+			pages.clear();
+			nextPageId = 0;
+			session = 0;
+		}
+		session++;
+		indexDirty = false;
+
+		if (!isReadOnly())
+		{
+			deleteOrphanedPages();
+			trim(sizeBudget);
+		}
+	}
+
+	void SvgDiskCache::close()
+	{
+		if (!isOpen())
+		{
+			return;
+		}
+
+		if (!isReadOnly())
+		{
+			sealWritePage();
+			if (indexDirty)
+			{
+				saveIndex();
+			}
+		}
+
+		for (SvgDiskCachePage& page : pages)
+		{
+			Platform::unmapFile(page.mapping);
+			page.mapping = nullptr;
+		}
+		pages.clear();
+		entries.clear();
+		scratchPixels.clear();
+		scratchPixels.shrink_to_fit();
+
+		Platform::unlockFile(lock);
+		lock = nullptr;
+		directory.clear();
+	}
+
+	bool SvgDiskCache::isOpen() const
+	{
+		return directory.size() > 0;
+	}
+
+	bool SvgDiskCache::isReadOnly() const
+	{
+		return lock == nullptr;
+	}
+
+	const uint8* SvgDiskCache::find(uint64 key, int* outWidth, int* outHeight, Vec2* outSvgSize)
+	{
+		auto iter = entries.find(key);
+		if (iter == entries.end())
+		{
+			return nullptr;
+		}
+
+		SvgDiskCacheEntry& entry = iter->second;
+		int pageIndex = findPage(entry.page);
+		size_t numBytes = (size_t)entry.width * (size_t)entry.height * bytesPerPixel;
+		const uint8* res = nullptr;
+		if (pageIndex >= 0 && pageIndex == writePage)
+		{
+			// The page is still growing, so read it the normal way instead of mapping it
+			scratchPixels.resize(numBytes);
+			fflush(writeFile);
+			if (fseek(writeFile, (long)entry.offset, SEEK_SET) == 0 &&
+				fread(scratchPixels.data(), numBytes, 1, writeFile) == 1)
+			{
+				res = scratchPixels.data();
+			}
+			fseek(writeFile, 0, SEEK_END);
+		}
+		else if (pageIndex >= 0)
+		{
+			SvgDiskCachePage& page = pages[pageIndex];
+			if (page.mapping == nullptr)
+			{
+				page.mapping = Platform::memoryMapFile(pageFilename(page.id).c_str());
+			}
+
+			if (page.mapping && entry.offset + numBytes <= page.mapping->dataSize)
+			{
+				res = page.mapping->data + entry.offset;
+			}
+		}
+
+		if (res == nullptr)
+		{
+			g_logger_warning("SVG disk cache entry 0x%llx could not be read, dropping it.", (unsigned long long)key);
+			entries.erase(iter);
+			indexDirty = true;
+			return nullptr;
+		}
+
+		entry.lastUsed = session;
+		pages[pageIndex].lastUsed = session;
+		indexDirty = true;
+
+		*outWidth = (int)entry.width;
+		*outHeight = (int)entry.height;
+		*outSvgSize = entry.svgSize;
+		return res;
+	}
+
+	void SvgDiskCache::store(uint64 key, const uint8* pixels, int width, int height, const Vec2& svgSize)
+	{
+		if (!isOpen() || isReadOnly() || entries.find(key) != entries.end())
+		{
+			return;
+		}
+
+		size_t numBytes = (size_t)width * (size_t)height * bytesPerPixel;
+		if (numBytes == 0 || numBytes > maxPageSize)
+		{
+			return;
+		}
+
+		if (writePage >= 0 && pages[writePage].size + numBytes > maxPageSize)
+		{
+			sealWritePage();
+		}
+
+		if (writePage < 0)
+		{
+			uint32 id = nextPageId++;
+			std::string filename = pageFilename(id);
+			writeFile = fopen(filename.c_str(), "w+b");
+			if (!writeFile)
+			{
+				g_logger_error("Could not create SVG disk cache page '%s'.", filename.c_str());
+				return;
+			}
+
+			pages.push_back(SvgDiskCachePage{ id, 0, session, nullptr });
+			writePage = (int)pages.size() - 1;
+		}
+
+		SvgDiskCachePage& page = pages[writePage];
+		if (fwrite(pixels, numBytes, 1, writeFile) != 1)
+		{
+			g_logger_error("Failed to write SVG to disk cache page '%s'.", pageFilename(page.id).c_str());
+			// Put the cursor back so a partial write gets overwritten by the next one
+			fseek(writeFile, (long)page.size, SEEK_SET);
+			return;
+		}
+
+		entries[key] = SvgDiskCacheEntry{ key, page.id, (uint32)width, (uint32)height, svgSize, page.size, session };
+		page.size += numBytes;
+		page.lastUsed = session;
+		indexDirty = true;
+
+		if (getSizeOnDisk() > sizeBudget)
+		{
+			trim(sizeBudget);
+		}
+	}
+
+	void SvgDiskCache::trim(uint64 budget)
+	{
+		if (!isOpen() || isReadOnly())
+		{
+			return;
+		}
+
+		uint64 sizeOnDisk = getSizeOnDisk();
+		while (sizeOnDisk > budget)
+		{
+			// Pages are only deleted as a whole. Entries are appended in the order they
+			// were rasterized, so everything on a page tends to get used together anyways.
+			int oldest = -1;
+			for (int i = 0; i < (int)pages.size(); i++)
+			{
+				if (i == writePage)
+				{
+					continue;
+				}
+
+				if (oldest < 0 || pages[i].lastUsed < pages[oldest].lastUsed ||
+					(pages[i].lastUsed == pages[oldest].lastUsed && pages[i].id < pages[oldest].id))
+				{
+					oldest = i;
+				}
+			}
+
+			if (oldest < 0)
+			{
+				break;
+			}
+
+			sizeOnDisk -= pages[oldest].size;
+			deletePage(oldest);
+		}
+	}
+
+	void SvgDiskCache::clear()
+	{
+		if (!isOpen() || isReadOnly())
+		{
+			return;
+		}
+
+		sealWritePage();
+		while (pages.size() > 0)
+		{
+			deletePage((int)pages.size() - 1);
+		}
+		saveIndex();
+	}
+
+	uint64 SvgDiskCache::getSizeOnDisk() const
+	{
+		uint64 res = 0;
+		for (const SvgDiskCachePage& page : pages)
+		{
+			res += page.size;
+		}
+		return res;
+	}
+
+	int SvgDiskCache::getNumEntries() const
+	{
+		return (int)entries.size();
+	}
+
+	// --------------------- Private ---------------------
+	bool SvgDiskCache::loadIndex()
+	{
+		std::string indexFilename = directory + "index.bin";
+		FILE* fp = fopen(indexFilename.c_str(), "rb");
+		if (!fp)
+		{
+			return false;
+		}
+
+		fseek(fp, 0, SEEK_END);
+		size_t fileSize = ftell(fp);
+		fseek(fp, 0, SEEK_SET);
+
+		RawMemory memory;
+		memory.init(fileSize);
+		size_t bytesRead = fread(memory.data, fileSize, 1, fp) == 1 ? fileSize : 0;
+		fclose(fp);
+
+		uint32 magic = 0;
+		uint32 version = 0;
+		if (bytesRead != fileSize || !memory.read<uint32>(&magic) || !memory.read<uint32>(&version) ||
+			magic != indexMagic || version != indexVersion)
+		{
+			g_logger_info("SVG disk cache index '%s' is outdated or corrupt, starting with an empty cache.", indexFilename.c_str());
+			memory.free();
+			return false;
+		}
+
+		bool success = memory.read<uint64>(&session) && memory.read<uint32>(&nextPageId);
+
+		uint32 numPages = 0;
+		success = success && memory.read<uint32>(&numPages);
+		for (uint32 i = 0; success && i < numPages; i++)
+		{
+			SvgDiskCachePage page;
+			page.mapping = nullptr;
+			success = memory.read<uint32>(&page.id) &&
+				memory.read<uint64>(&page.size) &&
+				memory.read<uint64>(&page.lastUsed);
+
+			// Page files can disappear or get cut short if the app dies mid write
+			std::error_code err;
+			uint64 actualSize = (uint64)std::filesystem::file_size(pageFilename(page.id), err);
+			if (success && !err && actualSize >= page.size)
+			{
+				pages.push_back(page);
+			}
+		}
+
+		uint32 numEntries = 0;
+		success = success && memory.read<uint32>(&numEntries);
+		for (uint32 i = 0; success && i < numEntries; i++)
+		{
+			SvgDiskCacheEntry entry;
+			success = memory.read<uint64>(&entry.key) &&
+				memory.read<uint32>(&entry.page) &&
+				memory.read<uint32>(&entry.width) &&
+				memory.read<uint32>(&entry.height) &&
+				memory.read<Vec2>(&entry.svgSize) &&
+				memory.read<uint64>(&entry.offset) &&
+				memory.read<uint64>(&entry.lastUsed);
+
+			int pageIndex = findPage(entry.page);
+			uint64 numBytes = (uint64)entry.width * (uint64)entry.height * bytesPerPixel;
+			if (success && pageIndex >= 0 && entry.offset + numBytes <= pages[pageIndex].size)
+			{
+				entries[entry.key] = entry;
+			}
+		}
+
+		memory.free();
+
+		if (!success)
+		{
+			g_logger_warning("SVG disk cache index '%s' is truncated, starting with an empty cache.", indexFilename.c_str());
+			return false;
+		}
+
+		return true;
+	}
+
+	bool SvgDiskCache::saveIndex()
+	{
+		g_logger_assert(writePage < 0, "Cannot save the SVG disk cache index while a page is being written.");
+
+		RawMemory memory;
+		memory.init(sizeof(uint32) * 4 + sizeof(uint64) + pages.size() * 20 + entries.size() * 44);
+		memory.write<uint32>(&indexMagic);
+		memory.write<uint32>(&indexVersion);
+		memory.write<uint64>(&session);
+		memory.write<uint32>(&nextPageId);
+
+		uint32 numPages = (uint32)pages.size();
+		memory.write<uint32>(&numPages);
+		for (const SvgDiskCachePage& page : pages)
+		{
+			memory.write<uint32>(&page.id);
+			memory.write<uint64>(&page.size);
+			memory.write<uint64>(&page.lastUsed);
+		}
+
+		uint32 numEntries = (uint32)entries.size();
+		memory.write<uint32>(&numEntries);
+		for (const auto& [key, entry] : entries)
+		{
+			memory.write<uint64>(&entry.key);
+			memory.write<uint32>(&entry.page);
+			memory.write<uint32>(&entry.width);
+			memory.write<uint32>(&entry.height);
+			memory.write<Vec2>(&entry.svgSize);
+			memory.write<uint64>(&entry.offset);
+			memory.write<uint64>(&entry.lastUsed);
+		}
+
+		// Write to a temporary file first so a crash never leaves a half written index
+		std::string indexFilename = directory + "index.bin";
+		std::string tmpFilename = directory + "index.tmp";
+		FILE* fp = fopen(tmpFilename.c_str(), "wb");
+		if (!fp)
+		{
+			g_logger_error("Could not write SVG disk cache index '%s'.", tmpFilename.c_str());
+			memory.free();
+			return false;
+		}
+
+		bool success = fwrite(memory.data, memory.offset, 1, fp) == 1;
+		fclose(fp);
+		memory.free();
+
+		std::error_code err;
+		if (success)
+		{
+			std::filesystem::rename(tmpFilename, indexFilename, err);
+		}
+
+		if (!success || err)
+		{
+			g_logger_error("Could not write SVG disk cache index '%s'.", indexFilename.c_str());
+			return false;
+		}
+
+		indexDirty = false;
+		return true;
+	}
+
+	void SvgDiskCache::deleteOrphanedPages()
+	{
+		// Pages that were still being written when the app went down never made it into
+		// the index
+		std::error_code err;
+		for (const auto& file : std::filesystem::directory_iterator(directory, err))
+		{
+			std::string filename = file.path().filename().string();
+			if (filename.rfind("page_", 0) != 0 || file.path().extension() != ".bin")
+			{
+				continue;
+			}
+
+			uint32 id = (uint32)std::strtoul(filename.c_str() + std::strlen("page_"), nullptr, 10);
+			if (findPage(id) < 0)
+			{
+				std::error_code removeErr;
+				std::filesystem::remove(file.path(), removeErr);
+			}
+		}
+	}
+
+	int SvgDiskCache::findPage(uint32 id) const
+	{
+		for (int i = 0; i < (int)pages.size(); i++)
+		{
+			if (pages[i].id == id)
+			{
+				return i;
+			}
+		}
+
+		return -1;
+	}
+
+	void SvgDiskCache::sealWritePage()
+	{
+		if (writePage < 0)
+		{
+			return;
+		}
+
+		fclose(writeFile);
+		writeFile = nullptr;
+		writePage = -1;
+
+		// Every sealed page gets checkpointed, so at most one page is lost in a crash
+		saveIndex();
+	}
+
+	void SvgDiskCache::deletePage(int pageIndex)
+	{
+		g_logger_assert(pageIndex != writePage, "Cannot delete the SVG disk cache page that's being written.");
+
+		SvgDiskCachePage& page = pages[pageIndex];
+		Platform::unmapFile(page.mapping);
+		page.mapping = nullptr;
+
+		for (auto iter = entries.begin(); iter != entries.end();)
+		{
+			if (iter->second.page == page.id)
+			{
+				iter = entries.erase(iter);
+			}
+			else
+			{
+				iter++;
+			}
+		}
+
+		std::error_code err;
+		std::filesystem::remove(pageFilename(page.id), err);
+
+		pages.erase(pages.begin() + pageIndex);
+		if (writePage > pageIndex)
+		{
+			writePage--;
+		}
+		indexDirty = true;
+	}
+
+	std::string SvgDiskCache::pageFilename(uint32 id) const
+	{
+		return directory + "page_" + std::to_string(id) + ".bin";
+	}
+}
@@ -1,9 +1,9 @@
 #include "svg/SvgParser.h"
 #include "svg/Svg.h"
+#include "platform/Platform.h"
+#include "parsers/XmlReader.h"
 
-#include <../tinyxml2/tinyxml2.h>
-
-using namespace tinyxml2;
+#include <charconv>
 
 #define PANIC(formatStr, ...) \
 	snprintf(errorBuffer, errorBufferSize, formatStr, __VA_ARGS__); \
@@ -127,15 +127,6 @@ namespace MathAnim
 		}
 	};
 
-	struct ArcParams
-	{
-		Vec2 radius;
-		float xAxisRotation;
-		bool largeArcFlag;
-		bool sweepFlag;
-		Vec2 endpoint;
-	};
-
 	enum class StyleAttributeType : uint8
 	{
 		None = 0,
@@ -252,28 +243,50 @@ namespace MathAnim
 		std::unordered_map<std::string, Style> classMap;
 	};
 
+	// A drawable child of <svg> or <g>. These are held until the whole document has
+	// been read, so a <use> can link to a <defs> path that comes after it
+	struct SvgPendingElement
+	{
+		SvgElementType type;
+		// Parsed shape for paths, polygons and rects
+		SvgObject obj;
+		// Id a <use> links to
+		std::string link;
+		// x and y attributes of a <use> or <rect>, NAN for everything else
+		Vec2 offset;
+	};
+
 	namespace SvgParser
 	{
 		// Internal variables
 		static constexpr size_t errorBufferSize = 1024;
 		static char errorBuffer[errorBufferSize];
+		// Arcs take the most numbers of any path command
+		static constexpr int maxPathCommandArgs = 7;
 
 		// ----------- Internal Functions -----------
-		static bool parseSvgStylesheet(XMLElement* element, Stylesheet* output);
-		static bool parseSvgPathTag(XMLElement* element, SvgObject* output, const Stylesheet& styles);
-		static bool parsePolygonTag(XMLElement* element, SvgObject* output, const Stylesheet& styles);
-		static void applyElementStylesToSvg(XMLElement* element, SvgObject* output, const Stylesheet& styles);
+		static SvgGroup* parseSvgDocument(XmlReader& reader, const char* filepath);
+		static bool parseDefsElement(XmlReader& reader, Stylesheet* stylesheet, bool* hasStylesheet, std::unordered_map<std::string, SvgObject>& objIds);
+		static bool parseStyleElement(XmlReader& reader, Stylesheet* stylesheet, bool* hasStylesheet);
+		static bool parsePendingElement(XmlReader& reader, const Stylesheet& styles, std::vector<SvgPendingElement>& pending, const char* filepath);
+		static void pushPendingElement(SvgGroup* group, const SvgPendingElement& element, const std::unordered_map<std::string, SvgObject>& objIds, const Vec4& viewbox);
+		static void readElementText(XmlReader& reader, std::string* output);
+		static XmlSlice resolveEntities(const XmlSlice& value, std::string* storage);
+		static bool parseSvgStylesheet(const std::string& styleText, Stylesheet* output);
+		static bool parseSvgPathTag(const XmlReader& element, SvgObject* output, const Stylesheet& styles);
+		static bool parsePolygonTag(const XmlReader& element, SvgObject* output, const Stylesheet& styles);
+		static void applyElementStylesToSvg(const XmlReader& element, SvgObject* output, const Stylesheet& styles);
 		static void applyStylesTo(SvgObject* output, const Style& style);
 		static void applyStyleAttributeTo(SvgObject* output, const StyleAttribute& attribute);
-		static SvgElementType elementStringToEnum(const std::string& elementName);
+		static SvgElementType elementStringToEnum(const XmlSlice& elementName);
+		static bool isStyleAttribute(const XmlSlice& attributeName);
 
 		// -------- Path Parser --------
 		static bool interpretCommand(const PathToken& token, ParserInfo& parserInfo, SvgObject* res);
+		static int pathCommandArgCount(PathTokenType commandType);
+		static bool parseNumbers(ParserInfo& parserInfo, float* out, int count);
 		static bool parseVec2List(std::vector<Vec2>& list, ParserInfo& parserInfo);
-		static bool parseHzNumberList(std::vector<float>& list, ParserInfo& parserInfo);
-		static bool parseVtNumberList(std::vector<float>& list, ParserInfo& parserInfo);
-		static bool parseArcParamsList(std::vector<ArcParams>& list, ParserInfo& parserInfo);
-		static bool parseViewbox(Vec4* out, const char* viewboxStr);
+		static bool parseViewbox(Vec4* out, const XmlSlice& viewboxStr);
 		static PathToken parseNextPathToken(ParserInfo& parserInfo);
 		static PathToken consume(PathTokenType expected, ParserInfo& parserInfo);
 
@@ -286,7 +299,7 @@ namespace MathAnim
 		static void printStyleToken(StyleToken& token);
 		static bool parseColor(const std::string& string, Vec4* output);
 		static bool sanitizeAttribute(const StyleToken& attributeName, const StyleToken& attributeValue, StyleAttribute* output);
-		static bool sanitizeAttribute(const XMLAttribute* attribute, StyleAttribute* output);
+		static bool sanitizeAttribute(const XmlAttribute& attribute, StyleAttribute* output);
 
 		// -------- Generic Parser Stuff --------
 		static bool parseNumber(ParserInfo& parserInfo, float* out);
@@ -299,7 +312,7 @@ namespace MathAnim
 		static inline char advance(ParserInfo& parserInfo) { char c = parserInfo.cursor < parserInfo.textLength ? parserInfo.text[parserInfo.cursor] : '\0'; parserInfo.cursor++; return c; }
 		static inline char peek(const ParserInfo& parserInfo, int advance = 0) { return parserInfo.cursor + advance > parserInfo.textLength - 1 ? '\0' : parserInfo.text[parserInfo.cursor + advance]; }
 		static inline bool isDigit(char c) { return (c >= '0' && c <= '9'); }
-		static inline bool isNumberPart(char c) { return isDigit(c) || c == '-' || c == '.'; }
+		static inline bool isNumberPart(char c) { return isDigit(c) || c == '-' || c == '+' || c == '.'; }
 		static inline bool isAlpha(char c) { return (c >= 'a' && c <= 'z') || (c >= 'A' && c <= 'Z'); }
 		static inline bool isWhitespace(char c) { return c == ' ' || c == '\t' || c == '\n' || c == '\r' || c == '\0'; }
 		static inline bool isStyleIdentifierPart(char c) { return isAlpha(c) || c == '-'; }
@@ -311,22 +324,105 @@ namespace MathAnim
 
 		SvgGroup* parseSvgDoc(const char* filepath)
 		{
-			XMLDocument doc;
-			int res = doc.LoadFile(filepath);
-			if (res != XML_SUCCESS)
+			// The reader hands out slices of the mapped file instead of copying it, so the
+			// file stays mapped until the whole document has been parsed
+			MemoryMappedFile* file = Platform::memoryMapFile(filepath);
+			if (!file)
+			{
+				PANIC("Failed to open SVG file '%s'.", filepath);
+				return nullptr;
+			}
+
+			XmlReader reader((const char*)file->data, file->dataSize);
+			SvgGroup* group = parseSvgDocument(reader, filepath);
+			Platform::unmapFile(file);
+
+			return group;
+		}
+
+		bool parseSvgPath(const char* pathText, size_t pathTextLength, SvgObject* output)
+		{
+			SvgObject res = Svg::createDefault();
+			if (pathTextLength <= 0)
+			{
+				PANIC("Cannot parse an SVG path that has no text.");
+				return false;
+			}
+
+			ParserInfo parserInfo;
+			parserInfo.cursor = 0;
+			parserInfo.text = pathText;
+			parserInfo.textLength = pathTextLength;
+
+			PathToken token = parseNextPathToken(parserInfo);
+			bool lastPathTokenWasClosePath = false;
+			while (token.type != PathTokenType::EndOfFile)
+			{
+				// panic if we fail to interpret a command
+				bool panic = !interpretCommand(token, parserInfo, &res);
+				if (!panic)
+				{
+					PathToken nextPathToken = parseNextPathToken(parserInfo);
+					if (nextPathToken.type == PathTokenType::EndOfFile)
+					{
+						lastPathTokenWasClosePath = token.type == PathTokenType::ClosePath;
+					}
+					else if (nextPathToken.type == PathTokenType::Panic)
+					{
+						panic = true;
+					}
+					token = nextPathToken;
+				}
+
+				if (panic)
+				{
+					res.free();
+					g_logger_error("Had an error while parsing svg path and panicked");
+					return false;
+				}
+			}
+
+			// We should only do this if the path didn't end with a close_path command
+			if (!lastPathTokenWasClosePath)
+			{
+				bool isHole = res.numPaths > 1;
+				Svg::closePath(&res, false, isHole);
+			}
+
+			res.calculateApproximatePerimeter();
+			res.calculateBBox();
+			*output = res;
+
+			return true;
+		}
+
+		const char* getLastError()
+		{
+			return errorBuffer;
+		}
+
+		// ----------- Internal Functions -----------
+		static SvgGroup* parseSvgDocument(XmlReader& reader, const char* filepath)
+		{
+			XmlEventType event = reader.next();
+			while (event != XmlEventType::StartElement && event != XmlEventType::EndOfDocument && event != XmlEventType::Error)
+			{
+				event = reader.next();
+			}
+
+			if (event == XmlEventType::Error)
 			{
-				PANIC("Failed to parse XML in SVG file '%s'.", filepath);
+				PANIC("Failed to parse XML in SVG file '%s' on line %d: %s", filepath, reader.getErrorLine(), reader.getError().c_str());
 				return nullptr;
 			}
 
-			XMLElement* svgElement = doc.FirstChildElement("svg");
-			if (!svgElement)
+			if (event != XmlEventType::StartElement || !reader.name().equals("svg"))
 			{
 				PANIC("No <svg> element found in document '%s'.", filepath);
 				return nullptr;
 			}
 
-			const XMLAttribute* viewboxAttribute = svgElement->FindAttribute("viewBox");
+			const XmlSlice* viewboxAttribute = reader.findAttribute("viewBox");
 			if (!viewboxAttribute)
 			{
 				PANIC("SVG '%s' has no viewBox attribute.", filepath);
@@ -334,338 +430,430 @@ namespace MathAnim
 			}
 
 			Vec4 viewbox;
-			if (!parseViewbox(&viewbox, viewboxAttribute->Value()))
+			if (!parseViewbox(&viewbox, *viewboxAttribute))
 			{
 				PANIC("Failed to parse viewBox attribute for SVG '%s'.", filepath);
 				return nullptr;
 			}
 
+			Stylesheet rootStylesheet;
+			bool hasStylesheet = false;
+			std::unordered_map<std::string, SvgObject> objIds;
+
 			// NOTE: <defs> and <g> elements are not required apparently
-			// The SVG paths can be embedded as children of <svg> directly
-			XMLElement* defsElement = svgElement->FirstChildElement("defs");
-			XMLElement* groupElement = svgElement->FirstChildElement("g");
-			// TODO: This isn't the best way to do this
-			XMLElement* styleElement = svgElement->FirstChildElement("style");
+			// The SVG paths can be embedded as children of <svg> directly. Those are only
+			// drawn when there's no <g>, which isn't known until the end of the document.
+			std::vector<SvgPendingElement> svgChildren;
+			std::vector<SvgPendingElement> groupChildren;
+			bool foundGroup = false;
+			bool insideGroup = false;
+			bool success = true;
 
-			Stylesheet rootStylesheet;
-			if (styleElement)
+			while (success)
 			{
-				if (!parseSvgStylesheet(styleElement, &rootStylesheet))
+				event = reader.next();
+				if (event == XmlEventType::EndOfDocument)
 				{
-					PANIC("Parsing SVG style failed: %s", styleElement->GetText());
-					return nullptr;
+					break;
 				}
-			}
 
-			std::unordered_map<std::string, SvgObject> objIds;
+				if (event == XmlEventType::Error)
+				{
+					PANIC("Failed to parse XML in SVG file '%s' on line %d: %s", filepath, reader.getErrorLine(), reader.getError().c_str());
+					success = false;
+					break;
+				}
 
-			if (defsElement)
-			{
-				XMLElement* childEl = defsElement->FirstChildElement();
-				// Loop through all the definitions and save the svg objects
-				while (childEl != nullptr)
+				if (event == XmlEventType::EndElement && reader.depth() == 2)
+				{
+					insideGroup = false;
+				}
+
+				if (event != XmlEventType::StartElement)
 				{
-					std::string elementName = childEl->Name();
-					SvgElementType elementType = elementStringToEnum(elementName);
+					continue;
+				}
 
-					switch (elementType)
-					{
-					case SvgElementType::Path:
+				if (insideGroup && reader.depth() == 3)
+				{
+					success = parsePendingElement(reader, rootStylesheet, groupChildren, filepath);
+					continue;
+				}
+
+				if (reader.depth() != 2)
+				{
+					reader.skipElement();
+					continue;
+				}
+
+				SvgElementType elementType = elementStringToEnum(reader.name());
+				if (reader.name().equals("g"))
+				{
+					// Only the first group gets drawn
+					if (!foundGroup)
 					{
-						const XMLAttribute* id = childEl->FindAttribute("id");
-						if (id == nullptr) g_logger_warning("Child element '%s' had no id attribute.", childEl->Name());
-
-						const XMLAttribute* pathAttribute = childEl->FindAttribute("d");
-						SvgObject obj;
-						if (parseSvgPathTag(childEl, &obj, rootStylesheet))
-						{
-							std::string idStr = std::string(id->Value());
-							auto iter = objIds.find(idStr);
-							g_logger_assert(iter == objIds.end(), "Tried to insert duplicate ID '%s' in SVG object map", idStr.c_str());
-							obj.calculateBBox();
-							objIds[idStr] = obj;
-						}
+						foundGroup = true;
+						insideGroup = true;
 					}
-					break;
-					case SvgElementType::Style:
+					else
 					{
-						if (styleElement != nullptr)
-						{
-							PANIC("We don't support multi-stylesheet SVGs yet. This SVG has multiple embedded stylesheets.");
-						}
-						else
-						{
-							parseSvgStylesheet(childEl, &rootStylesheet);
-						}
-					}
-					break;
-					case SvgElementType::Defs:
-						g_logger_warning("TODO: Implement me.");
-						break;
-					case SvgElementType::Desc:
-						g_logger_warning("TODO: Implement me.");
-						break;
-					case SvgElementType::Polygon:
-						g_logger_warning("TODO: Implement me.");
-						break;
-					case SvgElementType::Rect:
-						g_logger_warning("TODO: Implement me.");
-						break;
-					case SvgElementType::Title:
-						g_logger_warning("TODO: Implement me.");
-						break;
-					case SvgElementType::Use:
-						g_logger_warning("TODO: Implement me.");
-						break;
-					case SvgElementType::None:
-						break;
+						reader.skipElement();
 					}
+				}
+				else if (elementType == SvgElementType::Defs)
+				{
+					success = parseDefsElement(reader, &rootStylesheet, &hasStylesheet, objIds);
+				}
+				else if (elementType == SvgElementType::Style)
+				{
+					success = parseStyleElement(reader, &rootStylesheet, &hasStylesheet);
+				}
+				else
+				{
+					success = parsePendingElement(reader, rootStylesheet, svgChildren, filepath);
+				}
+			}
+
+			SvgGroup* group = nullptr;
+			if (success)
+			{
+				// Create a group using the svg objects and the viewbox attribute
+				group = (SvgGroup*)g_memory_allocate(sizeof(SvgGroup));
+				*group = Svg::createDefaultGroup();
+				Svg::beginSvgGroup(group);
 
-					childEl = childEl->NextSiblingElement();
+				const std::vector<SvgPendingElement>& children = foundGroup ? groupChildren : svgChildren;
+				for (const SvgPendingElement& child : children)
+				{
+					pushPendingElement(group, child, objIds, viewbox);
 				}
+
+				if (group->numObjects > 0)
+				{
+					Svg::endSvgGroup(group);
+				}
+				else
+				{
+					PANIC("Did not find any <path> elements or other SVG elements in file '%s'. Check the logs for more information.", filepath);
+					group->free();
+					g_memory_free(group);
+					group = nullptr;
+				}
+			}
+
+			// The group holds copies of everything it uses
+			for (SvgPendingElement& child : svgChildren)
+			{
+				child.obj.free();
 			}
 
-			// Create a group using the svg objects and the viewbox attribute
-			SvgGroup* group = (SvgGroup*)g_memory_allocate(sizeof(SvgGroup));
-			*group = Svg::createDefaultGroup();
-			Svg::beginSvgGroup(group);
+			for (SvgPendingElement& child : groupChildren)
+			{
+				child.obj.free();
+			}
 
+			for (auto& pair : objIds)
 			{
-				XMLElement* childEl = groupElement != nullptr
-					? groupElement->FirstChildElement()
-					: svgElement->FirstChildElement();
-				while (childEl != nullptr)
+				pair.second.free();
+			}
+
+			return group;
+		}
+
+		static bool parseDefsElement(XmlReader& reader, Stylesheet* stylesheet, bool* hasStylesheet, std::unordered_map<std::string, SvgObject>& objIds)
+		{
+			// Loop through all the definitions and save the svg objects
+			int defsDepth = reader.depth();
+			for (;;)
+			{
+				XmlEventType event = reader.next();
+				if (event == XmlEventType::EndElement && reader.depth() == defsDepth)
 				{
-					SvgElementType elementType = elementStringToEnum(childEl->Name());
+					return true;
+				}
 
-					switch (elementType)
-					{
-					case SvgElementType::Use:
-					{
-						const XMLAttribute* xAttr = childEl->FindAttribute("x");
-						const XMLAttribute* yAttr = childEl->FindAttribute("y");
-						const XMLAttribute* linkAttr = childEl->FindAttribute("xlink:href");
-
-						if (!xAttr) g_logger_warning("Child element '%s' had no x attribute.", childEl->Name());
-						if (!yAttr) g_logger_warning("Child element '%s' had no y attribute.", childEl->Name());
-
-						if (!linkAttr) g_logger_warning("Child element '%s' had no xlink:href attribute.", childEl->Name());
-
-						if (xAttr && yAttr && linkAttr)
-						{
-							float x = xAttr->FloatValue();
-							float y = yAttr->FloatValue();
-							const char* linkText = linkAttr->Value();
-							if (linkText[0] != '#')
-							{
-								g_logger_warning("Child element '%s' link attribute '%s' did not begin with '#'.", childEl->Name(), linkText);
-								continue;
-							}
-
-							std::string id = std::string(linkText + 1);
-							auto iter = objIds.find(id);
-							if (iter == objIds.end())
-							{
-								g_logger_warning("Could not find link to svg path '%s' for child element '%s'", id.c_str(), childEl->Name());
-								continue;
-							}
-
-							// Flip y-coords to be consistent with everything else positioning from 
-							// the bottom-left
-							// NOTE: I'm not exactly sure why I have to "flip" the coordinate like this
-							// but it works and that's good enough for me...
-							y = y + iter->second.bbox.min.y - viewbox.values[3];
-							Svg::pushSvgToGroup(group, iter->second, iter->first, Vec2{ x, y });
-						}
-					}
-					break;
-					case SvgElementType::Rect:
-					{
-						const XMLAttribute* xAttr = childEl->FindAttribute("x");
-						const XMLAttribute* yAttr = childEl->FindAttribute("y");
-
-						if (!xAttr) g_logger_warning("Child element '%s' had no x attribute.", childEl->Name());
-						if (!yAttr) g_logger_warning("Child element '%s' had no y attribute.", childEl->Name());
-
-						const XMLAttribute* wAttr = childEl->FindAttribute("width");
-						const XMLAttribute* hAttr = childEl->FindAttribute("height");
-
-						if (!wAttr) g_logger_warning("Child element '%s' had no width attribute.", childEl->Name());
-						if (!hAttr) g_logger_warning("Child element '%s' had no height attribute.", childEl->Name());
-
-						if (wAttr && hAttr && xAttr && yAttr)
-						{
-							float x = xAttr->FloatValue();
-							float y = yAttr->FloatValue();
-							float w = wAttr->FloatValue();
-							float h = hAttr->FloatValue();
-
-							SvgObject rect = Svg::createDefault();
-							Svg::beginPath(&rect, { 0, h });
-							Svg::lineTo(&rect, { w, h });
-							Svg::lineTo(&rect, { w, 0 });
-							Svg::lineTo(&rect, { 0, 0 });
-							Svg::lineTo(&rect, { 0, h });
-							Svg::closePath(&rect);
-
-							static uint64 rCounter = 0;
-							rCounter++;
-							std::string rCounterStr = "rect-" + rCounter;
-							// Flip y-coords to be consistent with everything else positioning from 
-							// the bottom-left
-							y = y - viewbox.values[3];
-							Svg::pushSvgToGroup(group, rect, rCounterStr, Vec2{ x, y });
-						}
-					}
-					break;
-					case SvgElementType::Path:
-					{
-						SvgObject obj;
-						if (parseSvgPathTag(childEl, &obj, rootStylesheet))
-						{
-							static uint64 uniqueName = 0;
-							uniqueName++;
-							std::string name = std::to_string(uniqueName);
-							Svg::pushSvgToGroup(group, obj, name);
-						}
-						else
-						{
-							g_logger_warning("Failed to parse path tag in SVG '%s'", filepath);
-							goto error_cleanup;
-						}
-					}
-					break;
-					case SvgElementType::Polygon:
-					{
-						SvgObject obj;
-						if (parsePolygonTag(childEl, &obj, rootStylesheet))
-						{
-							static uint64 uniqueName = 0;
-							uniqueName++;
-							std::string name = std::to_string(uniqueName);
-							Svg::pushSvgToGroup(group, obj, name);
-						}
-						else
-						{
-							g_logger_warning("Failed to parse path tag in SVG '%s'", filepath);
-							goto error_cleanup;
-						}
-					}
-					break;
-					case SvgElementType::Defs:
-					{
-						// NOP; Don't care about the defs block that's handled above.
-					}
-					break;
-					case SvgElementType::Title:
+				// Malformed XML gets reported by the caller's next call to next()
+				if (event == XmlEventType::EndOfDocument || event == XmlEventType::Error)
+				{
+					return true;
+				}
+
+				if (event != XmlEventType::StartElement)
+				{
+					continue;
+				}
+
+				const XmlSlice& name = reader.name();
+				SvgElementType elementType = elementStringToEnum(name);
+				if (elementType == SvgElementType::Style)
+				{
+					// Reads up to the end of the <style> element itself
+					if (!parseStyleElement(reader, stylesheet, hasStylesheet))
 					{
-						// FIXME: Title is necessary for accesibility
+						return false;
 					}
-					break;
-					case SvgElementType::Desc:
+					continue;
+				}
+
+				if (elementType == SvgElementType::Path)
+				{
+					const XmlSlice* id = reader.findAttribute("id");
+					SvgObject obj;
+					if (id == nullptr)
 					{
-						g_logger_warning("TODO: Implement me.");
+						g_logger_warning("Child element '%.*s' had no id attribute.", (int)name.length, name.text);
 					}
-					case SvgElementType::Style:
+					else if (parseSvgPathTag(reader, &obj, *stylesheet))
 					{
-						g_logger_warning("TODO: Implement me.");
+						std::string idStr = XmlReader::unescape(*id);
+						auto iter = objIds.find(idStr);
+						g_logger_assert(iter == objIds.end(), "Tried to insert duplicate ID '%s' in SVG object map", idStr.c_str());
+						obj.calculateBBox();
+						objIds[idStr] = obj;
 					}
-					break;
-					case SvgElementType::None:
-						break;
-					}
-
-					childEl = childEl->NextSiblingElement();
 				}
+				else if (elementType != SvgElementType::None)
+				{
+					g_logger_warning("TODO: Implement <%.*s> inside <defs>.", (int)name.length, name.text);
+				}
+
+				reader.skipElement();
 			}
+		}
 
-			if (group->numObjects <= 0)
+		static bool parseStyleElement(XmlReader& reader, Stylesheet* stylesheet, bool* hasStylesheet)
+		{
+			std::string styleText;
+			readElementText(reader, &styleText);
+
+			if (*hasStylesheet)
 			{
-			error_cleanup:
-				PANIC("Did not find any <path> elements or other SVG elements in file '%s'. Check the logs for more information.", filepath);
-				group->free();
-				g_memory_free(group);
-				return nullptr;
+				PANIC("We don't support multi-stylesheet SVGs yet. This SVG has multiple embedded stylesheets.");
+				return true;
 			}
 
-			Svg::endSvgGroup(group);
+			if (!parseSvgStylesheet(styleText, stylesheet))
+			{
+				PANIC("Parsing SVG style failed: %s", styleText.c_str());
+				return false;
+			}
 
-			return group;
+			*hasStylesheet = true;
+			return true;
 		}
 
-		bool parseSvgPath(const char* pathText, size_t pathTextLength, SvgObject* output)
+		static bool parsePendingElement(XmlReader& reader, const Stylesheet& styles, std::vector<SvgPendingElement>& pending, const char* filepath)
 		{
-			SvgObject res = Svg::createDefault();
-			if (pathTextLength <= 0)
-			{
-				PANIC("Cannot parse an SVG path that has no text.");
-				return false;
-			}
+			const XmlSlice& name = reader.name();
 
-			ParserInfo parserInfo;
-			parserInfo.cursor = 0;
-			parserInfo.text = pathText;
-			parserInfo.textLength = pathTextLength;
+			SvgPendingElement element = {};
+			element.type = elementStringToEnum(name);
+			element.offset = Vec2{ NAN, NAN };
 
-			PathToken token = parseNextPathToken(parserInfo);
-			bool lastPathTokenWasClosePath = false;
-			while (token.type != PathTokenType::EndOfFile)
+			switch (element.type)
 			{
-				// panic if we fail to interpret a command
-				bool panic = !interpretCommand(token, parserInfo, &res);
-				if (!panic)
+			case SvgElementType::Use:
+			{
+				const XmlSlice* xAttr = reader.findAttribute("x");
+				const XmlSlice* yAttr = reader.findAttribute("y");
+				const XmlSlice* linkAttr = reader.findAttribute("xlink:href");
+
+				if (!xAttr) g_logger_warning("Child element '%.*s' had no x attribute.", (int)name.length, name.text);
+				if (!yAttr) g_logger_warning("Child element '%.*s' had no y attribute.", (int)name.length, name.text);
+
+				if (!linkAttr) g_logger_warning("Child element '%.*s' had no xlink:href attribute.", (int)name.length, name.text);
+
+				if (xAttr && yAttr && linkAttr)
 				{
-					PathToken nextPathToken = parseNextPathToken(parserInfo);
-					if (nextPathToken.type == PathTokenType::EndOfFile)
+					std::string linkText = XmlReader::unescape(*linkAttr);
+					if (linkText.size() == 0 || linkText[0] != '#')
 					{
-						lastPathTokenWasClosePath = token.type == PathTokenType::ClosePath;
-					}
-					else if (nextPathToken.type == PathTokenType::Panic)
-					{
-						panic = true;
+						g_logger_warning("Child element '%.*s' link attribute '%s' did not begin with '#'.", (int)name.length, name.text, linkText.c_str());
+						break;
 					}
-					token = nextPathToken;
+
+					xAttr->toFloat(&element.offset.x);
+					yAttr->toFloat(&element.offset.y);
+					element.link = linkText.substr(1);
+					pending.emplace_back(element);
 				}
+			}
+			break;
+			case SvgElementType::Rect:
+			{
+				const XmlSlice* xAttr = reader.findAttribute("x");
+				const XmlSlice* yAttr = reader.findAttribute("y");
 
-				if (panic)
+				if (!xAttr) g_logger_warning("Child element '%.*s' had no x attribute.", (int)name.length, name.text);
+				if (!yAttr) g_logger_warning("Child element '%.*s' had no y attribute.", (int)name.length, name.text);
+
+				const XmlSlice* wAttr = reader.findAttribute("width");
+				const XmlSlice* hAttr = reader.findAttribute("height");
+
+				if (!wAttr) g_logger_warning("Child element '%.*s' had no width attribute.", (int)name.length, name.text);
+				if (!hAttr) g_logger_warning("Child element '%.*s' had no height attribute.", (int)name.length, name.text);
+
+				if (wAttr && hAttr && xAttr && yAttr)
 				{
-					res.free();
-					g_logger_error("Had an error while parsing svg path and panicked");
+					float w = 0.0f;
+					float h = 0.0f;
+					xAttr->toFloat(&element.offset.x);
+					yAttr->toFloat(&element.offset.y);
+					wAttr->toFloat(&w);
+					hAttr->toFloat(&h);
+
+					element.obj = Svg::createDefault();
+					Svg::beginPath(&element.obj, { 0, h });
+					Svg::lineTo(&element.obj, { w, h });
+					Svg::lineTo(&element.obj, { w, 0 });
+					Svg::lineTo(&element.obj, { 0, 0 });
+					Svg::lineTo(&element.obj, { 0, h });
+					Svg::closePath(&element.obj);
+					pending.emplace_back(element);
+				}
+			}
+			break;
+			case SvgElementType::Path:
+			{
+				if (!parseSvgPathTag(reader, &element.obj, styles))
+				{
+					PANIC("Failed to parse path tag in SVG '%s'", filepath);
 					return false;
 				}
+				pending.emplace_back(element);
 			}
-
-			// We should only do this if the path didn't end with a close_path command
-			if (!lastPathTokenWasClosePath)
+			break;
+			case SvgElementType::Polygon:
 			{
-				bool isHole = res.numPaths > 1;
-				Svg::closePath(&res, false, isHole);
+				if (!parsePolygonTag(reader, &element.obj, styles))
+				{
+					PANIC("Failed to parse polygon tag in SVG '%s'", filepath);
+					return false;
+				}
+				pending.emplace_back(element);
+			}
+			break;
+			case SvgElementType::Defs:
+			{
+				// NOP; Only <defs> directly inside <svg> gets read
+			}
+			break;
+			case SvgElementType::Title:
+			{
+				// FIXME: Title is necessary for accesibility
+			}
+			break;
+			case SvgElementType::Desc:
+			case SvgElementType::Style:
+			{
+				g_logger_warning("TODO: Implement me.");
+			}
+			break;
+			case SvgElementType::None:
+				break;
 			}
 
-			res.calculateApproximatePerimeter();
-			res.calculateBBox();
-			*output = res;
-
+			reader.skipElement();
 			return true;
 		}
 
-		const char* getLastError()
+		static void pushPendingElement(SvgGroup* group, const SvgPendingElement& element, const std::unordered_map<std::string, SvgObject>& objIds, const Vec4& viewbox)
 		{
-			return errorBuffer;
+			static uint64 uniqueName = 0;
+
+			switch (element.type)
+			{
+			case SvgElementType::Use:
+			{
+				auto iter = objIds.find(element.link);
+				if (iter == objIds.end())
+				{
+					g_logger_warning("Could not find link to svg path '%s' for child element 'use'", element.link.c_str());
+					break;
+				}
+
+				// Flip y-coords to be consistent with everything else positioning from
+				// the bottom-left
+				// NOTE: I'm not exactly sure why I have to "flip" the coordinate like this
+				// but it works and that's good enough for me...
+				float y = element.offset.y + iter->second.bbox.min.y - viewbox.values[3];
+				Svg::pushSvgToGroup(group, iter->second, iter->first, Vec2{ element.offset.x, y });
+			}
+			break;
+			case SvgElementType::Rect:
+			{
+				uniqueName++;
+				std::string name = "rect-" + std::to_string(uniqueName);
+				// Flip y-coords to be consistent with everything else positioning from
+				// the bottom-left
+				float y = element.offset.y - viewbox.values[3];
+				Svg::pushSvgToGroup(group, element.obj, name, Vec2{ element.offset.x, y });
+			}
+			break;
+			case SvgElementType::Path:
+			case SvgElementType::Polygon:
+			{
+				uniqueName++;
+				std::string name = std::to_string(uniqueName);
+				Svg::pushSvgToGroup(group, element.obj, name);
+			}
+			break;
+			default:
+				break;
+			}
 		}
 
-		// ----------- Internal Functions -----------
-		static bool parseSvgStylesheet(XMLElement* element, Stylesheet* output)
+		static void readElementText(XmlReader& reader, std::string* output)
 		{
-			// Stylesheet: 
-			//   Style | Stylesheet
-			// 
+			// Stops early on malformed XML, the caller's next call to next() reports it
+			int depth = reader.depth();
+			for (;;)
+			{
+				XmlEventType event = reader.next();
+				switch (event)
+				{
+				case XmlEventType::Text:
+					*output += XmlReader::unescape(reader.text());
+					break;
+				case XmlEventType::CData:
+					output->append(reader.text().text, reader.text().length);
+					break;
+				case XmlEventType::StartElement:
+					reader.skipElement();
+					break;
+				case XmlEventType::EndElement:
+					if (reader.depth() == depth)
+					{
+						return;
+					}
+					break;
+				case XmlEventType::EndOfDocument:
+				case XmlEventType::Error:
+					return;
+				}
+			}
+		}
 
-			const char* styleText = element->GetText();
-			size_t styleTextLength = std::strlen(styleText);
+		static XmlSlice resolveEntities(const XmlSlice& value, std::string* storage)
+		{
+			// Values only get copied when they actually have an entity reference in them
+			if (!std::memchr(value.text, '&', value.length))
+			{
+				return value;
+			}
+
+			*storage = XmlReader::unescape(value);
+			return XmlSlice{ storage->c_str(), storage->size() };
+		}
+
+		static bool parseSvgStylesheet(const std::string& styleText, Stylesheet* output)
+		{
+			// Stylesheet:
+			//   Style | Stylesheet
+			//
 
 			Stylesheet res = {};
-			if (styleTextLength <= 0)
+			if (styleText.size() <= 0)
 			{
 				PANIC("Cannot parse an SVG style that has no text.");
 				return false;
@@ -673,8 +861,8 @@ namespace MathAnim
 
 			ParserInfo parserInfo;
 			parserInfo.cursor = 0;
-			parserInfo.text = styleText;
-			parserInfo.textLength = styleTextLength;
+			parserInfo.text = styleText.c_str();
+			parserInfo.textLength = styleText.size();
 
 			StyleToken token = {};
 			while (token.type != StyleTokenType::EndOfFile)
@@ -706,24 +894,26 @@ namespace MathAnim
 			return true;
 		}
 
-		static bool parseSvgPathTag(XMLElement* element, SvgObject* output, const Stylesheet& styles)
+		static bool parseSvgPathTag(const XmlReader& element, SvgObject* output, const Stylesheet& styles)
 		{
-			if (std::strcmp(element->Name(), "path") != 0)
+			const XmlSlice& name = element.name();
+			if (!name.equals("path"))
 			{
-				PANIC("Tried to parse tag <%s> as SVG path, but this tag is not a path tag.", element->Name());
+				PANIC("Tried to parse tag <%.*s> as SVG path, but this tag is not a path tag.", (int)name.length, name.text);
 				return false;
 			}
 
-			const XMLAttribute* pathAttribute = element->FindAttribute("d");
+			const XmlSlice* pathAttribute = element.findAttribute("d");
 			if (pathAttribute == nullptr)
 			{
-				PANIC("Element '%s' had no path attribute.", element->Name());
+				PANIC("Element '%.*s' had no path attribute.", (int)name.length, name.text);
 				return false;
 
 			}
 
-			size_t textLength = std::strlen(pathAttribute->Value());
-			if (parseSvgPath(pathAttribute->Value(), textLength, output))
+			// Path data is only numbers and command letters, so it's parsed straight out
+			// of the document
+			if (parseSvgPath(pathAttribute->text, pathAttribute->length, output))
 			{
 				applyElementStylesToSvg(element, output, styles);
 				return true;
@@ -732,43 +922,43 @@ namespace MathAnim
 			return false;
 		}
 
-		static bool parsePolygonTag(XMLElement* element, SvgObject* output, const Stylesheet& styles)
+		static bool parsePolygonTag(const XmlReader& element, SvgObject* output, const Stylesheet& styles)
 		{
-			if (std::strcmp(element->Name(), "polygon") != 0)
+			const XmlSlice& name = element.name();
+			if (!name.equals("polygon"))
 			{
-				PANIC("Tried to parse tag <%s> as polygon, but this tag is not a polygon.", element->Name());
+				PANIC("Tried to parse tag <%.*s> as polygon, but this tag is not a polygon.", (int)name.length, name.text);
 				return false;
 			}
 
-			const XMLAttribute* points = element->FindAttribute("points");
+			const XmlSlice* points = element.findAttribute("points");
 			if (points == nullptr)
 			{
-				PANIC("Element '%s' had no points attribute.", element->Name());
+				PANIC("Element '%.*s' had no points attribute.", (int)name.length, name.text);
 				return false;
 
 			}
-			size_t textLength = std::strlen(points->Value());
 
 			ParserInfo pointsParser;
 			pointsParser.cursor = 0;
-			pointsParser.text = points->Value();
-			pointsParser.textLength = textLength;
+			pointsParser.text = points->text;
+			pointsParser.textLength = points->length;
 			std::vector<Vec2> pointsList;
 
-			// Points are only valid if they have an even number of points as specified here: 
+			// Points are only valid if they have an even number of points as specified here:
 			// https://www.w3.org/TR/SVG2/shapes.html#PolygonElement
 			// The parseVec2List should fail if there are an odd number of elements
-			if (!parseVec2List(pointsList, pointsParser))
+			if (points->length > 0 && !parseVec2List(pointsList, pointsParser))
 			{
-				PANIC("Element '%s' had an odd number of points.", element->Name());
+				PANIC("Element '%.*s' had an odd number of points.", (int)name.length, name.text);
 				return false;
 			}
 
 			// Create an SVG object using absolute moveTo commands and lineTo commands
 			// to each point in the list
+			*output = Svg::createDefault();
 			if (pointsList.size() > 0)
 			{
-				*output = Svg::createDefault();
 				Svg::moveTo(output, pointsList[0]);
 
 				for (size_t i = 1; i < pointsList.size(); i++)
@@ -783,482 +973,316 @@ namespace MathAnim
 			return true;
 		}
 
-		static void applyElementStylesToSvg(XMLElement* element, SvgObject* output, const Stylesheet& styles)
+		static void applyElementStylesToSvg(const XmlReader& element, SvgObject* output, const Stylesheet& styles)
 		{
 			// First add any styles specified by the class and/or id this element has
 
-			// Add styles to this SVG path
-			const XMLAttribute* classNameAttribute = element->FindAttribute("class");
-			if (classNameAttribute)
-			{
-				const std::string& className = classNameAttribute->Value();
-				auto iter = styles.classMap.find(className);
-				if (iter != styles.classMap.end())
-				{
-					const Style& style = iter->second;
-					// Apply each attribute to our SVG object
-					applyStylesTo(output, style);
-				}
-			}
-
-			const XMLAttribute* idNameAttribute = element->FindAttribute("id");
-			if (idNameAttribute)
-			{
-				const std::string& idName = idNameAttribute->Value();
-				auto iter = styles.idMap.find(idName);
-				if (iter != styles.idMap.end())
-				{
-					const Style& style = iter->second;
-					// Apply each attribute to our SVG object
-					applyStylesTo(output, style);
-				}
-			}
-
-			// Next apply any styles specified in attributes like this:
-			//    <path d="..." fill-rule="nonzero"></path>
-			//                  ^- Style specified in the attribute
-			const XMLAttribute* attribute = element->FirstAttribute();
-
-			// These are a list of attributes that get skipped since they're not styles
-			const std::unordered_set<std::string> attributeBlacklist = {
-				"d",
-				"class",
-				"id",
-				"points"
-			};
-
-			while (attribute != nullptr)
-			{
-				const std::string& name = attribute->Name();
-				auto blacklistIter = attributeBlacklist.find(name);
-				if (blacklistIter == attributeBlacklist.end())
-				{
-					StyleAttribute sanitizedAttribute;
-					if (name == "style")
-					{
-						// If there's an inline style embedded in this attribute, parse the style then
-						// apply it to the path
-						ParserInfo inlineStylePi;
-						inlineStylePi.text = attribute->Value();
-						inlineStylePi.textLength = std::strlen(attribute->Value());
-						inlineStylePi.cursor = 0;
-						Style inlineStyle;
-						if (parseInlineStyle(inlineStylePi, &inlineStyle, false))
-						{
-							applyStylesTo(output, inlineStyle);
-						}
-						else
-						{
-							PANIC("Failed to parse inline style.");
-						}
-					}
-					else if (sanitizeAttribute(attribute, &sanitizedAttribute))
-					{
-						applyStyleAttributeTo(output, sanitizedAttribute);
-					}
-					else
-					{
-						PANIC("Unknown inline style attribute for SVG path '%s'", name.c_str());
-					}
-				}
-
-				attribute = attribute->Next();
-			}
-		}
-
-		static void applyStylesTo(SvgObject* output, const Style& style)
-		{
-			for (const StyleAttribute& attribute : style.attributes)
-			{
-				applyStyleAttributeTo(output, attribute);
-			}
-		}
-
-		static void applyStyleAttributeTo(SvgObject* output, const StyleAttribute& attribute)
-		{
-			const std::string& attributeName = attribute.name();
-			if (attributeName == "fill-rule")
-			{
-				std::string value = attribute.value();
-				if (value == "evenodd")
-				{
-					output->fillType = FillType::EvenOddFillType;
-				}
-				else if (value == "nonzero")
-				{
-					output->fillType = FillType::NonZeroFillType;
-				}
-				else
-				{
-					g_logger_warning("Unknown fill-rule type: %s", value.c_str());
-				}
-			}
-			else if (attributeName == "fill")
-			{
-				if (!(attribute.isColor()))
-				{
-					PANIC("Invalid fill type '%s' in SVG document. Must be color.", attribute.value().c_str());
-				}
-				output->fillColor = attribute.asColor();
-			}
-		}
-
-		static SvgElementType elementStringToEnum(const std::string& elementName)
-		{
-			static const std::unordered_map<std::string, SvgElementType> map = {
-				{ "path",    SvgElementType::Path },
-				{ "title",   SvgElementType::Title },
-				{ "desc",    SvgElementType::Desc },
-				{ "use",     SvgElementType::Use },
-				{ "rect",    SvgElementType::Rect },
-				{ "polygon", SvgElementType::Polygon },
-				{ "style",   SvgElementType::Style },
-				{ "defs",    SvgElementType::Defs }
-			};
-
-			auto iter = map.find(elementName);
-			if (iter != map.end())
-			{
-				return iter->second;
-			}
-
-			return SvgElementType::None;
-		}
-
-		static bool interpretCommand(const PathToken& token, ParserInfo& parserInfo, SvgObject* res)
-		{
-			PathTokenType commandType = token.type;
-			bool isAbsolute = token.isAbsolute;
-			if (commandType == PathTokenType::Panic)
-			{
-				return false;
-			}
-
-			// Parse as many {x, y} pairs as possible
-			switch (commandType)
-			{
-			case PathTokenType::MoveTo:
-			{
-				std::vector<Vec2> vec2List;
-				if (!parseVec2List(vec2List, parserInfo))
-				{
-					PANIC("Error interpreting move to command. Invalid coordinate encountered.");
-					return false;
-				}
-				if (vec2List.size() <= 0)
-				{
-					PANIC("Error interpreting move to command. No coordinates provided.");
-					return false;
-				}
-
-				const Vec2& firstPoint = vec2List[0];
-				Svg::moveTo(res, Vec2{ firstPoint.x, firstPoint.y }, isAbsolute);
-				for (int i = 1; i < vec2List.size(); i++)
-				{
-					Svg::lineTo(res, Vec2{ vec2List[i].x, vec2List[i].y }, isAbsolute);
-				}
-			}
-			break;
-			case PathTokenType::ClosePath:
-			{
-				bool isHole = res->numPaths > 1;
-				Svg::closePath(res, true, isHole);
-			}
-			break;
-			case PathTokenType::LineTo:
-			{
-				std::vector<Vec2> vec2List;
-				if (!parseVec2List(vec2List, parserInfo))
-				{
-					PANIC("Error interpreting line to command. Invalid coordinate encountered.");
-					return false;
-				}
-				if (vec2List.size() <= 0)
-				{
-					PANIC("Error interpreting line to command. No coordinates provided.");
-					return false;
-				}
-
-				for (int i = 0; i < vec2List.size(); i++)
-				{
-					Svg::lineTo(res, Vec2{ vec2List[i].x, vec2List[i].y }, isAbsolute);
-				}
-			}
-			break;
-			case PathTokenType::HzLineTo:
-			{
-				std::vector<float> numberList;
-				if (!parseHzNumberList(numberList, parserInfo))
-				{
-					PANIC("Error interpreting line to command. Invalid coordinate encountered.");
-					return false;
-				}
-				if (numberList.size() <= 0)
-				{
-					PANIC("Error interpreting line to command. No coordinates provided.");
-					return false;
-				}
-
-				for (int i = 0; i < numberList.size(); i++)
-				{
-					Svg::hzLineTo(res, numberList[i], isAbsolute);
-				}
-			}
-			break;
-			case PathTokenType::VtLineTo:
+			// Add styles to this SVG path
+			const XmlSlice* classNameAttribute = element.findAttribute("class");
+			if (classNameAttribute && styles.classMap.size() > 0)
 			{
-				std::vector<float> numberList;
-				if (!parseVtNumberList(numberList, parserInfo))
-				{
-					PANIC("Error interpreting line to command. Invalid coordinate encountered.");
-					return false;
-				}
-				if (numberList.size() <= 0)
+				std::string className = XmlReader::unescape(*classNameAttribute);
+				auto iter = styles.classMap.find(className);
+				if (iter != styles.classMap.end())
 				{
-					PANIC("Error interpreting line to command. No coordinates provided.");
-					return false;
+					const Style& style = iter->second;
+					// Apply each attribute to our SVG object
+					applyStylesTo(output, style);
 				}
+			}
 
-				for (int i = 0; i < numberList.size(); i++)
+			const XmlSlice* idNameAttribute = element.findAttribute("id");
+			if (idNameAttribute && styles.idMap.size() > 0)
+			{
+				std::string idName = XmlReader::unescape(*idNameAttribute);
+				auto iter = styles.idMap.find(idName);
+				if (iter != styles.idMap.end())
 				{
-					Svg::vtLineTo(res, numberList[i], isAbsolute);
+					const Style& style = iter->second;
+					// Apply each attribute to our SVG object
+					applyStylesTo(output, style);
 				}
 			}
-			break;
-			case PathTokenType::CurveTo:
+
+			// Next apply any styles specified in attributes like this:
+			//    <path d="..." fill-rule="nonzero"></path>
+			//                  ^- Style specified in the attribute
+			for (const XmlAttribute& attribute : element.attributes())
 			{
-				std::vector<Vec2> vec2List;
-				if (!parseVec2List(vec2List, parserInfo))
+				if (!isStyleAttribute(attribute.name))
 				{
-					PANIC("Error interpreting move to command. Invalid coordinate encountered.");
-					return false;
-				}
-				if (vec2List.size() <= 0)
-				{
-					PANIC("Error interpreting move to command. No coordinates provided.");
-					return false;
+					continue;
 				}
 
-				if (vec2List.size() % 3 != 0)
+				StyleAttribute sanitizedAttribute;
+				if (attribute.name.equals("style"))
 				{
-					PANIC("Cubic polybezier curve must have a multiple of 3 coordinates, otherwise it's not a valid polybezier curve.");
-					return false;
-				}
+					// If there's an inline style embedded in this attribute, parse the style then
+					// apply it to the path
+					std::string valueStorage;
+					XmlSlice value = resolveEntities(attribute.value, &valueStorage);
+					if (value.length == 0)
+					{
+						continue;
+					}
 
-				for (size_t i = 0; i < vec2List.size(); i += 3)
-				{
-					g_logger_assert(i + 2 < vec2List.size(), "Somehow ended up with a non-multiple of 3.");
-					Svg::bezier3To(res, vec2List[i + 0], vec2List[i + 1], vec2List[i + 2], isAbsolute);
-				}
-			}
-			break;
-			case PathTokenType::SmoothCurveTo:
-			{
-				std::vector<Vec2> vec2List;
-				if (!parseVec2List(vec2List, parserInfo))
-				{
-					PANIC("Error interpreting move to command. Invalid coordinate encountered.");
-					return false;
+					ParserInfo inlineStylePi;
+					inlineStylePi.text = value.text;
+					inlineStylePi.textLength = value.length;
+					inlineStylePi.cursor = 0;
+					Style inlineStyle;
+					if (parseInlineStyle(inlineStylePi, &inlineStyle, false))
+					{
+						applyStylesTo(output, inlineStyle);
+					}
+					else
+					{
+						PANIC("Failed to parse inline style.");
+					}
 				}
-				if (vec2List.size() <= 0)
+				else if (sanitizeAttribute(attribute, &sanitizedAttribute))
 				{
-					PANIC("Error interpreting move to command. No coordinates provided.");
-					return false;
+					applyStyleAttributeTo(output, sanitizedAttribute);
 				}
-
-				if (vec2List.size() % 2 != 0)
+				else
 				{
-					PANIC("Smooth cubic polybezier curve must have a multiple of 2 coordinates, otherwise it's not a valid polybezier curve.");
-					return false;
+					PANIC("Unknown inline style attribute for SVG path '%.*s'", (int)attribute.name.length, attribute.name.text);
 				}
+			}
+		}
 
-				for (size_t i = 0; i < vec2List.size(); i += 2)
-				{
-					g_logger_assert(i + 1 < vec2List.size(), "Somehow ended up with a non-multiple of 2.");
-					Svg::smoothBezier3To(res, vec2List[i + 0], vec2List[i + 1], isAbsolute);
-				}
+		static void applyStylesTo(SvgObject* output, const Style& style)
+		{
+			for (const StyleAttribute& attribute : style.attributes)
+			{
+				applyStyleAttributeTo(output, attribute);
 			}
-			break;
-			case PathTokenType::QuadCurveTo:
+		}
+
+		static void applyStyleAttributeTo(SvgObject* output, const StyleAttribute& attribute)
+		{
+			const std::string& attributeName = attribute.name();
+			if (attributeName == "fill-rule")
 			{
-				std::vector<Vec2> vec2List;
-				if (!parseVec2List(vec2List, parserInfo))
-				{
-					PANIC("Error interpreting move to command. Invalid coordinate encountered.");
-					return false;
-				}
-				if (vec2List.size() <= 0)
+				std::string value = attribute.value();
+				if (value == "evenodd")
 				{
-					PANIC("Error interpreting move to command. No coordinates provided.");
-					return false;
+					output->fillType = FillType::EvenOddFillType;
 				}
-
-				if (vec2List.size() % 2 != 0)
+				else if (value == "nonzero")
 				{
-					PANIC("Quadratic polybezier curve must have a multiple of 2 coordinates, otherwise it's not a valid polybezier curve.");
-					return false;
+					output->fillType = FillType::NonZeroFillType;
 				}
-
-				for (size_t i = 0; i < vec2List.size(); i += 2)
+				else
 				{
-					g_logger_assert(i + 1 < vec2List.size(), "Somehow ended up with a non-multiple of 2.");
-					Svg::bezier2To(res, vec2List[i + 0], vec2List[i + 1], isAbsolute);
+					g_logger_warning("Unknown fill-rule type: %s", value.c_str());
 				}
 			}
-			break;
-			case PathTokenType::SmoothQuadCurveTo:
+			else if (attributeName == "fill")
 			{
-				std::vector<Vec2> vec2List;
-				if (!parseVec2List(vec2List, parserInfo))
-				{
-					PANIC("Error interpreting move to command. Invalid coordinate encountered.");
-					return false;
-				}
-				if (vec2List.size() <= 0)
+				if (!(attribute.isColor()))
 				{
-					PANIC("Error interpreting move to command. No coordinates provided.");
-					return false;
+					PANIC("Invalid fill type '%s' in SVG document. Must be color.", attribute.value().c_str());
 				}
+				output->fillColor = attribute.asColor();
+			}
+		}
+
+		static SvgElementType elementStringToEnum(const XmlSlice& elementName)
+		{
+			struct ElementName
+			{
+				const char* name;
+				SvgElementType type;
+			};
+
+			static const ElementName elementNames[] = {
+				{ "path",    SvgElementType::Path },
+				{ "title",   SvgElementType::Title },
+				{ "desc",    SvgElementType::Desc },
+				{ "use",     SvgElementType::Use },
+				{ "rect",    SvgElementType::Rect },
+				{ "polygon", SvgElementType::Polygon },
+				{ "style",   SvgElementType::Style },
+				{ "defs",    SvgElementType::Defs }
+			};
 
-				for (size_t i = 0; i < vec2List.size(); i++)
+			for (const ElementName& element : elementNames)
+			{
+				if (elementName.equals(element.name))
 				{
-					Svg::smoothBezier2To(res, vec2List[i], isAbsolute);
+					return element.type;
 				}
 			}
-			break;
-			case PathTokenType::ArcTo:
+
+			return SvgElementType::None;
+		}
+
+		static bool isStyleAttribute(const XmlSlice& attributeName)
+		{
+			// These are a list of attributes that get skipped since they're not styles
+			static const char* attributeBlacklist[] = {
+				"d",
+				"class",
+				"id",
+				"points"
+			};
+
+			for (const char* blacklisted : attributeBlacklist)
 			{
-				std::vector<ArcParams> arcParamsList;
-				if (!parseArcParamsList(arcParamsList, parserInfo))
-				{
-					PANIC("Error interpreting move to command. Invalid coordinate encountered.");
-					return false;
-				}
-				if (arcParamsList.size() <= 0)
+				if (attributeName.equals(blacklisted))
 				{
-					PANIC("Error interpreting arc to command. No coordinates provided.");
 					return false;
 				}
+			}
 
-				for (size_t i = 0; i < arcParamsList.size(); i++)
-				{
-					Svg::arcTo(
-						res,
-						arcParamsList[i].radius,
-						arcParamsList[i].xAxisRotation,
-						arcParamsList[i].largeArcFlag,
-						arcParamsList[i].sweepFlag,
-						arcParamsList[i].endpoint,
-						isAbsolute
-					);
-				}
+			return true;
+		}
+
+		static bool interpretCommand(const PathToken& token, ParserInfo& parserInfo, SvgObject* res)
+		{
+			PathTokenType commandType = token.type;
+			bool isAbsolute = token.isAbsolute;
+			switch (commandType)
+			{
+			case PathTokenType::ClosePath:
+			{
+				bool isHole = res->numPaths > 1;
+				Svg::closePath(res, true, isHole);
+				return true;
 			}
-			break;
 			case PathTokenType::EndOfFile:
 				PANIC("Interpreting SVG EOF as a command. Something must have gone wrong. Check logs.");
-				break;
+				return true;
+			case PathTokenType::Panic:
+				return false;
 			case PathTokenType::Length:
 			case PathTokenType::Number:
-			case PathTokenType::Panic:
+				return true;
+			default:
 				break;
 			}
 
-			return true;
-		}
-
-		static bool parseVec2List(std::vector<Vec2>& list, ParserInfo& parserInfo)
-		{
+			// Commands can be followed by any number of argument groups, each group gets
+			// emitted into the svg as soon as it's parsed
+			float args[maxPathCommandArgs];
+			int numArgs = pathCommandArgCount(commandType);
+			bool isFirstGroup = true;
 			do
 			{
-				// TODO: Revisit this with a match(tokenType) statement
-				PathToken x = consume(PathTokenType::Number, parserInfo);
-				PathToken y = consume(PathTokenType::Number, parserInfo);
-
-				if (x.type == PathTokenType::Number && y.type == PathTokenType::Number)
+				if (!parseNumbers(parserInfo, args, numArgs))
 				{
-					float xVal = x.as.number;
-					float yVal = y.as.number;
-					list.emplace_back(Vec2{ xVal, yVal });
+					PANIC("Error interpreting path command. Expected %d numbers per coordinate group.", numArgs);
+					return false;
 				}
-				else
+
+				switch (commandType)
 				{
-					return false;
+				case PathTokenType::MoveTo:
+					// Coordinates after the first pair are implicit line tos
+					if (isFirstGroup)
+					{
+						Svg::moveTo(res, Vec2{ args[0], args[1] }, isAbsolute);
+					}
+					else
+					{
+						Svg::lineTo(res, Vec2{ args[0], args[1] }, isAbsolute);
+					}
+					break;
+				case PathTokenType::LineTo:
+					Svg::lineTo(res, Vec2{ args[0], args[1] }, isAbsolute);
+					break;
+				case PathTokenType::HzLineTo:
+					Svg::hzLineTo(res, args[0], isAbsolute);
+					break;
+				case PathTokenType::VtLineTo:
+					Svg::vtLineTo(res, args[0], isAbsolute);
+					break;
+				case PathTokenType::CurveTo:
+					Svg::bezier3To(res, Vec2{ args[0], args[1] }, Vec2{ args[2], args[3] }, Vec2{ args[4], args[5] }, isAbsolute);
+					break;
+				case PathTokenType::SmoothCurveTo:
+					Svg::smoothBezier3To(res, Vec2{ args[0], args[1] }, Vec2{ args[2], args[3] }, isAbsolute);
+					break;
+				case PathTokenType::QuadCurveTo:
+					Svg::bezier2To(res, Vec2{ args[0], args[1] }, Vec2{ args[2], args[3] }, isAbsolute);
+					break;
+				case PathTokenType::SmoothQuadCurveTo:
+					Svg::smoothBezier2To(res, Vec2{ args[0], args[1] }, isAbsolute);
+					break;
+				case PathTokenType::ArcTo:
+					Svg::arcTo(
+						res,
+						Vec2{ args[0], args[1] },
+						args[2],
+						args[3] != 0.0f,
+						args[4] != 0.0f,
+						Vec2{ args[5], args[6] },
+						isAbsolute
+					);
+					break;
+				default:
+					break;
 				}
+
+				isFirstGroup = false;
 			} while (isNumberPart(peek(parserInfo)));
 
 			return true;
 		}
 
-		static bool parseHzNumberList(std::vector<float>& list, ParserInfo& parserInfo)
+		static int pathCommandArgCount(PathTokenType commandType)
 		{
-			do
+			switch (commandType)
 			{
-				// TODO: Revisit this with a match(tokenType) statement
-				PathToken x = consume(PathTokenType::Number, parserInfo);
-
-				if (x.type == PathTokenType::Number)
-				{
-					float xVal = x.as.number;
-					list.emplace_back(xVal);
-				}
-				else
-				{
-					return false;
-				}
-			} while (isNumberPart(peek(parserInfo)));
+			case PathTokenType::MoveTo:
+			case PathTokenType::LineTo:
+			case PathTokenType::SmoothQuadCurveTo:
+				return 2;
+			case PathTokenType::HzLineTo:
+			case PathTokenType::VtLineTo:
+				return 1;
+			case PathTokenType::CurveTo:
+				return 6;
+			case PathTokenType::SmoothCurveTo:
+			case PathTokenType::QuadCurveTo:
+				return 4;
+			case PathTokenType::ArcTo:
+				return maxPathCommandArgs;
+			default:
+				break;
+			}
 
-			return true;
+			return 0;
 		}
 
-		static bool parseVtNumberList(std::vector<float>& list, ParserInfo& parserInfo)
+		static bool parseNumbers(ParserInfo& parserInfo, float* out, int count)
 		{
-			do
+			for (int i = 0; i < count; i++)
 			{
-				// TODO: Revisit this with a match(tokenType) statement
-				PathToken y = consume(PathTokenType::Number, parserInfo);
-
-				if (y.type == PathTokenType::Number)
-				{
-					float yVal = y.as.number;
-					list.emplace_back(yVal);
-				}
-				else
+				if (!isNumberPart(peek(parserInfo)) || !parseNumber(parserInfo, &out[i]))
 				{
 					return false;
 				}
-			} while (isNumberPart(peek(parserInfo)));
+				skipWhitespaceAndCommas(parserInfo);
+			}
 
 			return true;
 		}
 
-		static bool parseArcParamsList(std::vector<ArcParams>& list, ParserInfo& parserInfo)
+		static bool parseVec2List(std::vector<Vec2>& list, ParserInfo& parserInfo)
 		{
 			do
 			{
 				// TODO: Revisit this with a match(tokenType) statement
-				PathToken rx = consume(PathTokenType::Number, parserInfo);
-				PathToken ry = consume(PathTokenType::Number, parserInfo);
-				PathToken xAxisRotation = consume(PathTokenType::Number, parserInfo);
-				PathToken largeArcFlag = consume(PathTokenType::Number, parserInfo);
-				PathToken sweepFlag = consume(PathTokenType::Number, parserInfo);
-				PathToken dstX = consume(PathTokenType::Number, parserInfo);
-				PathToken dstY = consume(PathTokenType::Number, parserInfo);
-
-				if (rx.type == PathTokenType::Number && ry.type == PathTokenType::Number &&
-					xAxisRotation.type == PathTokenType::Number &&
-					largeArcFlag.type == PathTokenType::Number && sweepFlag.type == PathTokenType::Number &&
-					dstX.type == PathTokenType::Number && dstY.type == PathTokenType::Number)
-				{
-					ArcParams res;
-					res.radius.x = rx.as.number;
-					res.radius.y = ry.as.number;
-					res.xAxisRotation = xAxisRotation.as.number;
-					res.largeArcFlag = largeArcFlag.as.number != 0.0f;
-					res.sweepFlag = sweepFlag.as.number != 0.0f;
-					res.endpoint.x = dstX.as.number;
-					res.endpoint.y = dstY.as.number;
-
-					list.emplace_back(res);
+				PathToken x = consume(PathTokenType::Number, parserInfo);
+				PathToken y = consume(PathTokenType::Number, parserInfo);
+
+				if (x.type == PathTokenType::Number && y.type == PathTokenType::Number)
+				{
+					float xVal = x.as.number;
+					float yVal = y.as.number;
+					list.emplace_back(Vec2{ xVal, yVal });
 				}
 				else
 				{
@@ -1269,12 +1293,12 @@ namespace MathAnim
 			return true;
 		}
 
-		static bool parseViewbox(Vec4* out, const char* viewboxStr)
+		static bool parseViewbox(Vec4* out, const XmlSlice& viewboxStr)
 		{
 			ParserInfo pi;
 			pi.cursor = 0;
-			pi.text = viewboxStr;
-			pi.textLength = std::strlen(viewboxStr);
+			pi.text = viewboxStr.text;
+			pi.textLength = viewboxStr.length;
 
 			PathToken x = parseNextPathToken(pi);
 			PathToken y = parseNextPathToken(pi);
@@ -1283,7 +1307,7 @@ namespace MathAnim
 
 			if (x.type != PathTokenType::Number || y.type != PathTokenType::Number || w.type != PathTokenType::Number || h.type != PathTokenType::Number)
 			{
-				PANIC("Malformed viewBox '%s'", viewboxStr);
+				PANIC("Malformed viewBox '%.*s'", (int)viewboxStr.length, viewboxStr.text);
 				return false;
 			}
 
@@ -1862,20 +1886,27 @@ namespace MathAnim
 			return true;
 		}
 
-		static bool sanitizeAttribute(const XMLAttribute* attribute, StyleAttribute* output)
+		static bool sanitizeAttribute(const XmlAttribute& attribute, StyleAttribute* output)
 		{
+			std::string valueStorage;
+			XmlSlice value = resolveEntities(attribute.value, &valueStorage);
+			if (value.length == 0)
+			{
+				return false;
+			}
+
 			// TODO: I really don't like this, but it might be the best way to leverage
 			// the parser to get the appropriate types and stuff...
 			ParserInfo pi;
 			pi.cursor = 0;
-			pi.text = attribute->Name();
-			pi.textLength = std::strlen(attribute->Name());
+			pi.text = attribute.name.text;
+			pi.textLength = attribute.name.length;
 
 			StyleToken attributeNameToken = parseNextStyleToken(pi);
 
 			pi.cursor = 0;
-			pi.text = attribute->Value();
-			pi.textLength = std::strlen(attribute->Value());
+			pi.text = value.text;
+			pi.textLength = value.length;
 			StyleToken attributeValueToken = parseNextStyleToken(pi);
 
 			bool res = sanitizeAttribute(attributeNameToken, attributeValueToken, output);
@@ -1890,37 +1921,30 @@ namespace MathAnim
 
 		static bool parseNumber(ParserInfo& parserInfo, float* out)
 		{
-			size_t numberStart = parserInfo.cursor;
-			size_t numberEnd = parserInfo.cursor;
-
-			bool seenDot = false;
-			if (peek(parserInfo) == '-')
-			{
-				numberEnd++;
-				advance(parserInfo);
-			}
+			const char* numberStart = parserInfo.text + parserInfo.cursor;
+			const char* textEnd = parserInfo.text + parserInfo.textLength;
 
-			while (isDigit(peek(parserInfo)) || (peek(parserInfo) == '.' && !seenDot))
+			// SVG numbers can start with a plus sign but from_chars won't take one
+			if (numberStart < textEnd && *numberStart == '+')
 			{
-				seenDot = seenDot || peek(parserInfo) == '.';
-				numberEnd++;
-				advance(parserInfo);
+				numberStart++;
+				if (numberStart < textEnd && (*numberStart == '+' || *numberStart == '-'))
+				{
+					*out = 0.0f;
+					return false;
+				}
 			}
 
-			if (numberEnd > numberStart)
+			// Parses in place, there's no need to copy the number out of the text first
+			std::from_chars_result result = std::from_chars(numberStart, textEnd, *out);
+			if (result.ec != std::errc())
 			{
-				constexpr int maxSmallBufferSize = 32;
-				char smallBuffer[maxSmallBufferSize];
-				g_logger_assert(numberEnd - numberStart <= maxSmallBufferSize, "Cannot parse number greater than %d characters big.", maxSmallBufferSize);
-				g_memory_copyMem(smallBuffer, (void*)(parserInfo.text + numberStart), sizeof(char) * (numberEnd - numberStart));
-				smallBuffer[numberEnd - numberStart] = '\0';
-				// TODO: atof is not safe use a safer modern alternative
-				*out = (float)atof(smallBuffer);
-				return true;
+				*out = 0.0f;
+				return false;
 			}
 
-			*out = 0.0f;
-			return false;
+			parserInfo.cursor = (size_t)(result.ptr - parserInfo.text);
+			return true;
 		}
 
 		static bool parseString(ParserInfo& parserInfo, DumbString* string, char stringTerminator)
@@ -0,0 +1,83 @@
+#include "svg/SvgParserBenchmark.h"
+#include "svg/SvgParser.h"
+#include "svg/Svg.h"
+#include "core/CommandLine.h"
+
+#include <algorithm>
+#include <chrono>
+
+namespace MathAnim
+{
+	namespace SvgParserBenchmark
+	{
+		bool run(const SvgBenchmarkOptions& options)
+		{
+			std::vector<std::filesystem::path> corpus;
+			std::error_code err;
+			for (auto iter = std::filesystem::directory_iterator(options.corpusDir, err); !err && iter != std::filesystem::directory_iterator(); iter.increment(err))
+			{
+				if (iter->is_regular_file(err) && iter->path().extension() == ".svg")
+				{
+					corpus.push_back(iter->path());
+				}
+			}
+
+			if (corpus.size() == 0)
+			{
+				g_logger_error("No .svg files found in benchmark corpus '%s'.", options.corpusDir.c_str());
+				return false;
+			}
+
+			// Directory order isn't stable between runs or platforms
+			std::sort(corpus.begin(), corpus.end());
+
+			SvgParser::init();
+
+			g_logger_info("Parsing %d SVG files %d times each", (int)corpus.size(), options.iterations);
+			g_logger_info("%-32s %10s %10s %12s %10s", "File", "Size (KB)", "Min (ms)", "Median (ms)", "MB/s");
+
+			std::vector<double> timings;
+			timings.reserve(options.iterations);
+			double totalMedianMs = 0.0;
+			uintmax_t totalBytes = 0;
+			for (const std::filesystem::path& file : corpus)
+			{
+				uintmax_t fileSize = std::filesystem::file_size(file, err);
+				std::string filepath = file.string();
+
+				timings.clear();
+				for (int i = 0; i < options.iterations; i++)
+				{
+					auto startTime = std::chrono::steady_clock::now();
+					SvgGroup* group = SvgParser::parseSvgDoc(filepath.c_str());
+					double elapsedMs = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - startTime).count();
+
+					if (!group)
+					{
+						g_logger_error("Failed to parse benchmark file '%s': %s", filepath.c_str(), SvgParser::getLastError());
+						return false;
+					}
+
+					group->free();
+					g_memory_free(group);
+					timings.push_back(elapsedMs);
+				}
+
+				std::sort(timings.begin(), timings.end());
+				double minMs = timings[0];
+				double medianMs = timings[timings.size() / 2];
+				double megabytesPerSecond = ((double)fileSize / (1024.0 * 1024.0)) / (medianMs / 1000.0);
+				g_logger_info("%-32s %10.1f %10.3f %12.3f %10.1f",
+					file.filename().string().c_str(), (double)fileSize / 1024.0, minMs, medianMs, megabytesPerSecond);
+
+				totalMedianMs += medianMs;
+				totalBytes += fileSize;
+			}
+
+			double totalMegabytesPerSecond = ((double)totalBytes / (1024.0 * 1024.0)) / (totalMedianMs / 1000.0);
+			g_logger_info("%-32s %10.1f %10s %12.3f %10.1f", "Total", (double)totalBytes / 1024.0, "", totalMedianMs, totalMegabytesPerSecond);
+
+			return true;
+		}
+	}
+}
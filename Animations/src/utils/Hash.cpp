@@ -0,0 +1,21 @@
+#include "utils/Hash.h"
+
+namespace MathAnim
+{
+	namespace Hash
+	{
+		static constexpr uint64 fnvPrime = 1099511628211ULL;
+
+		uint64 fnv1a(const void* data, size_t size, uint64 hash)
+		{
+			const uint8* bytes = (const uint8*)data;
+			for (size_t i = 0; i < size; i++)
+			{
+				hash ^= bytes[i];
+				hash *= fnvPrime;
+			}
+
+			return hash;
+		}
+	}
+}
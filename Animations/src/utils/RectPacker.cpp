@@ -0,0 +1,434 @@
+#include "utils/RectPacker.h"
+
+namespace MathAnim
+{
+	// ------------- Internal Functions -------------
+	static bool intersects(const PackedRect& a, const PackedRect& b);
+	static bool contains(const PackedRect& outer, const PackedRect& inner);
+	static void splitFreeRect(const PackedRect& freeRect, const PackedRect& usedRect, std::vector<PackedRect>& newFreeRects);
+	static bool tryMerge(PackedRect& a, const PackedRect& b);
+	static void pruneFreeRects(std::vector<PackedRect>& freeRects);
+	// Returns the lowest y a rect can sit at if its left edge is on the node at
+	// nodeIndex, or -1 if it doesn't fit there
+	static int32 skylineFitsAt(const SkylinePacker& packer, size_t nodeIndex, int32 rectWidth, int32 rectHeight);
+
+	void RectPacker::init(int32 inWidth, int32 inHeight)
+	{
+		g_logger_assert(inWidth > 0 && inHeight > 0, "Cannot create rect packer of size %dx%d.", inWidth, inHeight);
+		width = inWidth;
+		height = inHeight;
+		clear();
+	}
+
+	void RectPacker::free()
+	{
+		freeRects.clear();
+		freeRects.shrink_to_fit();
+		usedArea = 0;
+		numAllocations = 0;
+	}
+
+	void RectPacker::clear()
+	{
+		freeRects.clear();
+		freeRects.push_back(PackedRect{ 0, 0, width, height });
+		usedArea = 0;
+		numAllocations = 0;
+	}
+
+	bool RectPacker::allocate(int32 rectWidth, int32 rectHeight, PackedRect* out)
+	{
+		g_logger_assert(out != nullptr, "Cannot allocate into null rect.");
+		if (rectWidth <= 0 || rectHeight <= 0 || rectWidth > width || rectHeight > height)
+		{
+			return false;
+		}
+
+		// Best short side fit, place the rect where it leaves the smallest leftover
+		// strip. Ties are broken with the long side.
+		int bestIndex = -1;
+		int32 bestShortSide = INT32_MAX;
+		int32 bestLongSide = INT32_MAX;
+		for (size_t i = 0; i < freeRects.size(); i++)
+		{
+			const PackedRect& freeRect = freeRects[i];
+			if (freeRect.width < rectWidth || freeRect.height < rectHeight)
+			{
+				continue;
+			}
+
+			int32 leftoverX = freeRect.width - rectWidth;
+			int32 leftoverY = freeRect.height - rectHeight;
+			int32 shortSide = glm::min(leftoverX, leftoverY);
+			int32 longSide = glm::max(leftoverX, leftoverY);
+			if (shortSide < bestShortSide || (shortSide == bestShortSide && longSide < bestLongSide))
+			{
+				bestIndex = (int)i;
+				bestShortSide = shortSide;
+				bestLongSide = longSide;
+			}
+		}
+
+		if (bestIndex < 0)
+		{
+			return false;
+		}
+
+		PackedRect placed = PackedRect{ freeRects[bestIndex].x, freeRects[bestIndex].y, rectWidth, rectHeight };
+
+		// Carve the placed rect out of every free rect it overlaps
+		std::vector<PackedRect> newFreeRects;
+		for (size_t i = 0; i < freeRects.size();)
+		{
+			if (intersects(freeRects[i], placed))
+			{
+				splitFreeRect(freeRects[i], placed, newFreeRects);
+				freeRects[i] = freeRects.back();
+				freeRects.pop_back();
+			}
+			else
+			{
+				i++;
+			}
+		}
+		freeRects.insert(freeRects.end(), newFreeRects.begin(), newFreeRects.end());
+		pruneFreeRects(freeRects);
+
+		usedArea += (int64)rectWidth * (int64)rectHeight;
+		numAllocations++;
+		*out = placed;
+		return true;
+	}
+
+	void RectPacker::release(const PackedRect& rect)
+	{
+		g_logger_assert(numAllocations > 0, "Releasing rect from empty rect packer.");
+		usedArea -= (int64)rect.width * (int64)rect.height;
+		numAllocations--;
+
+		// Nothing left on the page, skip the merging and start over with one big rect
+		if (numAllocations == 0)
+		{
+			clear();
+			return;
+		}
+
+		// Grow the released rect by merging it with free rects that share a full edge
+		// with it. Every merge can enable another one, so keep going until nothing changes.
+		PackedRect merged = rect;
+		bool didMerge = true;
+		while (didMerge)
+		{
+			didMerge = false;
+			for (size_t i = 0; i < freeRects.size(); i++)
+			{
+				if (tryMerge(merged, freeRects[i]))
+				{
+					freeRects[i] = freeRects.back();
+					freeRects.pop_back();
+					didMerge = true;
+					break;
+				}
+			}
+		}
+
+		freeRects.push_back(merged);
+		pruneFreeRects(freeRects);
+	}
+
+	int64 RectPacker::freeArea() const
+	{
+		return (int64)width * (int64)height - usedArea;
+	}
+
+	int64 RectPacker::largestFreeArea() const
+	{
+		int64 res = 0;
+		for (const PackedRect& freeRect : freeRects)
+		{
+			res = glm::max(res, (int64)freeRect.width * (int64)freeRect.height);
+		}
+		return res;
+	}
+
+	float RectPacker::occupancy() const
+	{
+		return (float)((double)usedArea / ((double)width * (double)height));
+	}
+
+	float RectPacker::fragmentation() const
+	{
+		int64 totalFree = freeArea();
+		if (totalFree <= 0)
+		{
+			return 0.0f;
+		}
+
+		return glm::clamp(1.0f - (float)((double)largestFreeArea() / (double)totalFree), 0.0f, 1.0f);
+	}
+
+	void SkylinePacker::init(int32 inWidth, int32 inHeight)
+	{
+		g_logger_assert(inWidth > 0 && inHeight > 0, "Cannot create skyline packer of size %dx%d.", inWidth, inHeight);
+		width = inWidth;
+		height = inHeight;
+		clear();
+	}
+
+	void SkylinePacker::free()
+	{
+		skyline.clear();
+		skyline.shrink_to_fit();
+		usedArea = 0;
+	}
+
+	void SkylinePacker::clear()
+	{
+		skyline.clear();
+		skyline.push_back(SkylineNode{ 0, 0, width });
+		usedArea = 0;
+	}
+
+	bool SkylinePacker::allocate(int32 rectWidth, int32 rectHeight, PackedRect* out)
+	{
+		g_logger_assert(out != nullptr, "Cannot allocate into null rect.");
+		if (rectWidth <= 0 || rectHeight <= 0 || rectWidth > width || rectHeight > height)
+		{
+			return false;
+		}
+
+		int bestIndex = -1;
+		int32 bestY = INT32_MAX;
+		int32 bestWaste = INT32_MAX;
+		for (size_t i = 0; i < skyline.size(); i++)
+		{
+			int32 y = skylineFitsAt(*this, i, rectWidth, rectHeight);
+			if (y < 0)
+			{
+				continue;
+			}
+
+			// The waste is the area between the skyline and the bottom of the rect
+			int32 waste = 0;
+			int32 rectRight = skyline[i].x + rectWidth;
+			for (size_t j = i; j < skyline.size() && skyline[j].x < rectRight; j++)
+			{
+				int32 overlap = glm::min(rectRight, skyline[j].x + skyline[j].width) - skyline[j].x;
+				waste += (y - skyline[j].y) * overlap;
+			}
+
+			if (y < bestY || (y == bestY && waste < bestWaste))
+			{
+				bestIndex = (int)i;
+				bestY = y;
+				bestWaste = waste;
+			}
+		}
+
+		if (bestIndex < 0)
+		{
+			return false;
+		}
+
+		PackedRect placed = PackedRect{ skyline[bestIndex].x, bestY, rectWidth, rectHeight };
+
+		// Raise the skyline over the placed rect and trim the nodes it now covers
+		skyline.insert(skyline.begin() + bestIndex, SkylineNode{ placed.x, placed.y + placed.height, placed.width });
+		int32 placedRight = placed.x + placed.width;
+		for (size_t i = bestIndex + 1; i < skyline.size();)
+		{
+			SkylineNode& node = skyline[i];
+			if (node.x >= placedRight)
+			{
+				break;
+			}
+
+			int32 nodeRight = node.x + node.width;
+			if (nodeRight <= placedRight)
+			{
+				skyline.erase(skyline.begin() + i);
+			}
+			else
+			{
+				node.width = nodeRight - placedRight;
+				node.x = placedRight;
+				break;
+			}
+		}
+
+		// Neighbours at the same height are one segment
+		for (size_t i = 0; i + 1 < skyline.size();)
+		{
+			if (skyline[i].y == skyline[i + 1].y)
+			{
+				skyline[i].width += skyline[i + 1].width;
+				skyline.erase(skyline.begin() + i + 1);
+			}
+			else
+			{
+				i++;
+			}
+		}
+
+		usedArea += (int64)rectWidth * (int64)rectHeight;
+		*out = placed;
+		return true;
+	}
+
+	void SkylinePacker::grow(int32 newWidth, int32 newHeight)
+	{
+		g_logger_assert(newWidth >= width && newHeight >= height, "Cannot shrink skyline packer from %dx%d to %dx%d.", width, height, newWidth, newHeight);
+		if (newWidth > width)
+		{
+			// The new columns are empty all the way down
+			if (skyline.size() > 0 && skyline.back().y == 0)
+			{
+				skyline.back().width += newWidth - width;
+			}
+			else
+			{
+				skyline.push_back(SkylineNode{ width, 0, newWidth - width });
+			}
+		}
+
+		width = newWidth;
+		height = newHeight;
+	}
+
+	float SkylinePacker::occupancy() const
+	{
+		return (float)((double)usedArea / ((double)width * (double)height));
+	}
+
+	// ------------- Internal Functions -------------
+	static bool intersects(const PackedRect& a, const PackedRect& b)
+	{
+		return a.x < b.x + b.width && b.x < a.x + a.width &&
+			a.y < b.y + b.height && b.y < a.y + a.height;
+	}
+
+	static bool contains(const PackedRect& outer, const PackedRect& inner)
+	{
+		return inner.x >= outer.x && inner.y >= outer.y &&
+			inner.x + inner.width <= outer.x + outer.width &&
+			inner.y + inner.height <= outer.y + outer.height;
+	}
+
+	static void splitFreeRect(const PackedRect& freeRect, const PackedRect& usedRect, std::vector<PackedRect>& newFreeRects)
+	{
+		// Keep the maximal strips of freeRect on each side of usedRect. The strips overlap
+		// in the corners, that's what makes them maximal.
+		if (usedRect.y > freeRect.y)
+		{
+			newFreeRects.push_back(PackedRect{ freeRect.x, freeRect.y, freeRect.width, usedRect.y - freeRect.y });
+		}
+
+		int32 usedBottom = usedRect.y + usedRect.height;
+		int32 freeBottom = freeRect.y + freeRect.height;
+		if (usedBottom < freeBottom)
+		{
+			newFreeRects.push_back(PackedRect{ freeRect.x, usedBottom, freeRect.width, freeBottom - usedBottom });
+		}
+
+		if (usedRect.x > freeRect.x)
+		{
+			newFreeRects.push_back(PackedRect{ freeRect.x, freeRect.y, usedRect.x - freeRect.x, freeRect.height });
+		}
+
+		int32 usedRight = usedRect.x + usedRect.width;
+		int32 freeRight = freeRect.x + freeRect.width;
+		if (usedRight < freeRight)
+		{
+			newFreeRects.push_back(PackedRect{ usedRight, freeRect.y, freeRight - usedRight, freeRect.height });
+		}
+	}
+
+	static bool tryMerge(PackedRect& a, const PackedRect& b)
+	{
+		// Stacked vertically with the same horizontal span
+		if (a.x == b.x && a.width == b.width)
+		{
+			if (a.y + a.height == b.y)
+			{
+				a.height += b.height;
+				return true;
+			}
+			if (b.y + b.height == a.y)
+			{
+				a.y = b.y;
+				a.height += b.height;
+				return true;
+			}
+		}
+
+		// Side by side with the same vertical span
+		if (a.y == b.y && a.height == b.height)
+		{
+			if (a.x + a.width == b.x)
+			{
+				a.width += b.width;
+				return true;
+			}
+			if (b.x + b.width == a.x)
+			{
+				a.x = b.x;
+				a.width += b.width;
+				return true;
+			}
+		}
+
+		return false;
+	}
+
+	static void pruneFreeRects(std::vector<PackedRect>& freeRects)
+	{
+		// Free rects that are fully inside another free rect are redundant
+		for (size_t i = 0; i < freeRects.size(); i++)
+		{
+			for (size_t j = i + 1; j < freeRects.size();)
+			{
+				if (contains(freeRects[i], freeRects[j]))
+				{
+					freeRects[j] = freeRects.back();
+					freeRects.pop_back();
+				}
+				else if (contains(freeRects[j], freeRects[i]))
+				{
+					freeRects[i] = freeRects[j];
+					freeRects[j] = freeRects.back();
+					freeRects.pop_back();
+					// Restart the comparisons for the rect that now lives at i
+					j = i + 1;
+				}
+				else
+				{
+					j++;
+				}
+			}
+		}
+	}
+
+	static int32 skylineFitsAt(const SkylinePacker& packer, size_t nodeIndex, int32 rectWidth, int32 rectHeight)
+	{
+		if (packer.skyline[nodeIndex].x + rectWidth > packer.width)
+		{
+			return -1;
+		}
+
+		// The rect rests on the highest node it spans
+		int32 y = 0;
+		int32 widthLeft = rectWidth;
+		for (size_t i = nodeIndex; widthLeft > 0; i++)
+		{
+			g_logger_assert(i < packer.skyline.size(), "Skyline does not cover the whole width of the packer.");
+			y = glm::max(y, packer.skyline[i].y);
+			if (y + rectHeight > packer.height)
+			{
+				return -1;
+			}
+			widthLeft -= packer.skyline[i].width;
+		}
+
+		return y;
+	}
+}
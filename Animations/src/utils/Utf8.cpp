@@ -0,0 +1,97 @@
+#include "utils/Utf8.h"
+
+namespace MathAnim
+{
+	namespace Utf8
+	{
+		uint32 decode(const uint8* str, size_t length, int* outNumBytes)
+		{
+			g_logger_assert(length > 0, "Cannot decode an empty UTF-8 string.");
+
+			uint8 lead = str[0];
+			int numBytes = 0;
+			uint32 res = 0;
+			uint32 minCodepoint = 0;
+			if (lead < 0x80)
+			{
+				*outNumBytes = 1;
+				return lead;
+			}
+			else if ((lead & 0xE0) == 0xC0)
+			{
+				numBytes = 2;
+				res = lead & 0x1F;
+				minCodepoint = 0x80;
+			}
+			else if ((lead & 0xF0) == 0xE0)
+			{
+				numBytes = 3;
+				res = lead & 0x0F;
+				minCodepoint = 0x800;
+			}
+			else if ((lead & 0xF8) == 0xF0)
+			{
+				numBytes = 4;
+				res = lead & 0x07;
+				minCodepoint = 0x10000;
+			}
+
+			*outNumBytes = 1;
+			if (numBytes == 0 || (size_t)numBytes > length)
+			{
+				return replacementCharacter;
+			}
+
+			for (int i = 1; i < numBytes; i++)
+			{
+				if ((str[i] & 0xC0) != 0x80)
+				{
+					return replacementCharacter;
+				}
+				res = (res << 6) | (str[i] & 0x3F);
+			}
+
+			// Overlong encodings, surrogates and anything past the last plane are invalid
+			if (res < minCodepoint || (res >= 0xD800 && res <= 0xDFFF) || res > 0x10FFFF)
+			{
+				return replacementCharacter;
+			}
+
+			*outNumBytes = numBytes;
+			return res;
+		}
+
+		int encode(uint32 codepoint, uint8* out)
+		{
+			if (codepoint > 0x10FFFF || (codepoint >= 0xD800 && codepoint <= 0xDFFF))
+			{
+				codepoint = replacementCharacter;
+			}
+
+			if (codepoint < 0x80)
+			{
+				out[0] = (uint8)codepoint;
+				return 1;
+			}
+			else if (codepoint < 0x800)
+			{
+				out[0] = (uint8)(0xC0 | (codepoint >> 6));
+				out[1] = (uint8)(0x80 | (codepoint & 0x3F));
+				return 2;
+			}
+			else if (codepoint < 0x10000)
+			{
+				out[0] = (uint8)(0xE0 | (codepoint >> 12));
+				out[1] = (uint8)(0x80 | ((codepoint >> 6) & 0x3F));
+				out[2] = (uint8)(0x80 | (codepoint & 0x3F));
+				return 3;
+			}
+
+			out[0] = (uint8)(0xF0 | (codepoint >> 18));
+			out[1] = (uint8)(0x80 | ((codepoint >> 12) & 0x3F));
+			out[2] = (uint8)(0x80 | ((codepoint >> 6) & 0x3F));
+			out[3] = (uint8)(0x80 | (codepoint & 0x3F));
+			return 4;
+		}
+	}
+}
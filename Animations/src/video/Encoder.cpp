@@ -20,7 +20,9 @@ namespace MathAnim
 		//static const int bitrate = 2000;
 
 		// ---------------- Internal functions ----------------
-		static bool encodePacket(VideoEncoder& encoder);
+		static bool submitFrame(VideoEncoder& encoder);
+		static bool encodePacket(VideoEncoder& encoder, bool flush = false);
+		static bool remuxConcatList(const char* listFilename, const char* outputFilename, AVFormatContext** inputContext, AVFormatContext** outputContext);
 		static void printError(int errorNum);
 
 		// Adapted from https://stackoverflow.com/questions/46444474/c-ffmpeg-create-mp4-file
@@ -39,6 +41,7 @@ namespace MathAnim
 			output->height = outputHeight;
 			output->framerate = outputFramerate;
 			output->frameCounter = 0;
+			output->duplicateFrameCount = 0;
 			output->logProgress = logProgress;
 
 			output->codecContext = nullptr;
@@ -109,8 +112,12 @@ namespace MathAnim
 			avcodec_parameters_to_context(output->codecContext, stream->codecpar);
 			output->codecContext->max_b_frames = 2;
 			output->codecContext->gop_size = 12;
+			// Closed GOPs so that no frame references anything before the previous keyframe.
+			// This is what makes it possible to concat segments without re-encoding.
+			output->codecContext->flags |= AV_CODEC_FLAG_CLOSED_GOP;
 			output->codecContext->time_base = AVRational{ 1, output->framerate };
 			output->codecContext->framerate = AVRational{ output->framerate, 1 };
+			stream->time_base = output->codecContext->time_base;
 
 			if (stream->codecpar->codec_id == AV_CODEC_ID_H264 || stream->codecpar->codec_id == AV_CODEC_ID_H265)
 			{
@@ -185,6 +192,15 @@ namespace MathAnim
 				);
 			}
 
+			// The encoder may still hold a reference to the last frame we sent it (B-frames,
+			// lookahead or a duplicated frame), so make sure we're not writing over its pixels
+			if ((err = av_frame_make_writable(encoder.videoFrame)) < 0)
+			{
+				g_logger_error("Failed to make video frame writable.");
+				printError(err);
+				return false;
+			}
+
 			int inLinesize[1] = { 3 * encoder.codecContext->width };
 
 			// Convert from RGB to YUV
@@ -199,24 +215,29 @@ namespace MathAnim
 				encoder.videoFrame->linesize
 			);
 
-			encoder.videoFrame->pts = (int64)((1.0 / (double)encoder.framerate) * 90000.0 * (double)(encoder.frameCounter++));
+			return submitFrame(encoder);
+		}
 
-			if (encoder.logProgress && ((encoder.frameCounter % encoder.framerate) == 0))
+		bool pushDuplicateFrame(VideoEncoder& encoder)
+		{
+			if (!encoder.videoFrame)
 			{
-				g_logger_info("%d second(s) encoded.", (encoder.frameCounter / 60));
+				g_logger_error("Cannot duplicate a frame before any frame has been pushed.");
+				return false;
 			}
 
-			return encodePacket(encoder);
+			// The YUV frame from the last pushFrame is still sitting in videoFrame, so
+			// all that changes is the timestamp
+			encoder.duplicateFrameCount++;
+			return submitFrame(encoder);
 		}
 
 		bool finalizeEncodingFile(VideoEncoder& encoder)
 		{
-			for (;;)
+			// Drain any frames the encoder is still holding on to (B-frames etc)
+			if (!encodePacket(encoder, true))
 			{
-				if (!encodePacket(encoder))
-				{
-					break;
-				}
+				g_logger_error("Failed to flush encoder.");
 			}
 
 			int err = av_write_trailer(encoder.formatContext);
@@ -250,6 +271,7 @@ namespace MathAnim
 			}
 
 			encoder.frameCounter = 0;
+			encoder.duplicateFrameCount = 0;
 			encoder.filenameLength = 0;
 			encoder.width = 0;
 			encoder.height = 0;
@@ -282,40 +304,244 @@ namespace MathAnim
 			}
 		}
 
+		bool concatSegments(const std::vector<std::string>& segmentFilenames, const char* outputFilename)
+		{
+			if (segmentFilenames.size() == 0)
+			{
+				g_logger_error("No segments to concatenate into '%s'.", outputFilename);
+				return false;
+			}
+
+			// The concat demuxer reads a small text file listing each segment
+			std::string listFilename = std::string(outputFilename) + ".concat.txt";
+			{
+				FILE* fp = fopen(listFilename.c_str(), "wb");
+				if (!fp)
+				{
+					g_logger_error("Failed to create concat list file '%s'.", listFilename.c_str());
+					return false;
+				}
+
+				for (const std::string& segment : segmentFilenames)
+				{
+					std::string absolutePath = std::filesystem::absolute(segment).generic_string();
+					fprintf(fp, "file '%s'\n", absolutePath.c_str());
+				}
+				fclose(fp);
+			}
+
+			AVFormatContext* inputContext = nullptr;
+			AVFormatContext* outputContext = nullptr;
+			bool success = remuxConcatList(listFilename.c_str(), outputFilename, &inputContext, &outputContext);
+
+			if (inputContext)
+			{
+				avformat_close_input(&inputContext);
+			}
+			if (outputContext)
+			{
+				if (!(outputContext->oformat->flags & AVFMT_NOFILE) && outputContext->pb)
+				{
+					avio_closep(&outputContext->pb);
+				}
+				avformat_free_context(outputContext);
+			}
+			remove(listFilename.c_str());
+
+			return success;
+		}
+
+		int countFrames(const char* filename)
+		{
+			AVFormatContext* inputContext = nullptr;
+			int err;
+			if ((err = avformat_open_input(&inputContext, filename, nullptr, nullptr)) < 0)
+			{
+				return -1;
+			}
+
+			if ((err = avformat_find_stream_info(inputContext, nullptr)) < 0)
+			{
+				avformat_close_input(&inputContext);
+				return -1;
+			}
+
+			int videoStream = av_find_best_stream(inputContext, AVMEDIA_TYPE_VIDEO, -1, -1, nullptr, 0);
+			if (videoStream < 0)
+			{
+				avformat_close_input(&inputContext);
+				return -1;
+			}
+
+			// Container frame counts aren't always filled in, counting packets works everywhere
+			int numFrames = 0;
+			AVPacket* pkt = av_packet_alloc();
+			while (av_read_frame(inputContext, pkt) >= 0)
+			{
+				if (pkt->stream_index == videoStream)
+				{
+					numFrames++;
+				}
+				av_packet_unref(pkt);
+			}
+			av_packet_free(&pkt);
+			avformat_close_input(&inputContext);
+
+			return numFrames;
+		}
+
 		// ---------------- Internal functions ----------------
-		static bool encodePacket(VideoEncoder& encoder)
+		static bool submitFrame(VideoEncoder& encoder)
 		{
+			// PTS is in codec time base units (1/framerate), it gets rescaled to the
+			// stream time base when the packet is written
+			encoder.videoFrame->pts = (int64)(encoder.frameCounter++);
+
+			if (encoder.logProgress && ((encoder.frameCounter % encoder.framerate) == 0))
+			{
+				g_logger_info("%d second(s) encoded.", (encoder.frameCounter / 60));
+			}
+
+			return encodePacket(encoder);
+		}
+
+		static bool encodePacket(VideoEncoder& encoder, bool flush)
+		{
+			// Sending a null frame puts the encoder in draining mode
 			int err;
-			if ((err = avcodec_send_frame(encoder.codecContext, encoder.videoFrame)) < 0)
+			if ((err = avcodec_send_frame(encoder.codecContext, flush ? nullptr : encoder.videoFrame)) < 0)
 			{
 				g_logger_error("Failed to send frame '%d'", encoder.frameCounter);
 				printError(err);
 				return false;
 			}
 
-			AVPacket pkt;
-			av_init_packet(&pkt);
-			pkt.data = NULL;
-			pkt.size = 0;
-			pkt.flags |= AV_PKT_FLAG_KEY;
-			if ((err = avcodec_receive_packet(encoder.codecContext, &pkt)) < 0)
+			AVPacket* pkt = av_packet_alloc();
+			AVStream* stream = encoder.formatContext->streams[0];
+			bool success = true;
+			for (;;)
 			{
-				g_logger_error("Failed to recieve packet.");
+				err = avcodec_receive_packet(encoder.codecContext, pkt);
+				if (err == AVERROR(EAGAIN) || err == AVERROR_EOF)
+				{
+					// The encoder needs more input (or is fully drained), this isn't an error
+					break;
+				}
+				else if (err < 0)
+				{
+					g_logger_error("Failed to recieve packet.");
+					printError(err);
+					success = false;
+					break;
+				}
+
+				av_packet_rescale_ts(pkt, encoder.codecContext->time_base, stream->time_base);
+				pkt->stream_index = stream->index;
+				if ((err = av_interleaved_write_frame(encoder.formatContext, pkt)) < 0)
+				{
+					g_logger_error("Failed to write frame: %d", encoder.frameCounter);
+					printError(err);
+					success = false;
+					break;
+				}
+			}
+
+			av_packet_free(&pkt);
+			return success;
+		}
+
+		static bool remuxConcatList(const char* listFilename, const char* outputFilename, AVFormatContext** inputContext, AVFormatContext** outputContext)
+		{
+			// Allow absolute paths in the list file
+			AVDictionary* inputOptions = nullptr;
+			av_dict_set(&inputOptions, "safe", "0", 0);
+			const AVInputFormat* concatFormat = av_find_input_format("concat");
+			int err = avformat_open_input(inputContext, listFilename, concatFormat, &inputOptions);
+			av_dict_free(&inputOptions);
+			if (err < 0)
+			{
+				g_logger_error("Failed to open concat list '%s'.", listFilename);
+				printError(err);
+				return false;
+			}
+
+			if ((err = avformat_find_stream_info(*inputContext, nullptr)) < 0)
+			{
+				g_logger_error("Failed to read segment stream info.");
+				printError(err);
+				return false;
+			}
+
+			if ((err = avformat_alloc_output_context2(outputContext, nullptr, nullptr, outputFilename)) < 0)
+			{
+				g_logger_error("Could not create output context for '%s'.", outputFilename);
 				printError(err);
-				av_packet_unref(&pkt);
 				return false;
 			}
 
-			uint8_t* size = ((uint8_t*)pkt.data);
-			if ((err = av_interleaved_write_frame(encoder.formatContext, &pkt)) < 0)
+			for (unsigned int i = 0; i < (*inputContext)->nb_streams; i++)
 			{
-				g_logger_error("Failed to write frame: %d", encoder.frameCounter);
+				AVStream* inStream = (*inputContext)->streams[i];
+				AVStream* outStream = avformat_new_stream(*outputContext, nullptr);
+				if (!outStream || avcodec_parameters_copy(outStream->codecpar, inStream->codecpar) < 0)
+				{
+					g_logger_error("Failed to copy stream parameters for stream %d.", i);
+					return false;
+				}
+				outStream->codecpar->codec_tag = 0;
+				outStream->time_base = inStream->time_base;
+			}
+
+			if (!((*outputContext)->oformat->flags & AVFMT_NOFILE))
+			{
+				if ((err = avio_open(&(*outputContext)->pb, outputFilename, AVIO_FLAG_WRITE)) < 0)
+				{
+					g_logger_error("Failed to open file '%s'.", outputFilename);
+					printError(err);
+					return false;
+				}
+			}
+
+			if ((err = avformat_write_header(*outputContext, nullptr)) < 0)
+			{
+				g_logger_error("Failed to write file header.");
+				printError(err);
+				return false;
+			}
+
+			AVPacket* pkt = av_packet_alloc();
+			bool success = true;
+			while (av_read_frame(*inputContext, pkt) >= 0)
+			{
+				AVStream* inStream = (*inputContext)->streams[pkt->stream_index];
+				AVStream* outStream = (*outputContext)->streams[pkt->stream_index];
+				av_packet_rescale_ts(pkt, inStream->time_base, outStream->time_base);
+				pkt->pos = -1;
+
+				err = av_interleaved_write_frame(*outputContext, pkt);
+				av_packet_unref(pkt);
+				if (err < 0)
+				{
+					g_logger_error("Failed to write packet while concatenating segments.");
+					printError(err);
+					success = false;
+					break;
+				}
+			}
+			av_packet_free(&pkt);
+
+			if (!success)
+			{
+				return false;
+			}
+
+			if ((err = av_write_trailer(*outputContext)) < 0)
+			{
+				g_logger_error("Failed to write video trailer.");
 				printError(err);
-				av_packet_unref(&pkt);
 				return false;
 			}
 
-			av_packet_unref(&pkt);
 			return true;
 		}
 
@@ -0,0 +1,257 @@
+#include "video/ExportCheckpoint.h"
+#include "video/Encoder.h"
+
+namespace MathAnim
+{
+	namespace ExportCheckpoint
+	{
+		// Bump this if the manifest layout changes. Old manifests just won't resume.
+		static constexpr int manifestVersion = 1;
+		static const char* manifestFilename = "manifest.txt";
+
+		// ------------- Internal Functions -------------
+		static std::string getSegmentDir(const std::string& outputFilename);
+		static bool writeManifest(const ExportManifest& manifest);
+		static bool readManifest(ExportManifest* manifest);
+
+		bool create(ExportManifest* manifest, const std::string& outputFilename, const std::string& sceneName, int frameStart, int frameEnd, int framesPerSegment)
+		{
+			g_logger_assert(manifest != nullptr, "Cannot create null export manifest.");
+			g_logger_assert(framesPerSegment > 0, "Segments must contain at least one frame.");
+
+			manifest->outputFilename = outputFilename;
+			manifest->segmentDir = getSegmentDir(outputFilename);
+			manifest->sceneName = sceneName;
+			manifest->frameStart = frameStart;
+			manifest->frameEnd = frameEnd;
+			manifest->segments.clear();
+
+			// Start from a clean slate, stale segments would get stitched into the output otherwise
+			std::error_code err;
+			std::filesystem::remove_all(manifest->segmentDir, err);
+			std::filesystem::create_directories(manifest->segmentDir, err);
+			if (err)
+			{
+				g_logger_error("Failed to create segment directory '%s'.", manifest->segmentDir.c_str());
+				return false;
+			}
+
+			std::string extension = std::filesystem::path(outputFilename).extension().string();
+			for (int segmentStart = frameStart; segmentStart <= frameEnd; segmentStart += framesPerSegment)
+			{
+				ExportSegment segment;
+				segment.frameStart = segmentStart;
+				segment.frameEnd = glm::min(segmentStart + framesPerSegment - 1, frameEnd);
+				segment.complete = false;
+
+				char segmentName[64];
+				snprintf(segmentName, sizeof(segmentName), "segment_%05d%s", (int)manifest->segments.size(), extension.c_str());
+				segment.filename = (std::filesystem::path(manifest->segmentDir) / segmentName).string();
+
+				manifest->segments.push_back(segment);
+			}
+
+			return writeManifest(*manifest);
+		}
+
+		bool resume(ExportManifest* manifest, const std::string& outputFilename, const std::string& sceneName, int frameStart, int frameEnd)
+		{
+			g_logger_assert(manifest != nullptr, "Cannot resume into null export manifest.");
+
+			manifest->outputFilename = outputFilename;
+			manifest->segmentDir = getSegmentDir(outputFilename);
+			if (!readManifest(manifest))
+			{
+				return false;
+			}
+
+			if (manifest->sceneName != sceneName || manifest->frameStart != frameStart || manifest->frameEnd != frameEnd)
+			{
+				g_logger_error("Cannot resume export of scene '%s' frames [%d, %d], the checkpoint is for scene '%s' frames [%d, %d].",
+					sceneName.c_str(), frameStart, frameEnd,
+					manifest->sceneName.c_str(), manifest->frameStart, manifest->frameEnd);
+				return false;
+			}
+
+			// Don't trust the manifest blindly, the segment could have been deleted or
+			// truncated after it was recorded
+			bool anyInvalidated = false;
+			for (ExportSegment& segment : manifest->segments)
+			{
+				if (!segment.complete)
+				{
+					continue;
+				}
+
+				int expectedFrames = segment.frameEnd - segment.frameStart + 1;
+				int actualFrames = std::filesystem::exists(segment.filename)
+					? VideoWriter::countFrames(segment.filename.c_str())
+					: -1;
+				if (actualFrames != expectedFrames)
+				{
+					g_logger_warning("Segment '%s' has %d frames, expected %d. It will be rendered again.",
+						segment.filename.c_str(), actualFrames, expectedFrames);
+					segment.complete = false;
+					anyInvalidated = true;
+				}
+			}
+
+			if (anyInvalidated && !writeManifest(*manifest))
+			{
+				return false;
+			}
+
+			g_logger_info("Resuming export to '%s', %d of %d frames are already done.",
+				outputFilename.c_str(), numCompleteFrames(*manifest), frameEnd - frameStart + 1);
+			return true;
+		}
+
+		bool markComplete(ExportManifest& manifest, size_t segmentIndex)
+		{
+			g_logger_assert(segmentIndex < manifest.segments.size(), "Segment index %d out of bounds.", (int)segmentIndex);
+
+			manifest.segments[segmentIndex].complete = true;
+			return writeManifest(manifest);
+		}
+
+		int numCompleteFrames(const ExportManifest& manifest)
+		{
+			int res = 0;
+			for (const ExportSegment& segment : manifest.segments)
+			{
+				if (segment.complete)
+				{
+					res += segment.frameEnd - segment.frameStart + 1;
+				}
+			}
+
+			return res;
+		}
+
+		bool finalize(const ExportManifest& manifest)
+		{
+			std::vector<std::string> segmentFilenames;
+			for (const ExportSegment& segment : manifest.segments)
+			{
+				if (!segment.complete)
+				{
+					g_logger_error("Cannot finalize export, segment '%s' is incomplete.", segment.filename.c_str());
+					return false;
+				}
+				segmentFilenames.push_back(segment.filename);
+			}
+
+			if (!VideoWriter::concatSegments(segmentFilenames, manifest.outputFilename.c_str()))
+			{
+				g_logger_error("Failed to concatenate segments. Leaving segments in '%s'.", manifest.segmentDir.c_str());
+				return false;
+			}
+
+			std::error_code err;
+			std::filesystem::remove_all(manifest.segmentDir, err);
+			return true;
+		}
+
+		// ------------- Internal Functions -------------
+		static std::string getSegmentDir(const std::string& outputFilename)
+		{
+			return outputFilename + ".segments";
+		}
+
+		static bool writeManifest(const ExportManifest& manifest)
+		{
+			// Write to a temporary file and swap it in so a crash mid-write never
+			// leaves a half written manifest behind
+			std::filesystem::path manifestPath = std::filesystem::path(manifest.segmentDir) / manifestFilename;
+			std::filesystem::path tmpPath = manifestPath;
+			tmpPath += ".tmp";
+
+			FILE* fp = fopen(tmpPath.string().c_str(), "wb");
+			if (!fp)
+			{
+				g_logger_error("Failed to write export manifest '%s'.", tmpPath.string().c_str());
+				return false;
+			}
+
+			fprintf(fp, "MathAnimExportManifest %d\n", manifestVersion);
+			fprintf(fp, "frames %d %d\n", manifest.frameStart, manifest.frameEnd);
+			fprintf(fp, "scene %s\n", manifest.sceneName.c_str());
+			for (const ExportSegment& segment : manifest.segments)
+			{
+				// Segments are stored relative to the segment directory so the whole export
+				// can be moved around before resuming
+				std::string segmentName = std::filesystem::path(segment.filename).filename().string();
+				fprintf(fp, "segment %d %d %d %s\n", segment.frameStart, segment.frameEnd, segment.complete ? 1 : 0, segmentName.c_str());
+			}
+			fflush(fp);
+			fclose(fp);
+
+			std::error_code err;
+			std::filesystem::rename(tmpPath, manifestPath, err);
+			if (err)
+			{
+				g_logger_error("Failed to update export manifest '%s': %s", manifestPath.string().c_str(), err.message().c_str());
+				return false;
+			}
+
+			return true;
+		}
+
+		static bool readManifest(ExportManifest* manifest)
+		{
+			std::filesystem::path manifestPath = std::filesystem::path(manifest->segmentDir) / manifestFilename;
+			std::ifstream file(manifestPath);
+			if (!file.is_open())
+			{
+				g_logger_error("No export checkpoint found at '%s'.", manifestPath.string().c_str());
+				return false;
+			}
+
+			std::string line;
+			int version = 0;
+			if (!std::getline(file, line) || sscanf(line.c_str(), "MathAnimExportManifest %d", &version) != 1 || version != manifestVersion)
+			{
+				g_logger_error("Export checkpoint '%s' is invalid or from an unsupported version.", manifestPath.string().c_str());
+				return false;
+			}
+
+			manifest->segments.clear();
+			bool hasFrames = false;
+			bool hasScene = false;
+			while (std::getline(file, line))
+			{
+				if (line.rfind("frames ", 0) == 0)
+				{
+					hasFrames = sscanf(line.c_str(), "frames %d %d", &manifest->frameStart, &manifest->frameEnd) == 2;
+				}
+				else if (line.rfind("scene ", 0) == 0)
+				{
+					manifest->sceneName = line.substr(std::strlen("scene "));
+					hasScene = true;
+				}
+				else if (line.rfind("segment ", 0) == 0)
+				{
+					ExportSegment segment;
+					int complete = 0;
+					char segmentName[256];
+					if (sscanf(line.c_str(), "segment %d %d %d %255s", &segment.frameStart, &segment.frameEnd, &complete, segmentName) != 4)
+					{
+						g_logger_error("Malformed segment entry '%s' in export checkpoint.", line.c_str());
+						return false;
+					}
+					segment.complete = complete != 0;
+					segment.filename = (std::filesystem::path(manifest->segmentDir) / segmentName).string();
+					manifest->segments.push_back(segment);
+				}
+			}
+
+			if (!hasFrames || !hasScene || manifest->segments.size() == 0)
+			{
+				g_logger_error("Export checkpoint '%s' is missing data.", manifestPath.string().c_str());
+				return false;
+			}
+
+			return true;
+		}
+	}
+}
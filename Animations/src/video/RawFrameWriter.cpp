@@ -0,0 +1,550 @@
+#include "video/RawFrameWriter.h"
+#include "video/Encoder.h"
+
+extern "C"
+{
+#include <libavutil/pixfmt.h>
+#include <libswscale/swscale.h>
+}
+
+#ifdef _WIN32
+#include <io.h>
+#include <fcntl.h>
+#include <sys/stat.h>
+#else
+#include <unistd.h>
+#include <fcntl.h>
+#include <signal.h>
+#include <sys/stat.h>
+#include <sys/ioctl.h>
+#include <sys/uio.h>
+#endif
+
+namespace MathAnim
+{
+	// Enough to keep the writer busy while the next frame renders. Anything more just
+	// means more memory sitting around when the consumer is the bottleneck.
+	static constexpr int rawFrameBufferCount = 3;
+
+	struct RawFrameBuffer
+	{
+		uint8* data;
+		// Number of queued writes that still reference this buffer. Buffers are only
+		// handed back to the renderer once this drops to 0.
+		int refCount;
+	};
+
+	struct RawFrameQueue
+	{
+		RawFrameBuffer buffers[rawFrameBufferCount];
+		std::deque<int> pendingWrites;
+		int lastBuffer;
+		bool useVmsplice;
+
+		std::thread writerThread;
+		// Guards everything above except useVmsplice, which never changes after open
+		std::mutex mtx;
+		std::condition_variable cv;
+		bool stop;
+		bool failed;
+	};
+
+	namespace RawFrameWriter
+	{
+		static const char y4mFrameHeader[] = "FRAME\n";
+		static constexpr size_t y4mFrameHeaderLength = sizeof(y4mFrameHeader) - 1;
+		// How long close waits for the consumer to drain spliced frames from the pipe
+		static constexpr int maxPipeDrainWaitMs = 5000;
+
+		static int reservedStdoutFd = -1;
+
+		// ------------- Internal Functions -------------
+		static int openOutputFd(const char* filename);
+		static void closeFd(int fd);
+		static bool writeAll(int fd, const uint8* data, size_t size);
+		static bool canVmsplice(int fd, size_t frameSize);
+		static bool spliceAll(int fd, const uint8* data, size_t size);
+		static void waitForPipeDrain(int fd);
+		static int acquireBuffer(RawFrameQueue* queue);
+		static bool submitBuffer(RawFrameQueue* queue, int bufferIndex);
+		static void writerLoop(RawFrameOutput* output);
+
+		void reserveStdout()
+		{
+			if (reservedStdoutFd >= 0)
+			{
+				return;
+			}
+
+			// Keep our own handle to stdout for the frames and send everything else that
+			// gets printed to stderr so it can't corrupt the stream
+			fflush(stdout);
+#ifdef _WIN32
+			reservedStdoutFd = _dup(_fileno(stdout));
+			if (reservedStdoutFd >= 0)
+			{
+				_setmode(reservedStdoutFd, _O_BINARY);
+				_dup2(_fileno(stderr), _fileno(stdout));
+			}
+#else
+			reservedStdoutFd = dup(STDOUT_FILENO);
+			if (reservedStdoutFd >= 0)
+			{
+				dup2(STDERR_FILENO, STDOUT_FILENO);
+			}
+#endif
+		}
+
+		bool open(RawFrameOutput* output, const char* filename, RawFrameFormat format, int width, int height, int framerate)
+		{
+			g_logger_assert(output != nullptr, "Cannot open null raw frame output.");
+			g_logger_assert(format != RawFrameFormat::None && format != RawFrameFormat::Length, "Invalid raw frame format.");
+
+			if (format != RawFrameFormat::Rgb24 && ((width % 2) != 0 || (height % 2) != 0))
+			{
+				g_logger_error("%s output requires an even width and height, got %dx%d.", rawFrameFormatNames[(uint8)format], width, height);
+				return false;
+			}
+
+			output->width = width;
+			output->height = height;
+			output->framerate = framerate;
+			output->format = format;
+			output->frameCounter = 0;
+			output->duplicateFrameCount = 0;
+			output->swsContext = nullptr;
+			output->queue = nullptr;
+
+			size_t numPixels = (size_t)width * (size_t)height;
+			output->frameHeaderSize = format == RawFrameFormat::Y4m ? y4mFrameHeaderLength : 0;
+			output->frameSize = output->frameHeaderSize + (format == RawFrameFormat::Rgb24
+				? numPixels * 3
+				: numPixels + (numPixels / 2));
+
+#ifndef _WIN32
+			// A consumer closing the pipe early should be an error we can report, not a dead process
+			signal(SIGPIPE, SIG_IGN);
+#endif
+
+			output->fd = openOutputFd(filename);
+			if (output->fd < 0)
+			{
+				g_logger_error("Failed to open raw frame output '%s'.", filename);
+				return false;
+			}
+
+			if (format == RawFrameFormat::Y4m)
+			{
+				char streamHeader[128];
+				int headerLength = snprintf(streamHeader, sizeof(streamHeader), "YUV4MPEG2 W%d H%d F%d:1 Ip A1:1 C420jpeg\n", width, height, framerate);
+				if (!writeAll(output->fd, (const uint8*)streamHeader, (size_t)headerLength))
+				{
+					g_logger_error("Failed to write y4m header to '%s'.", filename);
+					closeFd(output->fd);
+					output->fd = -1;
+					return false;
+				}
+			}
+
+			// Placement new so the mutex and friends get constructed but still go through the memory tracker
+			void* queueMemory = g_memory_allocate(sizeof(RawFrameQueue));
+			output->queue = new(queueMemory)RawFrameQueue();
+			output->queue->lastBuffer = -1;
+			output->queue->stop = false;
+			output->queue->failed = false;
+			output->queue->useVmsplice = canVmsplice(output->fd, output->frameSize);
+			for (int i = 0; i < rawFrameBufferCount; i++)
+			{
+				output->queue->buffers[i].data = (uint8*)g_memory_allocate(output->frameSize);
+				output->queue->buffers[i].refCount = 0;
+				// The frame header never changes so it only needs to be written once
+				if (output->frameHeaderSize > 0)
+				{
+					g_memory_copyMem(output->queue->buffers[i].data, (void*)y4mFrameHeader, output->frameHeaderSize);
+				}
+			}
+
+			output->queue->writerThread = std::thread(writerLoop, output);
+
+			g_logger_info("Streaming %dx%d %s frames to '%s'%s.", width, height, rawFrameFormatNames[(uint8)format], filename,
+				output->queue->useVmsplice ? " with vmsplice" : "");
+			return true;
+		}
+
+		bool pushFrame(Pixel* pixels, int pixelsLength, RawFrameOutput& output)
+		{
+			g_logger_assert(pixelsLength == output.width * output.height, "Invalid pixel buffer for raw frame output. Width and height do not match pixelsLength.");
+
+			// Blocks while every buffer is still waiting on the consumer
+			int bufferIndex = acquireBuffer(output.queue);
+			if (bufferIndex < 0)
+			{
+				g_logger_error("Raw frame output was closed by the consumer.");
+				return false;
+			}
+
+			uint8* dst = output.queue->buffers[bufferIndex].data + output.frameHeaderSize;
+			if (output.format == RawFrameFormat::Rgb24)
+			{
+				g_memory_copyMem(dst, pixels, sizeof(Pixel) * pixelsLength);
+			}
+			else
+			{
+				if (!output.swsContext)
+				{
+					output.swsContext = sws_getContext(
+						output.width,
+						output.height,
+						AV_PIX_FMT_RGB24,
+						output.width,
+						output.height,
+						AV_PIX_FMT_YUV420P,
+						SWS_BICUBIC,
+						0,
+						0,
+						0
+					);
+				}
+
+				// Planes are written back to back, which is exactly what raw yuv420p looks like
+				size_t lumaSize = (size_t)output.width * (size_t)output.height;
+				uint8* dstPlanes[3] = { dst, dst + lumaSize, dst + lumaSize + (lumaSize / 4) };
+				int dstLinesize[3] = { output.width, output.width / 2, output.width / 2 };
+				int inLinesize[1] = { 3 * output.width };
+				sws_scale(
+					output.swsContext,
+					(const uint8* const*)&pixels,
+					inLinesize,
+					0,
+					output.height,
+					dstPlanes,
+					dstLinesize
+				);
+			}
+
+			output.frameCounter++;
+			return submitBuffer(output.queue, bufferIndex);
+		}
+
+		bool pushDuplicateFrame(RawFrameOutput& output)
+		{
+			int lastBuffer;
+			{
+				std::lock_guard<std::mutex> lock(output.queue->mtx);
+				lastBuffer = output.queue->lastBuffer;
+			}
+
+			if (lastBuffer < 0)
+			{
+				g_logger_error("Cannot duplicate a frame before any frame has been pushed.");
+				return false;
+			}
+
+			// Just queue the same buffer again, it stays referenced until both writes finish
+			output.frameCounter++;
+			output.duplicateFrameCount++;
+			return submitBuffer(output.queue, lastBuffer);
+		}
+
+		bool close(RawFrameOutput& output)
+		{
+			if (!output.queue)
+			{
+				return false;
+			}
+
+			{
+				std::lock_guard<std::mutex> lock(output.queue->mtx);
+				output.queue->stop = true;
+			}
+			output.queue->cv.notify_all();
+			output.queue->writerThread.join();
+
+			bool success = !output.queue->failed;
+			if (output.queue->useVmsplice)
+			{
+				// Spliced pages are still owned by the pipe until they're read, so don't
+				// free the buffers out from under the consumer
+				waitForPipeDrain(output.fd);
+			}
+
+			for (int i = 0; i < rawFrameBufferCount; i++)
+			{
+				g_memory_free(output.queue->buffers[i].data);
+			}
+			output.queue->~RawFrameQueue();
+			g_memory_free(output.queue);
+			output.queue = nullptr;
+
+			if (output.swsContext)
+			{
+				sws_freeContext(output.swsContext);
+				output.swsContext = nullptr;
+			}
+
+			closeFd(output.fd);
+			output.fd = -1;
+
+			if (success)
+			{
+				g_logger_info("Streamed %d raw frames.", output.frameCounter);
+			}
+			return success;
+		}
+
+		RawFrameFormat parseFormat(const char* str)
+		{
+			for (uint8 i = (uint8)RawFrameFormat::None + 1; i < (uint8)RawFrameFormat::Length; i++)
+			{
+				if (std::strcmp(str, rawFrameFormatNames[i]) == 0)
+				{
+					return (RawFrameFormat)i;
+				}
+			}
+
+			return RawFrameFormat::None;
+		}
+
+		// ------------- Internal Functions -------------
+		static int openOutputFd(const char* filename)
+		{
+			if (std::strcmp(filename, "-") == 0)
+			{
+				// The output owns the handle from here on
+				reserveStdout();
+				int fd = reservedStdoutFd;
+				reservedStdoutFd = -1;
+				return fd;
+			}
+
+#ifdef _WIN32
+			// Works for regular files and named pipes (\\.\pipe\name)
+			return _open(filename, _O_WRONLY | _O_BINARY | _O_CREAT | _O_TRUNC, _S_IREAD | _S_IWRITE);
+#else
+			// Opening a FIFO blocks until the consumer opens the other end
+			return ::open(filename, O_WRONLY | O_CREAT | O_TRUNC, 0644);
+#endif
+		}
+
+		static void closeFd(int fd)
+		{
+			if (fd < 0)
+			{
+				return;
+			}
+
+#ifdef _WIN32
+			_close(fd);
+#else
+			::close(fd);
+#endif
+		}
+
+		static bool writeAll(int fd, const uint8* data, size_t size)
+		{
+			// One big write per frame, the kernel (or CRT) splits it up however it likes
+			while (size > 0)
+			{
+#ifdef _WIN32
+				unsigned int chunkSize = (unsigned int)glm::min(size, (size_t)(1u << 30));
+				int written = _write(fd, data, chunkSize);
+#else
+				ssize_t written = ::write(fd, data, size);
+#endif
+				if (written < 0)
+				{
+					if (errno == EINTR)
+					{
+						continue;
+					}
+					return false;
+				}
+
+				data += written;
+				size -= (size_t)written;
+			}
+
+			return true;
+		}
+
+		static bool canVmsplice(int fd, size_t frameSize)
+		{
+#ifdef __linux__
+			struct stat fileStat;
+			if (fstat(fd, &fileStat) != 0 || !S_ISFIFO(fileStat.st_mode))
+			{
+				return false;
+			}
+
+			// Bigger pipes mean fewer syscalls, it's fine if we're not allowed to grow it
+			fcntl(fd, F_SETPIPE_SZ, 1024 * 1024);
+			int pipeSize = fcntl(fd, F_GETPIPE_SZ);
+			if (pipeSize <= 0)
+			{
+				return false;
+			}
+
+			// Spliced pages are referenced by the pipe until the consumer reads them. A buffer
+			// only gets reused after a whole frame has been spliced behind it, which guarantees
+			// it has been read only if a frame can't fit in the pipe.
+			return frameSize >= (size_t)pipeSize;
+#else
+			return false;
+#endif
+		}
+
+		static bool spliceAll(int fd, const uint8* data, size_t size)
+		{
+#ifdef __linux__
+			while (size > 0)
+			{
+				struct iovec iov;
+				iov.iov_base = (void*)data;
+				iov.iov_len = size;
+				ssize_t spliced = vmsplice(fd, &iov, 1, 0);
+				if (spliced < 0)
+				{
+					if (errno == EINTR)
+					{
+						continue;
+					}
+					return false;
+				}
+
+				data += spliced;
+				size -= (size_t)spliced;
+			}
+
+			return true;
+#else
+			return writeAll(fd, data, size);
+#endif
+		}
+
+		static void waitForPipeDrain(int fd)
+		{
+#ifdef __linux__
+			for (int i = 0; i < maxPipeDrainWaitMs; i++)
+			{
+				int bytesInPipe = 0;
+				if (ioctl(fd, FIONREAD, &bytesInPipe) != 0 || bytesInPipe <= 0)
+				{
+					return;
+				}
+				std::this_thread::sleep_for(std::chrono::milliseconds(1));
+			}
+
+			g_logger_warning("Consumer did not finish reading the raw frame pipe.");
+#endif
+		}
+
+		static int acquireBuffer(RawFrameQueue* queue)
+		{
+			std::unique_lock<std::mutex> lock(queue->mtx);
+
+			int freeBuffer = -1;
+			queue->cv.wait(lock, [queue, &freeBuffer]() {
+				if (queue->failed)
+				{
+					return true;
+				}
+
+				for (int i = 0; i < rawFrameBufferCount; i++)
+				{
+					if (queue->buffers[i].refCount == 0)
+					{
+						freeBuffer = i;
+						return true;
+					}
+				}
+
+				return false;
+			});
+
+			return queue->failed ? -1 : freeBuffer;
+		}
+
+		static bool submitBuffer(RawFrameQueue* queue, int bufferIndex)
+		{
+			{
+				std::lock_guard<std::mutex> lock(queue->mtx);
+				if (queue->failed)
+				{
+					return false;
+				}
+
+				queue->buffers[bufferIndex].refCount++;
+				queue->pendingWrites.push_back(bufferIndex);
+				queue->lastBuffer = bufferIndex;
+			}
+			queue->cv.notify_all();
+
+			return true;
+		}
+
+		static void writerLoop(RawFrameOutput* output)
+		{
+			RawFrameQueue* queue = output->queue;
+			// With vmsplice the previous frame stays referenced until the next one is
+			// fully spliced, see canVmsplice
+			int heldBuffer = -1;
+
+			for (;;)
+			{
+				int bufferIndex;
+				{
+					std::unique_lock<std::mutex> lock(queue->mtx);
+					queue->cv.wait(lock, [queue]() { return queue->stop || queue->pendingWrites.size() > 0; });
+
+					// Finish everything that was queued before stopping
+					if (queue->pendingWrites.size() == 0)
+					{
+						break;
+					}
+
+					bufferIndex = queue->pendingWrites.front();
+					queue->pendingWrites.pop_front();
+				}
+
+				const uint8* data = queue->buffers[bufferIndex].data;
+				bool success = queue->useVmsplice
+					? spliceAll(output->fd, data, output->frameSize)
+					: writeAll(output->fd, data, output->frameSize);
+
+				{
+					std::lock_guard<std::mutex> lock(queue->mtx);
+					if (queue->useVmsplice)
+					{
+						if (heldBuffer >= 0)
+						{
+							queue->buffers[heldBuffer].refCount--;
+						}
+						heldBuffer = bufferIndex;
+					}
+					else
+					{
+						queue->buffers[bufferIndex].refCount--;
+					}
+
+					if (!success)
+					{
+						queue->failed = true;
+					}
+				}
+				queue->cv.notify_all();
+
+				if (!success)
+				{
+					g_logger_error("Failed to write raw frame, the consumer probably exited.");
+					break;
+				}
+			}
+
+			if (heldBuffer >= 0)
+			{
+				std::lock_guard<std::mutex> lock(queue->mtx);
+				queue->buffers[heldBuffer].refCount--;
+			}
+		}
+	}
+}
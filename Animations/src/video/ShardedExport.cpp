@@ -0,0 +1,224 @@
+#include "video/ShardedExport.h"
+#include "video/ExportCheckpoint.h"
+#include "core/CommandLine.h"
+#include "core/Application.h"
+#include "platform/Platform.h"
+
+namespace MathAnim
+{
+	struct ShardWorkerStats
+	{
+		int shardsCompleted;
+		int framesRendered;
+		double secondsBusy;
+	};
+
+	struct ShardCoordinator
+	{
+		const HeadlessRenderOptions* options;
+		const std::string* sceneName;
+		// Every shard is one segment of the export checkpoint
+		ExportManifest* manifest;
+		std::vector<size_t> pendingShards;
+		std::vector<ShardWorkerStats> workerStats;
+
+		// Guards nextShard, failed and writes to the manifest
+		std::mutex mtx;
+		size_t nextShard;
+		bool failed;
+	};
+
+	namespace ShardedExport
+	{
+		// Each worker should get a few shards so that finished workers can pick up the
+		// slack from slower ones
+		static constexpr int shardsPerWorker = 4;
+
+		// ------------- Internal Functions -------------
+		static void workerLoop(ShardCoordinator* coordinator, int workerIndex);
+		static std::string buildWorkerArgs(const ShardCoordinator& coordinator, const ExportSegment& shard);
+		static std::string quoteArgument(const std::string& arg);
+
+		bool run(const HeadlessRenderOptions& options, const std::string& sceneName, int frameStart, int frameEnd)
+		{
+			g_logger_assert(options.numWorkers > 1, "Sharded export requires more than one worker.");
+
+			int totalFrames = frameEnd - frameStart + 1;
+			int framesPerShard = options.framesPerShard;
+			if (framesPerShard <= 0)
+			{
+				// Don't make shards shorter than a second, every segment pays for
+				// process startup and a fresh keyframe
+				framesPerShard = glm::max(totalFrames / (options.numWorkers * shardsPerWorker), Application::getFrameratePerSecond());
+			}
+
+			// When resuming, the shard layout comes from the checkpoint so already finished
+			// segments line up with the ones that still need rendering
+			ExportManifest manifest;
+			bool manifestReady = options.resume
+				? ExportCheckpoint::resume(&manifest, options.outputFilename, sceneName, frameStart, frameEnd)
+				: ExportCheckpoint::create(&manifest, options.outputFilename, sceneName, frameStart, frameEnd, framesPerShard);
+			if (!manifestReady)
+			{
+				return false;
+			}
+
+			ShardCoordinator coordinator;
+			coordinator.options = &options;
+			coordinator.sceneName = &sceneName;
+			coordinator.manifest = &manifest;
+			coordinator.nextShard = 0;
+			coordinator.failed = false;
+			for (size_t i = 0; i < manifest.segments.size(); i++)
+			{
+				if (!manifest.segments[i].complete)
+				{
+					coordinator.pendingShards.push_back(i);
+				}
+			}
+
+			int framesToRender = totalFrames - ExportCheckpoint::numCompleteFrames(manifest);
+			int numWorkers = glm::min(options.numWorkers, (int)coordinator.pendingShards.size());
+			coordinator.workerStats.resize(numWorkers, ShardWorkerStats{ 0, 0, 0.0 });
+			g_logger_info("Rendering %d frames as %d shards with %d workers.",
+				framesToRender, (int)coordinator.pendingShards.size(), numWorkers);
+
+			auto startTime = std::chrono::steady_clock::now();
+			std::vector<std::thread> workerThreads;
+			for (int i = 0; i < numWorkers; i++)
+			{
+				workerThreads.emplace_back(workerLoop, &coordinator, i);
+			}
+
+			for (std::thread& thread : workerThreads)
+			{
+				thread.join();
+			}
+			double elapsedTime = std::chrono::duration<double>(std::chrono::steady_clock::now() - startTime).count();
+
+			for (int i = 0; i < numWorkers; i++)
+			{
+				const ShardWorkerStats& stats = coordinator.workerStats[i];
+				g_logger_info("Worker %d: %d shards, %d frames in %2.3fs (%2.2f fps).",
+					i, stats.shardsCompleted, stats.framesRendered, stats.secondsBusy,
+					stats.secondsBusy > 0.0 ? (double)stats.framesRendered / stats.secondsBusy : 0.0);
+			}
+
+			if (coordinator.failed)
+			{
+				g_logger_error("Sharded export failed. Finished segments are kept in '%s', run again with --resume to continue.", manifest.segmentDir.c_str());
+				return false;
+			}
+
+			if (!ExportCheckpoint::finalize(manifest))
+			{
+				return false;
+			}
+
+			g_logger_info("Rendered %d frames in %2.3fs (%2.2f fps) across %d workers.",
+				framesToRender, elapsedTime, elapsedTime > 0.0 ? (double)framesToRender / elapsedTime : 0.0, numWorkers);
+
+			return true;
+		}
+
+		// ------------- Internal Functions -------------
+		static void workerLoop(ShardCoordinator* coordinator, int workerIndex)
+		{
+			for (;;)
+			{
+				size_t shardIndex;
+				{
+					std::lock_guard<std::mutex> lock(coordinator->mtx);
+					if (coordinator->failed || coordinator->nextShard >= coordinator->pendingShards.size())
+					{
+						return;
+					}
+					shardIndex = coordinator->pendingShards[coordinator->nextShard++];
+				}
+
+				// The segment list never changes size, only the complete flags get written
+				const ExportSegment& shard = coordinator->manifest->segments[shardIndex];
+				std::string args = buildWorkerArgs(*coordinator, shard);
+
+				auto shardStartTime = std::chrono::steady_clock::now();
+				int exitCode = -1;
+				bool launched = Platform::executeProgramAndWait(coordinator->options->executablePath.c_str(), args.c_str(), &exitCode);
+				double shardTime = std::chrono::duration<double>(std::chrono::steady_clock::now() - shardStartTime).count();
+
+				if (!launched || exitCode != 0)
+				{
+					g_logger_error("Worker %d failed to render shard %d (frames [%d, %d]), exit code %d.",
+						workerIndex, (int)shardIndex, shard.frameStart, shard.frameEnd, exitCode);
+					std::lock_guard<std::mutex> lock(coordinator->mtx);
+					coordinator->failed = true;
+					return;
+				}
+
+				{
+					// Checkpoint right away so this shard survives a crash of the coordinator
+					std::lock_guard<std::mutex> lock(coordinator->mtx);
+					if (!ExportCheckpoint::markComplete(*coordinator->manifest, shardIndex))
+					{
+						coordinator->failed = true;
+						return;
+					}
+				}
+
+				// Each worker only ever touches its own stats entry
+				int framesInShard = shard.frameEnd - shard.frameStart + 1;
+				ShardWorkerStats& stats = coordinator->workerStats[workerIndex];
+				stats.shardsCompleted++;
+				stats.framesRendered += framesInShard;
+				stats.secondsBusy += shardTime;
+
+				g_logger_info("Worker %d finished shard %d (frames [%d, %d]) at %2.2f fps.",
+					workerIndex, (int)shardIndex, shard.frameStart, shard.frameEnd,
+					shardTime > 0.0 ? (double)framesInShard / shardTime : 0.0);
+			}
+		}
+
+		static std::string buildWorkerArgs(const ShardCoordinator& coordinator, const ExportSegment& shard)
+		{
+			// Workers are regular single process headless renders of a sub-range. The shard
+			// is already a checkpoint segment, so they write straight to it.
+			return std::string("--render ") + quoteArgument(coordinator.options->projectFile) +
+				" --scene " + quoteArgument(*coordinator.sceneName) +
+				" --frames " + std::to_string(shard.frameStart) + ":" + std::to_string(shard.frameEnd) +
+				(coordinator.options->verifyHeldFrames ? " --verify-holds" : "") +
+				" --no-checkpoints" +
+				" --out " + quoteArgument(shard.filename);
+		}
+
+		static std::string quoteArgument(const std::string& arg)
+		{
+			// Follows the CommandLineToArgvW rules, which the Linux platform layer splits
+			// arguments with too. Backslashes are only special in front of a quote, so a
+			// run of them gets doubled when a quote (embedded or the closing one) follows.
+			std::string res = "\"";
+			size_t numBackslashes = 0;
+			for (char c : arg)
+			{
+				if (c == '\\')
+				{
+					numBackslashes++;
+					continue;
+				}
+
+				if (c == '"')
+				{
+					res.append(numBackslashes * 2 + 1, '\\');
+				}
+				else
+				{
+					res.append(numBackslashes, '\\');
+				}
+				res += c;
+				numBackslashes = 0;
+			}
+			res.append(numBackslashes * 2, '\\');
+			res += '"';
+
+			return res;
+		}
+	}
+}